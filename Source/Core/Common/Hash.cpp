@@ -5,6 +5,7 @@
 #include "Common/Hash.h"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include "Common/BitUtils.h"
 #include "Common/CPUDetect.h"
@@ -13,11 +14,14 @@
 
 #ifdef _M_ARM_64
 #include <arm_acle.h>
+#include <arm_neon.h>
 #endif
 
 namespace Common
 {
 static u64 (*ptrHashFunction)(const u8* src, u32 len, u32 samples) = nullptr;
+// Used by the wide hashes for sampled and short inputs.
+static u64 (*ptrSampledHashFunction)(const u8* src, u32 len, u32 samples) = nullptr;
 
 // uint32_t
 // WARNING - may read one more byte!
@@ -245,6 +249,53 @@ static u64 GetMurmurHash3(const u8* src, u32 len, u32 samples)
   return h1;
 }
 
+#if defined(_M_X86_64) || defined(_M_ARM_64)
+// Wide hash, used for unsampled hashing on hosts with AVX2 or NEON. It follows the structure of
+// XXH3: eight 64-bit lanes accumulate 64-byte stripes, each stripe keyed by a sliding window into
+// a secret, and the lanes are scrambled after every block of 16 stripes so that the result
+// depends on the order of the stripes.
+constexpr u32 WIDE_HASH_STRIPE_SIZE = 64;
+constexpr u32 WIDE_HASH_STRIPES_PER_BLOCK = 16;
+constexpr u32 WIDE_HASH_BLOCK_SIZE = WIDE_HASH_STRIPE_SIZE * WIDE_HASH_STRIPES_PER_BLOCK;
+constexpr u32 WIDE_HASH_PRIME32 = 0x9E3779B1;
+
+// Offsets into the secret, in u64s. Stripes use 8 u64s starting at their index in the block.
+constexpr size_t WIDE_HASH_LAST_STRIPE_KEY = 7;
+constexpr size_t WIDE_HASH_SCRAMBLE_KEY = 16;
+
+static constexpr std::array<u64, 24> MakeWideHashSecret()
+{
+  // splitmix64
+  std::array<u64, 24> secret{};
+  u64 state = 0;
+  for (u64& value : secret)
+  {
+    state += 0x9E3779B97F4A7C15;
+    u64 z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    value = z ^ (z >> 31);
+  }
+  return secret;
+}
+
+alignas(32) static constexpr std::array<u64, 24> s_wide_hash_secret = MakeWideHashSecret();
+
+// Whether GetHash64 would skip over some of the data, in which case the sampling hashes are used.
+static bool IsSampledHash(u32 len, u32 samples)
+{
+  return samples != 0 && (len / 8) / samples > 1;
+}
+
+static u64 FinalizeWideHash(const u64* lanes, u32 len)
+{
+  u64 h = len * 0x9E3779B185EBCA87;
+  for (int i = 0; i < 8; ++i)
+    h = fmix64(h ^ lanes[i]);
+  return h;
+}
+#endif
+
 // CRC32 hash using the SSE4.2 instruction
 #if defined(_M_X86_64)
 
@@ -287,6 +338,66 @@ static u64 GetCRC32(const u8* src, u32 len, u32 samples)
   return h[0] + (h[1] << 10) + (h[2] << 21) + (h[3] << 32);
 }
 
+FUNCTION_TARGET_AVX2
+static inline void AccumulateStripeAVX2(__m256i* acc, const u8* data, const u64* key)
+{
+  for (int i = 0; i < 2; ++i)
+  {
+    const __m256i data_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + i);
+    const __m256i key_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i);
+    const __m256i data_key = _mm256_xor_si256(data_vec, key_vec);
+    const __m256i product = _mm256_mul_epu32(data_key, _mm256_srli_epi64(data_key, 32));
+    const __m256i data_swap = _mm256_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+    acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(data_swap, product));
+  }
+}
+
+FUNCTION_TARGET_AVX2
+static inline void ScrambleAVX2(__m256i* acc, const u64* key)
+{
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(WIDE_HASH_PRIME32));
+  for (int i = 0; i < 2; ++i)
+  {
+    __m256i value = _mm256_xor_si256(acc[i], _mm256_srli_epi64(acc[i], 47));
+    value = _mm256_xor_si256(
+        value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i));
+    const __m256i product_lo = _mm256_mul_epu32(value, prime);
+    const __m256i product_hi = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+    acc[i] = _mm256_add_epi64(product_lo, _mm256_slli_epi64(product_hi, 32));
+  }
+}
+
+FUNCTION_TARGET_AVX2
+static u64 GetWideHashAVX2(const u8* src, u32 len, u32 samples)
+{
+  if (len < WIDE_HASH_STRIPE_SIZE || IsSampledHash(len, samples))
+    return ptrSampledHashFunction(src, len, samples);
+
+  const u64* secret = s_wide_hash_secret.data();
+  __m256i acc[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+  const u8* data = src;
+  const u8* const end = src + len;
+
+  for (; end - data >= WIDE_HASH_BLOCK_SIZE; data += WIDE_HASH_BLOCK_SIZE)
+  {
+    for (u32 i = 0; i < WIDE_HASH_STRIPES_PER_BLOCK; ++i)
+      AccumulateStripeAVX2(acc, data + i * WIDE_HASH_STRIPE_SIZE, secret + i);
+    ScrambleAVX2(acc, secret + WIDE_HASH_SCRAMBLE_KEY);
+  }
+
+  for (u32 i = 0; end - data >= WIDE_HASH_STRIPE_SIZE; ++i, data += WIDE_HASH_STRIPE_SIZE)
+    AccumulateStripeAVX2(acc, data, secret + i);
+
+  // The last partial stripe overlaps with the data before it.
+  if (data != end)
+    AccumulateStripeAVX2(acc, end - WIDE_HASH_STRIPE_SIZE, secret + WIDE_HASH_LAST_STRIPE_KEY);
+
+  alignas(32) u64 lanes[8];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[0]);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes) + 1, acc[1]);
+  return FinalizeWideHash(lanes, len);
+}
+
 #elif defined(_M_ARM_64)
 
 static u64 GetCRC32(const u8* src, u32 len, u32 samples)
@@ -327,6 +438,61 @@ static u64 GetCRC32(const u8* src, u32 len, u32 samples)
   return h[0] + (h[1] << 10) + (h[2] << 21) + (h[3] << 32);
 }
 
+static inline void AccumulateStripeNEON(uint64x2_t* acc, const u8* data, const u64* key)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    const uint64x2_t data_vec = vreinterpretq_u64_u8(vld1q_u8(data + i * 16));
+    const uint64x2_t data_key = veorq_u64(data_vec, vld1q_u64(key + i * 2));
+    const uint64x2_t product = vmull_u32(vmovn_u64(data_key), vshrn_n_u64(data_key, 32));
+    const uint64x2_t data_swap = vextq_u64(data_vec, data_vec, 1);
+    acc[i] = vaddq_u64(acc[i], vaddq_u64(data_swap, product));
+  }
+}
+
+static inline void ScrambleNEON(uint64x2_t* acc, const u64* key)
+{
+  const uint32x2_t prime = vdup_n_u32(WIDE_HASH_PRIME32);
+  for (int i = 0; i < 4; ++i)
+  {
+    uint64x2_t value = veorq_u64(acc[i], vshrq_n_u64(acc[i], 47));
+    value = veorq_u64(value, vld1q_u64(key + i * 2));
+    const uint64x2_t product_lo = vmull_u32(vmovn_u64(value), prime);
+    const uint64x2_t product_hi = vmull_u32(vshrn_n_u64(value, 32), prime);
+    acc[i] = vaddq_u64(product_lo, vshlq_n_u64(product_hi, 32));
+  }
+}
+
+static u64 GetWideHashNEON(const u8* src, u32 len, u32 samples)
+{
+  if (len < WIDE_HASH_STRIPE_SIZE || IsSampledHash(len, samples))
+    return ptrSampledHashFunction(src, len, samples);
+
+  const u64* secret = s_wide_hash_secret.data();
+  uint64x2_t acc[4] = {vdupq_n_u64(0), vdupq_n_u64(0), vdupq_n_u64(0), vdupq_n_u64(0)};
+  const u8* data = src;
+  const u8* const end = src + len;
+
+  for (; end - data >= WIDE_HASH_BLOCK_SIZE; data += WIDE_HASH_BLOCK_SIZE)
+  {
+    for (u32 i = 0; i < WIDE_HASH_STRIPES_PER_BLOCK; ++i)
+      AccumulateStripeNEON(acc, data + i * WIDE_HASH_STRIPE_SIZE, secret + i);
+    ScrambleNEON(acc, secret + WIDE_HASH_SCRAMBLE_KEY);
+  }
+
+  for (u32 i = 0; end - data >= WIDE_HASH_STRIPE_SIZE; ++i, data += WIDE_HASH_STRIPE_SIZE)
+    AccumulateStripeNEON(acc, data, secret + i);
+
+  // The last partial stripe overlaps with the data before it.
+  if (data != end)
+    AccumulateStripeNEON(acc, end - WIDE_HASH_STRIPE_SIZE, secret + WIDE_HASH_LAST_STRIPE_KEY);
+
+  u64 lanes[8];
+  for (int i = 0; i < 4; ++i)
+    vst1q_u64(lanes + i * 2, acc[i]);
+  return FinalizeWideHash(lanes, len);
+}
+
 #else
 
 static u64 GetCRC32(const u8* src, u32 len, u32 samples)
@@ -525,5 +691,14 @@ void SetHash64Function()
   {
     ptrHashFunction = &GetMurmurHash3;
   }
+
+  // The wide hashes only handle unsampled hashing of inputs of at least one stripe themselves.
+  ptrSampledHashFunction = ptrHashFunction;
+#if defined(_M_X86_64)
+  if (cpu_info.bAVX2)
+    ptrHashFunction = &GetWideHashAVX2;
+#elif defined(_M_ARM_64)
+  ptrHashFunction = &GetWideHashNEON;
+#endif
 }
 }  // namespace Common
@@ -0,0 +1,75 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a lockless thread-safe,
+// multiple producer, single consumer queue
+
+#include <atomic>
+#include <utility>
+
+namespace Common
+{
+// Producers only swap the head pointer and link the previous element to their own, so pushing
+// never blocks. A pop that races with a push whose link isn't visible yet sees the queue as
+// ending before that element, and picks it up on the next pop instead.
+template <typename T>
+class MPSCQueue
+{
+public:
+  MPSCQueue() : m_head(new Node()) { m_tail = m_head.load(); }
+  ~MPSCQueue()
+  {
+    while (m_tail)
+    {
+      Node* next = m_tail->next.load();
+      delete m_tail;
+      m_tail = next;
+    }
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  // May be called from any thread.
+  template <typename Arg>
+  void Push(Arg&& t)
+  {
+    Node* node = new Node();
+    node->current = std::forward<Arg>(t);
+    Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Must only be called from the consumer thread.
+  bool Empty() const { return !m_tail->next.load(std::memory_order_acquire); }
+
+  // Must only be called from the consumer thread.
+  bool Pop(T& t)
+  {
+    Node* next = m_tail->next.load(std::memory_order_acquire);
+    if (!next)
+      return false;
+
+    // The popped element's node becomes the new stub, so only the old stub is freed.
+    t = std::move(next->current);
+    delete m_tail;
+    m_tail = next;
+    return true;
+  }
+
+private:
+  struct Node
+  {
+    T current{};
+    std::atomic<Node*> next{nullptr};
+  };
+
+  // Written by the producers.
+  alignas(64) std::atomic<Node*> m_head;
+  // Only accessed by the consumer. It always points at a stub whose element was already popped.
+  alignas(64) Node* m_tail;
+};
+}
@@ -0,0 +1,109 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/ParallelFor.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/Thread.h"
+
+namespace Common
+{
+namespace detail
+{
+namespace
+{
+class WorkerPool
+{
+public:
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_shutdown = true;
+    }
+    m_work_available.notify_all();
+    for (std::thread& thread : m_threads)
+      thread.join();
+  }
+
+  void Run(const std::function<void()>& work, size_t num_helpers)
+  {
+    Job job{&work, num_helpers, 0};
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      // Threads are only ever added, so the pool ends up as large as the largest request.
+      while (m_threads.size() < num_helpers)
+        m_threads.emplace_back(&WorkerPool::WorkerThread, this);
+      m_jobs.push_back(&job);
+    }
+    m_work_available.notify_all();
+
+    work();
+
+    // All items have been handed out by now, so helpers that haven't picked the job up yet
+    // have nothing left to do.
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (job.unstarted != 0)
+    {
+      m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+      job.unstarted = 0;
+    }
+    m_job_finished.wait(lk, [&] { return job.running == 0; });
+  }
+
+private:
+  struct Job
+  {
+    const std::function<void()>* work;
+    size_t unstarted;
+    size_t running;
+  };
+
+  void WorkerThread()
+  {
+    Common::SetCurrentThreadName("ParallelFor worker");
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (true)
+    {
+      m_work_available.wait(lk, [&] { return m_shutdown || !m_jobs.empty(); });
+      if (m_shutdown)
+        return;
+
+      Job* job = m_jobs.front();
+      if (--job->unstarted == 0)
+        m_jobs.pop_front();
+      job->running++;
+
+      lk.unlock();
+      (*job->work)();
+      lk.lock();
+
+      if (--job->running == 0)
+        m_job_finished.notify_all();
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_work_available;
+  std::condition_variable m_job_finished;
+  std::deque<Job*> m_jobs;
+  std::vector<std::thread> m_threads;
+  bool m_shutdown = false;
+};
+}  // Anonymous namespace
+
+void RunOnWorkerThreads(const std::function<void()>& work, size_t num_helpers)
+{
+  static WorkerPool pool;
+  pool.Run(work, num_helpers);
+}
+}  // namespace detail
+}  // namespace Common
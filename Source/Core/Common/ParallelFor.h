@@ -0,0 +1,51 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+namespace Common
+{
+// Returns the number of worker threads ParallelFor uses by default.
+inline size_t GetParallelForThreadCount()
+{
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+namespace detail
+{
+// Runs work on the calling thread and on up to num_helpers threads of a persistent pool, and
+// returns once every started copy has returned. Copies that haven't started by the time the
+// calling thread's copy returns are dropped, so this never waits on a busy pool.
+void RunOnWorkerThreads(const std::function<void()>& work, size_t num_helpers);
+}  // namespace detail
+
+// Calls function(i) for every i in [0, count), distributing the calls over up to num_threads
+// threads (the calling thread included). Items are handed out in increasing order, but may
+// complete in any order. Returns once every call has completed.
+template <typename Function>
+void ParallelFor(size_t count, Function function, size_t num_threads = GetParallelForThreadCount())
+{
+  num_threads = std::min(num_threads, count);
+  if (num_threads <= 1)
+  {
+    for (size_t i = 0; i < count; ++i)
+      function(i);
+    return;
+  }
+
+  std::atomic<size_t> next_index{0};
+  detail::RunOnWorkerThreads(
+      [&] {
+        for (size_t i = next_index++; i < count; i = next_index++)
+          function(i);
+      },
+      num_threads - 1);
+}
+}  // namespace Common
@@ -1795,12 +1795,12 @@ static int GetVEXpp(u8 opPrefix)
 }
 
 void XEmitter::WriteVEXOp(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg,
-                          int W, int extrabytes)
+                          int W, int extrabytes, int L)
 {
   int mmmmm = GetVEXmmmmm(op);
   int pp = GetVEXpp(opPrefix);
-  // FIXME: we currently don't support 256-bit instructions, and "size" is not the vector size here
-  arg.WriteVEX(this, regOp1, regOp2, 0, pp, mmmmm, W);
+  // L selects the vector size: 0 for 128-bit (XMM), 1 for 256-bit (YMM).
+  arg.WriteVEX(this, regOp1, regOp2, L, pp, mmmmm, W);
   Write8(op & 0xFF);
   arg.WriteRest(this, extrabytes, regOp1);
 }
@@ -1813,11 +1813,19 @@ void XEmitter::WriteVEXOp4(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, co
 }
 
 void XEmitter::WriteAVXOp(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg,
-                          int W, int extrabytes)
+                          int W, int extrabytes, int L)
 {
   if (!cpu_info.bAVX)
     PanicAlert("Trying to use AVX on a system that doesn't support it. Bad programmer.");
-  WriteVEXOp(opPrefix, op, regOp1, regOp2, arg, W, extrabytes);
+  WriteVEXOp(opPrefix, op, regOp1, regOp2, arg, W, extrabytes, L);
+}
+
+void XEmitter::WriteAVX2Op(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg,
+                           int W, int extrabytes, int L)
+{
+  if (!cpu_info.bAVX2)
+    PanicAlert("Trying to use AVX2 on a system that doesn't support it. Bad programmer.");
+  WriteVEXOp(opPrefix, op, regOp1, regOp2, arg, W, extrabytes, L);
 }
 
 void XEmitter::WriteAVXOp4(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg,
@@ -2917,6 +2925,49 @@ void XEmitter::VPXOR(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)
   WriteAVXOp(0x66, 0xEF, regOp1, regOp2, arg);
 }
 
+void XEmitter::VZEROUPPER()
+{
+  if (!cpu_info.bAVX)
+    PanicAlert("Trying to use AVX on a system that doesn't support it. Bad programmer.");
+  Write8(0xC5);
+  Write8(0xF8);
+  Write8(0x77);
+}
+
+void XEmitter::VMULPS_256(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)
+{
+  WriteAVXOp(0x00, sseMUL, regOp1, regOp2, arg, 0, 0, 1);
+}
+void XEmitter::VCVTDQ2PS_256(X64Reg regOp1, const OpArg& arg)
+{
+  WriteAVXOp(0x00, 0x5B, regOp1, INVALID_REG, arg, 0, 0, 1);
+}
+void XEmitter::VPSHUFB_256(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)
+{
+  WriteAVX2Op(0x66, 0x3800, regOp1, regOp2, arg, 0, 0, 1);
+}
+void XEmitter::VPSRAD_256(X64Reg regOp1, X64Reg regOp2, u8 shift)
+{
+  WriteAVX2Op(0x66, 0x72, (X64Reg)4, regOp1, R(regOp2), 0, 1, 1);
+  Write8(shift);
+}
+void XEmitter::VBROADCASTI128(X64Reg regOp1, const OpArg& arg)
+{
+  if (arg.IsSimpleReg())
+    PanicAlert("VBROADCASTI128 can't use a register source");
+  WriteAVX2Op(0x66, 0x385A, regOp1, INVALID_REG, arg, 0, 0, 1);
+}
+void XEmitter::VINSERTI128(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 lane)
+{
+  WriteAVX2Op(0x66, 0x3A38, regOp1, regOp2, arg, 0, 1, 1);
+  Write8(lane);
+}
+void XEmitter::VEXTRACTI128(const OpArg& arg, X64Reg regOp1, u8 lane)
+{
+  WriteAVX2Op(0x66, 0x3A39, regOp1, INVALID_REG, arg, 0, 1, 1);
+  Write8(lane);
+}
+
 void XEmitter::VFMADD132PS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)
 {
   WriteFMA3Op(0x98, regOp1, regOp2, arg);
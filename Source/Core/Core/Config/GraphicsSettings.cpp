@@ -84,6 +84,10 @@ const ConfigInfo<int> GFX_SHADER_COMPILER_THREADS{
     {System::GFX, "Settings", "ShaderCompilerThreads"}, 1};
 const ConfigInfo<int> GFX_SHADER_PRECOMPILER_THREADS{
     {System::GFX, "Settings", "ShaderPrecompilerThreads"}, 1};
+const ConfigInfo<bool> GFX_PIPELINED_COMMAND_DECODING{
+    {System::GFX, "Settings", "PipelinedCommandDecoding"}, false};
+const ConfigInfo<bool> GFX_CACHE_DISPLAY_LISTS{{System::GFX, "Settings", "CacheDisplayLists"},
+                                               false};
 
 const ConfigInfo<bool> GFX_SW_ZCOMPLOC{{System::GFX, "Settings", "SWZComploc"}, true};
 const ConfigInfo<bool> GFX_SW_ZFREEZE{{System::GFX, "Settings", "SWZFreeze"}, true};
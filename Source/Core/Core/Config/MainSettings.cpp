@@ -103,6 +103,11 @@ const ConfigInfo<u32> MAIN_CUSTOM_RTC_VALUE{{System::Main, "Core", "CustomRTCVal
 const ConfigInfo<bool> MAIN_ENABLE_SIGNATURE_CHECKS{{System::Main, "Core", "EnableSignatureChecks"},
                                                     true};
 const ConfigInfo<bool> MAIN_REDUCE_POLLING_RATE{{System::Main, "Core", "ReducePollingRate"}, false};
+const ConfigInfo<bool> MAIN_REWIND_ENABLE{{System::Main, "Core", "EnableRewind"}, false};
+// In frames
+const ConfigInfo<int> MAIN_REWIND_FREQUENCY{{System::Main, "Core", "RewindFrequency"}, 30};
+// In MiB
+const ConfigInfo<int> MAIN_REWIND_BUFFER_SIZE{{System::Main, "Core", "RewindBufferSize"}, 512};
 
 // Main.DSP
 
@@ -77,6 +77,9 @@ extern const ConfigInfo<bool> MAIN_CUSTOM_RTC_ENABLE;
 extern const ConfigInfo<u32> MAIN_CUSTOM_RTC_VALUE;
 extern const ConfigInfo<bool> MAIN_ENABLE_SIGNATURE_CHECKS;
 extern const ConfigInfo<bool> MAIN_REDUCE_POLLING_RATE;
+extern const ConfigInfo<bool> MAIN_REWIND_ENABLE;
+extern const ConfigInfo<int> MAIN_REWIND_FREQUENCY;
+extern const ConfigInfo<int> MAIN_REWIND_BUFFER_SIZE;
 
 // Main.DSP
 
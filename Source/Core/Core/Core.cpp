@@ -765,6 +765,7 @@ void Callback_VideoCopiedToXFB(bool video_update)
     s_drawn_frame++;
 
   Movie::FrameUpdate();
+  ::State::RewindFrameUpdate();
 
   if (s_frame_step)
   {
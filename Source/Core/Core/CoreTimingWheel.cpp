@@ -0,0 +1,277 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/CoreTimingWheel.h"
+
+#include <algorithm>
+
+#include "Common/BitSet.h"
+#include "Common/MathUtil.h"
+
+namespace CoreTiming
+{
+TimingWheel::Handle TimingWheel::Insert(const Event& event)
+{
+  Handle handle = m_free;
+  if (handle != INVALID_HANDLE)
+  {
+    m_free = m_nodes[handle].next;
+  }
+  else
+  {
+    handle = static_cast<Handle>(m_nodes.size());
+    m_nodes.emplace_back();
+  }
+
+  Node& node = m_nodes[handle];
+  node.event = event;
+  Place(handle);
+  if (m_front != INVALID_HANDLE && event < m_nodes[m_front].event)
+    m_front = handle;
+
+  if (event.type->index >= m_type_heads.size())
+    m_type_heads.resize(event.type->index + 1, INVALID_HANDLE);
+  Handle& type_head = m_type_heads[event.type->index];
+  node.type_prev = INVALID_HANDLE;
+  node.type_next = type_head;
+  if (type_head != INVALID_HANDLE)
+    m_nodes[type_head].type_prev = handle;
+  type_head = handle;
+
+  m_size++;
+  return handle;
+}
+
+void TimingWheel::Remove(Handle handle)
+{
+  Node& node = m_nodes[handle];
+  if (node.type_prev != INVALID_HANDLE)
+    m_nodes[node.type_prev].type_next = node.type_next;
+  else
+    m_type_heads[node.event.type->index] = node.type_next;
+  if (node.type_next != INVALID_HANDLE)
+    m_nodes[node.type_next].type_prev = node.type_prev;
+
+  if (handle == m_front)
+    m_front = INVALID_HANDLE;
+  Unlink(handle);
+  Free(handle);
+}
+
+void TimingWheel::RemoveAll(const EventType* type)
+{
+  // PowerPC::Reset removes the decrementer event before SystemTimers registers its type.
+  if (!type || type->index >= m_type_heads.size())
+    return;
+
+  Handle handle = m_type_heads[type->index];
+  m_type_heads[type->index] = INVALID_HANDLE;
+  while (handle != INVALID_HANDLE)
+  {
+    const Handle next = m_nodes[handle].type_next;
+    if (handle == m_front)
+      m_front = INVALID_HANDLE;
+    Unlink(handle);
+    Free(handle);
+    handle = next;
+  }
+}
+
+const Event* TimingWheel::GetFront(s64 now)
+{
+  const Handle handle = FindFront(now);
+  return handle != INVALID_HANDLE ? &m_nodes[handle].event : nullptr;
+}
+
+bool TimingWheel::PopDue(s64 now, Event* event)
+{
+  const Handle handle = FindFront(now);
+  if (handle == INVALID_HANDLE || m_nodes[handle].event.time > now)
+    return false;
+
+  *event = m_nodes[handle].event;
+  Remove(handle);
+  return true;
+}
+
+void TimingWheel::Clear(s64 now)
+{
+  m_nodes.clear();
+  m_free = INVALID_HANDLE;
+  m_front = INVALID_HANDLE;
+  m_size = 0;
+  m_wheel_time = now;
+  for (auto& level : m_slots)
+    level.fill({});
+  m_slot_masks.fill(0);
+  m_level_mask = 0;
+  m_past = {};
+  m_type_heads.clear();
+}
+
+std::vector<Event> TimingWheel::GetEvents() const
+{
+  std::vector<Event> events;
+  events.reserve(m_size);
+  for (const Handle type_head : m_type_heads)
+  {
+    for (Handle handle = type_head; handle != INVALID_HANDLE;
+         handle = m_nodes[handle].type_next)
+    {
+      events.push_back(m_nodes[handle].event);
+    }
+  }
+  std::sort(events.begin(), events.end());
+  return events;
+}
+
+TimingWheel::Handle TimingWheel::FindFront(s64 now)
+{
+  if (m_front == INVALID_HANDLE)
+    m_front = SearchFront(now);
+  return m_front;
+}
+
+TimingWheel::Handle TimingWheel::SearchFront(s64 now)
+{
+  // Events in the past are earlier than anything on the wheel.
+  if (m_past.head != INVALID_HANDLE)
+    return m_past.head;
+
+  while (m_level_mask != 0)
+  {
+    const u32 level = Common::LeastSignificantSetBit(m_level_mask);
+    const u32 slot = Common::LeastSignificantSetBit(m_slot_masks[level]);
+    List& list = m_slots[level][slot];
+    if (level == 0)
+      return list.head;
+
+    const s64 slot_start = GetSlotStart(level, slot);
+    if (slot_start > now)
+    {
+      // Moving the wheel past now would make events scheduled before the slot fall into the
+      // past, so look for the earliest event in it instead.
+      Handle front = list.head;
+      for (Handle handle = m_nodes[front].next; handle != INVALID_HANDLE;
+           handle = m_nodes[handle].next)
+      {
+        if (m_nodes[handle].event < m_nodes[front].event)
+          front = handle;
+      }
+      return front;
+    }
+
+    // Nothing is left before the slot, so move the wheel to it and spread it over the lower
+    // levels.
+    m_wheel_time = slot_start;
+    Handle handle = list.head;
+    list = {};
+    m_slot_masks[level] &= ~(1ULL << slot);
+    if (m_slot_masks[level] == 0)
+      m_level_mask &= ~(1U << level);
+    while (handle != INVALID_HANDLE)
+    {
+      const Handle next = m_nodes[handle].next;
+      Place(handle);
+      handle = next;
+    }
+  }
+
+  return INVALID_HANDLE;
+}
+
+s64 TimingWheel::GetSlotStart(u32 level, u32 slot) const
+{
+  const u32 shift = level * SLOT_BITS;
+  const u64 window_mask = shift + SLOT_BITS >= 64 ? 0 : ~0ULL << (shift + SLOT_BITS);
+  return static_cast<s64>((static_cast<u64>(m_wheel_time) & window_mask) |
+                          (static_cast<u64>(slot) << shift));
+}
+
+void TimingWheel::Place(Handle handle)
+{
+  Node& node = m_nodes[handle];
+  if (node.event.time < m_wheel_time)
+  {
+    node.level = PAST_LEVEL;
+    InsertSorted(&m_past, handle);
+    return;
+  }
+
+  const u64 time = static_cast<u64>(node.event.time);
+  const u64 difference = time ^ static_cast<u64>(m_wheel_time);
+  const u32 level = difference != 0 ? IntLog2(difference) / SLOT_BITS : 0;
+  const u32 slot = (time >> (level * SLOT_BITS)) & (NUM_SLOTS - 1);
+  node.level = static_cast<u8>(level);
+  node.slot = static_cast<u8>(slot);
+
+  List& list = m_slots[level][slot];
+  if (level == 0)
+  {
+    // All events in a level 0 slot have the same time, so they only need to be kept in FIFO
+    // order, and only events moved down from the levels above can be out of order.
+    InsertSorted(&list, handle);
+  }
+  else
+  {
+    node.prev = list.tail;
+    node.next = INVALID_HANDLE;
+    if (list.tail != INVALID_HANDLE)
+      m_nodes[list.tail].next = handle;
+    else
+      list.head = handle;
+    list.tail = handle;
+  }
+  m_slot_masks[level] |= 1ULL << slot;
+  m_level_mask |= 1U << level;
+}
+
+void TimingWheel::InsertSorted(List* list, Handle handle)
+{
+  Node& node = m_nodes[handle];
+  Handle prev = list->tail;
+  while (prev != INVALID_HANDLE && node.event < m_nodes[prev].event)
+    prev = m_nodes[prev].prev;
+
+  node.prev = prev;
+  node.next = prev != INVALID_HANDLE ? m_nodes[prev].next : list->head;
+  if (prev != INVALID_HANDLE)
+    m_nodes[prev].next = handle;
+  else
+    list->head = handle;
+  if (node.next != INVALID_HANDLE)
+    m_nodes[node.next].prev = handle;
+  else
+    list->tail = handle;
+}
+
+void TimingWheel::Unlink(Handle handle)
+{
+  const Node& node = m_nodes[handle];
+  const bool past = node.level == PAST_LEVEL;
+  List& list = past ? m_past : m_slots[node.level][node.slot];
+  if (node.prev != INVALID_HANDLE)
+    m_nodes[node.prev].next = node.next;
+  else
+    list.head = node.next;
+  if (node.next != INVALID_HANDLE)
+    m_nodes[node.next].prev = node.prev;
+  else
+    list.tail = node.prev;
+
+  if (!past && list.head == INVALID_HANDLE)
+  {
+    m_slot_masks[node.level] &= ~(1ULL << node.slot);
+    if (m_slot_masks[node.level] == 0)
+      m_level_mask &= ~(1U << node.level);
+  }
+}
+
+void TimingWheel::Free(Handle handle)
+{
+  m_nodes[handle].next = m_free;
+  m_free = handle;
+  m_size--;
+}
+}  // namespace CoreTiming
@@ -0,0 +1,130 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/CoreTiming.h"
+
+namespace CoreTiming
+{
+struct EventType
+{
+  TimedCallback callback;
+  const std::string* name;
+  // The order in which the type was registered.
+  u32 index;
+};
+
+struct Event
+{
+  s64 time;
+  u64 fifo_order;
+  u64 userdata;
+  EventType* type;
+};
+
+// Sort by time, unless the times are the same, in which case sort by the order added to the queue
+inline bool operator>(const Event& left, const Event& right)
+{
+  return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
+}
+inline bool operator<(const Event& left, const Event& right)
+{
+  return std::tie(left.time, left.fifo_order) < std::tie(right.time, right.fifo_order);
+}
+
+// The pending events, in a hierarchical timing wheel.
+//
+// Each level has 64 slots. An event is filed under the lowest level whose slot width still covers
+// the highest bit in which its time differs from the wheel's position, so level 0 slots hold
+// events of a single cycle, and all events on a level are earlier than those on the levels above
+// it. Finding the earliest event is a couple of bit scans. When a slot above level 0 comes up, the
+// wheel moves to its start and its events are spread over the lower levels; an event can only
+// move down a level this way, which keeps inserting and removing O(1) apart from those rare moves.
+//
+// The wheel never moves past the time passed to GetFront/PopDue, so events scheduled at or after
+// the current time always land in a slot. Ones scheduled into the past are kept in a sorted list.
+class TimingWheel
+{
+public:
+  using Handle = u32;
+  static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+  TimingWheel() { Clear(0); }
+
+  // Adds an event. The handle stays valid until the event is popped or removed.
+  Handle Insert(const Event& event);
+  void Remove(Handle handle);
+  // Removes all events of a type, in time proportional to their number.
+  void RemoveAll(const EventType* type);
+
+  // Returns the earliest event, or nullptr if there is none. now must be the current time, and
+  // must not go backwards between calls.
+  const Event* GetFront(s64 now);
+  // Pops the earliest event if it is due at now.
+  bool PopDue(s64 now, Event* event);
+
+  // Removes all events, and moves the wheel to now.
+  void Clear(s64 now);
+
+  bool Empty() const { return m_size == 0; }
+  size_t Size() const { return m_size; }
+  // Returns the events sorted by time and order of insertion.
+  std::vector<Event> GetEvents() const;
+
+private:
+  static constexpr u32 SLOT_BITS = 6;
+  static constexpr u32 NUM_SLOTS = 1 << SLOT_BITS;
+  static constexpr u32 NUM_LEVELS = (64 + SLOT_BITS - 1) / SLOT_BITS;
+  static constexpr u8 PAST_LEVEL = 0xFF;
+
+  struct Node
+  {
+    Event event;
+    // Neighbours in the slot (or the free list), and among the events of the same type.
+    Handle prev;
+    Handle next;
+    Handle type_prev;
+    Handle type_next;
+    u8 level;
+    u8 slot;
+  };
+
+  struct List
+  {
+    Handle head = INVALID_HANDLE;
+    Handle tail = INVALID_HANDLE;
+  };
+
+  // The earliest event is cached until it is removed, as it doesn't change as the wheel moves.
+  Handle FindFront(s64 now);
+  Handle SearchFront(s64 now);
+  s64 GetSlotStart(u32 level, u32 slot) const;
+  void Place(Handle handle);
+  void InsertSorted(List* list, Handle handle);
+  void Unlink(Handle handle);
+  void Free(Handle handle);
+
+  std::vector<Node> m_nodes;
+  Handle m_free = INVALID_HANDLE;
+  Handle m_front = INVALID_HANDLE;
+  size_t m_size = 0;
+
+  s64 m_wheel_time = 0;
+  std::array<std::array<List, NUM_SLOTS>, NUM_LEVELS> m_slots;
+  std::array<u64, NUM_LEVELS> m_slot_masks;
+  u32 m_level_mask = 0;
+  List m_past;
+
+  // The most recently inserted event of each type, by type index.
+  std::vector<Handle> m_type_heads;
+};
+}  // namespace CoreTiming
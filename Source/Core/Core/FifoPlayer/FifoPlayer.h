@@ -58,6 +58,7 @@ class FifoPlayer
 {
 public:
   using CallbackFunc = std::function<void()>;
+  using XFBCopiedCallbackFunc = std::function<void(u32 address, u32 stride, u32 height)>;
 
   ~FifoPlayer();
 
@@ -92,9 +93,19 @@ public:
   // If enabled then all memory updates happen at once before the first frame
   // Default is disabled
   void SetEarlyMemoryUpdates(bool enabled) { m_EarlyMemoryUpdates = enabled; }
+  // If non-zero, the frame range is played this many times before emulation stops, regardless of
+  // whether looping is enabled. Default is zero
+  void SetLoopCount(u32 count) { m_LoopCount = count; }
   // Callbacks
   void SetFileLoadedCallback(CallbackFunc callback) { m_FileLoadedCb = callback; }
   void SetFrameWrittenCallback(CallbackFunc callback) { m_FrameWrittenCb = callback; }
+  // Called on the GPU thread after each EFB to XFB copy, with the copy's location in memory
+  void SetXFBCopiedCallback(XFBCopiedCallbackFunc callback) { m_XFBCopiedCb = callback; }
+  void OnXFBCopied(u32 address, u32 stride, u32 height) const
+  {
+    if (m_XFBCopiedCb)
+      m_XFBCopiedCb(address, stride, height);
+  }
   static FifoPlayer& GetInstance();
 
   bool IsRunningWithFakeVideoInterfaceUpdates() const;
@@ -139,6 +150,8 @@ private:
   static bool IsHighWatermarkSet();
 
   bool m_Loop;
+  u32 m_LoopCount = 0;
+  u32 m_LoopsPlayed = 0;
 
   u32 m_CurrentFrame = 0;
   u32 m_FrameRangeStart = 0;
@@ -155,6 +168,7 @@ private:
 
   CallbackFunc m_FileLoadedCb = nullptr;
   CallbackFunc m_FrameWrittenCb = nullptr;
+  XFBCopiedCallbackFunc m_XFBCopiedCb = nullptr;
 
   std::unique_ptr<FifoDataFile> m_File;
 
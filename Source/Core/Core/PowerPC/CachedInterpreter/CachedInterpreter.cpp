@@ -4,6 +4,7 @@
 
 #include "Core/PowerPC/CachedInterpreter/CachedInterpreter.h"
 
+#include "Common/BitUtils.h"
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Core/ConfigManager.h"
@@ -11,43 +12,428 @@
 #include "Core/HLE/HLE.h"
 #include "Core/HW/CPU.h"
 #include "Core/PowerPC/Gekko.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
 #include "Core/PowerPC/Jit64Common/Jit64Base.h"
+#include "Core/PowerPC/MMU.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PowerPC.h"
 
+// Blocks are compiled to threaded code: each entry holds the handler that runs it, which returns
+// the next entry to run. Common instructions get handlers of their own with their operands decoded
+// in advance, and common pairs of them are fused into a single handler, to save dispatches. The
+// rest call into the Interpreter.
 struct CachedInterpreter::Instruction
 {
-  using CommonCallback = void (*)(UGeckoInstruction);
-  using ConditionalCallback = bool (*)(u32);
+  // Runs the instruction, and returns the next one, or nullptr to leave the block.
+  using Handler = const Instruction* (*)(const Instruction& instruction);
 
-  Instruction() {}
-  Instruction(const CommonCallback c, UGeckoInstruction i)
-      : common_callback(c), data(i.hex), type(Type::Common)
+  Handler handler;
+  // What the operands hold depends on the handler.
+  u32 data = 0;
+  union
   {
-  }
+    struct
+    {
+      u32 imm;
+      u8 d;
+      u8 a;
+      u8 b;
+      u8 crf;
+    };
+    Interpreter::Instruction interpreter_op;
+    bool (*check)(u32 data);
+  };
+};
+
+namespace
+{
+using Instruction = CachedInterpreter::Instruction;
+using Handler = Instruction::Handler;
+
+const Instruction* Abort(const Instruction& instruction)
+{
+  return nullptr;
+}
+
+const Instruction* InterpreterOp(const Instruction& instruction)
+{
+  instruction.interpreter_op(UGeckoInstruction(instruction.data));
+  return &instruction + 1;
+}
+
+const Instruction* Check(const Instruction& instruction)
+{
+  return instruction.check(instruction.data) ? nullptr : &instruction + 1;
+}
+
+const Instruction* EndBlock(const Instruction& instruction)
+{
+  PC = NPC;
+  PowerPC::ppcState.downcount -= instruction.data;
+  return nullptr;
+}
+
+const Instruction* WritePC(const Instruction& instruction)
+{
+  PC = instruction.data;
+  NPC = instruction.data + 4;
+  return &instruction + 1;
+}
+
+const Instruction* WriteBrokenBlockNPC(const Instruction& instruction)
+{
+  NPC = instruction.data;
+  return &instruction + 1;
+}
+
+const Instruction* LoadImmediate(const Instruction& instruction)
+{
+  rGPR[instruction.d] = instruction.imm;
+  return &instruction + 1;
+}
+
+const Instruction* AddImmediate(const Instruction& instruction)
+{
+  rGPR[instruction.d] = rGPR[instruction.a] + instruction.imm;
+  return &instruction + 1;
+}
+
+const Instruction* OrImmediate(const Instruction& instruction)
+{
+  rGPR[instruction.d] = rGPR[instruction.a] | instruction.imm;
+  return &instruction + 1;
+}
+
+const Instruction* Add(const Instruction& instruction)
+{
+  rGPR[instruction.d] = rGPR[instruction.a] + rGPR[instruction.b];
+  return &instruction + 1;
+}
+
+const Instruction* Subtract(const Instruction& instruction)
+{
+  rGPR[instruction.d] = rGPR[instruction.a] - rGPR[instruction.b];
+  return &instruction + 1;
+}
+
+const Instruction* Or(const Instruction& instruction)
+{
+  rGPR[instruction.d] = rGPR[instruction.a] | rGPR[instruction.b];
+  return &instruction + 1;
+}
+
+const Instruction* And(const Instruction& instruction)
+{
+  rGPR[instruction.d] = rGPR[instruction.a] & rGPR[instruction.b];
+  return &instruction + 1;
+}
+
+// The shift is in b, and the mask in imm.
+const Instruction* RotateAndMask(const Instruction& instruction)
+{
+  rGPR[instruction.d] = Common::RotateLeft(rGPR[instruction.a], instruction.b) & instruction.imm;
+  return &instruction + 1;
+}
+
+template <typename T>
+void SetCRFieldFromCompare(u32 crf, T a, T b)
+{
+  u32 value = a < b ? 0x8 : a > b ? 0x4 : 0x2;
+  if (PowerPC::GetXER_SO())
+    value |= 0x1;
+  PowerPC::SetCRField(crf, value);
+}
+
+const Instruction* CompareImmediate(const Instruction& instruction)
+{
+  SetCRFieldFromCompare<s32>(instruction.crf, rGPR[instruction.a], instruction.imm);
+  return &instruction + 1;
+}
+
+const Instruction* CompareLogicalImmediate(const Instruction& instruction)
+{
+  SetCRFieldFromCompare<u32>(instruction.crf, rGPR[instruction.a], instruction.imm);
+  return &instruction + 1;
+}
+
+const Instruction* Compare(const Instruction& instruction)
+{
+  SetCRFieldFromCompare<s32>(instruction.crf, rGPR[instruction.a], rGPR[instruction.b]);
+  return &instruction + 1;
+}
+
+const Instruction* CompareLogical(const Instruction& instruction)
+{
+  SetCRFieldFromCompare<u32>(instruction.crf, rGPR[instruction.a], rGPR[instruction.b]);
+  return &instruction + 1;
+}
+
+template <typename T, T (*read)(u32)>
+const Instruction* Load(const Instruction& instruction)
+{
+  const u32 value = read(rGPR[instruction.a] + instruction.imm);
+  if (!(PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+    rGPR[instruction.d] = value;
+  return &instruction + 1;
+}
 
-  Instruction(const ConditionalCallback c, u32 d)
-      : conditional_callback(c), data(d), type(Type::Conditional)
+const Instruction* LoadWord(const Instruction& instruction)
+{
+  return Load<u32, PowerPC::Read_U32>(instruction);
+}
+
+const Instruction* LoadHalf(const Instruction& instruction)
+{
+  return Load<u16, PowerPC::Read_U16>(instruction);
+}
+
+const Instruction* LoadByte(const Instruction& instruction)
+{
+  return Load<u8, PowerPC::Read_U8>(instruction);
+}
+
+template <typename T, void (*write)(T, u32)>
+const Instruction* Store(const Instruction& instruction)
+{
+  write(static_cast<T>(rGPR[instruction.d]), rGPR[instruction.a] + instruction.imm);
+  return &instruction + 1;
+}
+
+// The address is in data, the target in imm, and BO, BI and LK in a, b and d.
+const Instruction* BranchConditional(const Instruction& instruction)
+{
+  const u32 bo = instruction.a;
+  if ((bo & BO_DONT_DECREMENT_FLAG) == 0)
+    CTR--;
+
+  const bool counter = ((bo >> 2) | ((CTR != 0) ^ (bo >> 1))) & 1;
+  const bool condition = ((bo >> 4) | (PowerPC::GetCRBit(instruction.b) == ((bo >> 3) & 1))) & 1;
+  if (counter && condition)
   {
+    if (instruction.d)
+      LR = instruction.data + 4;
+    NPC = instruction.imm;
   }
-
-  enum class Type
+  else
   {
-    Abort,
-    Common,
-    Conditional,
-  };
+    NPC = instruction.data + 4;
+  }
+  return &instruction + 1;
+}
 
-  union
-  {
-    const CommonCallback common_callback;
-    const ConditionalCallback conditional_callback;
-  };
+const Instruction* Branch(const Instruction& instruction)
+{
+  if (instruction.d)
+    LR = instruction.data + 4;
+  NPC = instruction.imm;
+  return &instruction + 1;
+}
 
-  u32 data = 0;
-  Type type = Type::Abort;
+// Runs two instructions with a single dispatch. The first one must not leave the block.
+template <Handler first, Handler second>
+const Instruction* Fused(const Instruction& instruction)
+{
+  return second(*first(instruction));
+}
+
+struct Fusion
+{
+  Handler first;
+  Handler second;
+  Handler fused;
 };
 
+template <Handler first, Handler second>
+constexpr Fusion Fuse()
+{
+  return {first, second, Fused<first, second>};
+}
+
+template <Handler first, Handler second, Handler third>
+constexpr Fusion Fuse()
+{
+  return {Fused<first, second>, third, Fused<Fused<first, second>, third>};
+}
+
+// Common pairs of instructions: compares and the branches that use them, loads and the
+// instructions that use the loaded values, and chains of rotates.
+constexpr Fusion FUSIONS[] = {
+    Fuse<Compare, BranchConditional>(),
+    Fuse<CompareLogical, BranchConditional>(),
+    Fuse<CompareImmediate, BranchConditional>(),
+    Fuse<CompareLogicalImmediate, BranchConditional>(),
+    Fuse<Compare, BranchConditional, EndBlock>(),
+    Fuse<CompareLogical, BranchConditional, EndBlock>(),
+    Fuse<CompareImmediate, BranchConditional, EndBlock>(),
+    Fuse<CompareLogicalImmediate, BranchConditional, EndBlock>(),
+    Fuse<BranchConditional, EndBlock>(),
+    Fuse<Branch, EndBlock>(),
+
+    Fuse<LoadWord, CompareImmediate>(),
+    Fuse<LoadWord, CompareLogicalImmediate>(),
+    Fuse<LoadWord, RotateAndMask>(),
+    Fuse<LoadWord, AddImmediate>(),
+    Fuse<LoadWord, Add>(),
+    Fuse<LoadHalf, CompareImmediate>(),
+    Fuse<LoadHalf, CompareLogicalImmediate>(),
+    Fuse<LoadHalf, RotateAndMask>(),
+    Fuse<LoadHalf, AddImmediate>(),
+    Fuse<LoadHalf, Add>(),
+    Fuse<LoadByte, CompareImmediate>(),
+    Fuse<LoadByte, CompareLogicalImmediate>(),
+    Fuse<LoadByte, RotateAndMask>(),
+    Fuse<LoadByte, AddImmediate>(),
+    Fuse<LoadByte, Add>(),
+
+    Fuse<RotateAndMask, RotateAndMask>(),
+    Fuse<RotateAndMask, Add>(),
+    Fuse<RotateAndMask, Or>(),
+    Fuse<RotateAndMask, CompareLogicalImmediate>(),
+};
+
+Instruction MakeInstruction(Handler handler, u32 data = 0)
+{
+  Instruction instruction;
+  instruction.handler = handler;
+  instruction.data = data;
+  instruction.imm = 0;
+  instruction.d = instruction.a = instruction.b = instruction.crf = 0;
+  return instruction;
+}
+
+Instruction MakeInterpreterOp(Interpreter::Instruction op, u32 data)
+{
+  Instruction instruction = MakeInstruction(InterpreterOp, data);
+  instruction.interpreter_op = op;
+  return instruction;
+}
+
+Instruction MakeCheck(bool (*check)(u32), u32 data)
+{
+  Instruction instruction = MakeInstruction(Check, data);
+  instruction.check = check;
+  return instruction;
+}
+
+Instruction MakeOperands(Handler handler, u32 d, u32 a, u32 b, u32 imm)
+{
+  Instruction instruction = MakeInstruction(handler);
+  instruction.d = static_cast<u8>(d);
+  instruction.a = static_cast<u8>(a);
+  instruction.b = static_cast<u8>(b);
+  instruction.imm = imm;
+  return instruction;
+}
+// Decodes the instructions that have handlers of their own.
+bool DecodeInstruction(const PPCAnalyst::CodeOp& op, Instruction* instruction)
+{
+  const UGeckoInstruction inst = op.inst;
+  const u32 simm = static_cast<u32>(SignExt16(inst.SIMM_16));
+  switch (inst.OPCD)
+  {
+  case 14:  // addi
+  case 15:  // addis
+  {
+    const u32 imm = inst.OPCD == 15 ? simm << 16 : simm;
+    *instruction = MakeOperands(inst.RA ? AddImmediate : LoadImmediate, inst.RD, inst.RA, 0, imm);
+    return true;
+  }
+  case 24:  // ori
+  case 25:  // oris
+    *instruction = MakeOperands(OrImmediate, inst.RA, inst.RS, 0,
+                                inst.OPCD == 25 ? inst.UIMM << 16 : inst.UIMM);
+    return true;
+  case 21:  // rlwinmx
+    if (inst.Rc)
+      return false;
+    *instruction =
+        MakeOperands(RotateAndMask, inst.RA, inst.RS, inst.SH, MakeRotationMask(inst.MB, inst.ME));
+    return true;
+  case 11:  // cmpi
+  case 10:  // cmpli
+  {
+    *instruction =
+        MakeOperands(inst.OPCD == 11 ? CompareImmediate : CompareLogicalImmediate, 0, inst.RA, 0,
+                     inst.OPCD == 11 ? simm : inst.UIMM);
+    instruction->crf = static_cast<u8>(inst.CRFD);
+    return true;
+  }
+  case 32:  // lwz
+  case 40:  // lhz
+  case 34:  // lbz
+  {
+    if (!inst.RA)
+      return false;
+    const Handler load = inst.OPCD == 32 ? LoadWord : inst.OPCD == 40 ? LoadHalf : LoadByte;
+    *instruction = MakeOperands(load, inst.RD, inst.RA, 0, simm);
+    return true;
+  }
+  case 36:  // stw
+  case 44:  // sth
+  case 38:  // stb
+  {
+    if (!inst.RA)
+      return false;
+    Handler store = Store<u8, PowerPC::Write_U8>;
+    if (inst.OPCD == 36)
+      store = Store<u32, PowerPC::Write_U32>;
+    else if (inst.OPCD == 44)
+      store = Store<u16, PowerPC::Write_U16>;
+    *instruction = MakeOperands(store, inst.RS, inst.RA, 0, simm);
+    return true;
+  }
+  case 16:  // bcx
+  {
+    // The Interpreter looks for this idle loop, so leave it to it.
+    if (inst.hex == 0x4182fff8)
+      return false;
+    const u32 target = SignExt16(inst.BD << 2) + (inst.AA ? 0 : op.address);
+    *instruction = MakeOperands(BranchConditional, inst.LK, inst.BO, inst.BI, target);
+    instruction->data = op.address;
+    return true;
+  }
+  case 18:  // bx
+  {
+    const u32 target = SignExt26(inst.LI << 2) + (inst.AA ? 0 : op.address);
+    // Branches to themselves idle, which is left to the Interpreter too.
+    if (target == op.address)
+      return false;
+    *instruction = MakeOperands(Branch, inst.LK, 0, 0, target);
+    instruction->data = op.address;
+    return true;
+  }
+  case 31:
+    if (inst.Rc)
+      return false;
+    switch (inst.SUBOP10)
+    {
+    case 0:   // cmp
+    case 32:  // cmpl
+    {
+      *instruction =
+          MakeOperands(inst.SUBOP10 == 0 ? Compare : CompareLogical, 0, inst.RA, inst.RB, 0);
+      instruction->crf = static_cast<u8>(inst.CRFD);
+      return true;
+    }
+    case 266:  // addx without OE
+      *instruction = MakeOperands(Add, inst.RD, inst.RA, inst.RB, 0);
+      return true;
+    case 40:  // subfx without OE
+      *instruction = MakeOperands(Subtract, inst.RD, inst.RB, inst.RA, 0);
+      return true;
+    case 444:  // orx
+      *instruction = MakeOperands(Or, inst.RA, inst.RS, inst.RB, 0);
+      return true;
+    case 28:  // andx
+      *instruction = MakeOperands(And, inst.RA, inst.RS, inst.RB, 0);
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+}  // Anonymous namespace
+
 CachedInterpreter::CachedInterpreter() = default;
 
 CachedInterpreter::~CachedInterpreter() = default;
@@ -86,25 +472,8 @@ void CachedInterpreter::ExecuteOneBlock()
   }
 
   const Instruction* code = reinterpret_cast<const Instruction*>(normal_entry);
-
-  for (; code->type != Instruction::Type::Abort; ++code)
-  {
-    switch (code->type)
-    {
-    case Instruction::Type::Common:
-      code->common_callback(UGeckoInstruction(code->data));
-      break;
-
-    case Instruction::Type::Conditional:
-      if (code->conditional_callback(code->data))
-        return;
-      break;
-
-    default:
-      ERROR_LOG(POWERPC, "Unknown CachedInterpreter Instruction: %d", static_cast<int>(code->type));
-      break;
-    }
-  }
+  while (code)
+    code = code->handler(*code);
 }
 
 void CachedInterpreter::Run()
@@ -130,23 +499,6 @@ void CachedInterpreter::SingleStep()
   ExecuteOneBlock();
 }
 
-static void EndBlock(UGeckoInstruction data)
-{
-  PC = NPC;
-  PowerPC::ppcState.downcount -= data.hex;
-}
-
-static void WritePC(UGeckoInstruction data)
-{
-  PC = data.hex;
-  NPC = data.hex + 4;
-}
-
-static void WriteBrokenBlockNPC(UGeckoInstruction data)
-{
-  NPC = data.hex;
-}
-
 static bool CheckFPU(u32 data)
 {
   if (!MSR.FP)
@@ -184,18 +536,38 @@ static bool CheckBreakpoint(u32 data)
 bool CachedInterpreter::HandleFunctionHooking(u32 address)
 {
   return HLE::ReplaceFunctionIfPossible(address, [&](u32 function, HLE::HookType type) {
-    m_code.emplace_back(WritePC, address);
-    m_code.emplace_back(Interpreter::HLEFunction, function);
+    Emit(MakeInstruction(WritePC, address));
+    Emit(MakeInterpreterOp(Interpreter::HLEFunction, function));
 
     if (type != HLE::HookType::Replace)
       return false;
 
-    m_code.emplace_back(EndBlock, js.downcountAmount);
-    m_code.emplace_back();
+    Emit(MakeInstruction(EndBlock, js.downcountAmount));
+    Emit(MakeInstruction(Abort));
     return true;
   });
 }
 
+void CachedInterpreter::Emit(const Instruction& instruction)
+{
+  if (m_fusion_head < m_code.size())
+  {
+    Instruction& head = m_code[m_fusion_head];
+    for (const Fusion& fusion : FUSIONS)
+    {
+      if (fusion.first == head.handler && fusion.second == instruction.handler)
+      {
+        head.handler = fusion.fused;
+        m_code.push_back(instruction);
+        return;
+      }
+    }
+  }
+
+  m_fusion_head = m_code.size();
+  m_code.push_back(instruction);
+}
+
 void CachedInterpreter::Jit(u32 address)
 {
   if (m_code.size() >= CODE_SIZE / sizeof(Instruction) - 0x1000 ||
@@ -225,6 +597,8 @@ void CachedInterpreter::Jit(u32 address)
 
   b->checkedEntry = GetCodePtr();
   b->normalEntry = GetCodePtr();
+  // Nothing before the block may be fused with its first instruction.
+  m_fusion_head = m_code.size();
 
   for (u32 i = 0; i < code_block.m_num_instructions; i++)
   {
@@ -245,32 +619,37 @@ void CachedInterpreter::Jit(u32 address)
 
       if (breakpoint)
       {
-        m_code.emplace_back(WritePC, op.address);
-        m_code.emplace_back(CheckBreakpoint, js.downcountAmount);
+        Emit(MakeInstruction(WritePC, op.address));
+        Emit(MakeCheck(CheckBreakpoint, js.downcountAmount));
       }
 
       if (check_fpu)
       {
-        m_code.emplace_back(WritePC, op.address);
-        m_code.emplace_back(CheckFPU, js.downcountAmount);
+        Emit(MakeInstruction(WritePC, op.address));
+        Emit(MakeCheck(CheckFPU, js.downcountAmount));
         js.firstFPInstructionFound = true;
       }
 
-      if (endblock || memcheck)
-        m_code.emplace_back(WritePC, op.address);
-      m_code.emplace_back(PPCTables::GetInterpreterOp(op.inst), op.inst);
+      // The handlers of their own that branches have don't need the PC.
+      Instruction instruction;
+      const bool decoded = DecodeInstruction(op, &instruction);
+      if ((endblock && !decoded) || memcheck)
+        Emit(MakeInstruction(WritePC, op.address));
+      if (!decoded)
+        instruction = MakeInterpreterOp(PPCTables::GetInterpreterOp(op.inst), op.inst.hex);
+      Emit(instruction);
       if (memcheck)
-        m_code.emplace_back(CheckDSI, js.downcountAmount);
+        Emit(MakeCheck(CheckDSI, js.downcountAmount));
       if (endblock)
-        m_code.emplace_back(EndBlock, js.downcountAmount);
+        Emit(MakeInstruction(EndBlock, js.downcountAmount));
     }
   }
   if (code_block.m_broken)
   {
-    m_code.emplace_back(WriteBrokenBlockNPC, nextPC);
-    m_code.emplace_back(EndBlock, js.downcountAmount);
+    Emit(MakeInstruction(WriteBrokenBlockNPC, nextPC));
+    Emit(MakeInstruction(EndBlock, js.downcountAmount));
   }
-  m_code.emplace_back();
+  Emit(MakeInstruction(Abort));
 
   b->codeSize = (u32)(GetCodePtr() - b->checkedEntry);
   b->originalSize = code_block.m_num_instructions;
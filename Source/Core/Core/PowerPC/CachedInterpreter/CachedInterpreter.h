@@ -32,14 +32,18 @@ public:
   const char* GetName() const override { return "Cached Interpreter"; }
   const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
 
-private:
+  // An entry of the threaded code that blocks are compiled to.
   struct Instruction;
 
+private:
   u8* GetCodePtr();
   void ExecuteOneBlock();
 
   bool HandleFunctionHooking(u32 address);
+  void Emit(const Instruction& instruction);
 
   BlockCache m_block_cache{*this};
   std::vector<Instruction> m_code;
+  // The entry that runs the last one emitted, which may be an earlier one it was fused into.
+  size_t m_fusion_head = 0;
 };
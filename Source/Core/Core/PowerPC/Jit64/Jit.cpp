@@ -4,8 +4,13 @@
 
 #include "Core/PowerPC/Jit64/Jit.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <map>
+#include <numeric>
 #include <string>
+#include <tuple>
 
 // for the PROFILER stuff
 #ifdef _WIN32
@@ -257,6 +262,12 @@ void Jit64::Init()
   m_far_code.Init();
   Clear();
 
+  m_code_regions.near_start = region;
+  m_code_regions.near_size = region_size / NUM_CODE_REGIONS;
+  m_code_regions.far_start = m_far_code.GetWritableCodePtr();
+  m_code_regions.far_size = farcode_size / NUM_CODE_REGIONS;
+  ResetCodeRegions();
+
   code_block.m_stats = &js.st;
   code_block.m_gpa = &js.gpa;
   code_block.m_fpa = &js.fpa;
@@ -272,6 +283,103 @@ void Jit64::ClearCache()
   ClearCodeSpace();
   Clear();
   UpdateMemoryOptions();
+  ResetCodeRegions();
+  m_code_cache_clears++;
+}
+
+JitInterface::CodeCacheStats Jit64::GetCodeCacheStats() const
+{
+  JitInterface::CodeCacheStats stats;
+  stats.used_bytes = m_code_used_bytes;
+  stats.total_bytes = (m_code_regions.near_size + m_code_regions.far_size) * NUM_CODE_REGIONS;
+  stats.evicted_regions = m_evicted_code_regions;
+  stats.evicted_blocks = m_evicted_blocks;
+  stats.full_clears = m_code_cache_clears;
+  return stats;
+}
+
+void Jit64::ResetCodeRegions()
+{
+  // The code pointers are at the start of the first region after the code spaces are cleared.
+  m_code_regions.current = 0;
+  m_code_regions.ages.fill(0);
+  m_code_regions.ages[0] = ++m_code_regions.last_age;
+  m_code_regions.used.fill(0);
+  UpdateCodeCacheStats();
+}
+
+bool Jit64::IsCodeRegionAlmostFull() const
+{
+  const size_t next = m_code_regions.current + 1;
+  const u8* near_end = m_code_regions.near_start + next * m_code_regions.near_size;
+  const u8* far_end = m_code_regions.far_start + next * m_code_regions.far_size;
+  // The same margin as IsAlmostFull, which has to be bigger than the biggest block.
+  return near_end - GetCodePtr() < 0x10000 || far_end - m_far_code.GetCodePtr() < 0x10000;
+}
+
+size_t Jit64::GetCodeRegionUsedBytes() const
+{
+  const CodeRegions& regions = m_code_regions;
+  const u8* near_start = regions.near_start + regions.current * regions.near_size;
+  const u8* far_start = regions.far_start + regions.current * regions.far_size;
+  return (GetCodePtr() - near_start) + (m_far_code.GetCodePtr() - far_start);
+}
+
+void Jit64::EvictCodeRegion()
+{
+  CodeRegions& regions = m_code_regions;
+  const size_t current = regions.current;
+  regions.used[current] = GetCodeRegionUsedBytes();
+
+  // Blocks that were invalidated no longer count, so regions whose code was mostly overwritten
+  // or replaced by recompiles go first. Among equally live ones, the oldest goes.
+  std::array<size_t, NUM_CODE_REGIONS> live_bytes{};
+  blocks.RunOnBlocks([&](const JitBlock& block) {
+    live_bytes[(block.checkedEntry - regions.near_start) / regions.near_size] += block.codeSize;
+  });
+  size_t victim = current == 0 ? 1 : 0;
+  for (size_t i = 0; i < NUM_CODE_REGIONS; i++)
+  {
+    if (i != current && std::tie(live_bytes[i], regions.ages[i]) <
+                            std::tie(live_bytes[victim], regions.ages[victim]))
+    {
+      victim = i;
+    }
+  }
+
+  u8* near_start = regions.near_start + victim * regions.near_size;
+  u8* far_start = regions.far_start + victim * regions.far_size;
+  if (regions.ages[victim] != 0)
+  {
+    // Erasing the blocks unlinks the ones in other regions that jump into this one. Nothing can
+    // return into it either, as the dispatcher resets the stack before compiling.
+    const size_t num_blocks = blocks.EraseHostCodeRange(near_start, near_start + regions.near_size);
+    ClearRange(near_start, near_start + regions.near_size);
+    std::memset(near_start, 0xCC, regions.near_size);
+    std::memset(far_start, 0xCC, regions.far_size);
+    m_evicted_code_regions++;
+    m_evicted_blocks += num_blocks;
+    INFO_LOG(DYNA_REC, "Evicted code region %zu with %zu live blocks (%zu bytes)", victim,
+             num_blocks, live_bytes[victim]);
+  }
+
+  SetCodePtr(near_start);
+  m_far_code.SetCodePtr(far_start);
+  regions.current = victim;
+  regions.ages[victim] = ++regions.last_age;
+  regions.used[victim] = 0;
+}
+
+void Jit64::UpdateCodeCacheStats()
+{
+  const CodeRegions& regions = m_code_regions;
+  size_t used = GetCodeRegionUsedBytes();
+  for (size_t i = 0; i < NUM_CODE_REGIONS; i++)
+  {
+    if (i != regions.current)
+      used += regions.used[i];
+  }
+  m_code_used_bytes = used;
 }
 
 void Jit64::Shutdown()
@@ -587,20 +695,24 @@ void Jit64::Jit(u32 em_address)
 #endif
   }
 
-  if (IsAlmostFull() || m_far_code.IsAlmostFull() || trampolines.IsAlmostFull() ||
-      SConfig::GetInstance().bJITNoBlockCache)
+  if (SConfig::GetInstance().bJITNoBlockCache)
   {
-    if (!SConfig::GetInstance().bJITNoBlockCache)
-    {
-      const auto reason =
-          IsAlmostFull() ? "main" : m_far_code.IsAlmostFull() ? "far" : "trampoline";
-      WARN_LOG(POWERPC, "flushing %s code cache, please report if this happens a lot", reason);
-    }
     ClearCache();
   }
+  else if (trampolines.IsAlmostFull())
+  {
+    // Trampolines aren't tracked per block, so they can only be reclaimed all at once.
+    WARN_LOG(POWERPC, "flushing trampoline code cache, please report if this happens a lot");
+    ClearCache();
+  }
+  else if (IsCodeRegionAlmostFull())
+  {
+    EvictCodeRegion();
+  }
 
   std::size_t block_size = m_code_buffer.size();
 
+  m_baseline_compile = false;
   if (SConfig::GetInstance().bEnableDebugging)
   {
     // We can link blocks as long as we are not single stepping and there are no breakpoints here
@@ -625,6 +737,20 @@ void Jit64::Jit(u32 em_address)
       Trace();
     }
   }
+  else
+  {
+    // New blocks get a baseline compile, which neither follows branches nor continues past
+    // conditional ones. That keeps code which only runs a few times, e.g. while booting, quick to
+    // compile and small. Blocks that turn out to be hot are compiled again with everything.
+    EnableOptimization();
+    m_baseline_compile = js.hotBlockAddresses.find(em_address) == js.hotBlockAddresses.end() &&
+                         js.hotLoopAddresses.find(em_address) == js.hotLoopAddresses.end();
+    if (m_baseline_compile)
+    {
+      analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+      analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+    }
+  }
 
   // Analyze the block, collect all instructions it is made of (including inlining,
   // if that is enabled), reorder instructions for optimal performance, and join joinable
@@ -644,8 +770,19 @@ void Jit64::Jit(u32 em_address)
   JitBlock* b = blocks.AllocateBlock(em_address);
   DoJit(em_address, b, nextPC);
   blocks.FinalizeBlock(*b, jo.enableBlocklink, code_block.m_physical_addresses);
+  UpdateCodeCacheStats();
 }
 
+// The number of times a baseline block has to run before it is compiled with all optimizations.
+constexpr u32 HOT_BLOCK_RUNS = 100;
+// The number of times a block has to branch back to its start before it is recompiled as a hot
+// loop.
+constexpr u32 HOT_LOOP_ITERATIONS = 1000;
+// The number of registers bound across the iterations of a hot loop, leaving the others for
+// temporaries.
+constexpr size_t MAX_LOOP_GPRS = 8;
+constexpr size_t MAX_LOOP_FPRS = 8;
+
 u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
 {
   js.firstFPInstructionFound = false;
@@ -657,6 +794,9 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
   js.numLoadStoreInst = 0;
   js.numFloatingPointInst = 0;
 
+  AnalyzeLoop();
+  b->loop_countdown = HOT_LOOP_ITERATIONS;
+
   // TODO: Test if this or AlignCode16 make a difference from GetCodePtr
   u8* const start = AlignCode4();
   b->checkedEntry = start;
@@ -671,6 +811,24 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
   u8* const normal_entry = GetWritableCodePtr();
   b->normalEntry = normal_entry;
 
+  if (m_baseline_compile)
+  {
+    b->run_countdown = HOT_BLOCK_RUNS;
+    MOV(64, R(RSCRATCH), ImmPtr(&b->run_countdown));
+    SUB(32, MatR(RSCRATCH), Imm8(1));
+    FixupBranch hot = J_CC(CC_Z, true);
+
+    SwitchToFarCode();
+    SetJumpTarget(hot);
+    MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunctionC(JitInterface::CompileExceptionCheck,
+                      static_cast<u32>(JitInterface::ExceptionType::HotBlock));
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    JMP(asm_routines.dispatcher_no_check, true);
+    SwitchToNearCode();
+  }
+
   // Used to get a trace of the last few blocks before a crash, sometimes VERY useful
   if (ImHereDebug)
   {
@@ -743,6 +901,9 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
     IntializeSpeculativeConstants();
   }
 
+  if (m_loop.hot)
+    BindLoopRegisters();
+
   // Translate instructions
   for (u32 i = 0; i < code_block.m_num_instructions; i++)
   {
@@ -922,9 +1083,9 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
       }
 
       // If we have a register that will never be used again, flush it.
-      for (int j : ~op.gprInUse)
+      for (int j : ~op.gprInUse & ~GetLoopGPRs())
         gpr.StoreFromRegister(j);
-      for (int j : ~op.fprInUse)
+      for (int j : ~op.fprInUse & ~GetLoopFPRs())
         fpr.StoreFromRegister(j);
 
       if (opinfo->flags & FL_LOADSTORE)
@@ -1005,7 +1166,8 @@ void Jit64::IntializeSpeculativeConstants()
   // Insert a check at the start of the block to verify that the value is actually constant.
   // This can save a lot of backpatching and optimize gather pipe writes in more places.
   const u8* target = nullptr;
-  for (auto i : code_block.m_gpr_inputs)
+  // A constant has to hold for every iteration of a loop.
+  for (auto i : code_block.m_gpr_inputs & ~m_loop.gprs_written)
   {
     u32 compileTimeValue = PowerPC::ppcState.gpr[i];
     if (PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue) ||
@@ -1031,6 +1193,167 @@ void Jit64::IntializeSpeculativeConstants()
   }
 }
 
+static bool BranchesTo(UGeckoInstruction inst, u32 address, u32 target)
+{
+  if (inst.OPCD != 16 || inst.LK)
+    return false;
+  return SignExt16(inst.BD << 2) + (inst.AA ? 0 : address) == target;
+}
+
+void Jit64::AnalyzeLoop()
+{
+  m_loop = {};
+
+  // Looping within the block stands in for linking it to itself, and would hide the iterations
+  // from the profiler and the performance monitor.
+  if (!jo.enableBlocklink || jo.profile_blocks || MMCR0.Hex || MMCR1.Hex)
+    return;
+
+  m_loop.end = static_cast<int>(code_block.m_num_instructions) - 1;
+  while (m_loop.end >= 0 && !BranchesTo(m_code_buffer[m_loop.end].inst,
+                                         m_code_buffer[m_loop.end].address, js.blockStart))
+  {
+    m_loop.end--;
+  }
+
+  for (int i = 0; i <= m_loop.end; i++)
+  {
+    const PPCAnalyst::CodeOp& op = m_code_buffer[i];
+    // Inlined calls that don't return within the block push to the stack on every iteration.
+    if (op.opinfo->type == OpType::Branch && op.inst.LK && !op.skipLRStack)
+    {
+      m_loop.end = -1;
+      return;
+    }
+    m_loop.gprs_written |= op.regsOut;
+  }
+
+  m_loop.hot = m_loop.end >= 0 &&
+               js.hotLoopAddresses.find(js.blockStart) != js.hotLoopAddresses.end();
+  if (!m_loop.hot)
+    m_loop.gprs_written = BitSet32{};
+}
+
+void Jit64::BindLoopRegisters()
+{
+  std::array<int, 32> gpr_uses{};
+  std::array<int, 32> fpr_uses{};
+  for (int i = 0; i <= m_loop.end; i++)
+  {
+    const PPCAnalyst::CodeOp& op = m_code_buffer[i];
+    for (int reg : op.regsIn | op.regsOut)
+      gpr_uses[reg]++;
+    for (int reg : op.fregsIn)
+      fpr_uses[reg]++;
+    if (op.fregOut >= 0)
+      fpr_uses[op.fregOut]++;
+  }
+
+  // Speculative constants stay immediates, as the loop doesn't write them.
+  for (size_t reg = 0; reg < gpr_uses.size(); reg++)
+  {
+    if (gpr.R(reg).IsImm())
+      gpr_uses[reg] = 0;
+  }
+
+  const auto pick = [](const std::array<int, 32>& uses, size_t count) {
+    std::array<int, 32> order;
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&uses](int a, int b) { return uses[a] > uses[b]; });
+    BitSet32 regs;
+    for (size_t i = 0; i < count && uses[order[i]] > 0; i++)
+      regs[order[i]] = true;
+    return regs;
+  };
+  m_loop.gprs = pick(gpr_uses, MAX_LOOP_GPRS);
+  m_loop.fprs = pick(fpr_uses, MAX_LOOP_FPRS);
+
+  // The registers are dirty from the start, as any iteration may have written them by the time
+  // the loop is left.
+  for (int reg : m_loop.gprs)
+    gpr.BindToRegister(reg, true, true);
+  for (int reg : m_loop.fprs)
+    fpr.BindToRegister(reg, true, true);
+
+  m_loop.gpr_state = gpr.GetState();
+  m_loop.fpr_state = fpr.GetState();
+  m_loop.head = GetCodePtr();
+}
+
+bool Jit64::IsLoopBackEdge(UGeckoInstruction inst, u32 address) const
+{
+  return m_loop.end >= 0 && jo.enableBlocklink && BranchesTo(inst, address, js.blockStart);
+}
+
+void Jit64::WriteLoopBackEdge()
+{
+  if (!m_loop.hot)
+  {
+    MOV(64, R(RSCRATCH), ImmPtr(&js.curBlock->loop_countdown));
+    SUB(32, MatR(RSCRATCH), Imm8(1));
+    FixupBranch hot = J_CC(CC_Z, true);
+
+    gpr.Flush(RegCache::FlushMode::MaintainState);
+    fpr.Flush(RegCache::FlushMode::MaintainState);
+    WriteExit(js.blockStart);
+
+    SwitchToFarCode();
+    SetJumpTarget(hot);
+    gpr.Flush(RegCache::FlushMode::MaintainState);
+    fpr.Flush(RegCache::FlushMode::MaintainState);
+    MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunctionC(JitInterface::CompileExceptionCheck,
+                      static_cast<u32>(JitInterface::ExceptionType::HotLoop));
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    MOV(32, R(RSCRATCH), Imm32(js.blockStart));
+    WriteExitDestInRSCRATCH();
+    SwitchToNearCode();
+    return;
+  }
+
+  const RegCache::State gpr_state = gpr.GetState();
+  const RegCache::State fpr_state = fpr.GetState();
+  gpr.Reconcile(m_loop.gpr_state);
+  fpr.Reconcile(m_loop.fpr_state);
+
+  // Like Cleanup, but without leaving the block.
+  if (jo.optimizeGatherPipe && js.fifoBytesSinceCheck > 0)
+  {
+    MOV(64, R(RSCRATCH), PPCSTATE(gather_pipe_ptr));
+    SUB(64, R(RSCRATCH), PPCSTATE(gather_pipe_base_ptr));
+    CMP(64, R(RSCRATCH), Imm32(GPFifo::GATHER_PIPE_SIZE));
+    FixupBranch not_full = J_CC(CC_L);
+    BitSet32 registersInUse = CallerSavedRegistersInUse();
+    ABI_PushRegistersAndAdjustStack(registersInUse, 0);
+    ABI_CallFunction(GPFifo::UpdateGatherPipe);
+    ABI_PopRegistersAndAdjustStack(registersInUse, 0);
+    SetJumpTarget(not_full);
+  }
+
+  SUB(32, PPCSTATE(downcount), Imm32(js.downcountAmount));
+  J_CC(CC_G, m_loop.head);
+
+  // Out of cycles; leave through the start of the block, which runs the timing code.
+  gpr.Flush(RegCache::FlushMode::MaintainState);
+  fpr.Flush(RegCache::FlushMode::MaintainState);
+  JustWriteExit(js.blockStart, false, 0);
+
+  gpr.SetState(gpr_state);
+  fpr.SetState(fpr_state);
+}
+
+BitSet32 Jit64::GetLoopGPRs() const
+{
+  return js.instructionNumber <= m_loop.end ? m_loop.gprs : BitSet32{};
+}
+
+BitSet32 Jit64::GetLoopFPRs() const
+{
+  return js.instructionNumber <= m_loop.end ? m_loop.fprs : BitSet32{};
+}
+
 bool Jit64::HandleFunctionHooking(u32 address)
 {
   return HLE::ReplaceFunctionIfPossible(address, [&](u32 function, HLE::HookType type) {
@@ -18,6 +18,9 @@
 // ----------
 #pragma once
 
+#include <array>
+#include <cstddef>
+
 #include "Common/CommonTypes.h"
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
@@ -59,10 +62,21 @@ public:
 
   void IntializeSpeculativeConstants();
 
+  // Loops that branch back to the start of their block. Once one turns out to be hot, the block is
+  // recompiled to keep its most used registers bound across iterations, and only writes them back
+  // when leaving the loop.
+  void AnalyzeLoop();
+  void BindLoopRegisters();
+  bool IsLoopBackEdge(UGeckoInstruction inst, u32 address) const;
+  void WriteLoopBackEdge();
+  BitSet32 GetLoopGPRs() const;
+  BitSet32 GetLoopFPRs() const;
+
   JitBlockCache* GetBlockCache() override { return &blocks; }
   void Trace();
 
   void ClearCache() override;
+  JitInterface::CodeCacheStats GetCodeCacheStats() const override;
 
   const CommonAsmRoutines* GetAsmRoutines() override { return &asm_routines; }
   const char* GetName() const override { return "JIT64"; }
@@ -250,6 +264,54 @@ private:
 
   Jit64AsmRoutineManager asm_routines{*this};
 
+  struct Loop
+  {
+    // The index of the last instruction that branches back to the start of the block, or -1.
+    int end = -1;
+    // Whether the registers are kept across iterations.
+    bool hot = false;
+    const u8* head = nullptr;
+    BitSet32 gprs;
+    BitSet32 fprs;
+    BitSet32 gprs_written;
+    RegCache::State gpr_state;
+    RegCache::State fpr_state;
+  };
+  Loop m_loop;
+  // Whether the block being compiled is a baseline one, which counts its runs to find out when it
+  // is worth compiling with all optimizations.
+  bool m_baseline_compile = false;
+
+  // The near and far code spaces are split into regions that are filled one at a time. Once the
+  // current one is full, the region with the least live code is evicted and filled next, instead
+  // of clearing the whole cache.
+  static constexpr size_t NUM_CODE_REGIONS = 8;
+  struct CodeRegions
+  {
+    u8* near_start = nullptr;
+    size_t near_size = 0;
+    u8* far_start = nullptr;
+    size_t far_size = 0;
+    size_t current = 0;
+    // When each region was last started, counting up from 1. Regions that are still empty are 0.
+    std::array<u64, NUM_CODE_REGIONS> ages{};
+    u64 last_age = 0;
+    // The number of bytes used in each full region.
+    std::array<size_t, NUM_CODE_REGIONS> used{};
+  };
+  void ResetCodeRegions();
+  bool IsCodeRegionAlmostFull() const;
+  size_t GetCodeRegionUsedBytes() const;
+  void EvictCodeRegion();
+  void UpdateCodeCacheStats();
+  CodeRegions m_code_regions;
+
+  // Reported by GetCodeCacheStats.
+  size_t m_code_used_bytes = 0;
+  u64 m_evicted_code_regions = 0;
+  u64 m_evicted_blocks = 0;
+  u64 m_code_cache_clears = 0;
+
   bool m_enable_blr_optimization;
   bool m_cleanup_after_stackfault;
   u8* m_stack;
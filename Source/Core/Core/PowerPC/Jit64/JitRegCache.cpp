@@ -111,6 +111,56 @@ void RegCache::Flush(FlushMode mode, BitSet32 regsToFlush)
   }
 }
 
+RegCache::State RegCache::GetState() const
+{
+  return {m_regs, m_xregs};
+}
+
+void RegCache::SetState(const State& state)
+{
+  m_regs = state.regs;
+  m_xregs = state.xregs;
+}
+
+void RegCache::Reconcile(const State& state)
+{
+  // Write back everything that isn't in the right place yet, which frees the host registers that
+  // are needed below.
+  for (size_t i = 0; i < m_regs.size(); i++)
+  {
+    const PPCCachedReg& target = state.regs[i];
+    if (target.away && target.location.IsSimpleReg() &&
+        m_regs[i].location.IsSimpleReg(target.location.GetSimpleReg()))
+    {
+      continue;
+    }
+
+    StoreFromRegister(i);
+    if (!target.away)
+      m_regs[i].location = target.location;
+  }
+
+  for (size_t i = 0; i < m_regs.size(); i++)
+  {
+    const PPCCachedReg& target = state.regs[i];
+    if (!target.away || !target.location.IsSimpleReg())
+      continue;
+
+    const X64Reg xr = target.location.GetSimpleReg();
+    ASSERT_MSG(DYNA_REC, state.xregs[xr].dirty, "Reconciling with clean reg %zu", i);
+    m_xregs[xr].dirty = true;
+    if (m_regs[i].away)
+      continue;
+
+    ASSERT_MSG(DYNA_REC, m_xregs[xr].free && !m_xregs[xr].locked, "X64 reg %i is in use", xr);
+    m_xregs[xr].free = false;
+    m_xregs[xr].ppcReg = i;
+    LoadRegister(i, xr);
+    m_regs[i].away = true;
+    m_regs[i].location = ::Gen::R(xr);
+  }
+}
+
 void RegCache::FlushR(X64Reg reg)
 {
   if (reg >= m_xregs.size())
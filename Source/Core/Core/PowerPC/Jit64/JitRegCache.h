@@ -38,6 +38,13 @@ public:
 
   static constexpr size_t NUM_XREGS = 16;
 
+  // Where each register is at some point of a block, e.g. the start of a loop.
+  struct State
+  {
+    std::array<PPCCachedReg, 32> regs;
+    std::array<X64CachedReg, NUM_XREGS> xregs;
+  };
+
   explicit RegCache(Jit64& jit);
   virtual ~RegCache() = default;
 
@@ -52,6 +59,14 @@ public:
 
   void Flush(FlushMode mode = FlushMode::All, BitSet32 regsToFlush = BitSet32::AllTrue(32));
 
+  State GetState() const;
+  // Switches to a state without emitting any code, e.g. to go on with another path of a branch.
+  void SetState(const State& state);
+  // Emits code to move the registers to where they are in a state taken earlier in the block.
+  // Registers bound in that state must be dirty, and its immediates must not have been written
+  // since, so that the register file is up to date for them.
+  void Reconcile(const State& state);
+
   void FlushR(Gen::X64Reg reg);
   void FlushR(Gen::X64Reg reg, Gen::X64Reg reg2);
 
@@ -175,7 +175,7 @@ void Jit64::ComputeRC(const OpArg& arg, bool needs_test, bool needs_sext)
         // better to flush it here so that we don't have to flush it on both sides of the branch.
         // We don't want to do this if a test is needed though, because it would interrupt macro-op
         // fusion.
-        for (int j : ~js.op->gprInUse)
+        for (int j : ~js.op->gprInUse & ~GetLoopGPRs())
           gpr.StoreFromRegister(j);
       }
       DoMergedBranchCondition();
@@ -428,10 +428,17 @@ void Jit64::DoMergedBranchCondition()
   else  // SO bit, do not branch (we don't emulate SO for cmp).
     pDontBranch = J(true);
 
-  gpr.Flush(RegCache::FlushMode::MaintainState);
-  fpr.Flush(RegCache::FlushMode::MaintainState);
+  if (IsLoopBackEdge(next, nextPC))
+  {
+    WriteLoopBackEdge();
+  }
+  else
+  {
+    gpr.Flush(RegCache::FlushMode::MaintainState);
+    fpr.Flush(RegCache::FlushMode::MaintainState);
 
-  DoMergedBranch();
+    DoMergedBranch();
+  }
 
   SetJumpTarget(pDontBranch);
 
@@ -464,7 +471,11 @@ void Jit64::DoMergedBranchImmediate(s64 val)
   else  // SO bit, do not branch (we don't emulate SO for cmp).
     branch = false;
 
-  if (branch)
+  if (branch && IsLoopBackEdge(next, nextPC))
+  {
+    WriteLoopBackEdge();
+  }
+  else if (branch)
   {
     gpr.Flush();
     fpr.Flush();
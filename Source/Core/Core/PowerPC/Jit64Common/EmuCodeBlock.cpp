@@ -5,6 +5,7 @@
 #include "Core/PowerPC/Jit64Common/EmuCodeBlock.h"
 
 #include <functional>
+#include <iterator>
 #include <limits>
 
 #include "Common/Assert.h"
@@ -1093,3 +1094,12 @@ void EmuCodeBlock::Clear()
   m_back_patch_info.clear();
   m_exception_handler_at_loc.clear();
 }
+
+void EmuCodeBlock::ClearRange(const u8* start, const u8* end)
+{
+  const auto in_range = [start, end](const u8* ptr) { return ptr >= start && ptr < end; };
+  for (auto it = m_back_patch_info.begin(); it != m_back_patch_info.end();)
+    it = in_range(it->first) ? m_back_patch_info.erase(it) : std::next(it);
+  for (auto it = m_exception_handler_at_loc.begin(); it != m_exception_handler_at_loc.end();)
+    it = in_range(it->first) ? m_exception_handler_at_loc.erase(it) : std::next(it);
+}
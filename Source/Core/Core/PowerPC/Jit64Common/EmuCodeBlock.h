@@ -123,6 +123,8 @@ public:
   void ConvertDoubleToSingle(Gen::X64Reg dst, Gen::X64Reg src);
   void SetFPRF(Gen::X64Reg xmm);
   void Clear();
+  // Forgets the fastmem accesses in [start, end) of the code space, before it is reused.
+  void ClearRange(const u8* start, const u8* end);
 
 protected:
   ConstantPool m_const_pool;
@@ -15,6 +15,7 @@
 #include "Core/PowerPC/CPUCoreBase.h"
 #include "Core/PowerPC/JitCommon/JitAsmCommon.h"
 #include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 
 //#define JIT_LOG_GENERATED_CODE  // Enables logging of generated code
@@ -100,6 +101,8 @@ protected:
     std::unordered_set<u32> fifoWriteAddresses;
     std::unordered_set<u32> pairedQuantizeAddresses;
     std::unordered_set<u32> noSpeculativeConstantsAddresses;
+    std::unordered_set<u32> hotBlockAddresses;
+    std::unordered_set<u32> hotLoopAddresses;
   };
 
   PPCAnalyst::CodeBlock code_block;
@@ -124,6 +127,9 @@ public:
   virtual bool HandleFault(uintptr_t access_address, SContext* ctx) = 0;
   virtual bool HandleStackFault() { return false; }
 
+  // Must be called on the CPU thread, or while it is paused.
+  virtual JitInterface::CodeCacheStats GetCodeCacheStats() const { return {}; }
+
   static constexpr std::size_t code_buffer_size = 32000;
 
   // This should probably be removed from public:
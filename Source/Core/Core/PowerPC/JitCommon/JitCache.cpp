@@ -13,9 +13,11 @@
 #include <array>
 #include <cstring>
 #include <functional>
-#include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/JitRegister.h"
@@ -65,6 +67,7 @@ void JitBaseBlockCache::Clear()
 #endif
   m_jit.js.fifoWriteAddresses.clear();
   m_jit.js.pairedQuantizeAddresses.clear();
+  // Hot blocks stay hot though, so that they don't go through a baseline compile again.
   for (auto& e : block_map)
   {
     DestroyBlock(e.second);
@@ -127,7 +130,7 @@ void JitBaseBlockCache::FinalizeBlock(JitBlock& block, bool block_link,
   {
     for (const auto& e : block.linkData)
     {
-      links_to.emplace(e.exitAddress, &block);
+      links_to[e.exitAddress].insert(&block);
     }
 
     LinkBlock(block);
@@ -216,6 +219,8 @@ void JitBaseBlockCache::InvalidateICache(u32 address, u32 length, bool forced)
       {
         m_jit.js.fifoWriteAddresses.erase(i);
         m_jit.js.pairedQuantizeAddresses.erase(i);
+        m_jit.js.hotBlockAddresses.erase(i);
+        m_jit.js.hotLoopAddresses.erase(i);
       }
     }
   }
@@ -223,51 +228,60 @@ void JitBaseBlockCache::InvalidateICache(u32 address, u32 length, bool forced)
 
 void JitBaseBlockCache::ErasePhysicalRange(u32 address, u32 length)
 {
-  // Iterate over all macro blocks which overlap the given range.
-  u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
-  auto start = block_range_map.lower_bound(address & range_mask);
-  auto end = block_range_map.lower_bound(address + length);
-  while (start != end)
-  {
-    // Iterate over all blocks in the macro block.
-    auto iter = start->second.begin();
-    while (iter != start->second.end())
+  const u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
+  const u64 range_start = address & range_mask;
+  const u64 range_end = u64(address) + length;
+
+  // Collect all blocks which overlap the given range first, as a block may be registered in
+  // several macro blocks of the range.
+  std::unordered_set<JitBlock*> overlapping_blocks;
+  const auto collect = [&](const std::unordered_set<JitBlock*>& blocks) {
+    for (JitBlock* block : blocks)
     {
-      JitBlock* block = *iter;
       if (block->OverlapsPhysicalRange(address, length))
-      {
-        // If the block overlaps, also remove all other occupied slots in the other macro blocks.
-        // This will leak empty macro blocks, but they may be reused or cleared later on.
-        for (u32 addr : block->physical_addresses)
-          if ((addr & range_mask) != start->first)
-            block_range_map[addr & range_mask].erase(block);
-
-        // And remove the block.
-        DestroyBlock(*block);
-        auto block_map_iter = block_map.equal_range(block->physicalAddress);
-        while (block_map_iter.first != block_map_iter.second)
-        {
-          if (&block_map_iter.first->second == block)
-          {
-            block_map.erase(block_map_iter.first);
-            break;
-          }
-          block_map_iter.first++;
-        }
-        iter = start->second.erase(iter);
-      }
-      else
-      {
-        iter++;
-      }
+        overlapping_blocks.insert(block);
     }
+  };
 
-    // If the macro block is empty, drop it.
-    if (start->second.empty())
-      start = block_range_map.erase(start);
-    else
-      start++;
+  // Small ranges (the common icbi/dcbi case) are looked up macro block by macro block.
+  // Huge ranges are cheaper to handle by walking all populated macro blocks instead.
+  const u64 num_macro_blocks =
+      (range_end - range_start + BLOCK_RANGE_MAP_ELEMENTS - 1) / BLOCK_RANGE_MAP_ELEMENTS;
+  if (num_macro_blocks <= block_range_map.size())
+  {
+    for (u64 macro_block = range_start; macro_block < range_end;
+         macro_block += BLOCK_RANGE_MAP_ELEMENTS)
+    {
+      auto iter = block_range_map.find(static_cast<u32>(macro_block));
+      if (iter != block_range_map.end())
+        collect(iter->second);
+    }
+  }
+  else
+  {
+    for (const auto& e : block_range_map)
+    {
+      if (e.first >= range_start && e.first < range_end)
+        collect(e.second);
+    }
+  }
+
+  for (JitBlock* block : overlapping_blocks)
+    EraseBlock(*block);
+}
+
+size_t JitBaseBlockCache::EraseHostCodeRange(const u8* start, const u8* end)
+{
+  std::vector<JitBlock*> blocks;
+  for (auto& e : block_map)
+  {
+    if (e.second.checkedEntry >= start && e.second.checkedEntry < end)
+      blocks.push_back(&e.second);
   }
+
+  for (JitBlock* block : blocks)
+    EraseBlock(*block);
+  return blocks.size();
 }
 
 u32* JitBaseBlockCache::GetBlockBitSet() const
@@ -304,13 +318,14 @@ void JitBaseBlockCache::LinkBlockExits(JitBlock& block)
 void JitBaseBlockCache::LinkBlock(JitBlock& block)
 {
   LinkBlockExits(block);
-  auto ppp = links_to.equal_range(block.effectiveAddress);
+  const auto it = links_to.find(block.effectiveAddress);
+  if (it == links_to.end())
+    return;
 
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
+  for (JitBlock* b2 : it->second)
   {
-    JitBlock& b2 = *iter->second;
-    if (block.msrBits == b2.msrBits)
-      LinkBlockExits(b2);
+    if (block.msrBits == b2->msrBits)
+      LinkBlockExits(*b2);
   }
 }
 
@@ -323,14 +338,16 @@ void JitBaseBlockCache::UnlinkBlock(const JitBlock& block)
   }
 
   // Unlink all exits of other blocks which points to this block
-  auto ppp = links_to.equal_range(block.effectiveAddress);
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
+  const auto it = links_to.find(block.effectiveAddress);
+  if (it == links_to.end())
+    return;
+
+  for (JitBlock* sourceBlock : it->second)
   {
-    JitBlock& sourceBlock = *iter->second;
-    if (sourceBlock.msrBits != block.msrBits)
+    if (sourceBlock->msrBits != block.msrBits)
       continue;
 
-    for (auto& e : sourceBlock.linkData)
+    for (auto& e : sourceBlock->linkData)
     {
       if (e.exitAddress == block.effectiveAddress)
       {
@@ -351,20 +368,47 @@ void JitBaseBlockCache::DestroyBlock(JitBlock& block)
   // Delete linking addresses
   for (const auto& e : block.linkData)
   {
-    auto it = links_to.equal_range(e.exitAddress);
-    while (it.first != it.second)
-    {
-      if (it.first->second == &block)
-        it.first = links_to.erase(it.first);
-      else
-        it.first++;
-    }
+    auto it = links_to.find(e.exitAddress);
+    if (it == links_to.end())
+      continue;
+    it->second.erase(&block);
+    if (it->second.empty())
+      links_to.erase(it);
   }
 
   // Raise an signal if we are going to call this block again
   WriteDestroyBlock(block);
 }
 
+void JitBaseBlockCache::EraseBlock(JitBlock& block)
+{
+  // Remove the block from all macro blocks it occupies, and drop the macro blocks that become
+  // empty.
+  const u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
+  for (u32 addr : block.physical_addresses)
+  {
+    auto iter = block_range_map.find(addr & range_mask);
+    if (iter == block_range_map.end())
+      continue;
+    iter->second.erase(&block);
+    if (iter->second.empty())
+      block_range_map.erase(iter);
+  }
+
+  // And remove the block.
+  DestroyBlock(block);
+  auto block_map_iter = block_map.equal_range(block.physicalAddress);
+  while (block_map_iter.first != block_map_iter.second)
+  {
+    if (&block_map_iter.first->second == &block)
+    {
+      block_map.erase(block_map_iter.first);
+      break;
+    }
+    block_map_iter.first++;
+  }
+}
+
 JitBlock* JitBaseBlockCache::MoveBlockIntoFastCache(u32 addr, u32 msr)
 {
   JitBlock* block = GetBlockFromStartAddress(addr, msr);
@@ -8,9 +8,10 @@
 #include <bitset>
 #include <cstring>
 #include <functional>
-#include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -74,6 +75,13 @@ struct JitBlock
     u64 ticStop;
   } profile_data = {};
 
+  // The number of times a baseline block may still run before Jit64 recompiles it with all
+  // optimizations.
+  u32 run_countdown = 0;
+  // The number of times the block may still branch back to its start before Jit64 recompiles it
+  // as a hot loop.
+  u32 loop_countdown = 0;
+
   // This tracks the position if this block within the fast block cache.
   // We allow each block to have only one map entry.
   size_t fast_block_map_index;
@@ -149,6 +157,9 @@ public:
 
   void InvalidateICache(u32 address, u32 length, bool forced);
   void ErasePhysicalRange(u32 address, u32 length);
+  // Erases the blocks whose code starts in [start, end) of the host code space, so that it can be
+  // reused. Returns the number of erased blocks.
+  size_t EraseHostCodeRange(const u8* start, const u8* end);
 
   u32* GetBlockBitSet() const;
 
@@ -163,6 +174,8 @@ private:
   void LinkBlock(JitBlock& block);
   void UnlinkBlock(const JitBlock& block);
   void DestroyBlock(JitBlock& block);
+  // Destroys the block and removes it from all maps, which invalidates it.
+  void EraseBlock(JitBlock& block);
 
   JitBlock* MoveBlockIntoFastCache(u32 em_address, u32 msr);
 
@@ -171,17 +184,18 @@ private:
 
   // links_to hold all exit points of all valid blocks in a reverse way.
   // It is used to query all blocks which links to an address.
-  std::multimap<u32, JitBlock*> links_to;  // destination_PC -> number
+  std::unordered_map<u32, std::unordered_set<JitBlock*>> links_to;  // destination_PC -> number
 
   // Map indexed by the physical address of the entry point.
   // This is used to query the block based on the current PC in a slow way.
-  std::multimap<u32, JitBlock> block_map;  // start_addr -> block
+  // References into an unordered container survive rehashing, so JitBlock pointers stay valid.
+  std::unordered_multimap<u32, JitBlock> block_map;  // start_addr -> block
 
   // Range of overlapping code indexed by a masked physical address.
   // This is used for invalidation of memory regions. The range is grouped
   // in macro blocks of each 0x100 bytes.
   static constexpr u32 BLOCK_RANGE_MAP_ELEMENTS = 0x100;
-  std::map<u32, std::set<JitBlock*>> block_range_map;
+  std::unordered_map<u32, std::unordered_set<JitBlock*>> block_range_map;
 
   // This bitsets shows which cachelines overlap with any blocks.
   // It is used to provide a fast way to query if no icache invalidation is needed.
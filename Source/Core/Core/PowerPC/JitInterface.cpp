@@ -19,6 +19,7 @@
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
+#include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 
 #include "Core/Core.h"
@@ -183,6 +184,13 @@ int GetHostCode(u32* address, const u8** code, u32* code_size)
   return 0;
 }
 
+CodeCacheStats GetCodeCacheStats()
+{
+  if (!g_jit)
+    return {};
+  return g_jit->GetCodeCacheStats();
+}
+
 bool HandleFault(uintptr_t access_address, SContext* ctx)
 {
   // Prevent nullptr dereference on a crash with no JIT present
@@ -239,6 +247,12 @@ void CompileExceptionCheck(ExceptionType type)
   case ExceptionType::SpeculativeConstants:
     exception_addresses = &g_jit->js.noSpeculativeConstantsAddresses;
     break;
+  case ExceptionType::HotBlock:
+    exception_addresses = &g_jit->js.hotBlockAddresses;
+    break;
+  case ExceptionType::HotLoop:
+    exception_addresses = &g_jit->js.hotLoopAddresses;
+    break;
   }
 
   if (PC != 0 && (exception_addresses->find(PC)) == (exception_addresses->end()))
@@ -262,6 +276,16 @@ void Shutdown()
 {
   if (g_jit)
   {
+    const CodeCacheStats stats = g_jit->GetCodeCacheStats();
+    if (stats.total_bytes != 0)
+    {
+      INFO_LOG(DYNA_REC,
+               "Code cache: %zu of %zu bytes used, %" PRIu64 " regions with %" PRIu64
+               " blocks evicted, %" PRIu64 " full clears",
+               stats.used_bytes, stats.total_bytes, stats.evicted_regions, stats.evicted_blocks,
+               stats.full_clears);
+    }
+
     g_jit->Shutdown();
     delete g_jit;
     g_jit = nullptr;
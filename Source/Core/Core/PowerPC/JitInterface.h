@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 #include "Common/CommonTypes.h"
@@ -28,7 +29,9 @@ enum class ExceptionType
 {
   FIFOWrite,
   PairedQuantize,
-  SpeculativeConstants
+  SpeculativeConstants,
+  HotBlock,
+  HotLoop
 };
 
 void DoState(PointerWrap& p);
@@ -48,6 +51,22 @@ void WriteProfileResults(const std::string& filename);
 void GetProfileResults(Profiler::ProfileStats* prof_stats);
 int GetHostCode(u32* address, const u8** code, u32* code_size);
 
+struct CodeCacheStats
+{
+  // The number of bytes of the code space that hold compiled code, and its total size.
+  size_t used_bytes = 0;
+  size_t total_bytes = 0;
+  // The number of regions of the code space that were evicted to make room for new code, and the
+  // number of blocks they held.
+  u64 evicted_regions = 0;
+  u64 evicted_blocks = 0;
+  // The number of times the whole cache was cleared.
+  u64 full_clears = 0;
+};
+
+// Must be called on the CPU thread, or while it is paused, as the JIT may be deleted at any time.
+CodeCacheStats GetCodeCacheStats();
+
 // Memory Utilities
 bool HandleFault(uintptr_t access_address, SContext* ctx);
 bool HandleStackFault();
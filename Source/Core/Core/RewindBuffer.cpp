@@ -0,0 +1,161 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/RewindBuffer.h"
+
+#include <algorithm>
+#include <lzo/lzo1x.h>
+#include <utility>
+
+#include "Common/Assert.h"
+#include "Common/CommonTypes.h"
+#include "Common/ParallelFor.h"
+
+namespace State
+{
+static constexpr size_t WRKMEM_ELEMENTS =
+    (LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t);
+
+// XORs length bytes of src starting at offset into dest. src is treated as if it was padded with
+// zeroes to any length.
+static void XorInto(u8* dest, const std::vector<u8>& src, size_t offset, size_t length)
+{
+  if (offset >= src.size())
+    return;
+
+  const u8* src_data = src.data() + offset;
+  length = std::min(length, src.size() - offset);
+  for (size_t i = 0; i < length; ++i)
+    dest[i] ^= src_data[i];
+}
+
+RewindBuffer::RewindBuffer(size_t budget_bytes) : m_budget(budget_bytes)
+{
+  static const int lzo_init_result = lzo_init();
+  ASSERT_MSG(CORE, lzo_init_result == LZO_E_OK, "Internal LZO Error - lzo_init() failed");
+}
+
+void RewindBuffer::SetBudget(size_t budget_bytes)
+{
+  m_budget = budget_bytes;
+  EnforceBudget();
+}
+
+void RewindBuffer::Clear()
+{
+  std::vector<u8>().swap(m_newest);
+  m_has_newest = false;
+  m_deltas.clear();
+  m_deltas_memory_usage = 0;
+}
+
+void RewindBuffer::Push(std::vector<u8> state)
+{
+  if (m_has_newest)
+  {
+    const std::vector<u8>& previous = m_newest;
+    const size_t length = std::max(previous.size(), state.size());
+
+    Delta delta;
+    delta.size = previous.size();
+    delta.chunks.resize((length + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+    Common::ParallelFor(delta.chunks.size(), [&](size_t chunk) {
+      const size_t offset = chunk * CHUNK_SIZE;
+      const size_t chunk_length = std::min(length - offset, CHUNK_SIZE);
+
+      std::vector<u8> xor_data(chunk_length);
+      XorInto(xor_data.data(), previous, offset, chunk_length);
+      XorInto(xor_data.data(), state, offset, chunk_length);
+
+      if (std::all_of(xor_data.begin(), xor_data.end(), [](u8 byte) { return byte == 0; }))
+        return;
+
+      std::vector<lzo_align_t> wrkmem(WRKMEM_ELEMENTS);
+      std::vector<u8>& out = delta.chunks[chunk];
+      out.resize(chunk_length + chunk_length / 16 + 64 + 3);
+      lzo_uint out_len = 0;
+      lzo1x_1_compress(xor_data.data(), chunk_length, out.data(), &out_len, wrkmem.data());
+      out.resize(out_len);
+      out.shrink_to_fit();
+    });
+
+    delta.memory_usage = sizeof(Delta) + delta.chunks.size() * sizeof(std::vector<u8>);
+    for (const std::vector<u8>& chunk : delta.chunks)
+      delta.memory_usage += chunk.size();
+
+    m_deltas_memory_usage += delta.memory_usage;
+    m_deltas.push_back(std::move(delta));
+  }
+
+  m_newest = std::move(state);
+  m_has_newest = true;
+  EnforceBudget();
+}
+
+bool RewindBuffer::Pop(std::vector<u8>* state)
+{
+  if (!m_has_newest)
+    return false;
+
+  if (m_deltas.empty())
+  {
+    *state = std::move(m_newest);
+    Clear();
+    return true;
+  }
+
+  const Delta& delta = m_deltas.back();
+  const size_t length = std::max(delta.size, m_newest.size());
+  std::vector<u8> previous(length);
+
+  Common::ParallelFor(delta.chunks.size(), [&](size_t chunk) {
+    const size_t offset = chunk * CHUNK_SIZE;
+    const size_t chunk_length = std::min(length - offset, CHUNK_SIZE);
+    const std::vector<u8>& in = delta.chunks[chunk];
+
+    if (in.empty())
+    {
+      XorInto(&previous[offset], m_newest, offset, chunk_length);
+      return;
+    }
+
+    lzo_uint out_len = chunk_length;
+    const int result =
+        lzo1x_decompress_safe(in.data(), in.size(), &previous[offset], &out_len, nullptr);
+    ASSERT_MSG(CORE, result == LZO_E_OK && out_len == chunk_length,
+               "Failed to decompress rewind state");
+
+    XorInto(&previous[offset], m_newest, offset, chunk_length);
+  });
+
+  previous.resize(delta.size);
+  m_deltas_memory_usage -= delta.memory_usage;
+  m_deltas.pop_back();
+
+  *state = std::move(m_newest);
+  m_newest = std::move(previous);
+  return true;
+}
+
+size_t RewindBuffer::GetNumStates() const
+{
+  return m_has_newest ? m_deltas.size() + 1 : 0;
+}
+
+size_t RewindBuffer::GetMemoryUsage() const
+{
+  return m_newest.size() + m_deltas_memory_usage;
+}
+
+void RewindBuffer::EnforceBudget()
+{
+  // The newest state is always kept, even if it alone exceeds the budget.
+  while (!m_deltas.empty() && GetMemoryUsage() > m_budget)
+  {
+    m_deltas_memory_usage -= m_deltas.front().memory_usage;
+    m_deltas.pop_front();
+  }
+}
+}  // namespace State
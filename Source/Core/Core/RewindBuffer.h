@@ -0,0 +1,58 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace State
+{
+// A bounded history of in-memory savestates, used for rewinding.
+//
+// Only the newest state is kept verbatim. Every older state is stored as the LZO-compressed XOR of
+// itself and the state that followed it, which is mostly zeroes as consecutive states rarely
+// differ by much. Once the memory used exceeds the budget, the oldest states are dropped.
+class RewindBuffer
+{
+public:
+  explicit RewindBuffer(size_t budget_bytes = 0);
+
+  void SetBudget(size_t budget_bytes);
+  void Clear();
+
+  // Makes the given state the newest one.
+  void Push(std::vector<u8> state);
+
+  // Removes the newest state and moves it into state. Returns false if there are no states.
+  bool Pop(std::vector<u8>* state);
+
+  size_t GetNumStates() const;
+  size_t GetMemoryUsage() const;
+
+private:
+  // Turns the newest state back into the one preceding it.
+  struct Delta
+  {
+    // The size of the preceding state.
+    size_t size;
+    // One entry per CHUNK_SIZE bytes. Chunks which did not change are empty.
+    std::vector<std::vector<u8>> chunks;
+    size_t memory_usage;
+  };
+
+  static constexpr size_t CHUNK_SIZE = 128 * 1024;
+
+  void EnforceBudget();
+
+  std::vector<u8> m_newest;
+  bool m_has_newest = false;
+  std::deque<Delta> m_deltas;
+  size_t m_deltas_memory_usage = 0;
+  size_t m_budget;
+};
+}  // namespace State
@@ -4,6 +4,9 @@
 
 #include "Core/State.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
 #include <lzo/lzo1x.h>
 #include <map>
 #include <mutex>
@@ -17,13 +20,16 @@
 #include "Common/Event.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
+#include "Common/ParallelFor.h"
 #include "Common/ScopeGuard.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 #include "Common/Timer.h"
 #include "Common/Version.h"
 
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -34,8 +40,10 @@
 #include "Core/Movie.h"
 #include "Core/NetPlayClient.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/RewindBuffer.h"
 
 #include "VideoCommon/AVIDump.h"
+#include "VideoCommon/Fifo.h"
 #include "VideoCommon/OnScreenDisplay.h"
 #include "VideoCommon/VideoBackendBase.h"
 
@@ -51,12 +59,10 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
-
-#define HEAP_ALLOC(var, size)                                                                      \
-  lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+// Every IN_LEN chunk is compressed independently of the others, so chunks can be compressed and
+// decompressed on several threads at once without changing the file format.
+static constexpr size_t WRKMEM_ELEMENTS =
+    (LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t);
 
 static std::string g_last_filename;
 
@@ -73,6 +79,11 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
+static RewindBuffer s_rewind_buffer;
+static std::mutex s_rewind_buffer_mutex;
+static std::atomic<int> s_frames_since_rewind_capture{0};
+static std::atomic<bool> s_rewind_capture_pending{false};
+
 // Don't forget to increase this after doing changes on the savestate system
 static const u32 STATE_VERSION = 98;  // Last changed in PR 6895
 
@@ -345,33 +356,44 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 
   if (header.size != 0)  // non-zero header size means the state is compressed
   {
-    lzo_uint i = 0;
-    while (true)
-    {
-      lzo_uint32 cur_len = 0;
-      lzo_uint out_len = 0;
+    // The last chunk is always shorter than IN_LEN, which makes it empty if the buffer size is a
+    // multiple of IN_LEN. Loaders rely on this to detect the end of the state.
+    const u64 start_time = Common::Timer::GetTimeUs();
+    const size_t num_chunks = buffer_size / IN_LEN + 1;
+    std::vector<std::vector<u8>> compressed_chunks(num_chunks);
+
+    // Errors are reported once the workers are done, as alerts can't be shown from them.
+    std::atomic<bool> failed{false};
+    Common::ParallelFor(num_chunks, [&](size_t chunk) {
+      const size_t offset = chunk * IN_LEN;
+      const lzo_uint cur_len =
+          static_cast<lzo_uint>(std::min<size_t>(buffer_size - offset, IN_LEN));
+      std::vector<lzo_align_t> wrkmem(WRKMEM_ELEMENTS);
+      std::vector<u8>& out = compressed_chunks[chunk];
+      out.resize(OUT_LEN);
 
-      if ((i + IN_LEN) >= buffer_size)
-      {
-        cur_len = (lzo_uint32)(buffer_size - i);
-      }
-      else
+      lzo_uint out_len = 0;
+      if (lzo1x_1_compress(buffer_data + offset, cur_len, out.data(), &out_len, wrkmem.data()) !=
+          LZO_E_OK)
       {
-        cur_len = IN_LEN;
+        failed = true;
       }
+      out.resize(out_len);
+    });
 
-      if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-        PanicAlertT("Internal LZO Error - compression failed");
+    if (failed)
+      PanicAlertT("Internal LZO Error - compression failed");
 
+    for (const std::vector<u8>& out : compressed_chunks)
+    {
       // The size of the data to write is 'out_len'
-      f.WriteArray((lzo_uint32*)&out_len, 1);
-      f.WriteBytes(out, out_len);
-
-      if (cur_len != IN_LEN)
-        break;
-
-      i += cur_len;
+      const lzo_uint32 out_len = static_cast<lzo_uint32>(out.size());
+      f.WriteArray(&out_len, 1);
+      f.WriteBytes(out.data(), out_len);
     }
+
+    INFO_LOG(CORE, "Compressed %zu byte state in %zu chunks in %" PRIu64 " us", buffer_size,
+             num_chunks, Common::Timer::GetTimeUs() - start_time);
   }
   else  // uncompressed
   {
@@ -477,30 +499,61 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
   {
     Core::DisplayMessage("Decompressing State...", 500);
 
+    const u64 start_time = Common::Timer::GetTimeUs();
     buffer.resize(header.size);
 
-    lzo_uint i = 0;
-    while (true)
+    // Read all compressed chunks first, then decompress them in parallel. Every chunk except for
+    // the last one decompresses to exactly IN_LEN bytes.
+    std::vector<std::vector<u8>> compressed_chunks;
+    while (compressed_chunks.size() * IN_LEN <= header.size)
     {
       lzo_uint32 cur_len = 0;  // number of bytes to read
-      lzo_uint new_len = 0;    // number of bytes to write
-
       if (!f.ReadArray(&cur_len, 1))
         break;
 
-      f.ReadBytes(out, cur_len);
-      const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-      if (res != LZO_E_OK)
+      std::vector<u8> chunk(cur_len);
+      if (!f.ReadBytes(chunk.data(), cur_len))
+        break;
+      compressed_chunks.push_back(std::move(chunk));
+    }
+
+    // The results are checked once the workers are done, as alerts can't be shown from them.
+    std::vector<int> results(compressed_chunks.size());
+    std::vector<lzo_uint> decompressed_sizes(compressed_chunks.size());
+    Common::ParallelFor(compressed_chunks.size(), [&](size_t chunk) {
+      const size_t offset = chunk * IN_LEN;
+      const std::vector<u8>& in = compressed_chunks[chunk];
+      lzo_uint new_len = static_cast<lzo_uint>(std::min<size_t>(header.size - offset, IN_LEN));
+      const lzo_uint expected_len = new_len;
+
+      results[chunk] =
+          lzo1x_decompress_safe(in.data(), in.size(), buffer.data() + offset, &new_len, nullptr);
+      if (results[chunk] == LZO_E_OK && new_len != expected_len)
+        results[chunk] = LZO_E_ERROR;
+      decompressed_sizes[chunk] = new_len;
+    });
+
+    for (size_t chunk = 0; chunk < compressed_chunks.size(); ++chunk)
+    {
+      if (results[chunk] != LZO_E_OK)
       {
         // This doesn't seem to happen anymore.
         PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
                     "Try loading the state again",
-                    res, i, new_len);
+                    results[chunk], static_cast<long>(chunk * IN_LEN),
+                    static_cast<long>(decompressed_sizes[chunk]));
         return;
       }
+    }
 
-      i += new_len;
+    if (compressed_chunks.size() * IN_LEN <= header.size)
+    {
+      PanicAlertT("Internal LZO Error - state is truncated");
+      return;
     }
+
+    INFO_LOG(CORE, "Read and decompressed %u byte state in %zu chunks in %" PRIu64 " us",
+             header.size, compressed_chunks.size(), Common::Timer::GetTimeUs() - start_time);
   }
   else  // uncompressed
   {
@@ -617,6 +670,8 @@ void Shutdown()
     std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
     std::vector<u8>().swap(g_undo_load_buffer);
   }
+
+  ClearRewindBuffer();
 }
 
 static std::string MakeStateFilename(int number)
@@ -702,4 +757,84 @@ void UndoSaveState()
   LoadAs(File::GetUserPath(D_STATESAVES_IDX) + "lastState.sav");
 }
 
+static bool IsRewindAllowed()
+{
+  // Rewinding would desync movies and netplay, so don't bother capturing states for them.
+  return Config::Get(Config::MAIN_REWIND_ENABLE) && !Movie::IsMovieActive() &&
+         !NetPlay::IsNetPlayRunning();
+}
+
+static void CaptureRewindState()
+{
+  s_rewind_capture_pending = false;
+  if (!Core::IsRunning() || !IsRewindAllowed())
+    return;
+
+  // This runs on the host thread, so SaveToBuffer pauses the CPU thread, which only stops
+  // between timing slices and never in the middle of an event callback.
+  const u64 start_time = Common::Timer::GetTimeUs();
+  std::vector<u8> buffer;
+  SaveToBuffer(buffer);
+
+  std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+  s_rewind_buffer.SetBudget(static_cast<size_t>(Config::Get(Config::MAIN_REWIND_BUFFER_SIZE))
+                            << 20);
+  s_rewind_buffer.Push(std::move(buffer));
+
+  INFO_LOG(CORE, "Captured rewind state in %" PRIu64 " us (%zu states, %zu bytes)",
+           Common::Timer::GetTimeUs() - start_time, s_rewind_buffer.GetNumStates(),
+           s_rewind_buffer.GetMemoryUsage());
+}
+
+void RewindFrameUpdate()
+{
+  if (!IsRewindAllowed())
+    return;
+
+  if (++s_frames_since_rewind_capture < Config::Get(Config::MAIN_REWIND_FREQUENCY))
+    return;
+  s_frames_since_rewind_capture = 0;
+
+  // Don't pile up captures if the host thread falls behind.
+  if (!s_rewind_capture_pending.exchange(true))
+    Core::QueueHostJob(CaptureRewindState);
+}
+
+void Rewind()
+{
+  if (NetPlay::IsNetPlayRunning())
+  {
+    OSD::AddMessage("Loading savestates is disabled in Netplay to prevent desyncs");
+    return;
+  }
+  if (Movie::IsMovieActive())
+  {
+    Core::DisplayMessage("Rewinding is disabled while a movie is active", 2000);
+    return;
+  }
+
+  std::vector<u8> buffer;
+  size_t states_left;
+  {
+    std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+    if (!s_rewind_buffer.Pop(&buffer))
+    {
+      Core::DisplayMessage("There is nothing to rewind", 2000);
+      return;
+    }
+    states_left = s_rewind_buffer.GetNumStates();
+  }
+
+  LoadFromBuffer(buffer);
+  s_frames_since_rewind_capture = 0;
+  Core::DisplayMessage(StringFromFormat("Rewound (%zu states left)", states_left), 1000);
+}
+
+void ClearRewindBuffer()
+{
+  std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+  s_rewind_buffer.Clear();
+  s_frames_since_rewind_capture = 0;
+}
+
 }  // namespace State
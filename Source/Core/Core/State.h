@@ -58,6 +58,14 @@ void UndoLoadState();
 // wait until previously scheduled savestate event (if any) is done
 void Flush();
 
+// Rewind support. When enabled, a state is captured into an in-memory buffer every few frames.
+// Must be called once per frame. May be called from any thread; the capture itself is queued
+// as a host job.
+void RewindFrameUpdate();
+// Loads the most recently captured rewind state and removes it from the buffer.
+void Rewind();
+void ClearRewindBuffer();
+
 // for calling back into UI code without introducing a dependency on it in core
 using AfterLoadCallbackFunc = std::function<void()>;
 void SetOnAfterLoadCallback(AfterLoadCallbackFunc callback);
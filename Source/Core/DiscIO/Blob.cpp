@@ -15,6 +15,7 @@
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
+#include "DiscIO/CachedBlob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DirectoryBlob.h"
 #include "DiscIO/DriveBlob.h"
@@ -197,7 +198,7 @@ std::unique_ptr<BlobReader> CreateBlobReader(const std::string& filename)
   case CISO_MAGIC:
     return CISOFileReader::Create(std::move(file));
   case GCZ_MAGIC:
-    return CompressedBlobReader::Create(std::move(file), filename);
+    return CachedBlobReader::Create(CompressedBlobReader::Create(std::move(file), filename));
   case TGC_MAGIC:
     return TGCFileReader::Create(std::move(file));
   case WBFS_MAGIC:
@@ -0,0 +1,198 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DiscIO/CachedBlob.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Thread.h"
+
+namespace DiscIO
+{
+// The number of consecutive sequential reads after which prefetching starts.
+static constexpr u32 SEQUENTIAL_READS_BEFORE_PREFETCH = 2;
+
+std::unique_ptr<CachedBlobReader> CachedBlobReader::Create(std::unique_ptr<BlobReader> reader,
+                                                           u32 block_size,
+                                                           size_t max_cached_blocks,
+                                                           u32 prefetch_blocks)
+{
+  if (!reader || block_size == 0 || max_cached_blocks == 0)
+    return nullptr;
+
+  return std::unique_ptr<CachedBlobReader>(
+      new CachedBlobReader(std::move(reader), block_size, max_cached_blocks, prefetch_blocks));
+}
+
+CachedBlobReader::CachedBlobReader(std::unique_ptr<BlobReader> reader, u32 block_size,
+                                   size_t max_cached_blocks, u32 prefetch_blocks)
+    : m_reader(std::move(reader)), m_data_size(m_reader->GetDataSize()), m_block_size(block_size),
+      m_max_cached_blocks(max_cached_blocks),
+      // Prefetched blocks must not push the blocks currently being read out of the cache.
+      m_prefetch_blocks(static_cast<u32>(std::min<size_t>(prefetch_blocks, max_cached_blocks / 2))),
+      m_cache_capacity(std::min(max_cached_blocks, RANDOM_ACCESS_CACHED_BLOCKS))
+{
+}
+
+CachedBlobReader::~CachedBlobReader() = default;
+
+bool CachedBlobReader::Read(u64 offset, u64 size, u8* out_ptr)
+{
+  if (size == 0)
+    return true;
+  if (offset + size > m_data_size || offset + size < offset)
+    return false;
+
+  const u64 first_block = offset / m_block_size;
+  const u64 last_block = (offset + size - 1) / m_block_size;
+  UpdateSequentialAccess(first_block, last_block);
+
+  while (size > 0)
+  {
+    const u64 block_index = offset / m_block_size;
+    const Block block = GetBlock(block_index);
+    if (!block)
+      return false;
+
+    const u64 offset_in_block = offset % m_block_size;
+    const u64 copy_size = std::min<u64>(size, block->size() - offset_in_block);
+    std::memcpy(out_ptr, block->data() + offset_in_block, static_cast<size_t>(copy_size));
+
+    offset += copy_size;
+    out_ptr += copy_size;
+    size -= copy_size;
+  }
+
+  return true;
+}
+
+bool CachedBlobReader::SupportsReadWiiDecrypted() const
+{
+  return m_reader->SupportsReadWiiDecrypted();
+}
+
+bool CachedBlobReader::ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset)
+{
+  std::lock_guard<std::mutex> lk(m_reader_mutex);
+  return m_reader->ReadWiiDecrypted(offset, size, out_ptr, partition_offset);
+}
+
+CachedBlobReader::Block CachedBlobReader::GetBlock(u64 block_index)
+{
+  if (Block block = FindBlock(block_index))
+    return block;
+
+  return LoadBlock(block_index);
+}
+
+CachedBlobReader::Block CachedBlobReader::FindBlock(u64 block_index)
+{
+  std::lock_guard<std::mutex> lk(m_cache_mutex);
+  const auto it = m_cache.find(block_index);
+  if (it == m_cache.end())
+    return nullptr;
+
+  m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+  return it->second.first;
+}
+
+CachedBlobReader::Block CachedBlobReader::LoadBlock(u64 block_index)
+{
+  std::lock_guard<std::mutex> lk(m_reader_mutex);
+
+  // The prefetch thread may have loaded the block while we were waiting for the reader.
+  if (Block block = FindBlock(block_index))
+    return block;
+
+  const u64 block_offset = block_index * m_block_size;
+  if (block_offset >= m_data_size)
+    return nullptr;
+
+  auto data = std::make_shared<std::vector<u8>>(
+      static_cast<size_t>(std::min<u64>(m_block_size, m_data_size - block_offset)));
+  if (!m_reader->Read(block_offset, data->size(), data->data()))
+    return nullptr;
+
+  InsertBlock(block_index, data);
+  return data;
+}
+
+void CachedBlobReader::InsertBlock(u64 block_index, Block block)
+{
+  std::lock_guard<std::mutex> lk(m_cache_mutex);
+  if (m_cache.count(block_index))
+    return;
+
+  m_lru.push_front(block_index);
+  m_cache.emplace(block_index, std::make_pair(std::move(block), m_lru.begin()));
+
+  while (m_cache.size() > m_cache_capacity)
+  {
+    m_cache.erase(m_lru.back());
+    m_lru.pop_back();
+  }
+}
+
+void CachedBlobReader::UpdateSequentialAccess(u64 first_block, u64 last_block)
+{
+  const bool sequential = first_block == m_last_block_read || first_block == m_last_block_read + 1;
+  m_last_block_read = last_block;
+  if (!sequential)
+  {
+    // Whatever was prefetched for the previous stream may have been evicted by now, so start
+    // over from the new position.
+    m_sequential_reads = 0;
+    m_prefetched_until = last_block + 1;
+    ++m_prefetch_generation;
+    return;
+  }
+
+  ++m_sequential_reads;
+
+  if (m_sequential_reads < SEQUENTIAL_READS_BEFORE_PREFETCH)
+    return;
+
+  // The cache only grows and the worker thread is only started once streaming starts, since most
+  // blob readers (e.g. those created for the game list) never see any sequential reads.
+  if (!m_streaming)
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_cache_mutex);
+      m_cache_capacity = m_max_cached_blocks;
+    }
+    if (m_prefetch_blocks != 0)
+      m_prefetch_thread.Reset([this](const PrefetchRequest& request) { PrefetchBlock(request); });
+    m_streaming = true;
+  }
+
+  if (m_prefetch_blocks == 0)
+    return;
+
+  const u64 generation = m_prefetch_generation.load();
+  const u64 end_block = (m_data_size + m_block_size - 1) / m_block_size;
+  const u64 prefetch_end = std::min(last_block + 1 + m_prefetch_blocks, end_block);
+  for (u64 block_index = std::max(last_block + 1, m_prefetched_until); block_index < prefetch_end;
+       ++block_index)
+  {
+    m_prefetch_thread.EmplaceItem(PrefetchRequest{block_index, generation});
+  }
+  m_prefetched_until = std::max(m_prefetched_until, prefetch_end);
+}
+
+void CachedBlobReader::PrefetchBlock(const PrefetchRequest& request)
+{
+  Common::SetCurrentThreadName("Blob prefetch thread");
+  if (request.generation != m_prefetch_generation.load())
+    return;
+
+  GetBlock(request.block_index);
+}
+
+}  // namespace DiscIO
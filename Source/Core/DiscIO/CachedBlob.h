@@ -0,0 +1,102 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/WorkQueueThread.h"
+#include "DiscIO/Blob.h"
+
+namespace DiscIO
+{
+// Wraps another BlobReader, caching the data it returns in fixed-size blocks.
+//
+// Reading a compressed blob means decompressing data on the thread that reads it. To keep that
+// off the DVD thread during streaming, sequential accesses are detected and the blocks following
+// them are read ahead of time on a worker thread.
+//
+// Readers that only see random accesses (e.g. those created for the game list) keep at most
+// RANDOM_ACCESS_CACHED_BLOCKS blocks. The cache only grows to its full size once streaming starts.
+class CachedBlobReader final : public BlobReader
+{
+public:
+  static constexpr u32 DEFAULT_BLOCK_SIZE = 0x10000;
+  static constexpr size_t DEFAULT_MAX_CACHED_BLOCKS = 256;
+  static constexpr u32 DEFAULT_PREFETCH_BLOCKS = 8;
+  static constexpr size_t RANDOM_ACCESS_CACHED_BLOCKS = 16;
+
+  static std::unique_ptr<CachedBlobReader>
+  Create(std::unique_ptr<BlobReader> reader, u32 block_size = DEFAULT_BLOCK_SIZE,
+         size_t max_cached_blocks = DEFAULT_MAX_CACHED_BLOCKS,
+         u32 prefetch_blocks = DEFAULT_PREFETCH_BLOCKS);
+  ~CachedBlobReader();
+
+  BlobType GetBlobType() const override { return m_reader->GetBlobType(); }
+  u64 GetRawSize() const override { return m_reader->GetRawSize(); }
+  u64 GetDataSize() const override { return m_data_size; }
+
+  bool Read(u64 offset, u64 size, u8* out_ptr) override;
+
+  bool SupportsReadWiiDecrypted() const override;
+  bool ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset) override;
+
+private:
+  using Block = std::shared_ptr<const std::vector<u8>>;
+
+  struct PrefetchRequest
+  {
+    u64 block_index;
+    u64 generation;
+  };
+
+  CachedBlobReader(std::unique_ptr<BlobReader> reader, u32 block_size, size_t max_cached_blocks,
+                   u32 prefetch_blocks);
+
+  // Returns the block from the cache, reading it from the underlying reader if necessary.
+  // Returns nullptr if the read fails.
+  Block GetBlock(u64 block_index);
+  Block FindBlock(u64 block_index);
+  Block LoadBlock(u64 block_index);
+  void InsertBlock(u64 block_index, Block block);
+
+  void UpdateSequentialAccess(u64 first_block, u64 last_block);
+  void PrefetchBlock(const PrefetchRequest& request);
+
+  // The underlying reader is not thread-safe, so any access to it must hold m_reader_mutex.
+  std::unique_ptr<BlobReader> m_reader;
+  std::mutex m_reader_mutex;
+  const u64 m_data_size;
+  const u32 m_block_size;
+  const size_t m_max_cached_blocks;
+  const u32 m_prefetch_blocks;
+
+  // Most recently used blocks are at the front of m_lru.
+  std::mutex m_cache_mutex;
+  size_t m_cache_capacity;
+  std::list<u64> m_lru;
+  std::unordered_map<u64, std::pair<Block, std::list<u64>::iterator>> m_cache;
+
+  // Only accessed from the thread calling Read.
+  u64 m_last_block_read = UINT64_MAX;
+  u32 m_sequential_reads = 0;
+  u64 m_prefetched_until = 0;
+  bool m_streaming = false;
+
+  // Bumped on every seek, so that the worker thread drops the blocks that were queued for the
+  // previous position instead of holding up the reads for the new one.
+  std::atomic<u64> m_prefetch_generation{0};
+
+  // Declared last so that the worker thread is stopped before anything it uses is destroyed.
+  Common::WorkQueueThread<PrefetchRequest> m_prefetch_thread;
+};
+
+}  // namespace DiscIO
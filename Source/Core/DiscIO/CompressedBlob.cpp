@@ -8,6 +8,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
@@ -23,6 +24,7 @@
 #include "Common/Hash.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
+#include "Common/ParallelFor.h"
 #include "Common/StringUtil.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
@@ -152,6 +154,37 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
   return true;
 }
 
+namespace
+{
+struct CompressionBlock
+{
+  std::vector<u8> in_buf;
+  std::vector<u8> out_buf;
+  u32 out_size;
+  // Whether the block didn't compress well and is stored as is (in in_buf).
+  bool stored;
+};
+}  // namespace
+
+static bool CompressBlock(CompressionBlock* block, u32 block_size)
+{
+  z_stream z = {};
+  if (deflateInit(&z, 9) != Z_OK)
+    return false;
+
+  z.next_in = block->in_buf.data();
+  z.avail_in = block_size;
+  z.next_out = block->out_buf.data();
+  z.avail_out = block_size;
+
+  int status = deflate(&z, Z_FINISH);
+  block->stored = (status != Z_STREAM_END) || (z.avail_out < 10);
+  block->out_size = block->stored ? block_size : block_size - z.avail_out;
+
+  deflateEnd(&z);
+  return true;
+}
+
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
                         u32 sub_type, int block_size, CompressCB callback, void* arg)
 {
@@ -193,10 +226,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     scrubbing = true;
   }
 
-  z_stream z = {};
-  if (deflateInit(&z, 9) != Z_OK)
-    return false;
-
   callback(GetStringT("Files opened, ready to compress."), 0, arg);
 
   CompressedBlobHeader header;
@@ -210,8 +239,15 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   std::vector<u64> offsets(header.num_blocks);
   std::vector<u32> hashes(header.num_blocks);
-  std::vector<u8> out_buf(block_size);
-  std::vector<u8> in_buf(block_size);
+
+  // Blocks are read and written in order, but compressed in parallel a batch at a time.
+  const u32 batch_size = static_cast<u32>(Common::GetParallelForThreadCount() * 4);
+  std::vector<CompressionBlock> batch(batch_size);
+  for (CompressionBlock& block : batch)
+  {
+    block.in_buf.resize(block_size);
+    block.out_buf.resize(block_size);
+  }
 
   // seek past the header (we will write it at the end)
   outfile.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -224,12 +260,15 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   u64 position = 0;
   int num_compressed = 0;
   int num_stored = 0;
-  int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
+  u32 progress_monitor = std::max<u32>(1, header.num_blocks / 1000);
   bool success = true;
 
-  for (u32 i = 0; i < header.num_blocks; i++)
+  for (u32 first = 0; first < header.num_blocks && success; first += batch_size)
   {
-    if (i % progress_monitor == 0)
+    const u32 count = std::min(batch_size, header.num_blocks - first);
+    const u32 last = first + count - 1;
+
+    if (first % progress_monitor == 0 || first / progress_monitor != last / progress_monitor)
     {
       const u64 inpos = infile.Tell();
       int ratio = 0;
@@ -237,9 +276,9 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
         ratio = (int)(100 * position / inpos);
 
       std::string temp =
-          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(), i,
+          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(), first,
                            header.num_blocks, ratio);
-      bool was_cancelled = !callback(temp, (float)i / (float)header.num_blocks, arg);
+      bool was_cancelled = !callback(temp, (float)first / (float)header.num_blocks, arg);
       if (was_cancelled)
       {
         success = false;
@@ -247,64 +286,64 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
       }
     }
 
-    offsets[i] = position;
-
-    size_t read_bytes;
-    if (scrubbing)
-      read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
-    else
-      infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
-    if (read_bytes < header.block_size)
-      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+    for (u32 i = 0; i < count; i++)
+    {
+      std::vector<u8>& in_buf = batch[i].in_buf;
+      size_t read_bytes;
+      if (scrubbing)
+        read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
+      else
+        infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
+      if (read_bytes < header.block_size)
+        std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+    }
 
-    int retval = deflateReset(&z);
-    z.next_in = in_buf.data();
-    z.avail_in = header.block_size;
-    z.next_out = out_buf.data();
-    z.avail_out = block_size;
+    std::atomic<bool> deflate_failed{false};
+    Common::ParallelFor(count, [&](size_t i) {
+      if (!CompressBlock(&batch[i], header.block_size))
+        deflate_failed = true;
+    });
 
-    if (retval != Z_OK)
+    if (deflate_failed)
     {
       ERROR_LOG(DISCIO, "Deflate failed");
       success = false;
       break;
     }
 
-    int status = deflate(&z, Z_FINISH);
-    int comp_size = block_size - z.avail_out;
-
-    u8* write_buf;
-    int write_size;
-    if ((status != Z_STREAM_END) || (z.avail_out < 10))
+    for (u32 i = 0; i < count; i++)
     {
-      // PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-      // let's store uncompressed
-      write_buf = in_buf.data();
-      offsets[i] |= 0x8000000000000000ULL;
-      write_size = block_size;
-      num_stored++;
-    }
-    else
-    {
-      // let's store compressed
-      // PanicAlert("Comp %i to %i", block_size, comp_size);
-      write_buf = out_buf.data();
-      write_size = comp_size;
-      num_compressed++;
-    }
+      const CompressionBlock& block = batch[i];
+      offsets[first + i] = position;
 
-    if (!outfile.WriteBytes(write_buf, write_size))
-    {
-      PanicAlertT("Failed to write the output file \"%s\".\n"
-                  "Check that you have enough space available on the target drive.",
-                  outfile_path.c_str());
-      success = false;
-      break;
-    }
+      const u8* write_buf;
+      if (block.stored)
+      {
+        // let's store uncompressed
+        write_buf = block.in_buf.data();
+        offsets[first + i] |= 0x8000000000000000ULL;
+        num_stored++;
+      }
+      else
+      {
+        // let's store compressed
+        write_buf = block.out_buf.data();
+        num_compressed++;
+      }
+
+      if (!outfile.WriteBytes(write_buf, block.out_size))
+      {
+        PanicAlertT("Failed to write the output file \"%s\".\n"
+                    "Check that you have enough space available on the target drive.",
+                    outfile_path.c_str());
+        success = false;
+        break;
+      }
 
-    position += write_size;
+      position += block.out_size;
 
-    hashes[i] = Common::HashAdler32(write_buf, write_size);
+      hashes[first + i] = Common::HashAdler32(write_buf, block.out_size);
+    }
   }
 
   header.compressed_data_size = position;
@@ -324,9 +363,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     outfile.WriteArray(hashes.data(), header.num_blocks);
   }
 
-  // Cleanup
-  deflateEnd(&z);
-
   if (success)
   {
     callback(GetStringT("Done compressing disc image."), 1.0f, arg);
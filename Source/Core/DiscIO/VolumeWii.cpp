@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <map>
@@ -21,6 +22,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
+#include "Common/ParallelFor.h"
 #include "Common/Swap.h"
 
 #include "DiscIO/Blob.h"
@@ -161,6 +163,21 @@ bool VolumeWii::Read(u64 offset, u64 length, u8* buffer, const Partition& partit
                                offset / BLOCK_DATA_SIZE * BLOCK_TOTAL_SIZE;
     u64 data_offset_in_block = offset % BLOCK_DATA_SIZE;
 
+    // Large reads of whole blocks are decrypted in parallel, straight into the caller's buffer.
+    if (data_offset_in_block == 0 && length >= PARALLEL_DECRYPTION_MIN_BLOCKS * BLOCK_DATA_SIZE)
+    {
+      const u64 num_blocks =
+          std::min<u64>(length / BLOCK_DATA_SIZE, PARALLEL_DECRYPTION_MAX_BLOCKS);
+      if (!ReadAndDecryptBlocks(block_offset_on_disc, num_blocks, buffer, aes_context))
+        return false;
+
+      const u64 copy_size = num_blocks * BLOCK_DATA_SIZE;
+      length -= copy_size;
+      buffer += copy_size;
+      offset += copy_size;
+      continue;
+    }
+
     if (m_last_decrypted_block != block_offset_on_disc)
     {
       // Read the current block
@@ -195,6 +212,23 @@ bool VolumeWii::Read(u64 offset, u64 length, u8* buffer, const Partition& partit
   return true;
 }
 
+bool VolumeWii::ReadAndDecryptBlocks(u64 block_offset_on_disc, u64 num_blocks, u8* buffer,
+                                     mbedtls_aes_context* aes_context) const
+{
+  std::vector<u8> read_buffer(num_blocks * BLOCK_TOTAL_SIZE);
+  if (!m_reader->Read(block_offset_on_disc, read_buffer.size(), read_buffer.data()))
+    return false;
+
+  // mbedtls only reads from the AES context, so it can be shared between threads.
+  Common::ParallelFor(num_blocks, [&](size_t i) {
+    u8* block = &read_buffer[i * BLOCK_TOTAL_SIZE];
+    mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, BLOCK_DATA_SIZE, &block[0x3D0],
+                          &block[BLOCK_HEADER_SIZE], buffer + i * BLOCK_DATA_SIZE);
+  });
+
+  return true;
+}
+
 bool VolumeWii::IsEncryptedAndHashed() const
 {
   return m_encrypted;
@@ -399,60 +433,74 @@ bool VolumeWii::CheckIntegrity(const Partition& partition) const
     return false;
 
   const u32 num_clusters = static_cast<u32>(part_data_size.value() / 0x8000);
-  for (u32 cluster_id = 0; cluster_id < num_clusters; ++cluster_id)
-  {
-    const u64 cluster_offset =
-        partition.offset + *partition_details.data_offset + static_cast<u64>(cluster_id) * 0x8000;
-
-    // Read and decrypt the cluster metadata
-    u8 cluster_metadata_crypted[0x400];
-    u8 cluster_metadata[0x400];
-    u8 iv[16] = {0};
-    if (!m_reader->Read(cluster_offset, sizeof(cluster_metadata_crypted), cluster_metadata_crypted))
-    {
-      WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", cluster_id);
-      return false;
-    }
-    mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, sizeof(cluster_metadata), iv,
-                          cluster_metadata_crypted, cluster_metadata);
-
-    // Some clusters have invalid data and metadata because they aren't
-    // meant to be read by the game (for example, holes between files). To
-    // try to avoid reporting errors because of these clusters, we check
-    // the 0x00 paddings in the metadata.
-    //
-    // This may cause some false negatives though: some bad clusters may be
-    // skipped because they are *too* bad and are not even recognized as
-    // valid clusters. To be improved.
-    const u8* pad_begin = cluster_metadata + 0x26C;
-    const u8* pad_end = pad_begin + 0x14;
-    const bool meaningless = std::any_of(pad_begin, pad_end, [](u8 val) { return val != 0; });
-
-    if (meaningless)
-      continue;
+  const u64 partition_data_offset = partition.offset + *partition_details.data_offset;
 
-    u8 cluster_data[0x7C00];
-    if (!Read(cluster_id * sizeof(cluster_data), sizeof(cluster_data), cluster_data, partition))
+  // Clusters are read in batches, and each batch is decrypted and hashed on several threads.
+  std::vector<u8> batch_buffer(PARALLEL_DECRYPTION_MAX_BLOCKS * BLOCK_TOTAL_SIZE);
+  for (u32 batch_start = 0; batch_start < num_clusters;
+       batch_start += static_cast<u32>(PARALLEL_DECRYPTION_MAX_BLOCKS))
+  {
+    const u32 batch_size =
+        std::min(num_clusters - batch_start, static_cast<u32>(PARALLEL_DECRYPTION_MAX_BLOCKS));
+    if (!m_reader->Read(partition_data_offset + static_cast<u64>(batch_start) * BLOCK_TOTAL_SIZE,
+                        static_cast<u64>(batch_size) * BLOCK_TOTAL_SIZE, batch_buffer.data()))
     {
-      WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read data", cluster_id);
+      WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read data", batch_start);
       return false;
     }
 
-    for (u32 hash_id = 0; hash_id < 31; ++hash_id)
-    {
-      u8 hash[20];
+    std::atomic<bool> valid{true};
+    Common::ParallelFor(batch_size, [&](size_t i) {
+      const u32 cluster_id = batch_start + static_cast<u32>(i);
+      u8* cluster = &batch_buffer[i * BLOCK_TOTAL_SIZE];
+
+      // Decrypt the cluster metadata
+      u8 cluster_metadata[BLOCK_HEADER_SIZE];
+      u8 iv[16] = {0};
+      mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, sizeof(cluster_metadata), iv,
+                            cluster, cluster_metadata);
+
+      // Some clusters have invalid data and metadata because they aren't
+      // meant to be read by the game (for example, holes between files). To
+      // try to avoid reporting errors because of these clusters, we check
+      // the 0x00 paddings in the metadata.
+      //
+      // This may cause some false negatives though: some bad clusters may be
+      // skipped because they are *too* bad and are not even recognized as
+      // valid clusters. To be improved.
+      const u8* pad_begin = cluster_metadata + 0x26C;
+      const u8* pad_end = pad_begin + 0x14;
+      const bool meaningless = std::any_of(pad_begin, pad_end, [](u8 val) { return val != 0; });
+
+      if (meaningless)
+        return;
+
+      // 0x3D0 - 0x3DF of the encrypted metadata is the IV of the data and gets overwritten here,
+      // but the metadata has already been decrypted at this point.
+      u8 cluster_data[BLOCK_DATA_SIZE];
+      mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, sizeof(cluster_data), &cluster[0x3D0],
+                            &cluster[BLOCK_HEADER_SIZE], cluster_data);
+
+      for (u32 hash_id = 0; hash_id < 31; ++hash_id)
+      {
+        u8 hash[20];
 
-      mbedtls_sha1(cluster_data + hash_id * sizeof(cluster_metadata), sizeof(cluster_metadata),
-                   hash);
+        mbedtls_sha1(cluster_data + hash_id * sizeof(cluster_metadata), sizeof(cluster_metadata),
+                     hash);
 
-      // Note that we do not use strncmp here
-      if (memcmp(hash, cluster_metadata + hash_id * sizeof(hash), sizeof(hash)))
-      {
-        WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: hash %d is invalid", cluster_id,
-                 hash_id);
-        return false;
+        // Note that we do not use strncmp here
+        if (memcmp(hash, cluster_metadata + hash_id * sizeof(hash), sizeof(hash)))
+        {
+          WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: hash %d is invalid", cluster_id,
+                   hash_id);
+          valid = false;
+          return;
+        }
       }
-    }
+    });
+
+    if (!valid)
+      return false;
   }
 
   return true;
@@ -71,6 +71,11 @@ protected:
   u32 GetOffsetShift() const override { return 2; }
 
 private:
+  // Reads of at least this many whole blocks are decrypted on several threads.
+  static constexpr u64 PARALLEL_DECRYPTION_MIN_BLOCKS = 8;
+  // Upper bound for how many blocks are read and decrypted in one batch.
+  static constexpr u64 PARALLEL_DECRYPTION_MAX_BLOCKS = 64;
+
   struct PartitionDetails
   {
     Common::Lazy<std::unique_ptr<mbedtls_aes_context>> key;
@@ -81,6 +86,9 @@ private:
     u32 type;
   };
 
+  bool ReadAndDecryptBlocks(u64 block_offset_on_disc, u64 num_blocks, u8* buffer,
+                            mbedtls_aes_context* aes_context) const;
+
   std::unique_ptr<BlobReader> m_reader;
   std::map<Partition, PartitionDetails> m_partitions;
   Partition m_game_partition;
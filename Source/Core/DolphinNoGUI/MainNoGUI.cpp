@@ -3,6 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <OptionParser.h>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
@@ -10,10 +13,12 @@
 #include <string>
 #include <thread>
 #include <unistd.h>
+#include <xxhash.h>
 
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
 #include "Common/Flag.h"
+#include "Common/Logging/Log.h"
 #include "Common/Logging/LogManager.h"
 #include "Common/MsgHandler.h"
 
@@ -22,6 +27,8 @@
 #include "Core/BootManager.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/FifoPlayer/FifoPlayer.h"
+#include "Core/HW/Memmap.h"
 #include "Core/Host.h"
 #include "Core/IOS/IOS.h"
 #include "Core/IOS/STM/STM.h"
@@ -34,6 +41,7 @@
 #include "UICommon/UICommon.h"
 
 #include "VideoCommon/RenderBase.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/VideoBackendBase.h"
 
 static bool rendererHasFocus = true;
@@ -42,6 +50,10 @@ static Common::Flag s_running{true};
 static Common::Flag s_shutdown_requested{false};
 static Common::Flag s_tried_graceful_shutdown{false};
 
+// Only written by the CPU thread while the FIFO log is playing.
+static std::atomic<u32> s_fifo_frames_played{0};
+static std::chrono::steady_clock::time_point s_fifo_playback_start;
+
 static void signal_handler(int)
 {
   const char message[] = "A signal was received. A second signal will force Dolphin to stop.\n";
@@ -371,9 +383,44 @@ static Platform* GetPlatform()
   return nullptr;
 }
 
+static void LogXFBHash(u32 address, u32 stride, u32 height)
+{
+  // Only called on the GPU thread.
+  static u32 s_xfb_copies = 0;
+
+  const u8* xfb = Memory::GetPointer(address);
+  if (!xfb)
+    return;
+
+  // Common::GetHash64 depends on the host CPU, so it can't be used to compare runs on different
+  // machines.
+  NOTICE_LOG(VIDEO, "XFB copy %u to %08x (%ux%u bytes): %016" PRIx64, s_xfb_copies++, address,
+             stride, height, static_cast<u64>(XXH64(xfb, stride * height, 0)));
+}
+
+static void LogFifoBenchmarkResults(std::chrono::steady_clock::duration elapsed)
+{
+  const u32 frames = s_fifo_frames_played;
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  NOTICE_LOG(VIDEO, "Played %u frames in %.3f s (%.2f frames/s)", frames, seconds,
+             seconds > 0 ? frames / seconds : 0.0);
+  NOTICE_LOG(VIDEO, "Time spent in each stage:\n%s", StageTimings::ToString().c_str());
+}
+
 int main(int argc, char* argv[])
 {
   auto parser = CommandLineParse::CreateParser(CommandLineParse::ParserOptions::OmitGUIOptions);
+  parser->add_option("--fifo-loops")
+      .dest("fifo_loops")
+      .type("int")
+      .metavar("<count>")
+      .help("Play a FIFO log the given number of times, then exit and log the frame rate and "
+            "the time spent in each stage of the video pipeline");
+  parser->add_option("--fifo-xfb-hashes")
+      .dest("fifo_xfb_hashes")
+      .action("store_true")
+      .help("When playing a FIFO log with --fifo-loops, log a hash of each XFB copy. This needs "
+            "a video backend that writes XFB copies to memory, such as the software renderer");
   optparse::Values& options = CommandLineParse::ParseArguments(parser.get(), argc, argv);
   std::vector<std::string> args = parser->args();
 
@@ -405,6 +452,26 @@ int main(int argc, char* argv[])
     return 0;
   }
 
+  int fifo_loops = 0;
+  if (options.is_set("fifo_loops"))
+  {
+    fifo_loops = options.get("fifo_loops");
+    if (fifo_loops <= 0)
+    {
+      fprintf(stderr, "Invalid FIFO loop count\n");
+      return 1;
+    }
+
+    FifoPlayer::GetInstance().SetLoopCount(static_cast<u32>(fifo_loops));
+    FifoPlayer::GetInstance().SetFrameWrittenCallback([] {
+      if (s_fifo_frames_played++ == 0)
+        s_fifo_playback_start = std::chrono::steady_clock::now();
+    });
+    if (options.is_set("fifo_xfb_hashes"))
+      FifoPlayer::GetInstance().SetXFBCopiedCallback(LogXFBHash);
+    StageTimings::SetEnabled(true);
+  }
+
   std::string user_directory;
   if (options.is_set("user"))
   {
@@ -421,6 +488,10 @@ int main(int argc, char* argv[])
   UICommon::SetUserDirectory(user_directory);
   UICommon::Init();
 
+  // The benchmark results are logged, regardless of which logs the user has enabled.
+  if (fifo_loops > 0)
+    LogManager::GetInstance()->SetEnable(LogTypes::VIDEO, true);
+
   Core::SetOnStateChangedCallback([](Core::State state) {
     if (state == Core::State::Uninitialized)
       s_running.Clear();
@@ -455,8 +526,12 @@ int main(int argc, char* argv[])
 
   if (s_running.IsSet())
     platform->MainLoop();
+  const auto playback_end = std::chrono::steady_clock::now();
   Core::Stop();
 
+  if (fifo_loops > 0 && s_fifo_frames_played > 0)
+    LogFifoBenchmarkResults(playback_end - s_fifo_playback_start);
+
   Core::Shutdown();
   platform->Shutdown();
   UICommon::Shutdown();
@@ -26,6 +26,6 @@ protected:
 private:
   void vFlush() override;
   std::vector<u8> m_local_v_buffer;
-  std::vector<u16> m_local_i_buffer;
+  std::vector<u32> m_local_i_buffer;
 };
 }
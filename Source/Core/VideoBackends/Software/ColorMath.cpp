@@ -0,0 +1,170 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoBackends/Software/ColorMath.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+
+namespace ColorMath
+{
+static constexpr s16 BIAS[4] = {0, 128, -128, 0};
+static constexpr u8 SCALE_LSHIFT[4] = {0, 1, 2, 0};
+static constexpr u8 SCALE_RSHIFT[4] = {0, 0, 0, 1};
+
+static s32 GetCombinerRounding(u32 shift, bool subtract)
+{
+  return (shift == 3) ? 0 : subtract ? 127 : 128;
+}
+
+namespace Reference
+{
+void CombineColor(const CombinerInputs& inputs, u32 bias, u32 shift, bool subtract, bool clamp,
+                  s16* result)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    const u16 c = inputs.c[i] + (inputs.c[i] >> 7);
+
+    s32 temp = inputs.a[i] * (256 - c) + (inputs.b[i] * c);
+    temp <<= SCALE_LSHIFT[shift];
+    temp += GetCombinerRounding(shift, subtract);
+    temp >>= 8;
+    temp = subtract ? -temp : temp;
+
+    s32 value = ((inputs.d[i] + BIAS[bias]) << SCALE_LSHIFT[shift]) + temp;
+    value = value >> SCALE_RSHIFT[shift];
+
+    result[i] = clamp ? std::clamp<s32>(value, 0, 255) : std::clamp<s32>(value, -1024, 1023);
+  }
+}
+
+void BlendColor(const u8* src, u8* dst, u32 src_factor, u32 dst_factor)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    // add MSB of factors to make their range 0 -> 256
+    u32 sf = (src_factor & 0xff);
+    sf += sf >> 7;
+
+    u32 df = (dst_factor & 0xff);
+    df += df >> 7;
+
+    u32 color = (src[i] * sf + dst[i] * df) >> 8;
+    dst[i] = (color > 255) ? 255 : color;
+
+    dst_factor >>= 8;
+    src_factor >>= 8;
+  }
+}
+
+void SubtractBlend(const u8* src, u8* dst)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    int c = (int)dst[i] - (int)src[i];
+    dst[i] = (c < 0) ? 0 : c;
+  }
+}
+}  // namespace Reference
+
+#if defined(_M_X86)
+
+// SSE2 is part of the x86-64 baseline, so no runtime check is needed.
+
+void CombineColor(const CombinerInputs& inputs, u32 bias, u32 shift, bool subtract, bool clamp,
+                  s16* result)
+{
+  const __m128i a = _mm_setr_epi16(inputs.a[0], inputs.a[1], inputs.a[2], 0, 0, 0, 0, 0);
+  const __m128i b = _mm_setr_epi16(inputs.b[0], inputs.b[1], inputs.b[2], 0, 0, 0, 0, 0);
+  __m128i c = _mm_setr_epi16(inputs.c[0], inputs.c[1], inputs.c[2], 0, 0, 0, 0, 0);
+  c = _mm_add_epi16(c, _mm_srli_epi16(c, 7));
+
+  // a * (256 - c) + b * c in a single multiply-add of the interleaved operands.
+  const __m128i ab = _mm_unpacklo_epi16(a, b);
+  const __m128i weights = _mm_unpacklo_epi16(_mm_sub_epi16(_mm_set1_epi16(256), c), c);
+  const __m128i lshift = _mm_cvtsi32_si128(SCALE_LSHIFT[shift]);
+
+  __m128i temp = _mm_sll_epi32(_mm_madd_epi16(ab, weights), lshift);
+  temp = _mm_add_epi32(temp, _mm_set1_epi32(GetCombinerRounding(shift, subtract)));
+  temp = _mm_srai_epi32(temp, 8);
+  if (subtract)
+    temp = _mm_sub_epi32(_mm_setzero_si128(), temp);
+
+  const s32 bias_value = BIAS[bias];
+  const __m128i d = _mm_setr_epi32(inputs.d[0] + bias_value, inputs.d[1] + bias_value,
+                                   inputs.d[2] + bias_value, 0);
+  __m128i value = _mm_add_epi32(_mm_sll_epi32(d, lshift), temp);
+  value = _mm_sra_epi32(value, _mm_cvtsi32_si128(SCALE_RSHIFT[shift]));
+
+  // The values fit into 16 bits before clamping, so the saturation of the pack never applies.
+  value = _mm_packs_epi32(value, value);
+  if (clamp)
+    value = _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), _mm_set1_epi16(255));
+  else
+    value = _mm_min_epi16(_mm_max_epi16(value, _mm_set1_epi16(-1024)), _mm_set1_epi16(1023));
+
+  s16 values[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values), value);
+  std::copy_n(values, 3, result);
+}
+
+void BlendColor(const u8* src, u8* dst, u32 src_factor, u32 dst_factor)
+{
+  u32 src_value, dst_value;
+  std::memcpy(&src_value, src, sizeof(u32));
+  std::memcpy(&dst_value, dst, sizeof(u32));
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i colors = _mm_unpacklo_epi16(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(src_value), zero),
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(dst_value), zero));
+
+  // add MSB of factors to make their range 0 -> 256
+  __m128i sf = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src_factor), zero);
+  __m128i df = _mm_unpacklo_epi8(_mm_cvtsi32_si128(dst_factor), zero);
+  sf = _mm_add_epi16(sf, _mm_srli_epi16(sf, 7));
+  df = _mm_add_epi16(df, _mm_srli_epi16(df, 7));
+
+  __m128i color = _mm_srli_epi32(_mm_madd_epi16(colors, _mm_unpacklo_epi16(sf, df)), 8);
+  color = _mm_packus_epi16(_mm_packs_epi32(color, color), zero);
+
+  dst_value = _mm_cvtsi128_si32(color);
+  std::memcpy(dst, &dst_value, sizeof(u32));
+}
+
+void SubtractBlend(const u8* src, u8* dst)
+{
+  u32 src_value, dst_value;
+  std::memcpy(&src_value, src, sizeof(u32));
+  std::memcpy(&dst_value, dst, sizeof(u32));
+
+  dst_value = _mm_cvtsi128_si32(
+      _mm_subs_epu8(_mm_cvtsi32_si128(dst_value), _mm_cvtsi32_si128(src_value)));
+  std::memcpy(dst, &dst_value, sizeof(u32));
+}
+
+#else
+
+void CombineColor(const CombinerInputs& inputs, u32 bias, u32 shift, bool subtract, bool clamp,
+                  s16* result)
+{
+  Reference::CombineColor(inputs, bias, shift, subtract, clamp, result);
+}
+
+void BlendColor(const u8* src, u8* dst, u32 src_factor, u32 dst_factor)
+{
+  Reference::BlendColor(src, dst, src_factor, dst_factor);
+}
+
+void SubtractBlend(const u8* src, u8* dst)
+{
+  Reference::SubtractBlend(src, dst);
+}
+
+#endif
+}  // namespace ColorMath
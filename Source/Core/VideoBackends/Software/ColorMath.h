@@ -0,0 +1,43 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Per-pixel color arithmetic shared by Tev and EfbInterface. Every function works on all color
+// components of a pixel at once, using SIMD where available. The Reference namespace contains
+// the plain per-component implementations, which the SIMD versions must match bit for bit.
+namespace ColorMath
+{
+// Inputs of the regular (non-compare) TEV color combiner for the blue, green and red components.
+// a, b and c are already truncated to 8 bits and d is sign-extended from 11 bits.
+struct CombinerInputs
+{
+  u8 a[3];
+  u8 b[3];
+  u8 c[3];
+  s16 d[3];
+};
+
+// Computes (d + bias + lerp(a, b, c) * (subtract ? -1 : 1)) * scale for the combiner's bias and
+// shift fields, clamped to [0, 255] if clamp is set and to [-1024, 1023] otherwise.
+void CombineColor(const CombinerInputs& inputs, u32 bias, u32 shift, bool subtract, bool clamp,
+                  s16* result);
+
+// Blends the four components of src and dst (both ABGR) with the given per-component factors,
+// storing the result, saturated to 255, in dst.
+void BlendColor(const u8* src, u8* dst, u32 src_factor, u32 dst_factor);
+
+// Stores max(dst - src, 0) in dst for each component.
+void SubtractBlend(const u8* src, u8* dst);
+
+namespace Reference
+{
+void CombineColor(const CombinerInputs& inputs, u32 bias, u32 shift, bool subtract, bool clamp,
+                  s16* result);
+void BlendColor(const u8* src, u8* dst, u32 src_factor, u32 dst_factor);
+void SubtractBlend(const u8* src, u8* dst);
+}  // namespace Reference
+}  // namespace ColorMath
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <vector>
@@ -14,6 +15,7 @@
 #include "Common/Logging/Log.h"
 #include "Common/Swap.h"
 
+#include "VideoBackends/Software/ColorMath.h"
 #include "VideoBackends/Software/CopyRegion.h"
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/LookUpTables.h"
@@ -23,7 +25,8 @@ namespace EfbInterface
 {
 static std::array<u8, EFB_WIDTH * EFB_HEIGHT * 6> efb;
 
-static std::array<u32, PQ_NUM_MEMBERS> perf_values;
+// Incremented from all rasterizer threads.
+static std::array<std::atomic<u32>, PQ_NUM_MEMBERS> perf_values;
 
 static inline u32 GetColorOffset(u16 x, u16 y)
 {
@@ -37,6 +40,20 @@ static inline u32 GetDepthOffset(u16 x, u16 y)
   return (x + y * EFB_WIDTH) * 3 + depth_buffer_start;
 }
 
+// Pixels are 3 bytes each and are only ever written as such: several threads may draw adjacent
+// rows of the same triangle, so a wider write could clobber a pixel another thread is writing.
+static u32 ReadPixel24(u32 offset)
+{
+  return efb[offset] | efb[offset + 1] << 8 | efb[offset + 2] << 16;
+}
+
+static void WritePixel24(u32 offset, u32 value)
+{
+  efb[offset] = static_cast<u8>(value);
+  efb[offset + 1] = static_cast<u8>(value >> 8);
+  efb[offset + 2] = static_cast<u8>(value >> 16);
+}
+
 static void SetPixelAlphaOnly(u32 offset, u8 a)
 {
   switch (bpmem.zcontrol.pixel_format)
@@ -49,10 +66,9 @@ static void SetPixelAlphaOnly(u32 offset, u8 a)
   case PEControl::RGBA6_Z24:
   {
     u32 a32 = a;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xffffffc0;
+    u32 val = ReadPixel24(offset) & 0xffffc0;
     val |= (a32 >> 2) & 0x0000003f;
-    *dst = val;
+    WritePixel24(offset, val);
   }
   break;
   default:
@@ -68,31 +84,24 @@ static void SetPixelColorOnly(u32 offset, u8* rgb)
   case PEControl::Z24:
   {
     u32 src = *(u32*)rgb;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    WritePixel24(offset, src >> 8);
   }
   break;
   case PEControl::RGBA6_Z24:
   {
     u32 src = *(u32*)rgb;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff00003f;
+    u32 val = ReadPixel24(offset) & 0x00003f;
     val |= (src >> 4) & 0x00000fc0;  // blue
     val |= (src >> 6) & 0x0003f000;  // green
     val |= (src >> 8) & 0x00fc0000;  // red
-    *dst = val;
+    WritePixel24(offset, val);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
     u32 src = *(u32*)rgb;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    WritePixel24(offset, src >> 8);
   }
   break;
   default:
@@ -108,32 +117,24 @@ static void SetPixelAlphaColor(u32 offset, u8* color)
   case PEControl::Z24:
   {
     u32 src = *(u32*)color;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    WritePixel24(offset, src >> 8);
   }
   break;
   case PEControl::RGBA6_Z24:
   {
     u32 src = *(u32*)color;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= (src >> 2) & 0x0000003f;  // alpha
-    val |= (src >> 4) & 0x00000fc0;  // blue
-    val |= (src >> 6) & 0x0003f000;  // green
-    val |= (src >> 8) & 0x00fc0000;  // red
-    *dst = val;
+    u32 val = (src >> 2) & 0x0000003f;  // alpha
+    val |= (src >> 4) & 0x00000fc0;     // blue
+    val |= (src >> 6) & 0x0003f000;     // green
+    val |= (src >> 8) & 0x00fc0000;     // red
+    WritePixel24(offset, val);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
     u32 src = *(u32*)color;
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= src >> 8;
-    *dst = val;
+    WritePixel24(offset, src >> 8);
   }
   break;
   default:
@@ -143,8 +144,7 @@ static void SetPixelAlphaColor(u32 offset, u8* color)
 
 static u32 GetPixelColor(u32 offset)
 {
-  u32 src;
-  std::memcpy(&src, &efb[offset], sizeof(u32));
+  const u32 src = ReadPixel24(offset);
 
   switch (bpmem.zcontrol.pixel_format)
   {
@@ -175,22 +175,12 @@ static void SetPixelDepth(u32 offset, u32 depth)
   case PEControl::RGB8_Z24:
   case PEControl::RGBA6_Z24:
   case PEControl::Z24:
-  {
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= depth & 0x00ffffff;
-    *dst = val;
-  }
-  break;
+    WritePixel24(offset, depth);
+    break;
   case PEControl::RGB565_Z16:
-  {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-    u32* dst = (u32*)&efb[offset];
-    u32 val = *dst & 0xff000000;
-    val |= depth & 0x00ffffff;
-    *dst = val;
-  }
-  break;
+    WritePixel24(offset, depth);
+    break;
   default:
     ERROR_LOG(VIDEO, "Unsupported pixel format: %i", static_cast<int>(bpmem.zcontrol.pixel_format));
   }
@@ -206,13 +196,13 @@ static u32 GetPixelDepth(u32 offset)
   case PEControl::RGBA6_Z24:
   case PEControl::Z24:
   {
-    depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+    depth = ReadPixel24(offset);
   }
   break;
   case PEControl::RGB565_Z16:
   {
     INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-    depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+    depth = ReadPixel24(offset);
   }
   break;
   default:
@@ -309,21 +299,7 @@ static void BlendColor(u8* srcClr, u8* dstClr)
   u32 srcFactor = GetSourceFactor(srcClr, dstClr, bpmem.blendmode.srcfactor);
   u32 dstFactor = GetDestinationFactor(srcClr, dstClr, bpmem.blendmode.dstfactor);
 
-  for (int i = 0; i < 4; i++)
-  {
-    // add MSB of factors to make their range 0 -> 256
-    u32 sf = (srcFactor & 0xff);
-    sf += sf >> 7;
-
-    u32 df = (dstFactor & 0xff);
-    df += df >> 7;
-
-    u32 color = (srcClr[i] * sf + dstClr[i] * df) >> 8;
-    dstClr[i] = (color > 255) ? 255 : color;
-
-    dstFactor >>= 8;
-    srcFactor >>= 8;
-  }
+  ColorMath::BlendColor(srcClr, dstClr, srcFactor, dstFactor);
 }
 
 static void LogicBlend(u32 srcClr, u32* dstClr, BlendMode::LogicOp op)
@@ -381,15 +357,6 @@ static void LogicBlend(u32 srcClr, u32* dstClr, BlendMode::LogicOp op)
   }
 }
 
-static void SubtractBlend(u8* srcClr, u8* dstClr)
-{
-  for (int i = 0; i < 4; i++)
-  {
-    int c = (int)dstClr[i] - (int)srcClr[i];
-    dstClr[i] = (c < 0) ? 0 : c;
-  }
-}
-
 static void Dither(u16 x, u16 y, u8* color)
 {
   // No blending for RGB8 mode
@@ -414,7 +381,7 @@ void BlendTev(u16 x, u16 y, u8* color)
   if (bpmem.blendmode.blendenable)
   {
     if (bpmem.blendmode.subtract)
-      SubtractBlend(color, dstClrPtr);
+      ColorMath::SubtractBlend(color, dstClrPtr);
     else
       BlendColor(color, dstClrPtr);
   }
@@ -693,7 +660,8 @@ u32 GetPerfQueryResult(PerfQueryType type)
 
 void ResetPerfQuery()
 {
-  perf_values = {};
+  for (std::atomic<u32>& value : perf_values)
+    value = 0;
 }
 
 void IncPerfCounterQuadCount(PerfQueryType type)
@@ -702,10 +670,9 @@ void IncPerfCounterQuadCount(PerfQueryType type)
   // Current software renderer architecture works on pixels though, so
   // we have this "quad" hack here to only increment the registers on
   // every fourth rendered pixel
-  static u32 quad[PQ_NUM_MEMBERS];
-  if (++quad[type] != 3)
+  static std::array<std::atomic<u32>, PQ_NUM_MEMBERS> quad;
+  if (++quad[type] % 3 != 0)
     return;
-  quad[type] = 0;
   ++perf_values[type];
 }
 }
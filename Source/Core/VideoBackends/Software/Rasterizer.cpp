@@ -4,13 +4,18 @@
 
 #include <algorithm>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/ParallelFor.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/Tev.h"
+#include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/PerfQueryBase.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/XFMemory.h"
@@ -19,6 +24,12 @@ namespace Rasterizer
 {
 static constexpr int BLOCK_SIZE = 2;
 
+// Triangles covering fewer pixels than this are not worth waking up other threads for.
+static constexpr s32 MIN_PARALLEL_AREA = 64 * 64;
+
+// Block rows are distributed over the threads in bands of this many pixel rows.
+static constexpr s32 BAND_HEIGHT = 8 * BLOCK_SIZE;
+
 static Slope ZSlope;
 static Slope WSlope;
 static Slope ColorSlopes[2][4];
@@ -29,12 +40,25 @@ static s32 vertex0Y;
 static float vertexOffsetX;
 static float vertexOffsetY;
 
-static Tev tev;
-static RasterBlock rasterBlock;
+// The per-pixel state. Every thread drawing a triangle has its own, while the slopes above are
+// only written during triangle setup and shared.
+struct RasterContext
+{
+  Tev tev;
+  RasterBlock rasterBlock;
+  int rasterizedPixels = 0;
+};
+
+static std::vector<std::unique_ptr<RasterContext>> contexts;
 
 void Init()
 {
-  tev.Init();
+  contexts.clear();
+  for (size_t i = 0; i < Common::GetParallelForThreadCount(); ++i)
+  {
+    contexts.push_back(std::make_unique<RasterContext>());
+    contexts.back()->tev.Init();
+  }
 
   // Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the
   // first primitive.
@@ -67,12 +91,13 @@ static inline int iround(float x)
 
 void SetTevReg(int reg, int comp, s16 color)
 {
-  tev.SetRegColor(reg, comp, color);
+  for (auto& context : contexts)
+    context->tev.SetRegColor(reg, comp, color);
 }
 
-static void Draw(s32 x, s32 y, s32 xi, s32 yi)
+static void Draw(RasterContext& context, s32 x, s32 y, s32 xi, s32 yi)
 {
-  INCSTAT(stats.thisFrame.rasterizedPixels);
+  context.rasterizedPixels++;
 
   float dx = vertexOffsetX + (float)(x - vertex0X);
   float dy = vertexOffsetY + (float)(y - vertex0Y);
@@ -92,7 +117,9 @@ static void Draw(s32 x, s32 y, s32 xi, s32 yi)
     EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
   }
 
-  RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
+  Tev& tev = context.tev;
+  const RasterBlock& rasterBlock = context.rasterBlock;
+  const RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
   tev.Position[0] = x;
   tev.Position[1] = y;
@@ -160,7 +187,8 @@ static void InitSlope(Slope* slope, float f1, float f2, float f3, float DX31, fl
   slope->f0 = f1;
 }
 
-static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoord)
+static inline void CalculateLOD(const RasterBlock& rasterBlock, s32* lodp, bool* linear,
+                                u32 texmap, u32 texcoord)
 {
   const FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
   const u8 subTexmap = texmap & 3;
@@ -173,17 +201,17 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
   float sDelta, tDelta;
   if (tm0.diag_lod)
   {
-    float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-    float* uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+    const float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+    const float* uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
     sDelta = fabsf(uv0[0] - uv1[0]);
     tDelta = fabsf(uv0[1] - uv1[1]);
   }
   else
   {
-    float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-    float* uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-    float* uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+    const float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+    const float* uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+    const float* uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
     sDelta = std::max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
     tDelta = std::max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -208,7 +236,7 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
   *lodp = lod;
 }
 
-static void BuildBlock(s32 blockX, s32 blockY)
+static void BuildBlock(RasterBlock& rasterBlock, s32 blockX, s32 blockY)
 {
   for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
   {
@@ -247,7 +275,8 @@ static void BuildBlock(s32 blockX, s32 blockY)
     u32 texcoord = indref & 3;
     indref >>= 3;
 
-    CalculateLOD(&rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
+    CalculateLOD(rasterBlock, &rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap,
+                 texcoord);
   }
 
   for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -259,7 +288,97 @@ static void BuildBlock(s32 blockX, s32 blockY)
       u32 texmap = order.getTexMap(stageOdd);
       u32 texcoord = order.getTexCoord(stageOdd);
 
-      CalculateLOD(&rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+      CalculateLOD(rasterBlock, &rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap,
+                   texcoord);
+    }
+  }
+}
+
+// Half-edge constants and deltas of a triangle, in 28.4 fixed point.
+struct TriangleEdges
+{
+  s32 C1, C2, C3;
+  s32 DX12, DX23, DX31;
+  s32 DY12, DY23, DY31;
+  s32 FDX12, FDX23, FDX31;
+  s32 FDY12, FDY23, FDY31;
+};
+
+static void DrawBlockRow(RasterContext& context, const TriangleEdges& e, s32 y, s32 minx,
+                         s32 maxx)
+{
+  for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
+  {
+    // Corners of block
+    s32 x0 = x << 4;
+    s32 x1 = (x + BLOCK_SIZE - 1) << 4;
+    s32 y0 = y << 4;
+    s32 y1 = (y + BLOCK_SIZE - 1) << 4;
+
+    // Evaluate half-space functions
+    bool a00 = e.C1 + e.DX12 * y0 - e.DY12 * x0 > 0;
+    bool a10 = e.C1 + e.DX12 * y0 - e.DY12 * x1 > 0;
+    bool a01 = e.C1 + e.DX12 * y1 - e.DY12 * x0 > 0;
+    bool a11 = e.C1 + e.DX12 * y1 - e.DY12 * x1 > 0;
+    int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
+
+    bool b00 = e.C2 + e.DX23 * y0 - e.DY23 * x0 > 0;
+    bool b10 = e.C2 + e.DX23 * y0 - e.DY23 * x1 > 0;
+    bool b01 = e.C2 + e.DX23 * y1 - e.DY23 * x0 > 0;
+    bool b11 = e.C2 + e.DX23 * y1 - e.DY23 * x1 > 0;
+    int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
+
+    bool c00 = e.C3 + e.DX31 * y0 - e.DY31 * x0 > 0;
+    bool c10 = e.C3 + e.DX31 * y0 - e.DY31 * x1 > 0;
+    bool c01 = e.C3 + e.DX31 * y1 - e.DY31 * x0 > 0;
+    bool c11 = e.C3 + e.DX31 * y1 - e.DY31 * x1 > 0;
+    int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
+
+    // Skip block when outside an edge
+    if (a == 0x0 || b == 0x0 || c == 0x0)
+      continue;
+
+    BuildBlock(context.rasterBlock, x, y);
+
+    // Accept whole block when totally covered
+    if (a == 0xF && b == 0xF && c == 0xF)
+    {
+      for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+      {
+        for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+        {
+          Draw(context, x + ix, y + iy, ix, iy);
+        }
+      }
+    }
+    else  // Partially covered block
+    {
+      s32 CY1 = e.C1 + e.DX12 * y0 - e.DY12 * x0;
+      s32 CY2 = e.C2 + e.DX23 * y0 - e.DY23 * x0;
+      s32 CY3 = e.C3 + e.DX31 * y0 - e.DY31 * x0;
+
+      for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+      {
+        s32 CX1 = CY1;
+        s32 CX2 = CY2;
+        s32 CX3 = CY3;
+
+        for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+        {
+          if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+          {
+            Draw(context, x + ix, y + iy, ix, iy);
+          }
+
+          CX1 -= e.FDY12;
+          CX2 -= e.FDY23;
+          CX3 -= e.FDY31;
+        }
+
+        CY1 += e.FDX12;
+        CY2 += e.FDX23;
+        CY3 += e.FDX31;
+      }
     }
   }
 }
@@ -269,6 +388,8 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
 {
   INCSTAT(stats.thisFrame.numTrianglesDrawn);
 
+  StageTimings::ScopedTimer timer(StageTimings::Stage::Rasterize);
+
   // adapted from http://devmaster.net/posts/6145/advanced-rasterization
 
   // 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
@@ -388,83 +509,58 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   minx &= ~(BLOCK_SIZE - 1);
   miny &= ~(BLOCK_SIZE - 1);
 
-  // Loop through blocks
-  for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
-  {
-    for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
-    {
-      // Corners of block
-      s32 x0 = x << 4;
-      s32 x1 = (x + BLOCK_SIZE - 1) << 4;
-      s32 y0 = y << 4;
-      s32 y1 = (y + BLOCK_SIZE - 1) << 4;
-
-      // Evaluate half-space functions
-      bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
-      bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
-      bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
-      bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
-      int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
-
-      bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
-      bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
-      bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
-      bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
-      int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
-
-      bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
-      bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
-      bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
-      bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
-      int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
-
-      // Skip block when outside an edge
-      if (a == 0x0 || b == 0x0 || c == 0x0)
-        continue;
-
-      BuildBlock(x, y);
-
-      // Accept whole block when totally covered
-      if (a == 0xF && b == 0xF && c == 0xF)
-      {
-        for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-        {
-          for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-          {
-            Draw(x + ix, y + iy, ix, iy);
-          }
-        }
-      }
-      else  // Partially covered block
-      {
-        s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
-        s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
-        s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
+  const TriangleEdges edges = {C1,    C2,    C3,    DX12,  DX23,  DX31,  DY12,  DY23,
+                               DY31,  FDX12, FDX23, FDX31, FDY12, FDY23, FDY31};
 
-        for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-        {
-          s32 CX1 = CY1;
-          s32 CX2 = CY2;
-          s32 CX3 = CY3;
+  // Pixels within a triangle never overlap, so large triangles can be split into bands of block
+  // rows that are drawn at the same time without changing the result. The debug dumps write to
+  // shared buffers and are kept on a single thread.
+  size_t num_threads = 1;
+  if ((maxx - minx) * (maxy - miny) >= MIN_PARALLEL_AREA && !g_ActiveConfig.bDumpTevStages &&
+      !g_ActiveConfig.bDumpTevTextureFetches)
+  {
+    num_threads = contexts.size();
+  }
 
-          for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-          {
-            if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-            {
-              Draw(x + ix, y + iy, ix, iy);
-            }
-
-            CX1 -= FDY12;
-            CX2 -= FDY23;
-            CX3 -= FDY31;
-          }
+  for (size_t i = 0; i < num_threads; ++i)
+  {
+    contexts[i]->tev.SetupStages();
+    std::copy_n(BoundingBox::coords, 4, contexts[i]->tev.BoundingBoxCoords);
+  }
 
-          CY1 += FDX12;
-          CY2 += FDX23;
-          CY3 += FDX31;
+  const s32 band_stride = static_cast<s32>(num_threads) * BAND_HEIGHT;
+  Common::ParallelFor(
+      num_threads,
+      [&](size_t i) {
+        RasterContext& context = *contexts[i];
+        for (s32 band = miny + static_cast<s32>(i) * BAND_HEIGHT; band < maxy; band += band_stride)
+        {
+          const s32 band_end = std::min(band + BAND_HEIGHT, maxy);
+          for (s32 y = band; y < band_end; y += BLOCK_SIZE)
+            DrawBlockRow(context, edges, y, minx, maxx);
         }
-      }
-    }
+      },
+      num_threads);
+
+  for (size_t i = 0; i < num_threads; ++i)
+  {
+    RasterContext& context = *contexts[i];
+    ADDSTAT(stats.thisFrame.rasterizedPixels, context.rasterizedPixels);
+    ADDSTAT(stats.thisFrame.tevPixelsIn, context.tev.PixelsIn);
+    ADDSTAT(stats.thisFrame.tevPixelsOut, context.tev.PixelsOut);
+    context.rasterizedPixels = 0;
+    context.tev.PixelsIn = 0;
+    context.tev.PixelsOut = 0;
+
+    const u16* coords = context.tev.BoundingBoxCoords;
+    BoundingBox::coords[BoundingBox::LEFT] =
+        std::min(coords[BoundingBox::LEFT], BoundingBox::coords[BoundingBox::LEFT]);
+    BoundingBox::coords[BoundingBox::RIGHT] =
+        std::max(coords[BoundingBox::RIGHT], BoundingBox::coords[BoundingBox::RIGHT]);
+    BoundingBox::coords[BoundingBox::TOP] =
+        std::min(coords[BoundingBox::TOP], BoundingBox::coords[BoundingBox::TOP]);
+    BoundingBox::coords[BoundingBox::BOTTOM] =
+        std::max(coords[BoundingBox::BOTTOM], BoundingBox::coords[BoundingBox::BOTTOM]);
   }
 }
 }
@@ -22,6 +22,7 @@
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/Statistics.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/VertexLoaderBase.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VideoConfig.h"
@@ -57,6 +58,9 @@ void SWVertexLoader::ResetBuffer(u32 stride)
 
 void SWVertexLoader::vFlush()
 {
+  // Transforming the vertices also sets up and clips the primitives, which then get rasterized.
+  StageTimings::ScopedTimer timer(StageTimings::Stage::Transform);
+
   DebugUtil::OnObjectBegin();
 
   u8 primitiveType = 0;
@@ -89,7 +93,7 @@ void SWVertexLoader::vFlush()
 
   for (u32 i = 0; i < IndexGenerator::GetIndexLen(); i++)
   {
-    const u16 index = m_local_index_buffer[i];
+    const u32 index = m_local_index_buffer[i];
     memset(&m_vertex, 0, sizeof(m_vertex));
 
     // Super Mario Sunshine requires those to be zero for those debug boxes.
@@ -31,7 +31,7 @@ private:
   void ParseVertex(const PortableVertexDeclaration& vdec, int index);
 
   std::vector<u8> m_local_vertex_buffer;
-  std::vector<u16> m_local_index_buffer;
+  std::vector<u32> m_local_index_buffer;
 
   InputVertexData m_vertex;
   SetupUnit m_setup_unit;
@@ -6,6 +6,7 @@
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "VideoBackends/Software/ColorMath.h"
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/Tev.h"
@@ -14,7 +15,6 @@
 #include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/PerfQueryBase.h"
 #include "VideoCommon/PixelShaderManager.h"
-#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/XFMemory.h"
 
@@ -169,28 +169,16 @@ static inline s16 Clamp1024(s16 in)
   return in > 1023 ? 1023 : (in < -1024 ? -1024 : in);
 }
 
-void Tev::SetRasColor(int colorChan, int swaptable)
+void Tev::SetRasColor(const StageSetup& stage)
 {
-  switch (colorChan)
+  switch (stage.RasChannel)
   {
   case 0:  // Color0
-  {
-    const u8* color = Color[0];
-    RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
-    swaptable++;
-    RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
-  }
-  break;
   case 1:  // Color1
   {
-    const u8* color = Color[1];
-    RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
-    swaptable++;
-    RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
+    const u8* color = Color[stage.RasChannel];
+    for (int comp = 0; comp < 4; comp++)
+      RasColor[comp] = color[stage.RasSwap[comp]];
   }
   break;
   case 5:  // alpha bump
@@ -223,23 +211,18 @@ void Tev::SetRasColor(int colorChan, int swaptable)
 
 void Tev::DrawColorRegular(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4])
 {
+  ColorMath::CombinerInputs combiner_inputs;
   for (int i = 0; i < 3; i++)
   {
-    const InputRegType& InputReg = inputs[BLU_C + i];
-
-    const u16 c = InputReg.c + (InputReg.c >> 7);
-
-    s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-    temp <<= m_ScaleLShiftLUT[cc.shift];
-    temp += (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
-    temp >>= 8;
-    temp = cc.op ? -temp : temp;
-
-    s32 result = ((InputReg.d + m_BiasLUT[cc.bias]) << m_ScaleLShiftLUT[cc.shift]) + temp;
-    result = result >> m_ScaleRShiftLUT[cc.shift];
-
-    Reg[cc.dest][BLU_C + i] = result;
+    combiner_inputs.a[i] = inputs[BLU_C + i].a;
+    combiner_inputs.b[i] = inputs[BLU_C + i].b;
+    combiner_inputs.c[i] = inputs[BLU_C + i].c;
+    combiner_inputs.d[i] = inputs[BLU_C + i].d;
   }
+
+  // This also applies the clamping.
+  ColorMath::CombineColor(combiner_inputs, cc.bias, cc.shift, cc.op, cc.clamp,
+                          &Reg[cc.dest][BLU_C]);
 }
 
 void Tev::DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4])
@@ -562,12 +545,67 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
   }
 }
 
+static void DecodeSwapTable(u32 swaptable, u8* swap)
+{
+  swap[Tev::RED_C] = bpmem.tevksel[swaptable].swap1;
+  swap[Tev::GRN_C] = bpmem.tevksel[swaptable].swap2;
+  swaptable++;
+  swap[Tev::BLU_C] = bpmem.tevksel[swaptable].swap1;
+  swap[Tev::ALP_C] = bpmem.tevksel[swaptable].swap2;
+}
+
+void Tev::SetupStages()
+{
+  for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+  {
+    StageSetup& stage = m_StageSetup[stageNum];
+
+    const int stageNum2 = stageNum >> 1;
+    const int stageOdd = stageNum & 1;
+    const TwoTevStageOrders& order = bpmem.tevorders[stageNum2];
+    const TevKSel& kSel = bpmem.tevksel[stageNum2];
+    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+    const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
+
+    // An all-zero indirect stage passes the texture coordinate through unchanged and sets the
+    // bump alpha to zero, which is by far the most common case.
+    stage.IndirectEnabled = bpmem.tevind[stageNum].hex != 0;
+
+    stage.TextureEnabled = order.getEnable(stageOdd);
+    stage.TexCoord = order.getTexCoord(stageOdd);
+    stage.TexMap = order.getTexMap(stageOdd);
+    DecodeSwapTable(ac.tswap * 2, stage.TexSwap);
+
+    stage.RasChannel = order.getColorChan(stageOdd);
+    DecodeSwapTable(ac.rswap * 2, stage.RasSwap);
+
+    const int kc = kSel.getKC(stageOdd);
+    const int ka = kSel.getKA(stageOdd);
+    stage.Konst[RED_C] = m_KonstLUT[kc][RED_C];
+    stage.Konst[GRN_C] = m_KonstLUT[kc][GRN_C];
+    stage.Konst[BLU_C] = m_KonstLUT[kc][BLU_C];
+    stage.Konst[ALP_C] = m_KonstLUT[ka][ALP_C];
+
+    for (int i = 0; i < 3; i++)
+    {
+      stage.ColorInputs[0][i] = m_ColorInputLUT[cc.a][i];
+      stage.ColorInputs[1][i] = m_ColorInputLUT[cc.b][i];
+      stage.ColorInputs[2][i] = m_ColorInputLUT[cc.c][i];
+      stage.ColorInputs[3][i] = m_ColorInputLUT[cc.d][i];
+    }
+    stage.AlphaInputs[0] = m_AlphaInputLUT[ac.a];
+    stage.AlphaInputs[1] = m_AlphaInputLUT[ac.b];
+    stage.AlphaInputs[2] = m_AlphaInputLUT[ac.c];
+    stage.AlphaInputs[3] = m_AlphaInputLUT[ac.d];
+  }
+}
+
 void Tev::Draw()
 {
   ASSERT(Position[0] >= 0 && Position[0] < EFB_WIDTH);
   ASSERT(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
 
-  INCSTAT(stats.thisFrame.tevPixelsIn);
+  PixelsIn++;
 
   // initial color values
   for (int i = 0; i < 4; i++)
@@ -607,84 +645,82 @@ void Tev::Draw()
 
   for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
   {
-    const int stageNum2 = stageNum >> 1;
-    const int stageOdd = stageNum & 1;
-    const TwoTevStageOrders& order = bpmem.tevorders[stageNum2];
-    const TevKSel& kSel = bpmem.tevksel[stageNum2];
+    const StageSetup& stage = m_StageSetup[stageNum];
 
     // stage combiners
     const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
     const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
 
-    const int texcoordSel = order.getTexCoord(stageOdd);
-    const int texmap = order.getTexMap(stageOdd);
-
-    Indirect(stageNum, Uv[texcoordSel].s, Uv[texcoordSel].t);
+    if (stage.IndirectEnabled)
+    {
+      Indirect(stageNum, Uv[stage.TexCoord].s, Uv[stage.TexCoord].t);
+    }
+    else
+    {
+      TexCoord.s = Uv[stage.TexCoord].s;
+      TexCoord.t = Uv[stage.TexCoord].t;
+      AlphaBump = 0;
+    }
 
     // sample texture
-    if (order.getEnable(stageOdd))
+    if (stage.TextureEnabled)
     {
       // RGBA
       u8 texel[4];
 
       TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum],
-                             texmap, texel);
+                             stage.TexMap, texel);
 
 #if ALLOW_TEV_DUMPS
       if (g_ActiveConfig.bDumpTevTextureFetches)
         DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
 #endif
 
-      int swaptable = ac.tswap * 2;
-
-      TexColor[RED_C] = texel[bpmem.tevksel[swaptable].swap1];
-      TexColor[GRN_C] = texel[bpmem.tevksel[swaptable].swap2];
-      swaptable++;
-      TexColor[BLU_C] = texel[bpmem.tevksel[swaptable].swap1];
-      TexColor[ALP_C] = texel[bpmem.tevksel[swaptable].swap2];
+      for (int comp = 0; comp < 4; comp++)
+        TexColor[comp] = texel[stage.TexSwap[comp]];
     }
 
     // set konst for this stage
-    const int kc = kSel.getKC(stageOdd);
-    const int ka = kSel.getKA(stageOdd);
-    StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
-    StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
-    StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
-    StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
+    for (int comp = 0; comp < 4; comp++)
+      StageKonst[comp] = *stage.Konst[comp];
 
     // set color
-    SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
+    SetRasColor(stage);
 
     // combine inputs
     InputRegType inputs[4];
     for (int i = 0; i < 3; i++)
     {
-      inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
-      inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
-      inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
-      inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
+      inputs[BLU_C + i].a = *stage.ColorInputs[0][i];
+      inputs[BLU_C + i].b = *stage.ColorInputs[1][i];
+      inputs[BLU_C + i].c = *stage.ColorInputs[2][i];
+      inputs[BLU_C + i].d = *stage.ColorInputs[3][i];
     }
-    inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
-    inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
-    inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
-    inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
+    inputs[ALP_C].a = *stage.AlphaInputs[0];
+    inputs[ALP_C].b = *stage.AlphaInputs[1];
+    inputs[ALP_C].c = *stage.AlphaInputs[2];
+    inputs[ALP_C].d = *stage.AlphaInputs[3];
 
     if (cc.bias != 3)
-      DrawColorRegular(cc, inputs);
-    else
-      DrawColorCompare(cc, inputs);
-
-    if (cc.clamp)
     {
-      Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
-      Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
-      Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+      DrawColorRegular(cc, inputs);
     }
     else
     {
-      Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
-      Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
-      Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+      DrawColorCompare(cc, inputs);
+
+      if (cc.clamp)
+      {
+        Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
+        Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
+        Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+      }
+      else
+      {
+        Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
+        Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
+        Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+      }
     }
 
     if (ac.bias != 3)
@@ -841,14 +877,14 @@ void Tev::Draw()
   }
 
   // branchless bounding box update
-  BoundingBox::coords[BoundingBox::LEFT] =
-      std::min((u16)Position[0], BoundingBox::coords[BoundingBox::LEFT]);
-  BoundingBox::coords[BoundingBox::RIGHT] =
-      std::max((u16)Position[0], BoundingBox::coords[BoundingBox::RIGHT]);
-  BoundingBox::coords[BoundingBox::TOP] =
-      std::min((u16)Position[1], BoundingBox::coords[BoundingBox::TOP]);
-  BoundingBox::coords[BoundingBox::BOTTOM] =
-      std::max((u16)Position[1], BoundingBox::coords[BoundingBox::BOTTOM]);
+  BoundingBoxCoords[BoundingBox::LEFT] =
+      std::min((u16)Position[0], BoundingBoxCoords[BoundingBox::LEFT]);
+  BoundingBoxCoords[BoundingBox::RIGHT] =
+      std::max((u16)Position[0], BoundingBoxCoords[BoundingBox::RIGHT]);
+  BoundingBoxCoords[BoundingBox::TOP] =
+      std::min((u16)Position[1], BoundingBoxCoords[BoundingBox::TOP]);
+  BoundingBoxCoords[BoundingBox::BOTTOM] =
+      std::max((u16)Position[1], BoundingBoxCoords[BoundingBox::BOTTOM]);
 
 #if ALLOW_TEV_DUMPS
   if (g_ActiveConfig.bDumpTevStages)
@@ -870,7 +906,7 @@ void Tev::Draw()
   }
 #endif
 
-  INCSTAT(stats.thisFrame.tevPixelsOut);
+  PixelsOut++;
   EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
 
   EfbInterface::BlendTev(Position[0], Position[1], output);
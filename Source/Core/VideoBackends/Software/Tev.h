@@ -57,7 +57,24 @@ class Tev
     INDIRECT = 32
   };
 
-  void SetRasColor(int colorChan, int swaptable);
+  // The parts of a TEV stage's configuration that are decoded once per primitive by SetupStages
+  // rather than for every pixel.
+  struct StageSetup
+  {
+    bool TextureEnabled;
+    bool IndirectEnabled;
+    u8 TexCoord;
+    u8 TexMap;
+    u8 TexSwap[4];
+    u8 RasChannel;
+    u8 RasSwap[4];
+    const s16* Konst[4];
+    const s16* ColorInputs[4][3];  // a, b, c and d, each indexed by BLU_INP..RED_INP
+    const s16* AlphaInputs[4];
+  };
+  StageSetup m_StageSetup[16];
+
+  void SetRasColor(const StageSetup& stage);
 
   void DrawColorRegular(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
   void DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
@@ -75,6 +92,14 @@ public:
   s32 TextureLod[16];
   bool TextureLinear[16];
 
+  // Bounding box of the pixels that passed all tests. The rasterizer loads this from and merges
+  // it back into BoundingBox::coords, so that several Tev instances can draw at the same time.
+  u16 BoundingBoxCoords[4];
+
+  // Pixel counts for the statistics, which the rasterizer adds to stats.thisFrame and resets.
+  int PixelsIn = 0;
+  int PixelsOut = 0;
+
   enum
   {
     ALP_C,
@@ -85,6 +110,9 @@ public:
 
   void Init();
 
+  // Must be called after the TEV configuration in bpmem has changed, before the next Draw.
+  void SetupStages();
+
   void Draw();
 
   void SetRegColor(int reg, int comp, s16 color);
@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include "VideoCommon/AsyncShaderCompiler.h"
+
+#include <algorithm>
 #include <thread>
+
 #include "Common/Assert.h"
 #include "Common/Logging/Log.h"
 
@@ -20,25 +23,92 @@ AsyncShaderCompiler::~AsyncShaderCompiler()
   ASSERT(!HasWorkerThreads());
 }
 
-void AsyncShaderCompiler::QueueWorkItem(WorkItemPtr item, u32 priority)
+AsyncShaderCompiler::WorkItemID
+AsyncShaderCompiler::QueueWorkItem(WorkItemPtr item, u32 priority,
+                                   const std::vector<WorkItemID>& dependencies)
+{
+  const WorkItemID id = m_next_id++;
+  m_incomplete_items.emplace(id, std::vector<WorkItemID>());
+
+  // Dependencies that are no longer incomplete have been retrieved already.
+  size_t remaining_dependencies = 0;
+  for (WorkItemID dependency : dependencies)
+  {
+    auto iter = m_incomplete_items.find(dependency);
+    if (iter == m_incomplete_items.end())
+      continue;
+
+    iter->second.push_back(id);
+    remaining_dependencies++;
+  }
+
+  if (remaining_dependencies != 0)
+  {
+    m_blocked_items.emplace(id, BlockedItem{std::move(item), priority, remaining_dependencies});
+    return id;
+  }
+
+  item->Prepare();
+  SubmitWorkItem(QueuedItem{std::move(item), id, Clock::now(), false}, priority);
+  return id;
+}
+
+void AsyncShaderCompiler::SubmitWorkItem(QueuedItem item, u32 priority)
 {
   // If no worker threads are available, compile synchronously.
   if (!HasWorkerThreads())
   {
-    item->Compile();
-    m_completed_work.push_back(std::move(item));
+    CompileWorkItem(&item);
+    FinishWorkItem(std::move(item));
+    return;
+  }
+
+  // The count is raised before the item is visible to the workers, so that HasPendingWork() can
+  // never miss it.
+  m_queued_items++;
+  WorkerQueue& queue = *m_worker_queues[m_next_queue++ % m_worker_queues.size()];
+  {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    queue.items.emplace(priority, std::move(item));
+  }
+
+  // Taking the lock makes sure that a worker which saw no work is waiting before we notify it.
+  {
+    std::lock_guard<std::mutex> guard(m_wake_lock);
   }
-  else
+  m_worker_thread_wake.notify_one();
+}
+
+void AsyncShaderCompiler::CompileWorkItem(QueuedItem* item)
+{
+  const Clock::time_point start_time = Clock::now();
+  item->compiled = item->item->Compile();
+  const Clock::time_point end_time = Clock::now();
+
+  const u64 wait_time = static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::microseconds>(start_time - item->ready_time)
+          .count());
+  const u64 compile_time = static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+  m_compiled_items++;
+  m_total_wait_time_us += wait_time;
+  m_total_compile_time_us += compile_time;
+  u64 max_compile_time = m_max_compile_time_us.load();
+  while (compile_time > max_compile_time &&
+         !m_max_compile_time_us.compare_exchange_weak(max_compile_time, compile_time))
   {
-    std::lock_guard<std::mutex> guard(m_pending_work_lock);
-    m_pending_work.emplace(priority, std::move(item));
-    m_worker_thread_wake.notify_one();
   }
 }
 
+void AsyncShaderCompiler::FinishWorkItem(QueuedItem item)
+{
+  std::lock_guard<std::mutex> guard(m_completed_work_lock);
+  m_completed_work.push_back(std::move(item));
+}
+
 void AsyncShaderCompiler::RetrieveWorkItems()
 {
-  std::deque<WorkItemPtr> completed_work;
+  std::deque<QueuedItem> completed_work;
   {
     std::lock_guard<std::mutex> guard(m_completed_work_lock);
     m_completed_work.swap(completed_work);
@@ -46,15 +116,101 @@ void AsyncShaderCompiler::RetrieveWorkItems()
 
   while (!completed_work.empty())
   {
-    completed_work.front()->Retrieve();
+    QueuedItem item = std::move(completed_work.front());
     completed_work.pop_front();
+    if (!item.compiled)
+    {
+      CancelWorkItem(item.id, item.item.get());
+      continue;
+    }
+
+    item.item->Retrieve();
+
+    // Hand the items that were only waiting for this one to the workers. Items that were queued
+    // before the pending work was cleared are no longer tracked.
+    auto iter = m_incomplete_items.find(item.id);
+    if (iter != m_incomplete_items.end())
+    {
+      std::vector<WorkItemID> dependents = std::move(iter->second);
+      m_incomplete_items.erase(iter);
+      for (WorkItemID dependent : dependents)
+      {
+        auto blocked = m_blocked_items.find(dependent);
+        if (blocked == m_blocked_items.end() || --blocked->second.remaining_dependencies != 0)
+          continue;
+
+        BlockedItem ready = std::move(blocked->second);
+        m_blocked_items.erase(blocked);
+        ready.item->Prepare();
+        SubmitWorkItem(QueuedItem{std::move(ready.item), dependent, Clock::now(), false},
+                       ready.priority);
+      }
+    }
+
+    // Without worker threads, the items that were just unblocked have been compiled already.
+    if (completed_work.empty() && !HasWorkerThreads())
+    {
+      std::lock_guard<std::mutex> guard(m_completed_work_lock);
+      m_completed_work.swap(completed_work);
+    }
+  }
+}
+
+void AsyncShaderCompiler::CancelWorkItem(WorkItemID id, WorkItem* item)
+{
+  item->Cancel();
+  m_cancelled_items++;
+
+  auto iter = m_incomplete_items.find(id);
+  if (iter == m_incomplete_items.end())
+    return;
+
+  // Items that depend on a cancelled item can never run.
+  std::vector<WorkItemID> dependents = std::move(iter->second);
+  m_incomplete_items.erase(iter);
+  for (WorkItemID dependent : dependents)
+  {
+    auto blocked = m_blocked_items.find(dependent);
+    if (blocked == m_blocked_items.end())
+      continue;
+
+    WorkItemPtr blocked_item = std::move(blocked->second.item);
+    m_blocked_items.erase(blocked);
+    CancelWorkItem(dependent, blocked_item.get());
+  }
+}
+
+void AsyncShaderCompiler::CancelPendingWork()
+{
+  std::vector<QueuedItem> cancelled_items;
+  for (auto& queue : m_worker_queues)
+  {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    for (auto& it : queue->items)
+      cancelled_items.push_back(std::move(it.second));
+    m_queued_items -= queue->items.size();
+    queue->items.clear();
+  }
+
+  for (QueuedItem& item : cancelled_items)
+    CancelWorkItem(item.id, item.item.get());
+
+  // Anything still blocked is waiting for an item that is being compiled or retrieved.
+  while (!m_blocked_items.empty())
+  {
+    auto iter = m_blocked_items.begin();
+    const WorkItemID id = iter->first;
+    WorkItemPtr item = std::move(iter->second.item);
+    m_blocked_items.erase(iter);
+    CancelWorkItem(id, item.get());
   }
 }
 
 bool AsyncShaderCompiler::HasPendingWork()
 {
-  std::lock_guard<std::mutex> guard(m_pending_work_lock);
-  return !m_pending_work.empty() || m_busy_workers.load() != 0;
+  // Workers are marked busy before they remove an item from the queue count, so checking the
+  // queue count first can't miss an item in between.
+  return m_queued_items.load() != 0 || m_busy_workers.load() != 0;
 }
 
 bool AsyncShaderCompiler::HasCompletedWork()
@@ -63,6 +219,21 @@ bool AsyncShaderCompiler::HasCompletedWork()
   return !m_completed_work.empty();
 }
 
+AsyncShaderCompiler::Statistics AsyncShaderCompiler::GetStatistics() const
+{
+  Statistics statistics;
+  statistics.queued_items = m_queued_items.load();
+  statistics.blocked_items = m_blocked_items.size();
+  statistics.busy_workers = m_busy_workers.load();
+  statistics.compiled_items = m_compiled_items.load();
+  statistics.stolen_items = m_stolen_items.load();
+  statistics.cancelled_items = m_cancelled_items;
+  statistics.total_wait_time_us = m_total_wait_time_us.load();
+  statistics.total_compile_time_us = m_total_compile_time_us.load();
+  statistics.max_compile_time_us = m_max_compile_time_us.load();
+  return statistics;
+}
+
 void AsyncShaderCompiler::WaitUntilCompletion()
 {
   while (HasPendingWork())
@@ -89,23 +260,14 @@ void AsyncShaderCompiler::WaitUntilCompletion(
   // Grab the number of pending items. We use this to work out how many are left.
   size_t total_items = 0;
   {
-    // Safe to hold both locks here, since nowhere else does.
-    std::lock_guard<std::mutex> pending_guard(m_pending_work_lock);
     std::lock_guard<std::mutex> completed_guard(m_completed_work_lock);
-    total_items = m_completed_work.size() + m_pending_work.size() + m_busy_workers.load() + 1;
+    total_items = m_completed_work.size() + m_queued_items.load() + m_busy_workers.load() + 1;
   }
 
   // Update progress while the compiles complete.
-  for (;;)
+  while (HasPendingWork())
   {
-    size_t remaining_items;
-    {
-      std::lock_guard<std::mutex> pending_guard(m_pending_work_lock);
-      if (m_pending_work.empty() && !m_busy_workers.load())
-        break;
-      remaining_items = m_pending_work.size();
-    }
-
+    const size_t remaining_items = std::min(m_queued_items.load(), total_items);
     progress_callback(total_items - remaining_items, total_items);
     std::this_thread::sleep_for(CHECK_INTERVAL);
   }
@@ -113,34 +275,45 @@ void AsyncShaderCompiler::WaitUntilCompletion(
 
 bool AsyncShaderCompiler::StartWorkerThreads(u32 num_worker_threads)
 {
-  if (num_worker_threads == 0)
-    return true;
-
-  for (u32 i = 0; i < num_worker_threads; i++)
+  if (num_worker_threads != 0)
   {
-    void* thread_param = nullptr;
-    if (!WorkerThreadInitMainThread(&thread_param))
+    DistributeWorkItems(num_worker_threads);
+    for (u32 i = 0; i < num_worker_threads; i++)
     {
-      WARN_LOG(VIDEO, "Failed to initialize shader compiler worker thread.");
-      break;
-    }
+      void* thread_param = nullptr;
+      if (!WorkerThreadInitMainThread(&thread_param))
+      {
+        WARN_LOG(VIDEO, "Failed to initialize shader compiler worker thread.");
+        break;
+      }
 
-    m_worker_thread_start_result.store(false);
+      m_worker_thread_start_result.store(false);
 
-    std::thread thr(&AsyncShaderCompiler::WorkerThreadEntryPoint, this, thread_param);
-    m_init_event.Wait();
+      std::thread thr(&AsyncShaderCompiler::WorkerThreadEntryPoint, this, thread_param,
+                      static_cast<size_t>(i));
+      m_init_event.Wait();
 
-    if (!m_worker_thread_start_result.load())
-    {
-      WARN_LOG(VIDEO, "Failed to start shader compiler worker thread.");
-      thr.join();
-      break;
+      if (!m_worker_thread_start_result.load())
+      {
+        WARN_LOG(VIDEO, "Failed to start shader compiler worker thread.");
+        thr.join();
+        break;
+      }
+
+      m_worker_threads.push_back(std::move(thr));
     }
+  }
 
-    m_worker_threads.push_back(std::move(thr));
+  // Without worker threads, items are compiled as they are queued. Anything that the previous
+  // worker threads left behind would never be compiled otherwise.
+  if (!HasWorkerThreads())
+  {
+    QueuedItem item;
+    while (PopWorkItem(0, &item))
+      RunWorkItem(std::move(item));
   }
 
-  return HasWorkerThreads();
+  return num_worker_threads == 0 || HasWorkerThreads();
 }
 
 bool AsyncShaderCompiler::ResizeWorkerThreads(u32 num_worker_threads)
@@ -164,7 +337,7 @@ void AsyncShaderCompiler::StopWorkerThreads()
 
   // Signal worker threads to stop, and wake all of them.
   {
-    std::lock_guard<std::mutex> guard(m_pending_work_lock);
+    std::lock_guard<std::mutex> guard(m_wake_lock);
     m_exit_flag.Set();
     m_worker_thread_wake.notify_all();
   }
@@ -190,7 +363,7 @@ void AsyncShaderCompiler::WorkerThreadExit(void* param)
 {
 }
 
-void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param)
+void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param, size_t queue_index)
 {
   // Initialize worker thread with backend-specific method.
   if (!WorkerThreadInitWorkerThread(param))
@@ -204,35 +377,73 @@ void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param)
   m_worker_thread_start_result.store(true);
   m_init_event.Set();
 
-  WorkerThreadRun();
+  WorkerThreadRun(queue_index);
 
   WorkerThreadExit(param);
 }
 
-void AsyncShaderCompiler::WorkerThreadRun()
+void AsyncShaderCompiler::WorkerThreadRun(size_t queue_index)
 {
-  std::unique_lock<std::mutex> pending_lock(m_pending_work_lock);
   while (!m_exit_flag.IsSet())
   {
-    m_worker_thread_wake.wait(pending_lock);
-
-    while (!m_pending_work.empty() && !m_exit_flag.IsSet())
+    QueuedItem item;
+    if (PopWorkItem(queue_index, &item))
     {
-      m_busy_workers++;
-      auto iter = m_pending_work.begin();
-      WorkItemPtr item(std::move(iter->second));
-      m_pending_work.erase(iter);
-      pending_lock.unlock();
+      RunWorkItem(std::move(item));
+      continue;
+    }
 
-      if (item->Compile())
-      {
-        std::lock_guard<std::mutex> completed_guard(m_completed_work_lock);
-        m_completed_work.push_back(std::move(item));
-      }
+    std::unique_lock<std::mutex> wake_lock(m_wake_lock);
+    m_worker_thread_wake.wait(
+        wake_lock, [this] { return m_exit_flag.IsSet() || m_queued_items.load() != 0; });
+  }
+}
 
-      pending_lock.lock();
-      m_busy_workers--;
-    }
+bool AsyncShaderCompiler::PopWorkItem(size_t queue_index, QueuedItem* item)
+{
+  // Take the most important item of our own queue, or steal one from the next queue that has
+  // any work.
+  const size_t num_queues = m_worker_queues.size();
+  for (size_t i = 0; i < num_queues; i++)
+  {
+    WorkerQueue& queue = *m_worker_queues[(queue_index + i) % num_queues];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.items.empty())
+      continue;
+
+    auto iter = queue.items.begin();
+    *item = std::move(iter->second);
+    queue.items.erase(iter);
+    m_busy_workers++;
+    m_queued_items--;
+    if (i != 0)
+      m_stolen_items++;
+    return true;
+  }
+
+  return false;
+}
+
+void AsyncShaderCompiler::RunWorkItem(QueuedItem item)
+{
+  CompileWorkItem(&item);
+  FinishWorkItem(std::move(item));
+  m_busy_workers--;
+}
+
+void AsyncShaderCompiler::DistributeWorkItems(size_t num_queues)
+{
+  // Only called while no worker threads are running, so the queues don't need to be locked.
+  std::vector<std::unique_ptr<WorkerQueue>> old_queues;
+  old_queues.swap(m_worker_queues);
+  for (size_t i = 0; i < num_queues; i++)
+    m_worker_queues.push_back(std::make_unique<WorkerQueue>());
+
+  size_t next_queue = 0;
+  for (auto& queue : old_queues)
+  {
+    for (auto& it : queue->items)
+      m_worker_queues[next_queue++ % num_queues]->items.emplace(it.first, std::move(it.second));
   }
 }
 
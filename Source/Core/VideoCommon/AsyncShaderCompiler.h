@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <functional>
@@ -12,6 +13,7 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -21,6 +23,13 @@
 
 namespace VideoCommon
 {
+// Compiles work items on a pool of worker threads. Each worker has its own queue, and takes work
+// from the others' queues when its own runs dry, so that queueing a large batch of items doesn't
+// make all of the workers contend on a single lock.
+//
+// Items can depend on other items, in which case they are only handed to the workers once their
+// dependencies have been retrieved. Queueing, retrieving and cancelling must all happen on the
+// same thread.
 class AsyncShaderCompiler
 {
 public:
@@ -28,12 +37,40 @@ public:
   {
   public:
     virtual ~WorkItem() = default;
+
+    // Called on the queueing thread once all dependencies have been retrieved, right before the
+    // item is handed to the workers.
+    virtual void Prepare() {}
+
+    // Called on a worker thread. If it returns false, the item is cancelled instead of retrieved.
     virtual bool Compile() = 0;
+
+    // Called on the queueing thread after the item has been compiled.
     virtual void Retrieve() = 0;
+
+    // Called on the queueing thread instead of Compile() and Retrieve(), when the item or one of
+    // its dependencies was cancelled.
+    virtual void Cancel() {}
   };
 
   using WorkItemPtr = std::unique_ptr<WorkItem>;
 
+  // Identifies a queued work item, to make other items depend on it. IDs are never reused.
+  using WorkItemID = u64;
+
+  struct Statistics
+  {
+    size_t queued_items;   // Ready to compile, waiting for a worker.
+    size_t blocked_items;  // Waiting for their dependencies.
+    size_t busy_workers;
+    u64 compiled_items;
+    u64 stolen_items;  // Compiled by a worker other than the one they were queued to.
+    u64 cancelled_items;
+    u64 total_wait_time_us;  // From being ready to a worker starting on the item.
+    u64 total_compile_time_us;
+    u64 max_compile_time_us;
+  };
+
   AsyncShaderCompiler();
   virtual ~AsyncShaderCompiler();
 
@@ -44,12 +81,20 @@ public:
   }
 
   // Queues a new work item to the compiler threads. The lower the priority, the sooner
-  // this work item will be compiled, relative to the other work items.
-  void QueueWorkItem(WorkItemPtr item, u32 priority);
+  // this work item will be compiled, relative to the other work items. The item isn't compiled
+  // before all of the given dependencies have been retrieved.
+  WorkItemID QueueWorkItem(WorkItemPtr item, u32 priority,
+                           const std::vector<WorkItemID>& dependencies = {});
   void RetrieveWorkItems();
   bool HasPendingWork();
   bool HasCompletedWork();
 
+  // Drops all work items that haven't started compiling yet, e.g. because the configuration they
+  // were queued for has changed. Items that are being compiled are still retrieved.
+  void CancelPendingWork();
+
+  Statistics GetStatistics() const;
+
   // Simpler version without progress updates.
   void WaitUntilCompletion();
 
@@ -68,8 +113,41 @@ protected:
   virtual void WorkerThreadExit(void* param);
 
 private:
-  void WorkerThreadEntryPoint(void* param);
-  void WorkerThreadRun();
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedItem
+  {
+    WorkItemPtr item;
+    WorkItemID id;
+    Clock::time_point ready_time;
+    bool compiled;
+  };
+
+  // A multimap is used to store the work items. We can't use a priority_queue here, because
+  // there's no way to obtain a non-const reference, which we need for the unique_ptr.
+  struct WorkerQueue
+  {
+    std::multimap<u32, QueuedItem> items;
+    std::mutex lock;
+  };
+
+  struct BlockedItem
+  {
+    WorkItemPtr item;
+    u32 priority;
+    size_t remaining_dependencies;
+  };
+
+  void SubmitWorkItem(QueuedItem item, u32 priority);
+  void CompileWorkItem(QueuedItem* item);
+  void FinishWorkItem(QueuedItem item);
+  void CancelWorkItem(WorkItemID id, WorkItem* item);
+  bool PopWorkItem(size_t queue_index, QueuedItem* item);
+  void RunWorkItem(QueuedItem item);
+  void DistributeWorkItems(size_t num_queues);
+
+  void WorkerThreadEntryPoint(void* param, size_t queue_index);
+  void WorkerThreadRun(size_t queue_index);
 
   Common::Flag m_exit_flag;
   Common::Event m_init_event;
@@ -77,15 +155,28 @@ private:
   std::vector<std::thread> m_worker_threads;
   std::atomic_bool m_worker_thread_start_result{false};
 
-  // A multimap is used to store the work items. We can't use a priority_queue here, because
-  // there's no way to obtain a non-const reference, which we need for the unique_ptr.
-  std::multimap<u32, WorkItemPtr> m_pending_work;
-  std::mutex m_pending_work_lock;
-  std::condition_variable m_worker_thread_wake;
+  std::vector<std::unique_ptr<WorkerQueue>> m_worker_queues;
+  size_t m_next_queue = 0;
+  std::atomic_size_t m_queued_items{0};
   std::atomic_size_t m_busy_workers{0};
+  std::mutex m_wake_lock;
+  std::condition_variable m_worker_thread_wake;
 
-  std::deque<WorkItemPtr> m_completed_work;
+  std::deque<QueuedItem> m_completed_work;
   std::mutex m_completed_work_lock;
+
+  // Only accessed by the queueing thread. Every item that was queued but not yet retrieved or
+  // cancelled has an entry in m_incomplete_items, with the items that depend on it.
+  WorkItemID m_next_id = 1;
+  std::unordered_map<WorkItemID, std::vector<WorkItemID>> m_incomplete_items;
+  std::unordered_map<WorkItemID, BlockedItem> m_blocked_items;
+  u64 m_cancelled_items = 0;
+
+  std::atomic<u64> m_compiled_items{0};
+  std::atomic<u64> m_stolen_items{0};
+  std::atomic<u64> m_total_wait_time_us{0};
+  std::atomic<u64> m_total_compile_time_us{0};
+  std::atomic<u64> m_max_compile_time_us{0};
 };
 
 }  // namespace VideoCommon
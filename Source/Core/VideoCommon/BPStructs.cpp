@@ -27,6 +27,7 @@
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/RenderBase.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/TextureCacheBase.h"
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VertexShaderManager.h"
@@ -205,6 +206,8 @@ static void BPWritten(const BPCmd& bp)
   // first and clear afterwards.
   case BPMEM_TRIGGER_EFB_COPY:  // Copy EFB Region or Render to the XFB or Clear the screen.
   {
+    StageTimings::ScopedTimer timer(StageTimings::Stage::EFBCopy);
+
     // The bottom right is within the rectangle
     // The values in bpmem.copyTexSrcXY and bpmem.copyTexSrcWH are updated in case 0x49 and 0x4a in
     // this function
@@ -270,6 +273,7 @@ static void BPWritten(const BPCmd& bp)
 
       // This stays in to signal end of a "frame"
       g_renderer->RenderToXFB(destAddr, srcRect, destStride, height, s_gammaLUT[PE_copy.gamma]);
+      FifoPlayer::GetInstance().OnXFBCopied(destAddr, destStride, height);
 
       if (g_ActiveConfig.bImmediateXFB)
       {
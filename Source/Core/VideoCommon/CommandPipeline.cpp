@@ -0,0 +1,593 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/CommandPipeline.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/Atomic.h"
+#include "Common/CommonTypes.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+#include "Core/ConfigManager.h"
+#include "Core/FifoPlayer/FifoRecorder.h"
+#include "Core/HW/Memmap.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/CommandProcessor.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/StageTimings.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoaderBase.h"
+#include "VideoCommon/VertexLoaderManager.h"
+#include "VideoCommon/VideoConfig.h"
+#include "VideoCommon/XFMemory.h"
+
+namespace CommandPipeline
+{
+namespace
+{
+enum class PacketType : u8
+{
+  LoadBPReg,
+  LoadCPReg,
+  LoadXFReg,
+  LoadIndexedXF,
+  Draw,
+};
+
+struct Packet
+{
+  PacketType type;
+  // CP register or primitive type.
+  u8 param;
+  // Number of XF words.
+  u16 size;
+  // Register value, XF address or command, or vertex count.
+  u32 value;
+  // Offset of the XF words or the DrawData in Batch::data.
+  u32 offset;
+  VertexLoaderBase* loader;
+};
+
+// Stored in front of the converted vertices of a draw.
+struct DrawData
+{
+  float positions[3][4];
+  u32 matrix_indices[4];
+};
+
+struct Batch
+{
+  static constexpr size_t MAX_PACKETS = 4096;
+  static constexpr u32 MAX_DATA_SIZE = 1024 * 1024;
+
+  bool IsFull() const { return packets.size() >= MAX_PACKETS || data_size >= MAX_DATA_SIZE; }
+
+  // Returns the offset of size new bytes in data, followed by at least padding bytes of space.
+  u32 Allocate(u32 size, u32 padding = 0)
+  {
+    const u32 offset = (data_size + 15) & ~15;
+    if (offset + size + padding > data_capacity)
+    {
+      const u32 new_capacity = std::max(std::max(offset + size + padding, MAX_DATA_SIZE),
+                                        data_capacity * 2);
+      std::unique_ptr<u8[]> new_data(new u8[new_capacity]);
+      if (data_size != 0)
+        std::memcpy(new_data.get(), data.get(), data_size);
+      data = std::move(new_data);
+      data_capacity = new_capacity;
+    }
+    data_size = offset + size;
+    return offset;
+  }
+
+  void Reset()
+  {
+    packets.clear();
+    data_size = 0;
+    num_cp_loads = 0;
+    num_display_lists = 0;
+    xfb_copy = false;
+    has_safe_read_pointer = false;
+  }
+
+  std::vector<Packet> packets;
+  std::unique_ptr<u8[]> data;
+  u32 data_size = 0;
+  u32 data_capacity = 0;
+
+  u32 num_cp_loads = 0;
+  u32 num_display_lists = 0;
+  // The batch ends with a copy to the XFB, so decoding is paused until it has been executed.
+  bool xfb_copy = false;
+  // All FIFO data up to this read pointer has been decoded into this and earlier batches.
+  bool has_safe_read_pointer = false;
+  u32 safe_read_pointer = 0;
+};
+}  // Anonymous namespace
+
+static constexpr size_t NUM_BATCHES = 4;
+// Limits how far the GPU thread can read the FIFO ahead of the decoding thread.
+static constexpr size_t MAX_PENDING_INPUT = 256 * 1024;
+// The vertex loaders may read a few bytes past the end of the vertex data.
+static constexpr size_t INPUT_PADDING = 4;
+
+static std::thread s_thread;
+static std::mutex s_mutex;
+static std::condition_variable s_decoder_cv;
+static std::condition_variable s_submit_cv;
+
+// Protected by s_mutex.
+static bool s_stop;
+static std::vector<u8> s_input;
+static u32 s_input_read_pointer;
+static bool s_decoding;
+static bool s_paused;
+static bool s_work_pending;
+static std::deque<std::unique_ptr<Batch>> s_decoded_batches;
+static std::vector<std::unique_ptr<Batch>> s_free_batches;
+
+// The data being decoded, owned by the decoding thread while s_decoding is set.
+static std::vector<u8> s_work;
+
+// Only used by the decoding thread.
+static std::unique_ptr<Batch> s_batch;
+static bool s_bp_mask_written;
+static bool s_xfb_copy_decoded;
+static bool s_fifo_error_seen;
+
+static void PublishBatchLocked()
+{
+  s_decoded_batches.push_back(std::move(s_batch));
+  s_submit_cv.notify_one();
+}
+
+static Batch& GetBatch()
+{
+  if (!s_batch)
+  {
+    std::unique_lock<std::mutex> lk(s_mutex);
+    if (s_free_batches.empty())
+    {
+      StageTimings::ScopedTimer timer(StageTimings::Stage::DecodeStall);
+      s_decoder_cv.wait(lk, [] { return !s_free_batches.empty(); });
+    }
+    s_batch = std::move(s_free_batches.back());
+    s_free_batches.pop_back();
+  }
+  return *s_batch;
+}
+
+static void AddPacket(PacketType type, u8 param, u16 size, u32 value, u32 offset = 0,
+                      VertexLoaderBase* loader = nullptr)
+{
+  GetBatch().packets.push_back({type, param, size, value, offset, loader});
+}
+
+static int DecodeVertices(int vtx_attr_group, int primitive, int count, DataReader src)
+{
+  if (!count)
+    return 0;
+
+  StageTimings::ScopedTimer timer(StageTimings::Stage::VertexLoad);
+
+  VertexLoaderBase* loader = VertexLoaderManager::GetLoaderForDecoding(vtx_attr_group);
+
+  const int size = count * loader->m_VertexSize;
+  if ((int)src.size() < size)
+    return -1;
+
+  // The SSE vertex loader can write up to 4 bytes past the end
+  const u32 stride = loader->m_native_vtx_decl.stride;
+  Batch& batch = GetBatch();
+  const u32 offset = batch.Allocate(sizeof(DrawData) + count * stride, 4);
+  u8* const draw_data = batch.data.get() + offset;
+  u8* const vertices = draw_data + sizeof(DrawData);
+  count = loader->RunVertices(src, DataReader(vertices, vertices + count * stride + 4), count);
+
+  DrawData draw;
+  std::memcpy(draw.positions, VertexLoaderManager::position_cache, sizeof(draw.positions));
+  std::memcpy(draw.matrix_indices, VertexLoaderManager::position_matrix_index,
+              sizeof(draw.matrix_indices));
+  std::memcpy(draw_data, &draw, sizeof(draw));
+
+  AddPacket(PacketType::Draw, static_cast<u8>(primitive), 0, count, offset, loader);
+  return size;
+}
+
+static void DecodeIndexedXF(u32 val, int refarray)
+{
+  const u32 index = val >> 16;
+  const u32 size = ((val >> 12) & 0xF) + 1;
+
+  const u8* new_data = Memory::GetPointer(g_main_cp_state.array_bases[refarray] +
+                                          g_main_cp_state.array_strides[refarray] * index);
+  if (!new_data)
+    return;
+
+  Batch& batch = GetBatch();
+  const u32 offset = batch.Allocate(size * sizeof(u32));
+  std::memcpy(batch.data.get() + offset, new_data, size * sizeof(u32));
+  AddPacket(PacketType::LoadIndexedXF, 0, static_cast<u16>(size), val, offset);
+}
+
+static u8* Decode(DataReader src, bool in_display_list);
+
+static void DecodeDisplayList(u32 address, u32 size)
+{
+  u8* start_address = Memory::GetPointer(address);
+
+  // Avoid the crash if Memory::GetPointer failed ..
+  if (start_address != nullptr)
+  {
+    Decode(DataReader(start_address, start_address + size), true);
+    GetBatch().num_display_lists++;
+  }
+}
+
+// The counterpart of OpcodeDecoder::Run. Returns the start of the first command which has not
+// been decoded.
+static u8* Decode(DataReader src, bool in_display_list)
+{
+  StageTimings::ScopedTimer timer(StageTimings::Stage::OpcodeDecode);
+
+  // Copies to the XFB in display lists only pause decoding after the display list.
+  while (in_display_list || !s_xfb_copy_decoded)
+  {
+    if (s_batch && s_batch->IsFull())
+    {
+      std::lock_guard<std::mutex> lk(s_mutex);
+      PublishBatchLocked();
+    }
+
+    u8* opcode_start = src.GetPointer();
+    if (!src.size())
+      return opcode_start;
+
+    const u8 cmd_byte = src.Read<u8>();
+    int refarray;
+    switch (cmd_byte)
+    {
+    case OpcodeDecoder::GX_NOP:
+    case OpcodeDecoder::GX_UNKNOWN_RESET:
+    case OpcodeDecoder::GX_CMD_UNKNOWN_METRICS:
+    case OpcodeDecoder::GX_CMD_INVL_VC:
+      break;
+
+    case OpcodeDecoder::GX_LOAD_CP_REG:
+    {
+      if (src.size() < 1 + 4)
+        return opcode_start;
+      const u8 sub_cmd = src.Read<u8>();
+      const u32 value = src.Read<u32>();
+      // The matrix indices are part of the vertex shader state, which belongs to the GPU thread.
+      if ((sub_cmd & 0xF0) == 0x30 || (sub_cmd & 0xF0) == 0x40)
+        AddPacket(PacketType::LoadCPReg, sub_cmd, 0, value);
+      else
+        LoadCPReg(sub_cmd, value);
+      GetBatch().num_cp_loads++;
+    }
+    break;
+
+    case OpcodeDecoder::GX_LOAD_XF_REG:
+    {
+      if (src.size() < 4)
+        return opcode_start;
+      const u32 cmd2 = src.Read<u32>();
+      const u32 transfer_size = ((cmd2 >> 16) & 15) + 1;
+      if (src.size() < transfer_size * sizeof(u32))
+        return opcode_start;
+
+      Batch& batch = GetBatch();
+      const u32 offset = batch.Allocate(transfer_size * sizeof(u32));
+      std::memcpy(batch.data.get() + offset, src.GetPointer(), transfer_size * sizeof(u32));
+      AddPacket(PacketType::LoadXFReg, 0, static_cast<u16>(transfer_size), cmd2 & 0xFFFF, offset);
+      src.Skip<u32>(transfer_size);
+    }
+    break;
+
+    case OpcodeDecoder::GX_LOAD_INDX_A:
+      refarray = 0xC;
+      goto load_indx;
+    case OpcodeDecoder::GX_LOAD_INDX_B:
+      refarray = 0xD;
+      goto load_indx;
+    case OpcodeDecoder::GX_LOAD_INDX_C:
+      refarray = 0xE;
+      goto load_indx;
+    case OpcodeDecoder::GX_LOAD_INDX_D:
+      refarray = 0xF;
+      goto load_indx;
+    load_indx:
+      if (src.size() < 4)
+        return opcode_start;
+      DecodeIndexedXF(src.Read<u32>(), refarray);
+      break;
+
+    case OpcodeDecoder::GX_CMD_CALL_DL:
+    {
+      if (src.size() < 8)
+        return opcode_start;
+      const u32 address = src.Read<u32>();
+      const u32 count = src.Read<u32>();
+
+      if (in_display_list)
+        INFO_LOG(VIDEO, "recursive display list detected");
+      else
+        DecodeDisplayList(address, count);
+    }
+    break;
+
+    case OpcodeDecoder::GX_LOAD_BP_REG:
+    {
+      if (src.size() < 4)
+        return opcode_start;
+      const u32 bp_cmd = src.Read<u32>();
+      AddPacket(PacketType::LoadBPReg, 0, 0, bp_cmd);
+
+      // A masked write could set the XFB bit without it being part of the command.
+      UPE_Copy copy;
+      copy.Hex = bp_cmd & 0xFFFFFF;
+      if ((bp_cmd >> 24) == BPMEM_TRIGGER_EFB_COPY && (copy.copy_to_xfb || s_bp_mask_written))
+        s_xfb_copy_decoded = true;
+      s_bp_mask_written = (bp_cmd >> 24) == BPMEM_BP_MASK;
+    }
+    break;
+
+    // draw primitives
+    default:
+      if ((cmd_byte & 0xC0) == 0x80)
+      {
+        // load vertices
+        if (src.size() < 2)
+          return opcode_start;
+        const u16 num_vertices = src.Read<u16>();
+        const int bytes = DecodeVertices(
+            cmd_byte & OpcodeDecoder::GX_VAT_MASK,
+            (cmd_byte & OpcodeDecoder::GX_PRIMITIVE_MASK) >> OpcodeDecoder::GX_PRIMITIVE_SHIFT,
+            num_vertices, src);
+        if (bytes < 0)
+          return opcode_start;
+
+        src.Skip(bytes);
+      }
+      else
+      {
+        if (!s_fifo_error_seen)
+          CommandProcessor::HandleUnknownOpcode(cmd_byte, opcode_start, false);
+        ERROR_LOG(VIDEO, "FIFO: Unknown Opcode(0x%02x @ %p, pipelined)", cmd_byte, opcode_start);
+        s_fifo_error_seen = true;
+      }
+      break;
+    }
+  }
+
+  return src.GetPointer();
+}
+
+static void DecoderThread()
+{
+  Common::SetCurrentThreadName("Command decoder");
+
+  std::unique_lock<std::mutex> lk(s_mutex);
+  while (true)
+  {
+    s_decoder_cv.wait(
+        lk, [] { return s_stop || (!s_paused && (!s_input.empty() || s_work_pending)); });
+    if (s_stop)
+      return;
+
+    const size_t size = s_work.size() + s_input.size();
+    s_work.insert(s_work.end(), s_input.begin(), s_input.end());
+    s_work.resize(size + INPUT_PADDING);
+    s_input.clear();
+    const u32 read_pointer = s_input_read_pointer;
+    s_decoding = true;
+    s_work_pending = false;
+    s_submit_cv.notify_one();
+    lk.unlock();
+
+    s_xfb_copy_decoded = false;
+    const u8* end = Decode(DataReader(s_work.data(), s_work.data() + size), false);
+    s_work.erase(s_work.begin(), s_work.begin() + (end - s_work.data()));
+    s_work.resize(s_work.size() - INPUT_PADDING);
+
+    lk.lock();
+    if (s_batch)
+    {
+      // The batch always exists after a copy to the XFB was decoded, as decoding stops right
+      // after it, or after the display list containing it.
+      s_batch->xfb_copy = s_xfb_copy_decoded;
+      if (s_work.empty())
+      {
+        s_batch->has_safe_read_pointer = true;
+        s_batch->safe_read_pointer = read_pointer;
+      }
+      PublishBatchLocked();
+    }
+    s_paused = s_xfb_copy_decoded;
+    s_work_pending = s_xfb_copy_decoded;
+    s_decoding = false;
+    s_submit_cv.notify_one();
+  }
+}
+
+static void Start()
+{
+  s_stop = false;
+  s_paused = false;
+  s_work_pending = false;
+  s_decoding = false;
+  s_bp_mask_written = false;
+  s_fifo_error_seen = false;
+  for (size_t i = 0; i < NUM_BATCHES; i++)
+    s_free_batches.push_back(std::make_unique<Batch>());
+
+  s_thread = std::thread(DecoderThread);
+}
+
+void Shutdown()
+{
+  if (!s_thread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lk(s_mutex);
+    s_stop = true;
+  }
+  s_decoder_cv.notify_one();
+  s_thread.join();
+
+  s_input.clear();
+  s_work.clear();
+  s_batch.reset();
+  s_decoded_batches.clear();
+  s_free_batches.clear();
+}
+
+bool ShouldUse()
+{
+  return g_ActiveConfig.bPipelinedCommandDecoding && SConfig::GetInstance().bCPUThread &&
+         !SConfig::GetInstance().bSyncGPU && !FifoRecorder::GetInstance().IsRecording();
+}
+
+static void ExecuteBatch(Batch& batch)
+{
+  StageTimings::ScopedTimer timer(StageTimings::Stage::Submit);
+
+  for (const Packet& packet : batch.packets)
+  {
+    u8* const data = batch.data.get() + packet.offset;
+    switch (packet.type)
+    {
+    case PacketType::LoadBPReg:
+      LoadBPReg(packet.value);
+      INCSTAT(stats.thisFrame.numBPLoads);
+      break;
+
+    case PacketType::LoadCPReg:
+      LoadCPReg(packet.param, packet.value);
+      break;
+
+    case PacketType::LoadXFReg:
+      LoadXFReg(packet.size, packet.value, DataReader(data, data + packet.size * sizeof(u32)));
+      INCSTAT(stats.thisFrame.numXFLoads);
+      break;
+
+    case PacketType::LoadIndexedXF:
+      LoadIndexedXFData(packet.value, reinterpret_cast<const u32*>(data));
+      break;
+
+    case PacketType::Draw:
+    {
+      DrawData draw;
+      std::memcpy(&draw, data, sizeof(draw));
+      VertexLoaderManager::SubmitConvertedVertices(packet.loader, packet.param, packet.value,
+                                                   data + sizeof(draw), draw.positions,
+                                                   draw.matrix_indices);
+    }
+    break;
+    }
+  }
+
+  ADDSTAT(stats.thisFrame.numCPLoads, batch.num_cp_loads);
+  ADDSTAT(stats.thisFrame.numDListsCalled, batch.num_display_lists);
+
+  if (batch.has_safe_read_pointer)
+    Common::AtomicStore(CommandProcessor::fifo.SafeCPReadPointer, batch.safe_read_pointer);
+}
+
+void SubmitDecodedBatches()
+{
+  std::unique_lock<std::mutex> lk(s_mutex);
+  while (!s_decoded_batches.empty())
+  {
+    std::unique_ptr<Batch> batch = std::move(s_decoded_batches.front());
+    s_decoded_batches.pop_front();
+    lk.unlock();
+
+    ExecuteBatch(*batch);
+    // Continue decoding after a copy to the XFB unless a FIFO recording is about to start with
+    // the next frame, which requires decoding on the GPU thread.
+    const bool resume = batch->xfb_copy && ShouldUse();
+    batch->Reset();
+
+    lk.lock();
+    s_free_batches.push_back(std::move(batch));
+    if (resume)
+      s_paused = false;
+    s_decoder_cv.notify_one();
+  }
+}
+
+void PushData(const u8* data, u32 size, u32 read_pointer)
+{
+  if (!s_thread.joinable())
+    Start();
+
+  std::unique_lock<std::mutex> lk(s_mutex);
+  s_input.insert(s_input.end(), data, data + size);
+  s_input_read_pointer = read_pointer;
+  s_decoder_cv.notify_one();
+
+  while (s_input.size() > MAX_PENDING_INPUT && !s_paused)
+  {
+    if (!s_decoded_batches.empty())
+    {
+      lk.unlock();
+      SubmitDecodedBatches();
+      lk.lock();
+      continue;
+    }
+
+    StageTimings::ScopedTimer timer(StageTimings::Stage::SubmitStall);
+    s_submit_cv.wait(lk, [] {
+      return !s_decoded_batches.empty() || s_input.size() <= MAX_PENDING_INPUT || s_paused;
+    });
+  }
+}
+
+static bool IsDecoderIdle()
+{
+  return !s_decoding && (s_paused || (s_input.empty() && !s_work_pending));
+}
+
+void Drain(std::vector<u8>* data)
+{
+  data->clear();
+  if (!s_thread.joinable())
+    return;
+
+  std::unique_lock<std::mutex> lk(s_mutex);
+  while (!s_decoded_batches.empty() || !IsDecoderIdle())
+  {
+    if (!s_decoded_batches.empty())
+    {
+      lk.unlock();
+      SubmitDecodedBatches();
+      lk.lock();
+      continue;
+    }
+
+    StageTimings::ScopedTimer timer(StageTimings::Stage::SubmitStall);
+    s_submit_cv.wait(lk, [] { return !s_decoded_batches.empty() || IsDecoderIdle(); });
+  }
+
+  data->insert(data->end(), s_work.begin(), s_work.end());
+  data->insert(data->end(), s_input.begin(), s_input.end());
+  s_work.clear();
+  s_input.clear();
+  s_paused = false;
+  s_work_pending = false;
+}
+}  // namespace CommandPipeline
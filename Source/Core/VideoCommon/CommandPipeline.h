@@ -0,0 +1,43 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Splits the processing of the FIFO on the GPU thread into two stages. A decoding thread parses
+// the commands, applies CP register loads, resolves display lists and indexed XF loads and
+// converts vertices. The results are stored in batches of prepared commands, which the GPU thread
+// executes: loading BP and XF registers, adding the converted vertices to the vertex manager and
+// drawing.
+//
+// The decoding thread owns the vertex loading state (g_main_cp_state apart from the matrix
+// indices, the cached array pointers and the vertex loaders' position cache) while the pipeline
+// is in use, so the GPU thread may only decode opcodes itself after Drain().
+//
+// The pipeline is not used with single core, deterministic GPU thread mode or sync GPU, whose
+// cycle accounting needs the commands to be executed as they are read, nor while FIFO recording
+// is active. Decoding stops after copies to the XFB until the GPU thread has executed them, so
+// that switching back to decoding on the GPU thread when a recording starts at the next frame
+// does not lose any commands.
+namespace CommandPipeline
+{
+void Shutdown();
+
+// Whether the pipeline should be used for the next FIFO data.
+bool ShouldUse();
+
+// Hands FIFO data to the decoding thread. read_pointer is the FIFO read pointer after the data,
+// which is reported in fifo.SafeCPReadPointer once all commands up to it have been executed.
+void PushData(const u8* data, u32 size, u32 read_pointer);
+
+// Executes all batches that have been decoded so far, without waiting for any.
+void SubmitDecodedBatches();
+
+// Waits until all data pushed so far has been decoded and executed, and moves the data that has
+// not been decoded yet (an incomplete command, or everything after a pending XFB copy) to data.
+void Drain(std::vector<u8>* data);
+}  // namespace CommandPipeline
@@ -0,0 +1,547 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/DisplayListCache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "Core/HW/Memmap.h"
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/Fifo.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/StageTimings.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoaderBase.h"
+#include "VideoCommon/VertexLoaderManager.h"
+#include "VideoCommon/VertexLoader_Normal.h"
+#include "VideoCommon/VertexLoader_Position.h"
+#include "VideoCommon/VertexLoader_TextCoord.h"
+#include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace DisplayListCache
+{
+namespace
+{
+// The parts of the CP state the vertex loaders depend on.
+struct VertexState
+{
+  bool operator==(const VertexState& other) const
+  {
+    return std::memcmp(this, &other, sizeof(*this)) == 0;
+  }
+
+  u32 array_bases[12];
+  u32 array_strides[12];
+  u64 vtx_desc;
+  u32 vtx_attr[8][3];
+};
+
+// A part of a vertex array read by the vertex loaders, relative to the array base.
+struct ArrayRange
+{
+  u32 base;
+  u32 begin;
+  u32 end;
+  u64 hash;
+};
+
+struct Draw
+{
+  // The commands between the previous draw and this one, as offsets into the display list.
+  u32 commands_begin;
+  u32 commands_end;
+
+  VertexLoaderBase* loader;
+  int primitive;
+  int count;
+  // Offset of the converted vertices in Entry::vertices.
+  size_t vertices_offset;
+  // The contents of VertexLoaderManager::position_cache and position_matrix_index after the
+  // vertices were converted.
+  float positions[3][4];
+  u32 matrix_indices[4];
+};
+
+// Identifies a display list by its location, contents and the CP state it was called with, so
+// that several variants of a display list can be cached at the same time.
+struct Key
+{
+  bool operator==(const Key& other) const
+  {
+    return address == other.address && size == other.size && hash == other.hash &&
+           state == other.state;
+  }
+
+  u32 address;
+  u32 size;
+  u64 hash;
+  VertexState state;
+};
+
+struct KeyHasher
+{
+  size_t operator()(const Key& key) const { return static_cast<size_t>(key.hash ^ key.address); }
+};
+
+struct Entry
+{
+  Key key;
+
+  // Whether the draws have been recorded, or recording them failed for the contents.
+  bool recorded = false;
+  bool uncacheable = false;
+
+  u32 cycles = 0;
+  std::vector<Draw> draws;
+  std::vector<ArrayRange> arrays;
+  std::vector<u8> vertices;
+  // The commands after the last draw.
+  u32 tail_begin = 0;
+};
+
+// An indexed attribute of a vertex.
+struct IndexedAttribute
+{
+  int array;
+  // Offset in the vertex.
+  u32 offset;
+  u32 index_size;
+  u32 num_indices;
+  // The number of bytes read from the array for each index.
+  u32 element_size;
+};
+}  // Anonymous namespace
+
+// The least recently used entries are evicted when there are more entries than this, or the
+// converted vertices exceed this size.
+static constexpr size_t MAX_CACHED_ENTRIES = 4096;
+static constexpr size_t MAX_CACHED_VERTEX_BYTES = 64 * 1024 * 1024;
+
+// Ordered from the most to the least recently used.
+static std::list<Entry> s_lru;
+static std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> s_entries;
+static size_t s_cached_vertex_bytes = 0;
+
+void Clear()
+{
+  s_entries.clear();
+  s_lru.clear();
+  s_cached_vertex_bytes = 0;
+}
+
+size_t GetEntryCount()
+{
+  return s_entries.size();
+}
+
+bool IsEnabled()
+{
+  // The deterministic GPU thread mode reads display lists from a copy made by the CPU thread,
+  // and FIFO recording needs to see every command.
+  return g_ActiveConfig.bCacheDisplayLists && !Fifo::UseDeterministicGPUThread() &&
+         !g_bRecordFifoData;
+}
+
+static VertexState GetVertexState()
+{
+  VertexState state;
+  std::memcpy(state.array_bases, g_main_cp_state.array_bases, sizeof(state.array_bases));
+  std::memcpy(state.array_strides, g_main_cp_state.array_strides, sizeof(state.array_strides));
+  state.vtx_desc = g_main_cp_state.vtx_desc.Hex;
+  for (int i = 0; i < 8; i++)
+  {
+    state.vtx_attr[i][0] = g_main_cp_state.vtx_attr[i].g0.Hex;
+    state.vtx_attr[i][1] = g_main_cp_state.vtx_attr[i].g1.Hex;
+    state.vtx_attr[i][2] = g_main_cp_state.vtx_attr[i].g2.Hex;
+  }
+  return state;
+}
+
+static void ResetEntry(Entry* entry)
+{
+  s_cached_vertex_bytes -= entry->vertices.size();
+  entry->recorded = false;
+  entry->uncacheable = false;
+  entry->draws.clear();
+  entry->arrays.clear();
+  entry->vertices.clear();
+}
+
+// Returns the number of bytes following cmd_byte, which must not be a draw command.
+static u32 GetCommandSize(u8 cmd_byte, const DataReader& src)
+{
+  switch (cmd_byte)
+  {
+  case OpcodeDecoder::GX_LOAD_CP_REG:
+    return 1 + 4;
+
+  case OpcodeDecoder::GX_LOAD_XF_REG:
+    if (src.size() < 4)
+      return 4;
+    return 4 + (((src.Peek<u32>() >> 16) & 15) + 1) * sizeof(u32);
+
+  case OpcodeDecoder::GX_LOAD_INDX_A:
+  case OpcodeDecoder::GX_LOAD_INDX_B:
+  case OpcodeDecoder::GX_LOAD_INDX_C:
+  case OpcodeDecoder::GX_LOAD_INDX_D:
+  case OpcodeDecoder::GX_LOAD_BP_REG:
+    return 4;
+
+  case OpcodeDecoder::GX_CMD_CALL_DL:
+    return 8;
+
+  default:
+    // NOPs, other single byte commands and unknown opcodes, which OpcodeDecoder::Run skips.
+    return 0;
+  }
+}
+
+static u32 RunCommands(u8* begin, u8* end)
+{
+  u32 cycles = 0;
+  if (begin != end)
+    OpcodeDecoder::Run(DataReader(begin, end), &cycles, true);
+  return cycles;
+}
+
+static u32 ReadIndex(const u8* indices, u32 index_size, u32 i)
+{
+  return index_size == 2 ? (indices[i * 2] << 8) | indices[i * 2 + 1] : indices[i];
+}
+
+// Adds the parts of the vertex arrays read when loading count vertices with the current vertex
+// format to entry->arrays. Returns false if the layout of the vertices could not be determined.
+static bool AddArrayRanges(Entry* entry, int vtx_attr_group, const u8* vertices, int count,
+                           int vertex_size)
+{
+  static constexpr std::array<u32, 6> color_sizes = {{2, 3, 4, 2, 3, 4}};
+
+  const TVtxDesc& desc = g_main_cp_state.vtx_desc;
+  const VAT& vat = g_main_cp_state.vtx_attr[vtx_attr_group];
+
+  std::array<IndexedAttribute, 12> attributes;
+  size_t num_attributes = 0;
+  u32 offset = 0;
+  auto add_attribute = [&](int array, u64 type, u32 size, u32 element_size) {
+    if (type & MASK_INDEXED)
+    {
+      const u32 index_size = type == INDEX16 ? 2 : 1;
+      attributes[num_attributes++] = {array, offset, index_size, size / index_size, element_size};
+    }
+    offset += size;
+  };
+
+  // The matrix indices are always direct.
+  for (int i = 0; i < 9; i++)
+    offset += (desc.Hex >> i) & 1;
+
+  add_attribute(ARRAY_POSITION, desc.Position,
+                VertexLoader_Position::GetSize(desc.Position, vat.g0.PosFormat, vat.g0.PosElements),
+                VertexLoader_Position::GetSize(DIRECT, vat.g0.PosFormat, vat.g0.PosElements));
+
+  if (desc.Normal != NOT_PRESENT)
+  {
+    // With NormalIndex3, each index reads one of the three normals of an element.
+    const u32 elements = vat.g0.NormalElements || vat.g0.NormalIndex3;
+    add_attribute(ARRAY_NORMAL, desc.Normal,
+                  VertexLoader_Normal::GetSize(desc.Normal, vat.g0.NormalFormat,
+                                               vat.g0.NormalElements, vat.g0.NormalIndex3),
+                  VertexLoader_Normal::GetSize(DIRECT, vat.g0.NormalFormat, elements, 0));
+  }
+
+  const std::array<u64, 2> color_types = {{desc.Color0, desc.Color1}};
+  const std::array<u32, 2> color_formats = {{vat.g0.Color0Comp, vat.g0.Color1Comp}};
+  for (int i = 0; i < 2; i++)
+  {
+    if (color_types[i] == NOT_PRESENT)
+      continue;
+    if (color_formats[i] >= color_sizes.size())
+      return false;
+
+    const u32 element_size = color_sizes[color_formats[i]];
+    const u32 size =
+        color_types[i] == DIRECT ? element_size : color_types[i] == INDEX16 ? 2 : 1;
+    add_attribute(ARRAY_COLOR + i, color_types[i], size, element_size);
+  }
+
+  const std::array<u64, 8> tex_types = {{desc.Tex0Coord, desc.Tex1Coord, desc.Tex2Coord,
+                                         desc.Tex3Coord, desc.Tex4Coord, desc.Tex5Coord,
+                                         desc.Tex6Coord, desc.Tex7Coord}};
+  const std::array<u32, 8> tex_formats = {
+      {vat.g0.Tex0CoordFormat, vat.g1.Tex1CoordFormat, vat.g1.Tex2CoordFormat,
+       vat.g1.Tex3CoordFormat, vat.g1.Tex4CoordFormat, vat.g2.Tex5CoordFormat,
+       vat.g2.Tex6CoordFormat, vat.g2.Tex7CoordFormat}};
+  const std::array<u32, 8> tex_elements = {
+      {vat.g0.Tex0CoordElements, vat.g1.Tex1CoordElements, vat.g1.Tex2CoordElements,
+       vat.g1.Tex3CoordElements, vat.g1.Tex4CoordElements, vat.g2.Tex5CoordElements,
+       vat.g2.Tex6CoordElements, vat.g2.Tex7CoordElements}};
+  for (int i = 0; i < 8; i++)
+  {
+    if (tex_types[i] == NOT_PRESENT)
+      continue;
+    add_attribute(ARRAY_TEXCOORD0 + i, tex_types[i],
+                  VertexLoader_TextCoord::GetSize(tex_types[i], tex_formats[i], tex_elements[i]),
+                  VertexLoader_TextCoord::GetSize(DIRECT, tex_formats[i], tex_elements[i]));
+  }
+
+  if (offset != static_cast<u32>(vertex_size))
+    return false;
+
+  // A position index with all bits set skips the vertex, and the vertex loaders don't read any
+  // of its attributes from the arrays.
+  const IndexedAttribute* position =
+      num_attributes != 0 && attributes[0].array == ARRAY_POSITION ? &attributes[0] : nullptr;
+  auto is_skipped = [&](const u8* vertex) {
+    if (!position)
+      return false;
+    const u32 skip_index = position->index_size == 2 ? 0xFFFF : 0xFF;
+    return ReadIndex(vertex + position->offset, position->index_size, 0) == skip_index;
+  };
+
+  for (size_t i = 0; i < num_attributes; i++)
+  {
+    const IndexedAttribute& attribute = attributes[i];
+
+    u32 min_index = UINT32_MAX;
+    u32 max_index = 0;
+    for (int vertex = 0; vertex < count; vertex++)
+    {
+      const u8* vertex_data = vertices + vertex * vertex_size;
+      if (is_skipped(vertex_data))
+        continue;
+
+      for (u32 j = 0; j < attribute.num_indices; j++)
+      {
+        const u32 index = ReadIndex(vertex_data + attribute.offset, attribute.index_size, j);
+        min_index = std::min(min_index, index);
+        max_index = std::max(max_index, index);
+      }
+    }
+    if (min_index > max_index)
+      continue;
+
+    const u32 base = g_main_cp_state.array_bases[attribute.array];
+    const u32 stride = g_main_cp_state.array_strides[attribute.array];
+    const u32 begin = min_index * stride;
+    const u32 end = max_index * stride + attribute.element_size;
+
+    auto range = std::find_if(entry->arrays.begin(), entry->arrays.end(),
+                              [base](const ArrayRange& r) { return r.base == base; });
+    if (range == entry->arrays.end())
+    {
+      entry->arrays.push_back({base, begin, end, 0});
+    }
+    else
+    {
+      range->begin = std::min(range->begin, begin);
+      range->end = std::max(range->end, end);
+    }
+  }
+
+  return true;
+}
+
+// Returns the number of bytes of emulated RAM from the physical address to the end of the memory
+// it is in, or 0 if the address isn't in RAM.
+static u32 GetRAMBytesFrom(u32 address)
+{
+  address &= 0x3FFFFFFF;
+  if (address < Memory::REALRAM_SIZE)
+    return Memory::REALRAM_SIZE - address;
+  if (Memory::m_pEXRAM && (address >> 28) == 0x1 && (address & 0x0FFFFFFF) < Memory::EXRAM_SIZE)
+    return Memory::EXRAM_SIZE - (address & 0x0FFFFFFF);
+  return 0;
+}
+
+static bool HashArrayRange(const ArrayRange& range, u64* hash)
+{
+  // Arrays that run past the end of RAM can't be checked for changes, so display lists using them
+  // aren't cached.
+  if (range.end > GetRAMBytesFrom(range.base))
+    return false;
+
+  const u8* data = Memory::GetPointer(range.base);
+  *hash = Common::GetHash64(data + range.begin, range.end - range.begin, 0);
+  return true;
+}
+
+static bool ArraysUnchanged(const Entry& entry)
+{
+  for (const ArrayRange& range : entry.arrays)
+  {
+    u64 hash;
+    if (!HashArrayRange(range, &hash) || hash != range.hash)
+      return false;
+  }
+  return true;
+}
+
+// Executes the display list like OpcodeDecoder::Run, but converts the vertices into the entry.
+static u32 Record(Entry* entry, u8* data)
+{
+  const u32 size = entry->key.size;
+  bool cacheable = true;
+  u32 cycles = 0;
+  u8* commands_begin = data;
+  DataReader src(data, data + size);
+  while (src.size())
+  {
+    u8* const command = src.GetPointer();
+    const u8 cmd_byte = src.Read<u8>();
+    if ((cmd_byte & 0xC0) != 0x80)
+    {
+      const u32 command_size = GetCommandSize(cmd_byte, src);
+      if (src.size() < command_size)
+        break;
+      src.Skip(command_size);
+      continue;
+    }
+
+    if (src.size() < 2)
+      break;
+    const u16 num_vertices = src.Read<u16>();
+    if (num_vertices == 0)
+      continue;
+
+    // The commands in front of the draw may change the vertex format.
+    const u32 commands_offset = static_cast<u32>(commands_begin - data);
+    cycles += RunCommands(commands_begin, command);
+    commands_begin = command;
+
+    const int vtx_attr_group = cmd_byte & OpcodeDecoder::GX_VAT_MASK;
+    VertexLoaderBase* loader = VertexLoaderManager::GetLoaderForDecoding(vtx_attr_group);
+    const u32 vertex_bytes = num_vertices * loader->m_VertexSize;
+    if (src.size() < vertex_bytes)
+      break;
+
+    Draw draw;
+    draw.commands_begin = commands_offset;
+    draw.commands_end = static_cast<u32>(command - data);
+    draw.loader = loader;
+    draw.primitive = (cmd_byte & OpcodeDecoder::GX_PRIMITIVE_MASK) >>
+                     OpcodeDecoder::GX_PRIMITIVE_SHIFT;
+    draw.vertices_offset = entry->vertices.size();
+
+    // The vertex loaders can write up to 4 bytes past the end
+    const u32 stride = loader->m_native_vtx_decl.stride;
+    entry->vertices.resize(draw.vertices_offset + num_vertices * stride + 4);
+    u8* const vertices = entry->vertices.data() + draw.vertices_offset;
+    {
+      StageTimings::ScopedTimer timer(StageTimings::Stage::VertexLoad);
+      draw.count = loader->RunVertices(
+          src, DataReader(vertices, vertices + num_vertices * stride + 4), num_vertices);
+    }
+    entry->vertices.resize(draw.vertices_offset + draw.count * stride);
+    std::memcpy(draw.positions, VertexLoaderManager::position_cache, sizeof(draw.positions));
+    std::memcpy(draw.matrix_indices, VertexLoaderManager::position_matrix_index,
+                sizeof(draw.matrix_indices));
+
+    if (!AddArrayRanges(entry, vtx_attr_group, src.GetPointer(), num_vertices,
+                        loader->m_VertexSize))
+    {
+      cacheable = false;
+    }
+
+    VertexLoaderManager::SubmitConvertedVertices(loader, draw.primitive, draw.count,
+                                                 entry->vertices.data() + draw.vertices_offset,
+                                                 draw.positions, draw.matrix_indices);
+    entry->draws.push_back(draw);
+
+    src.Skip(vertex_bytes);
+    // 4 GPU ticks per vertex, 3 CPU ticks per GPU tick
+    cycles += num_vertices * 4 * 3 + 6;
+    commands_begin = src.GetPointer();
+  }
+
+  // This also takes care of incomplete commands at the end, which OpcodeDecoder::Run stops at.
+  entry->tail_begin = static_cast<u32>(commands_begin - data);
+  cycles += RunCommands(commands_begin, data + size);
+  entry->cycles = cycles;
+
+  for (ArrayRange& range : entry->arrays)
+    cacheable &= HashArrayRange(range, &range.hash);
+
+  if (cacheable)
+  {
+    entry->recorded = true;
+    entry->vertices.shrink_to_fit();
+    s_cached_vertex_bytes += entry->vertices.size();
+  }
+  else
+  {
+    ResetEntry(entry);
+    entry->uncacheable = true;
+  }
+
+  return cycles;
+}
+
+static u32 Replay(const Entry& entry, u8* data)
+{
+  for (const Draw& draw : entry.draws)
+  {
+    RunCommands(data + draw.commands_begin, data + draw.commands_end);
+    VertexLoaderManager::SubmitConvertedVertices(draw.loader, draw.primitive, draw.count,
+                                                 entry.vertices.data() + draw.vertices_offset,
+                                                 draw.positions, draw.matrix_indices);
+  }
+  RunCommands(data + entry.tail_begin, data + entry.key.size);
+
+  return entry.cycles;
+}
+
+static void EvictEntries()
+{
+  while (s_lru.size() > MAX_CACHED_ENTRIES || s_cached_vertex_bytes > MAX_CACHED_VERTEX_BYTES)
+  {
+    const Entry& entry = s_lru.back();
+    s_cached_vertex_bytes -= entry.vertices.size();
+    s_entries.erase(entry.key);
+    s_lru.pop_back();
+  }
+}
+
+u32 Interpret(u32 address, u8* data, u32 size)
+{
+  const Key key = {address, size, Common::GetHash64(data, size, 0), GetVertexState()};
+  const auto it = s_entries.find(key);
+  if (it == s_entries.end())
+  {
+    // Display lists are only recorded when they are called a second time with the same contents,
+    // so display lists which are rebuilt for every call are not copied for nothing.
+    INCSTAT(stats.thisFrame.numDListCacheMisses);
+    s_lru.emplace_front();
+    s_lru.front().key = key;
+    s_entries.emplace(key, s_lru.begin());
+    EvictEntries();
+    return RunCommands(data, data + size);
+  }
+
+  s_lru.splice(s_lru.begin(), s_lru, it->second);
+  Entry& entry = s_lru.front();
+  if (entry.recorded && ArraysUnchanged(entry))
+  {
+    INCSTAT(stats.thisFrame.numDListCacheHits);
+    return Replay(entry, data);
+  }
+
+  INCSTAT(stats.thisFrame.numDListCacheMisses);
+  if (entry.uncacheable)
+    return RunCommands(data, data + size);
+
+  ResetEntry(&entry);
+  const u32 cycles = Record(&entry, data);
+  EvictEntries();
+  return cycles;
+}
+}  // namespace DisplayListCache
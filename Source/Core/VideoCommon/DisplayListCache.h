@@ -0,0 +1,34 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+// Caches the vertices of display lists after they have been converted by the vertex loaders, so
+// that calling the same display list again only has to copy them to the vertex manager.
+//
+// An entry is keyed by the address, size and a hash of the contents of the display list, and the
+// CP state it is called with, so that display lists which are rewritten or called with several
+// vertex formats keep an entry for each variant. Entries are only used if the parts of the vertex
+// arrays they referenced are unchanged, which is checked by hashing the memory on every call. The
+// least recently used entries are evicted once the cache is full. All other commands in the
+// display list are executed as usual, so the cache does not need to know about any BP or XF
+// state.
+namespace DisplayListCache
+{
+void Clear();
+
+// Returns the number of cached display lists, including those seen only once.
+size_t GetEntryCount();
+
+// Whether display lists should be interpreted with Interpret instead of OpcodeDecoder::Run.
+bool IsEnabled();
+
+// Executes the display list at address, which has been read to data, and returns the number of
+// cycles it took.
+u32 Interpret(u32 address, u8* data, u32 size);
+}  // namespace DisplayListCache
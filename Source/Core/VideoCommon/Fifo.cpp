@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <cstring>
+#include <vector>
 
 #include "Common/Assert.h"
 #include "Common/Atomic.h"
@@ -23,6 +24,7 @@
 
 #include "VideoCommon/AsyncRequests.h"
 #include "VideoCommon/CPMemory.h"
+#include "VideoCommon/CommandPipeline.h"
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/OpcodeDecoding.h"
@@ -34,6 +36,8 @@ namespace Fifo
 {
 static constexpr u32 FIFO_SIZE = 2 * 1024 * 1024;
 static constexpr int GPU_TIME_SLOT_SIZE = 1000;
+// How much FIFO data is collected before handing it to CommandPipeline.
+static constexpr u32 PIPELINE_PUSH_SIZE = 4096;
 
 static Common::BlockingLoop s_gpu_mainloop;
 
@@ -72,6 +76,9 @@ static std::atomic<int> s_sync_ticks;
 static bool s_syncing_suspended;
 static Common::Event s_sync_wakeup_event;
 
+// The data CommandPipeline returns from Drain().
+static std::vector<u8> s_pipeline_leftover;
+
 void DoState(PointerWrap& p)
 {
   p.DoArray(s_video_buffer, FIFO_SIZE);
@@ -288,6 +295,37 @@ void ResetVideoBuffer()
   s_fifo_aux_read_ptr = s_fifo_aux_data;
 }
 
+static void PushToCommandPipeline()
+{
+  u8* write_ptr = s_video_buffer_write_ptr;
+  CommandPipeline::PushData(s_video_buffer_read_ptr,
+                            static_cast<u32>(write_ptr - s_video_buffer_read_ptr),
+                            CommandProcessor::fifo.CPReadPointer);
+  s_video_buffer_read_ptr = write_ptr;
+}
+
+// Executes everything that has been read from the FIFO, and moves the data the pipeline has not
+// decoded yet back into the video buffer so that it is decoded on the GPU thread if the pipeline
+// is not used any more, and saved with savestates.
+static void DrainCommandPipeline()
+{
+  if (s_video_buffer_read_ptr != s_video_buffer_write_ptr)
+    PushToCommandPipeline();
+
+  CommandPipeline::Drain(&s_pipeline_leftover);
+  ASSERT_MSG(VIDEO, s_pipeline_leftover.size() <= FIFO_SIZE,
+             "Command pipeline returned too much data (%zu)", s_pipeline_leftover.size());
+
+  std::memcpy(s_video_buffer, s_pipeline_leftover.data(), s_pipeline_leftover.size());
+  s_video_buffer_read_ptr = s_video_buffer;
+  s_video_buffer_write_ptr = s_video_buffer + s_pipeline_leftover.size();
+  if (s_pipeline_leftover.empty())
+  {
+    Common::AtomicStore(CommandProcessor::fifo.SafeCPReadPointer,
+                        CommandProcessor::fifo.CPReadPointer);
+  }
+}
+
 // Description: Main FIFO update loop
 // Purpose: Keep the Core HW updated about the CPU-GPU distance
 void RunGpuLoop()
@@ -326,6 +364,8 @@ void RunGpuLoop()
 
           CommandProcessor::SetCPStatusFromGPU();
 
+          bool use_pipeline = CommandPipeline::ShouldUse();
+
           // check if we are able to run this buffer
           while (!CommandProcessor::IsInterruptWaiting() && fifo.bFF_GPReadEnable &&
                  fifo.CPReadWriteDistance && !AtBreakpoint())
@@ -333,6 +373,12 @@ void RunGpuLoop()
             if (param.bSyncGPU && s_sync_ticks.load() < param.iSyncGpuMinDistance)
               break;
 
+            if (use_pipeline && !CommandPipeline::ShouldUse())
+            {
+              DrainCommandPipeline();
+              use_pipeline = false;
+            }
+
             u32 cyclesExecuted = 0;
             u32 readPtr = fifo.CPReadPointer;
             ReadDataFromFifo(readPtr);
@@ -348,13 +394,25 @@ void RunGpuLoop()
                        fifo.CPReadWriteDistance - 32);
 
             u8* write_ptr = s_video_buffer_write_ptr;
-            s_video_buffer_read_ptr = OpcodeDecoder::Run(
-                DataReader(s_video_buffer_read_ptr, write_ptr), &cyclesExecuted, false);
+            if (!use_pipeline)
+            {
+              s_video_buffer_read_ptr = OpcodeDecoder::Run(
+                  DataReader(s_video_buffer_read_ptr, write_ptr), &cyclesExecuted, false);
+            }
 
             Common::AtomicStore(fifo.CPReadPointer, readPtr);
             Common::AtomicAdd(fifo.CPReadWriteDistance, static_cast<u32>(-32));
-            if ((write_ptr - s_video_buffer_read_ptr) == 0)
+            if (use_pipeline)
+            {
+              // The pipeline updates SafeCPReadPointer as it executes the commands.
+              if (write_ptr - s_video_buffer_read_ptr >= PIPELINE_PUSH_SIZE)
+                PushToCommandPipeline();
+              CommandPipeline::SubmitDecodedBatches();
+            }
+            else if ((write_ptr - s_video_buffer_read_ptr) == 0)
+            {
               Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
+            }
 
             CommandProcessor::SetCPStatusFromGPU();
 
@@ -374,6 +432,9 @@ void RunGpuLoop()
             AsyncRequests::GetInstance()->PullEvents();
           }
 
+          if (use_pipeline)
+            DrainCommandPipeline();
+
           // fast skip remaining GPU time if fifo is empty
           if (s_sync_ticks.load() > 0)
           {
@@ -389,6 +450,8 @@ void RunGpuLoop()
       },
       100);
 
+  CommandPipeline::Shutdown();
+
   AsyncRequests::GetInstance()->SetEnable(false);
   AsyncRequests::GetInstance()->SetPassthrough(true);
 }
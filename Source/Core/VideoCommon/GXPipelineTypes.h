@@ -80,8 +80,8 @@ struct GXUberPipelineUid
   bool operator!=(const GXUberPipelineUid& rhs) const { return !operator==(rhs); }
 };
 
-// Disk cache of pipeline UIDs. We can't use the whole UID as a type as it contains pointers.
-// This structure is safe to save to disk, and should be compiler/platform independent.
+// The pipeline UID cache format used before PipelineUIDLog, which is only read to import the UIDs
+// into a game's log. We can't use the whole UID as a type as it contains pointers.
 #pragma pack(push, 1)
 struct SerializedGXPipelineUid
 {
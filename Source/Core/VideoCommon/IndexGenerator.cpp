@@ -3,99 +3,442 @@
 // Refer to the license.txt file included.
 
 #include <cstddef>
+#include <limits>
 
+#include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
 #include "Common/Compiler.h"
+#include "Common/Intrinsics.h"
 #include "Common/Logging/Log.h"
 #include "VideoCommon/IndexGenerator.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/VideoConfig.h"
 
+#ifdef _M_ARM_64
+#include <arm_neon.h>
+#endif
+
 // Init
-u16* IndexGenerator::index_buffer_current;
-u16* IndexGenerator::BASEIptr;
+u8* IndexGenerator::index_buffer_current;
+u8* IndexGenerator::BASEIptr;
+u32 IndexGenerator::index_size = sizeof(u16);
 u32 IndexGenerator::base_index;
 
-static const u16 s_primitive_restart = UINT16_MAX;
+template <typename T>
+using PrimitiveFunction = T* (*)(T*, u32, u32);
+
+static PrimitiveFunction<u16> primitive_table_16[8];
+static PrimitiveFunction<u32> primitive_table_32[8];
+
+template <typename T>
+static PrimitiveFunction<T>* GetPrimitiveTable();
+template <>
+PrimitiveFunction<u16>* GetPrimitiveTable<u16>()
+{
+  return primitive_table_16;
+}
+template <>
+PrimitiveFunction<u32>* GetPrimitiveTable<u32>()
+{
+  return primitive_table_32;
+}
+
+template <typename T>
+static constexpr T PrimitiveRestart()
+{
+  return std::numeric_limits<T>::max();
+}
+
+// Index patterns
+//
+// Apart from their remainders, all primitives are converted by repeating a fixed sequence of
+// indices for every few vertices. For large draws, the indices are written in blocks containing
+// as many repetitions as are needed to fill whole 32-byte vectors, using a table which holds the
+// index offsets of one block and lane masks for the primitive restart indices and for the center
+// vertex of fans, which does not advance with the other vertices.
+
+namespace
+{
+enum PatternType
+{
+  PATTERN_SEQUENCE,
+  PATTERN_LIST_PR,
+  PATTERN_STRIP,
+  PATTERN_FAN,
+  PATTERN_FAN_PR,
+  PATTERN_QUADS,
+  PATTERN_QUADS_PR,
+  PATTERN_LINE_STRIP,
+  NUM_PATTERNS
+};
+
+constexpr s8 R = -1;  // Primitive restart
+constexpr s8 C = -2;  // Center vertex of a fan
+
+struct PatternPeriod
+{
+  u32 num_vertices;
+  u32 num_indices;
+  s8 indices[6];
+};
+
+// Must match the scalar implementations below.
+constexpr PatternPeriod s_pattern_periods[NUM_PATTERNS] = {
+    {1, 1, {0}},                 // PATTERN_SEQUENCE
+    {3, 4, {0, 1, 2, R}},        // PATTERN_LIST_PR
+    {2, 6, {0, 1, 2, 1, 3, 2}},  // PATTERN_STRIP
+    {1, 3, {C, 1, 2}},           // PATTERN_FAN
+    {3, 6, {1, 2, C, 3, 4, R}},  // PATTERN_FAN_PR
+    {4, 6, {0, 1, 2, 0, 2, 3}},  // PATTERN_QUADS
+    {4, 5, {1, 2, 0, 3, R}},     // PATTERN_QUADS_PR
+    {1, 2, {0, 1}},              // PATTERN_LINE_STRIP
+};
+
+constexpr u32 PATTERN_VECTOR_SIZE = 32;
+// lcm(5, 16), for PATTERN_QUADS_PR with 16-bit indices.
+constexpr u32 MAX_PATTERN_INDICES = 80;
+
+template <typename T>
+struct IndexPattern
+{
+  // Relative to the first vertex of the draw.
+  alignas(PATTERN_VECTOR_SIZE) T offsets[MAX_PATTERN_INDICES];
+  // All ones for the indices which advance by num_vertices for each block.
+  alignas(PATTERN_VECTOR_SIZE) T advance_mask[MAX_PATTERN_INDICES];
+  // All ones for the primitive restart indices.
+  alignas(PATTERN_VECTOR_SIZE) T restart_mask[MAX_PATTERN_INDICES];
+  u32 num_indices;
+  u32 num_vertices;
+  u32 num_periods;
+};
+
+template <typename T>
+using WritePatternFunction = T* (*)(T* Iptr, const IndexPattern<T>& pattern, u32 num_blocks,
+                                    u32 index);
+
+template <typename T>
+struct PatternSet
+{
+  IndexPattern<T> patterns[NUM_PATTERNS];
+  WritePatternFunction<T> write;
+};
+}  // Anonymous namespace
+
+static PatternSet<u16> s_patterns_16;
+static PatternSet<u32> s_patterns_32;
+
+template <typename T>
+static PatternSet<T>& GetPatternSet();
+template <>
+PatternSet<u16>& GetPatternSet<u16>()
+{
+  return s_patterns_16;
+}
+template <>
+PatternSet<u32>& GetPatternSet<u32>()
+{
+  return s_patterns_32;
+}
+
+template <typename T>
+static void BuildPattern(IndexPattern<T>* pattern, const PatternPeriod& period)
+{
+  constexpr u32 lanes = PATTERN_VECTOR_SIZE / sizeof(T);
+  u32 num_periods = 1;
+  while ((num_periods * period.num_indices) % lanes != 0)
+    num_periods++;
+
+  pattern->num_indices = num_periods * period.num_indices;
+  pattern->num_vertices = num_periods * period.num_vertices;
+  pattern->num_periods = num_periods;
+
+  u32 i = 0;
+  for (u32 p = 0; p < num_periods; p++)
+  {
+    for (u32 j = 0; j < period.num_indices; j++, i++)
+    {
+      const s8 index = period.indices[j];
+      pattern->offsets[i] = index < 0 ? 0 : static_cast<T>(p * period.num_vertices + index);
+      pattern->advance_mask[i] = index == C ? 0 : PrimitiveRestart<T>();
+      pattern->restart_mask[i] = index == R ? PrimitiveRestart<T>() : 0;
+    }
+  }
+}
+
+template <typename T>
+static T* WritePatternGeneric(T* Iptr, const IndexPattern<T>& pattern, u32 num_blocks, u32 index)
+{
+  for (u32 block = 0; block < num_blocks; block++)
+  {
+    const u32 advance = block * pattern.num_vertices;
+    for (u32 i = 0; i < pattern.num_indices; i++)
+    {
+      *Iptr++ = static_cast<T>((index + pattern.offsets[i] + (advance & pattern.advance_mask[i])) |
+                               pattern.restart_mask[i]);
+    }
+  }
+  return Iptr;
+}
+
+#if defined(_M_X86)
+template <typename T>
+static T* WritePatternSSE2(T* Iptr, const IndexPattern<T>& pattern, u32 num_blocks, u32 index)
+{
+  const bool is_u16 = sizeof(T) == sizeof(u16);
+  const __m128i base = is_u16 ? _mm_set1_epi16(static_cast<s16>(index)) : _mm_set1_epi32(index);
+  const __m128i step = is_u16 ? _mm_set1_epi16(static_cast<s16>(pattern.num_vertices)) :
+                                _mm_set1_epi32(pattern.num_vertices);
+  __m128i advance = _mm_setzero_si128();
+
+  for (u32 block = 0; block < num_blocks; block++)
+  {
+    for (u32 i = 0; i < pattern.num_indices; i += 16 / sizeof(T))
+    {
+      const __m128i offsets = _mm_load_si128(reinterpret_cast<const __m128i*>(&pattern.offsets[i]));
+      const __m128i advance_mask =
+          _mm_load_si128(reinterpret_cast<const __m128i*>(&pattern.advance_mask[i]));
+      const __m128i restart_mask =
+          _mm_load_si128(reinterpret_cast<const __m128i*>(&pattern.restart_mask[i]));
+      const __m128i moved = _mm_and_si128(advance, advance_mask);
+      const __m128i indices = is_u16 ? _mm_add_epi16(_mm_add_epi16(base, offsets), moved) :
+                                       _mm_add_epi32(_mm_add_epi32(base, offsets), moved);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(Iptr + i), _mm_or_si128(indices, restart_mask));
+    }
+    Iptr += pattern.num_indices;
+    advance = is_u16 ? _mm_add_epi16(advance, step) : _mm_add_epi32(advance, step);
+  }
+  return Iptr;
+}
+
+template <typename T>
+FUNCTION_TARGET_AVX2
+static T* WritePatternAVX2(T* Iptr, const IndexPattern<T>& pattern, u32 num_blocks, u32 index)
+{
+  const bool is_u16 = sizeof(T) == sizeof(u16);
+  const __m256i base =
+      is_u16 ? _mm256_set1_epi16(static_cast<s16>(index)) : _mm256_set1_epi32(index);
+  const __m256i step = is_u16 ? _mm256_set1_epi16(static_cast<s16>(pattern.num_vertices)) :
+                                _mm256_set1_epi32(pattern.num_vertices);
+  __m256i advance = _mm256_setzero_si256();
+
+  for (u32 block = 0; block < num_blocks; block++)
+  {
+    for (u32 i = 0; i < pattern.num_indices; i += 32 / sizeof(T))
+    {
+      const __m256i offsets =
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(&pattern.offsets[i]));
+      const __m256i advance_mask =
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(&pattern.advance_mask[i]));
+      const __m256i restart_mask =
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(&pattern.restart_mask[i]));
+      const __m256i moved = _mm256_and_si256(advance, advance_mask);
+      const __m256i indices = is_u16 ?
+                                  _mm256_add_epi16(_mm256_add_epi16(base, offsets), moved) :
+                                  _mm256_add_epi32(_mm256_add_epi32(base, offsets), moved);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(Iptr + i),
+                          _mm256_or_si256(indices, restart_mask));
+    }
+    Iptr += pattern.num_indices;
+    advance = is_u16 ? _mm256_add_epi16(advance, step) : _mm256_add_epi32(advance, step);
+  }
+  return Iptr;
+}
+#elif defined(_M_ARM_64)
+static uint8x16_t AddLanes(u16*, uint8x16_t a, uint8x16_t b)
+{
+  return vreinterpretq_u8_u16(vaddq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+}
+
+static uint8x16_t AddLanes(u32*, uint8x16_t a, uint8x16_t b)
+{
+  return vreinterpretq_u8_u32(vaddq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+}
+
+template <typename T>
+static T* WritePatternNEON(T* Iptr, const IndexPattern<T>& pattern, u32 num_blocks, u32 index)
+{
+  const bool is_u16 = sizeof(T) == sizeof(u16);
+  const uint8x16_t base = is_u16 ? vreinterpretq_u8_u16(vdupq_n_u16(static_cast<u16>(index))) :
+                                   vreinterpretq_u8_u32(vdupq_n_u32(index));
+  const uint8x16_t step =
+      is_u16 ? vreinterpretq_u8_u16(vdupq_n_u16(static_cast<u16>(pattern.num_vertices))) :
+               vreinterpretq_u8_u32(vdupq_n_u32(pattern.num_vertices));
+  uint8x16_t advance = vdupq_n_u8(0);
+
+  for (u32 block = 0; block < num_blocks; block++)
+  {
+    for (u32 i = 0; i < pattern.num_indices; i += 16 / sizeof(T))
+    {
+      const uint8x16_t offsets = vld1q_u8(reinterpret_cast<const u8*>(&pattern.offsets[i]));
+      const uint8x16_t advance_mask =
+          vld1q_u8(reinterpret_cast<const u8*>(&pattern.advance_mask[i]));
+      const uint8x16_t restart_mask =
+          vld1q_u8(reinterpret_cast<const u8*>(&pattern.restart_mask[i]));
+      const uint8x16_t indices =
+          AddLanes(Iptr, AddLanes(Iptr, base, offsets), vandq_u8(advance, advance_mask));
+      vst1q_u8(reinterpret_cast<u8*>(Iptr + i), vorrq_u8(indices, restart_mask));
+    }
+    Iptr += pattern.num_indices;
+    advance = AddLanes(Iptr, advance, step);
+  }
+  return Iptr;
+}
+#endif
+
+template <typename T>
+static void InitPatternSet(PatternSet<T>* set)
+{
+  for (int i = 0; i < NUM_PATTERNS; i++)
+    BuildPattern(&set->patterns[i], s_pattern_periods[i]);
 
-static u16* (*primitive_table[8])(u16*, u32, u32);
+#if defined(_M_X86)
+  set->write = cpu_info.bAVX2 ? WritePatternAVX2<T> : WritePatternSSE2<T>;
+#elif defined(_M_ARM_64)
+  set->write = WritePatternNEON<T>;
+#else
+  set->write = WritePatternGeneric<T>;
+#endif
+}
+
+// Writes the indices of as many whole blocks of the pattern as fit into num_periods repetitions,
+// and returns the number of repetitions written.
+template <typename T>
+static DOLPHIN_FORCE_INLINE u32 WritePattern(T** Iptr, PatternType type, u32 num_periods,
+                                             u32 index)
+{
+  const PatternSet<T>& set = GetPatternSet<T>();
+  const IndexPattern<T>& pattern = set.patterns[type];
+  const u32 num_blocks = num_periods / pattern.num_periods;
+  if (num_blocks == 0)
+    return 0;
+
+  *Iptr = set.write(*Iptr, pattern, num_blocks, index);
+  return num_blocks * pattern.num_periods;
+}
+
+template <typename T>
+static T* AddSequence(T* Iptr, u32 count, u32 index)
+{
+  for (u32 i = WritePattern(&Iptr, PATTERN_SEQUENCE, count, index); i < count; ++i)
+    *Iptr++ = index + i;
+  return Iptr;
+}
 
 void IndexGenerator::Init()
 {
+  InitPatternSet(&s_patterns_16);
+  InitPatternSet(&s_patterns_32);
+
   if (g_Config.backend_info.bSupportsPrimitiveRestart)
   {
-    primitive_table[OpcodeDecoder::GX_DRAW_QUADS] = AddQuads<true>;
-    primitive_table[OpcodeDecoder::GX_DRAW_QUADS_2] = AddQuads_nonstandard<true>;
-    primitive_table[OpcodeDecoder::GX_DRAW_TRIANGLES] = AddList<true>;
-    primitive_table[OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP] = AddStrip<true>;
-    primitive_table[OpcodeDecoder::GX_DRAW_TRIANGLE_FAN] = AddFan<true>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_QUADS] = AddQuads<u16, true>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_QUADS_2] = AddQuads_nonstandard<u16, true>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_TRIANGLES] = AddList<u16, true>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP] = AddStrip<u16, true>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_TRIANGLE_FAN] = AddFan<u16, true>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_QUADS] = AddQuads<u32, true>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_QUADS_2] = AddQuads_nonstandard<u32, true>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_TRIANGLES] = AddList<u32, true>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP] = AddStrip<u32, true>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_TRIANGLE_FAN] = AddFan<u32, true>;
   }
   else
   {
-    primitive_table[OpcodeDecoder::GX_DRAW_QUADS] = AddQuads<false>;
-    primitive_table[OpcodeDecoder::GX_DRAW_QUADS_2] = AddQuads_nonstandard<false>;
-    primitive_table[OpcodeDecoder::GX_DRAW_TRIANGLES] = AddList<false>;
-    primitive_table[OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP] = AddStrip<false>;
-    primitive_table[OpcodeDecoder::GX_DRAW_TRIANGLE_FAN] = AddFan<false>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_QUADS] = AddQuads<u16, false>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_QUADS_2] = AddQuads_nonstandard<u16, false>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_TRIANGLES] = AddList<u16, false>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP] = AddStrip<u16, false>;
+    primitive_table_16[OpcodeDecoder::GX_DRAW_TRIANGLE_FAN] = AddFan<u16, false>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_QUADS] = AddQuads<u32, false>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_QUADS_2] = AddQuads_nonstandard<u32, false>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_TRIANGLES] = AddList<u32, false>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP] = AddStrip<u32, false>;
+    primitive_table_32[OpcodeDecoder::GX_DRAW_TRIANGLE_FAN] = AddFan<u32, false>;
   }
-  primitive_table[OpcodeDecoder::GX_DRAW_LINES] = &AddLineList;
-  primitive_table[OpcodeDecoder::GX_DRAW_LINE_STRIP] = &AddLineStrip;
-  primitive_table[OpcodeDecoder::GX_DRAW_POINTS] = &AddPoints;
+  primitive_table_16[OpcodeDecoder::GX_DRAW_LINES] = &AddLineList<u16>;
+  primitive_table_16[OpcodeDecoder::GX_DRAW_LINE_STRIP] = &AddLineStrip<u16>;
+  primitive_table_16[OpcodeDecoder::GX_DRAW_POINTS] = &AddPoints<u16>;
+  primitive_table_32[OpcodeDecoder::GX_DRAW_LINES] = &AddLineList<u32>;
+  primitive_table_32[OpcodeDecoder::GX_DRAW_LINE_STRIP] = &AddLineStrip<u32>;
+  primitive_table_32[OpcodeDecoder::GX_DRAW_POINTS] = &AddPoints<u32>;
 }
 
 void IndexGenerator::Start(u16* Indexptr)
 {
-  index_buffer_current = Indexptr;
-  BASEIptr = Indexptr;
+  index_buffer_current = reinterpret_cast<u8*>(Indexptr);
+  BASEIptr = index_buffer_current;
+  index_size = sizeof(u16);
+  base_index = 0;
+}
+
+void IndexGenerator::Start(u32* Indexptr)
+{
+  index_buffer_current = reinterpret_cast<u8*>(Indexptr);
+  BASEIptr = index_buffer_current;
+  index_size = sizeof(u32);
   base_index = 0;
 }
 
 void IndexGenerator::AddIndices(int primitive, u32 numVerts)
 {
-  index_buffer_current = primitive_table[primitive](index_buffer_current, numVerts, base_index);
+  if (index_size == sizeof(u32))
+    AddIndices<u32>(primitive, numVerts);
+  else
+    AddIndices<u16>(primitive, numVerts);
   base_index += numVerts;
 }
 
+template <typename T>
+void IndexGenerator::AddIndices(int primitive, u32 numVerts)
+{
+  T* const Iptr = reinterpret_cast<T*>(index_buffer_current);
+  index_buffer_current =
+      reinterpret_cast<u8*>(GetPrimitiveTable<T>()[primitive](Iptr, numVerts, base_index));
+}
+
 // Triangles
-template <bool pr>
-DOLPHIN_FORCE_INLINE u16* IndexGenerator::WriteTriangle(u16* Iptr, u32 index1, u32 index2,
-                                                        u32 index3)
+template <typename T, bool pr>
+DOLPHIN_FORCE_INLINE T* IndexGenerator::WriteTriangle(T* Iptr, u32 index1, u32 index2, u32 index3)
 {
   *Iptr++ = index1;
   *Iptr++ = index2;
   *Iptr++ = index3;
   if (pr)
-    *Iptr++ = s_primitive_restart;
+    *Iptr++ = PrimitiveRestart<T>();
   return Iptr;
 }
 
-template <bool pr>
-u16* IndexGenerator::AddList(u16* Iptr, u32 const numVerts, u32 index)
+template <typename T, bool pr>
+T* IndexGenerator::AddList(T* Iptr, u32 const numVerts, u32 index)
 {
-  for (u32 i = 2; i < numVerts; i += 3)
+  if (!pr)
+    return AddSequence(Iptr, numVerts / 3 * 3, index);
+
+  const u32 done = WritePattern(&Iptr, PATTERN_LIST_PR, numVerts / 3, index);
+  for (u32 i = 2 + done * 3; i < numVerts; i += 3)
   {
-    Iptr = WriteTriangle<pr>(Iptr, index + i - 2, index + i - 1, index + i);
+    Iptr = WriteTriangle<T, pr>(Iptr, index + i - 2, index + i - 1, index + i);
   }
   return Iptr;
 }
 
-template <bool pr>
-u16* IndexGenerator::AddStrip(u16* Iptr, u32 const numVerts, u32 index)
+template <typename T, bool pr>
+T* IndexGenerator::AddStrip(T* Iptr, u32 const numVerts, u32 index)
 {
   if (pr)
   {
-    for (u32 i = 0; i < numVerts; ++i)
-    {
-      *Iptr++ = index + i;
-    }
-    *Iptr++ = s_primitive_restart;
+    Iptr = AddSequence(Iptr, numVerts, index);
+    *Iptr++ = PrimitiveRestart<T>();
   }
   else
   {
+    // Each repetition of the pattern covers two triangles, so the winding starts over.
+    const u32 done =
+        numVerts > 2 ? WritePattern(&Iptr, PATTERN_STRIP, (numVerts - 2) / 2, index) : 0;
     bool wind = false;
-    for (u32 i = 2; i < numVerts; ++i)
+    for (u32 i = 2 + done * 2; i < numVerts; ++i)
     {
-      Iptr = WriteTriangle<pr>(Iptr, index + i - 2, index + i - !wind, index + i - wind);
+      Iptr = WriteTriangle<T, pr>(Iptr, index + i - 2, index + i - !wind, index + i - wind);
 
       wind ^= true;
     }
@@ -122,13 +465,17 @@ u16* IndexGenerator::AddStrip(u16* Iptr, u32 const numVerts, u32 index)
  * so we use 6 indices for 3 triangles
  */
 
-template <bool pr>
-u16* IndexGenerator::AddFan(u16* Iptr, u32 numVerts, u32 index)
+template <typename T, bool pr>
+T* IndexGenerator::AddFan(T* Iptr, u32 numVerts, u32 index)
 {
   u32 i = 2;
+  if (numVerts <= i)
+    return Iptr;
 
   if (pr)
   {
+    i += WritePattern(&Iptr, PATTERN_FAN_PR, (numVerts - i) / 3, index) * 3;
+
     for (; i + 3 <= numVerts; i += 3)
     {
       *Iptr++ = index + i - 1;
@@ -136,7 +483,7 @@ u16* IndexGenerator::AddFan(u16* Iptr, u32 numVerts, u32 index)
       *Iptr++ = index;
       *Iptr++ = index + i + 1;
       *Iptr++ = index + i + 2;
-      *Iptr++ = s_primitive_restart;
+      *Iptr++ = PrimitiveRestart<T>();
     }
 
     for (; i + 2 <= numVerts; i += 2)
@@ -145,13 +492,17 @@ u16* IndexGenerator::AddFan(u16* Iptr, u32 numVerts, u32 index)
       *Iptr++ = index + i + 0;
       *Iptr++ = index;
       *Iptr++ = index + i + 1;
-      *Iptr++ = s_primitive_restart;
+      *Iptr++ = PrimitiveRestart<T>();
     }
   }
+  else
+  {
+    i += WritePattern(&Iptr, PATTERN_FAN, numVerts - i, index);
+  }
 
   for (; i < numVerts; ++i)
   {
-    Iptr = WriteTriangle<pr>(Iptr, index, index + i - 1, index + i);
+    Iptr = WriteTriangle<T, pr>(Iptr, index, index + i - 1, index + i);
   }
   return Iptr;
 }
@@ -173,10 +524,10 @@ u16* IndexGenerator::AddFan(u16* Iptr, u32 numVerts, u32 index)
  * A simple triangle has to be rendered for three vertices.
  * ZWW do this for sun rays
  */
-template <bool pr>
-u16* IndexGenerator::AddQuads(u16* Iptr, u32 numVerts, u32 index)
+template <typename T, bool pr>
+T* IndexGenerator::AddQuads(T* Iptr, u32 numVerts, u32 index)
 {
-  u32 i = 3;
+  u32 i = 3 + WritePattern(&Iptr, pr ? PATTERN_QUADS_PR : PATTERN_QUADS, numVerts / 4, index) * 4;
   for (; i < numVerts; i += 4)
   {
     if (pr)
@@ -185,47 +536,47 @@ u16* IndexGenerator::AddQuads(u16* Iptr, u32 numVerts, u32 index)
       *Iptr++ = index + i - 1;
       *Iptr++ = index + i - 3;
       *Iptr++ = index + i - 0;
-      *Iptr++ = s_primitive_restart;
+      *Iptr++ = PrimitiveRestart<T>();
     }
     else
     {
-      Iptr = WriteTriangle<pr>(Iptr, index + i - 3, index + i - 2, index + i - 1);
-      Iptr = WriteTriangle<pr>(Iptr, index + i - 3, index + i - 1, index + i - 0);
+      Iptr = WriteTriangle<T, pr>(Iptr, index + i - 3, index + i - 2, index + i - 1);
+      Iptr = WriteTriangle<T, pr>(Iptr, index + i - 3, index + i - 1, index + i - 0);
     }
   }
 
   // three vertices remaining, so render a triangle
   if (i == numVerts)
   {
-    Iptr =
-        WriteTriangle<pr>(Iptr, index + numVerts - 3, index + numVerts - 2, index + numVerts - 1);
+    Iptr = WriteTriangle<T, pr>(Iptr, index + numVerts - 3, index + numVerts - 2,
+                                index + numVerts - 1);
   }
   return Iptr;
 }
 
-template <bool pr>
-u16* IndexGenerator::AddQuads_nonstandard(u16* Iptr, u32 numVerts, u32 index)
+template <typename T, bool pr>
+T* IndexGenerator::AddQuads_nonstandard(T* Iptr, u32 numVerts, u32 index)
 {
   WARN_LOG(VIDEO, "Non-standard primitive drawing command GL_DRAW_QUADS_2");
-  return AddQuads<pr>(Iptr, numVerts, index);
+  return AddQuads<T, pr>(Iptr, numVerts, index);
 }
 
 // Lines
-u16* IndexGenerator::AddLineList(u16* Iptr, u32 numVerts, u32 index)
+template <typename T>
+T* IndexGenerator::AddLineList(T* Iptr, u32 numVerts, u32 index)
 {
-  for (u32 i = 1; i < numVerts; i += 2)
-  {
-    *Iptr++ = index + i - 1;
-    *Iptr++ = index + i;
-  }
-  return Iptr;
+  return AddSequence(Iptr, numVerts / 2 * 2, index);
 }
 
 // shouldn't be used as strips as LineLists are much more common
 // so converting them to lists
-u16* IndexGenerator::AddLineStrip(u16* Iptr, u32 numVerts, u32 index)
+template <typename T>
+T* IndexGenerator::AddLineStrip(T* Iptr, u32 numVerts, u32 index)
 {
-  for (u32 i = 1; i < numVerts; ++i)
+  if (numVerts == 0)
+    return Iptr;
+
+  for (u32 i = 1 + WritePattern(&Iptr, PATTERN_LINE_STRIP, numVerts - 1, index); i < numVerts; ++i)
   {
     *Iptr++ = index + i - 1;
     *Iptr++ = index + i;
@@ -234,17 +585,15 @@ u16* IndexGenerator::AddLineStrip(u16* Iptr, u32 numVerts, u32 index)
 }
 
 // Points
-u16* IndexGenerator::AddPoints(u16* Iptr, u32 numVerts, u32 index)
+template <typename T>
+T* IndexGenerator::AddPoints(T* Iptr, u32 numVerts, u32 index)
 {
-  for (u32 i = 0; i != numVerts; ++i)
-  {
-    *Iptr++ = index + i;
-  }
-  return Iptr;
+  return AddSequence(Iptr, numVerts, index);
 }
 
 u32 IndexGenerator::GetRemainingIndices()
 {
-  u32 max_index = 65534;  // -1 is reserved for primitive restart (ogl + dx11)
+  // -1 is reserved for primitive restart (ogl + dx11)
+  const u32 max_index = index_size == sizeof(u32) ? UINT32_MAX - 1 : 65534;
   return max_index - base_index;
 }
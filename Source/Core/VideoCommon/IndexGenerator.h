@@ -15,38 +15,47 @@ public:
   // Init
   static void Init();
   static void Start(u16* Indexptr);
+  // Generates 32-bit indices, so that batches are not limited to 65535 vertices.
+  static void Start(u32* Indexptr);
 
   static void AddIndices(int primitive, u32 numVertices);
 
   // returns numprimitives
   static u32 GetNumVerts() { return base_index; }
-  static u32 GetIndexLen() { return (u32)(index_buffer_current - BASEIptr); }
+  static u32 GetIndexLen() { return (u32)(index_buffer_current - BASEIptr) / index_size; }
   static u32 GetRemainingIndices();
 
 private:
+  template <typename T>
+  static void AddIndices(int primitive, u32 numVerts);
+
   // Triangles
-  template <bool pr>
-  static u16* AddList(u16* Iptr, u32 numVerts, u32 index);
-  template <bool pr>
-  static u16* AddStrip(u16* Iptr, u32 numVerts, u32 index);
-  template <bool pr>
-  static u16* AddFan(u16* Iptr, u32 numVerts, u32 index);
-  template <bool pr>
-  static u16* AddQuads(u16* Iptr, u32 numVerts, u32 index);
-  template <bool pr>
-  static u16* AddQuads_nonstandard(u16* Iptr, u32 numVerts, u32 index);
+  template <typename T, bool pr>
+  static T* AddList(T* Iptr, u32 numVerts, u32 index);
+  template <typename T, bool pr>
+  static T* AddStrip(T* Iptr, u32 numVerts, u32 index);
+  template <typename T, bool pr>
+  static T* AddFan(T* Iptr, u32 numVerts, u32 index);
+  template <typename T, bool pr>
+  static T* AddQuads(T* Iptr, u32 numVerts, u32 index);
+  template <typename T, bool pr>
+  static T* AddQuads_nonstandard(T* Iptr, u32 numVerts, u32 index);
 
   // Lines
-  static u16* AddLineList(u16* Iptr, u32 numVerts, u32 index);
-  static u16* AddLineStrip(u16* Iptr, u32 numVerts, u32 index);
+  template <typename T>
+  static T* AddLineList(T* Iptr, u32 numVerts, u32 index);
+  template <typename T>
+  static T* AddLineStrip(T* Iptr, u32 numVerts, u32 index);
 
   // Points
-  static u16* AddPoints(u16* Iptr, u32 numVerts, u32 index);
+  template <typename T>
+  static T* AddPoints(T* Iptr, u32 numVerts, u32 index);
 
-  template <bool pr>
-  static u16* WriteTriangle(u16* Iptr, u32 index1, u32 index2, u32 index3);
+  template <typename T, bool pr>
+  static T* WriteTriangle(T* Iptr, u32 index1, u32 index2, u32 index3);
 
-  static u16* index_buffer_current;
-  static u16* BASEIptr;
+  static u8* index_buffer_current;
+  static u8* BASEIptr;
+  static u32 index_size;
   static u32 base_index;
 };
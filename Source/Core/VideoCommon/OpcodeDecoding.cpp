@@ -24,7 +24,9 @@
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/DataReader.h"
+#include "VideoCommon/DisplayListCache.h"
 #include "VideoCommon/Fifo.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VideoCommon.h"
@@ -53,7 +55,10 @@ static u32 InterpretDisplayList(u32 address, u32 size)
     // temporarily swap dl and non-dl (small "hack" for the stats)
     Statistics::SwapDL();
 
-    Run(DataReader(startAddress, startAddress + size), &cycles, true);
+    if (DisplayListCache::IsEnabled())
+      cycles = DisplayListCache::Interpret(address, startAddress, size);
+    else
+      Run(DataReader(startAddress, startAddress + size), &cycles, true);
     INCSTAT(stats.thisFrame.numDListsCalled);
 
     // un-swap
@@ -83,6 +88,8 @@ void Init()
 template <bool is_preprocess>
 u8* Run(DataReader src, u32* cycles, bool in_display_list)
 {
+  StageTimings::ScopedTimer timer(is_preprocess ? StageTimings::Stage::OpcodePreprocess :
+                                                  StageTimings::Stage::OpcodeDecode);
   u32 totalCycles = 0;
   u8* opcodeStart;
   while (true)
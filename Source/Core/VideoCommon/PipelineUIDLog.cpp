@@ -0,0 +1,257 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/PipelineUIDLog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "Common/Logging/Log.h"
+
+namespace VideoCommon
+{
+namespace
+{
+constexpr u32 LOG_MAGIC = 0x474F4C50;  // PLOG
+constexpr u8 RECORD_PIPELINE = PipelineUIDLog::NUM_PARTS;
+constexpr size_t PIPELINE_RECORD_WORDS = PipelineUIDLog::NUM_PARTS + 3;
+
+bool WriteRecordHeader(File::IOFile& file, u8 type, size_t size)
+{
+  const u16 size16 = static_cast<u16>(size);
+  return file.WriteBytes(&type, sizeof(type)) && file.WriteBytes(&size16, sizeof(size16));
+}
+}  // Anonymous namespace
+
+bool PipelineUIDLog::Load(const std::string& filename, u32 version)
+{
+  Clear();
+
+  File::IOFile file(filename, "rb");
+  u32 magic;
+  u32 file_version;
+  if (!file.ReadBytes(&magic, sizeof(magic)) ||
+      !file.ReadBytes(&file_version, sizeof(file_version)) || magic != LOG_MAGIC ||
+      (version != 0 && file_version != version))
+  {
+    return false;
+  }
+  m_version = file_version;
+
+  // The index of each part in the file, which only differs from the one in the log if the file
+  // stores a part twice.
+  std::array<std::vector<u32>, NUM_PARTS> part_indices;
+  PartData data;
+  u8 type;
+  u16 size;
+  while (file.ReadBytes(&type, sizeof(type)) && file.ReadBytes(&size, sizeof(size)))
+  {
+    data.resize(size);
+    if (size != 0 && !file.ReadBytes(data.data(), size))
+      break;
+
+    if (type < NUM_PARTS)
+    {
+      PartTable& table = m_parts[type];
+      auto iter = table.indices.emplace(data, static_cast<u32>(table.data.size())).first;
+      if (iter->second == table.data.size())
+        table.data.push_back(data);
+      part_indices[type].push_back(iter->second);
+      continue;
+    }
+
+    if (type != RECORD_PIPELINE || size != PIPELINE_RECORD_WORDS * sizeof(u32))
+      break;
+
+    std::array<u32, PIPELINE_RECORD_WORDS> words;
+    std::memcpy(words.data(), data.data(), size);
+    Pipeline pipeline;
+    bool valid = true;
+    for (size_t i = 0; i < NUM_PARTS; i++)
+    {
+      valid &= words[i] < part_indices[i].size();
+      pipeline.parts[i] = valid ? part_indices[i][words[i]] : 0;
+    }
+    if (!valid)
+      break;
+    pipeline.rasterization_state_bits = words[NUM_PARTS];
+    pipeline.depth_state_bits = words[NUM_PARTS + 1];
+    pipeline.blending_state_bits = words[NUM_PARTS + 2];
+    if (m_pipeline_set.insert(pipeline).second)
+      m_pipelines.push_back(pipeline);
+  }
+
+  return true;
+}
+
+bool PipelineUIDLog::Open(const std::string& filename, u32 version)
+{
+  Close();
+
+  // Hold on to what is already in the log, to add it to the file's contents below, unless it was
+  // loaded from a log for another version.
+  PipelineUIDLog pending;
+  if (m_version == 0 || m_version == version)
+  {
+    pending.m_parts = std::move(m_parts);
+    pending.m_pipelines = std::move(m_pipelines);
+    pending.m_pipeline_set = std::move(m_pipeline_set);
+  }
+  Clear();
+
+  // As the file is only appended to, rewriting it with the loaded contents both drops any
+  // trailing garbage and keeps it compact.
+  const bool loaded = Load(filename, version);
+  m_version = version;
+  if (!loaded)
+    WARN_LOG(VIDEO, "Recreating pipeline UID log %s", filename.c_str());
+  if (!Save(filename) || !m_file.Open(filename, "ab"))
+  {
+    WARN_LOG(VIDEO, "Failed to open pipeline UID log %s", filename.c_str());
+    m_file.Close();
+  }
+
+  Merge(pending);
+  return loaded;
+}
+
+void PipelineUIDLog::Close()
+{
+  m_file.Close();
+}
+
+bool PipelineUIDLog::Save(const std::string& filename) const
+{
+  File::IOFile file(filename, "wb");
+  if (!WriteHeader(file))
+    return false;
+
+  for (size_t part = 0; part < NUM_PARTS; part++)
+  {
+    for (const PartData& data : m_parts[part].data)
+    {
+      if (!WritePart(file, static_cast<Part>(part), data))
+        return false;
+    }
+  }
+
+  for (const Pipeline& pipeline : m_pipelines)
+  {
+    if (!WritePipeline(file, pipeline))
+      return false;
+  }
+
+  return true;
+}
+
+bool PipelineUIDLog::AddPipeline(const std::array<PartData, NUM_PARTS>& parts,
+                                 u32 rasterization_state_bits, u32 depth_state_bits,
+                                 u32 blending_state_bits)
+{
+  Pipeline pipeline;
+  std::array<bool, NUM_PARTS> new_part = {};
+  for (size_t i = 0; i < NUM_PARTS; i++)
+  {
+    if (parts[i].size() > std::numeric_limits<u16>::max())
+    {
+      ERROR_LOG(VIDEO, "Pipeline UID part %zu is too large for the log", i);
+      return false;
+    }
+
+    const PartTable& table = m_parts[i];
+    auto iter = table.indices.find(parts[i]);
+    new_part[i] = iter == table.indices.end();
+    pipeline.parts[i] = new_part[i] ? static_cast<u32>(table.data.size()) : iter->second;
+  }
+  pipeline.rasterization_state_bits = rasterization_state_bits;
+  pipeline.depth_state_bits = depth_state_bits;
+  pipeline.blending_state_bits = blending_state_bits;
+
+  if (!m_pipeline_set.insert(pipeline).second)
+    return false;
+  m_pipelines.push_back(pipeline);
+
+  for (size_t i = 0; i < NUM_PARTS; i++)
+  {
+    if (!new_part[i])
+      continue;
+
+    m_parts[i].data.push_back(parts[i]);
+    m_parts[i].indices.emplace(parts[i], pipeline.parts[i]);
+    if (m_file.IsOpen() && !WritePart(m_file, static_cast<Part>(i), parts[i]))
+      WriteFailed();
+  }
+
+  if (m_file.IsOpen())
+  {
+    if (WritePipeline(m_file, pipeline))
+      m_file.Flush();
+    else
+      WriteFailed();
+  }
+
+  return true;
+}
+
+size_t PipelineUIDLog::Merge(const PipelineUIDLog& other)
+{
+  size_t added = 0;
+  std::array<PartData, NUM_PARTS> parts;
+  for (const Pipeline& pipeline : other.m_pipelines)
+  {
+    for (size_t i = 0; i < NUM_PARTS; i++)
+      parts[i] = other.m_parts[i].data[pipeline.parts[i]];
+
+    if (AddPipeline(parts, pipeline.rasterization_state_bits, pipeline.depth_state_bits,
+                    pipeline.blending_state_bits))
+    {
+      added++;
+    }
+  }
+  return added;
+}
+
+void PipelineUIDLog::Clear()
+{
+  m_version = 0;
+  for (PartTable& table : m_parts)
+  {
+    table.data.clear();
+    table.indices.clear();
+  }
+  m_pipelines.clear();
+  m_pipeline_set.clear();
+}
+
+bool PipelineUIDLog::WriteHeader(File::IOFile& file) const
+{
+  return file.WriteBytes(&LOG_MAGIC, sizeof(LOG_MAGIC)) &&
+         file.WriteBytes(&m_version, sizeof(m_version));
+}
+
+bool PipelineUIDLog::WritePart(File::IOFile& file, Part part, const PartData& data) const
+{
+  return WriteRecordHeader(file, part, data.size()) &&
+         (data.empty() || file.WriteBytes(data.data(), data.size()));
+}
+
+bool PipelineUIDLog::WritePipeline(File::IOFile& file, const Pipeline& pipeline) const
+{
+  std::array<u32, PIPELINE_RECORD_WORDS> words;
+  std::copy(pipeline.parts.begin(), pipeline.parts.end(), words.begin());
+  words[NUM_PARTS] = pipeline.rasterization_state_bits;
+  words[NUM_PARTS + 1] = pipeline.depth_state_bits;
+  words[NUM_PARTS + 2] = pipeline.blending_state_bits;
+  return WriteRecordHeader(file, RECORD_PIPELINE, sizeof(words)) &&
+         file.WriteBytes(words.data(), sizeof(words));
+}
+
+void PipelineUIDLog::WriteFailed()
+{
+  WARN_LOG(VIDEO, "Writing to the pipeline UID log failed, closing it.");
+  m_file.Close();
+}
+}  // namespace VideoCommon
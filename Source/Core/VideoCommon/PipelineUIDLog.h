@@ -0,0 +1,104 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+
+namespace VideoCommon
+{
+// A log of the pipelines a game has used, so that they can be compiled before they are needed.
+//
+// Pipelines share most of their vertex formats and shaders, so each of those parts is only stored
+// once, when it is first used, and a pipeline is stored as the indices of its parts along with its
+// render state. The file is a header followed by records, each a u8 type, a u16 size and the
+// data. Records are only ever appended, so a crash loses at most the last one.
+//
+// The log knows nothing about the parts besides their bytes, which allows merging logs without
+// the rest of VideoCommon.
+class PipelineUIDLog
+{
+public:
+  enum Part : u8
+  {
+    PART_VERTEX_FORMAT,
+    PART_VERTEX_SHADER,
+    PART_GEOMETRY_SHADER,
+    PART_PIXEL_SHADER,
+    NUM_PARTS
+  };
+
+  using PartData = std::vector<u8>;
+
+  struct Pipeline
+  {
+    std::array<u32, NUM_PARTS> parts;
+    u32 rasterization_state_bits;
+    u32 depth_state_bits;
+    u32 blending_state_bits;
+
+    bool operator<(const Pipeline& other) const
+    {
+      return std::tie(parts, rasterization_state_bits, depth_state_bits, blending_state_bits) <
+             std::tie(other.parts, other.rasterization_state_bits, other.depth_state_bits,
+                      other.blending_state_bits);
+    }
+  };
+
+  // Reads the log from filename. Returns false, leaving the log empty, if the file doesn't exist,
+  // isn't a pipeline log, or is for a different UID version (if version isn't zero). Trailing
+  // data that can't be read, e.g. after a crash, is ignored.
+  bool Load(const std::string& filename, u32 version = 0);
+
+  // Loads the log and keeps the file open, so that pipelines added later are written to it. If
+  // the file can't be loaded, it is recreated with the pipelines that are already in the log,
+  // unless those were loaded for a different version.
+  bool Open(const std::string& filename, u32 version);
+  void Close();
+  bool IsOpen() const { return m_file.IsOpen(); }
+
+  // Writes the whole log to filename, replacing it.
+  bool Save(const std::string& filename) const;
+
+  // Adds a pipeline with the given parts, unless it is already in the log. Returns whether it was
+  // added.
+  bool AddPipeline(const std::array<PartData, NUM_PARTS>& parts, u32 rasterization_state_bits,
+                   u32 depth_state_bits, u32 blending_state_bits);
+
+  // Adds all the pipelines of another log. Returns the number of pipelines that were new.
+  size_t Merge(const PipelineUIDLog& other);
+
+  u32 GetVersion() const { return m_version; }
+  const std::vector<Pipeline>& GetPipelines() const { return m_pipelines; }
+  const PartData& GetPartData(Part part, u32 index) const { return m_parts[part].data[index]; }
+  size_t GetPartCount(Part part) const { return m_parts[part].data.size(); }
+
+private:
+  struct PartTable
+  {
+    std::vector<PartData> data;
+    std::map<PartData, u32> indices;
+  };
+
+  void Clear();
+  bool WriteHeader(File::IOFile& file) const;
+  bool WritePart(File::IOFile& file, Part part, const PartData& data) const;
+  bool WritePipeline(File::IOFile& file, const Pipeline& pipeline) const;
+  void WriteFailed();
+
+  u32 m_version = 0;
+  std::array<PartTable, NUM_PARTS> m_parts;
+  std::vector<Pipeline> m_pipelines;
+  std::set<Pipeline> m_pipeline_set;
+  File::IOFile m_file;
+};
+}  // namespace VideoCommon
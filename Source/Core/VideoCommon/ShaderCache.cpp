@@ -7,10 +7,12 @@
 #include "Common/Assert.h"
 #include "Common/FileUtil.h"
 #include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/Host.h"
 
 #include "VideoCommon/FramebufferManagerBase.h"
+#include "VideoCommon/OnScreenDisplay.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderManager.h"
@@ -20,6 +22,28 @@ std::unique_ptr<VideoCommon::ShaderCache> g_shader_cache;
 
 namespace VideoCommon
 {
+namespace
+{
+// Shader UIDs are logged without their unused trailing bytes, which for pixel shaders is most of
+// the UID.
+template <typename UidData>
+PipelineUIDLog::PartData GetUIDLogPart(const ShaderUid<UidData>& uid)
+{
+  const u8* data = uid.GetUidDataRaw();
+  return PipelineUIDLog::PartData(data, data + uid.GetUidData()->NumValues());
+}
+
+template <typename UidData>
+bool ReadUIDLogPart(ShaderUid<UidData>* uid, const PipelineUIDLog::PartData& data)
+{
+  if (data.size() > uid->GetUidDataSize())
+    return false;
+
+  std::memcpy(uid->template GetUidData<UidData>(), data.data(), data.size());
+  return uid->GetUidData()->NumValues() == data.size();
+}
+}  // Anonymous namespace
+
 ShaderCache::ShaderCache() = default;
 ShaderCache::~ShaderCache() = default;
 
@@ -67,13 +91,18 @@ void ShaderCache::SetHostConfig(const ShaderHostConfig& host_config, u32 efb_mul
 
 void ShaderCache::Reload()
 {
+  // Anything that hasn't started compiling would be built for the old host config.
+  m_async_shader_compiler->CancelPendingWork();
   WaitForAsyncCompiler();
   ClosePipelineUIDCache();
   InvalidateCachedPipelines();
   ClearShaderCaches();
 
   if (g_ActiveConfig.bShaderCache)
+  {
     LoadShaderCaches();
+    LoadPipelineUIDCache();
+  }
 
   // Switch to the precompiling shader configuration while we rebuild.
   m_async_shader_compiler->ResizeWorkerThreads(g_ActiveConfig.GetShaderPrecompilerThreads());
@@ -90,6 +119,22 @@ void ShaderCache::Reload()
 void ShaderCache::RetrieveAsyncShaders()
 {
   m_async_shader_compiler->RetrieveWorkItems();
+  UpdatePrecompileProgress();
+
+  const AsyncShaderCompiler::Statistics compiler_stats = m_async_shader_compiler->GetStatistics();
+  SETSTAT(stats.numShaderCompilesQueued, compiler_stats.queued_items);
+  SETSTAT(stats.numShaderCompilesBlocked, compiler_stats.blocked_items);
+  SETSTAT(stats.numShaderCompilesDone, compiler_stats.compiled_items);
+  SETSTAT(stats.numShaderCompilesStolen, compiler_stats.stolen_items);
+  SETSTAT(stats.numShaderCompilesCancelled, compiler_stats.cancelled_items);
+  if (compiler_stats.compiled_items != 0)
+  {
+    SETSTAT_FT(stats.shaderCompileWaitMs, compiler_stats.total_wait_time_us / 1000.0f /
+                                              compiler_stats.compiled_items);
+    SETSTAT_FT(stats.shaderCompileTimeMs, compiler_stats.total_compile_time_us / 1000.0f /
+                                              compiler_stats.compiled_items);
+    SETSTAT_FT(stats.shaderCompileMaxTimeMs, compiler_stats.max_compile_time_us / 1000.0f);
+  }
 }
 
 void ShaderCache::Shutdown()
@@ -158,6 +203,10 @@ void ShaderCache::WaitForAsyncCompiler()
     });
     m_async_shader_compiler->RetrieveWorkItems();
   }
+
+  // Everything has been compiled behind the progress dialog, so there is nothing left to report.
+  m_precompile_total = 0;
+  m_precompile_completed = 0;
   Host_UpdateProgressDialog("", -1, -1);
 }
 
@@ -248,10 +297,15 @@ void ShaderCache::ClearShaderCaches()
 void ShaderCache::CompileMissingPipelines()
 {
   // Queue all uids with a null pipeline for compilation.
+  m_precompile_total = 0;
+  m_precompile_completed = 0;
   for (auto& it : m_gx_pipeline_cache)
   {
     if (!it.second.second)
+    {
       QueuePipelineCompile(it.first, COMPILE_PRIORITY_SHADERCACHE_PIPELINE);
+      m_precompile_total++;
+    }
   }
   for (auto& it : m_gx_uber_pipeline_cache)
   {
@@ -551,127 +605,152 @@ ShaderCache::InsertGXUberPipeline(const GXUberPipelineUid& config,
 
 void ShaderCache::LoadPipelineUIDCache()
 {
-  constexpr u32 CACHE_FILE_MAGIC = 0x44495550;  // PUID
-  constexpr size_t CACHE_HEADER_SIZE = sizeof(u32) + sizeof(u32);
-  std::string filename =
-      File::GetUserPath(D_CACHE_IDX) + SConfig::GetInstance().GetGameID() + ".uidcache";
-  if (m_gx_pipeline_uid_cache_file.Open(filename, "rb+"))
+  const std::string path = File::GetUserPath(D_CACHE_IDX) + SConfig::GetInstance().GetGameID();
+  const std::string filename = path + ".uidlog";
+
+  // Older versions wrote fixed-size UIDs to a .uidcache file. It is left alone for them, and its
+  // UIDs are written to the log below when the game doesn't have one yet.
+  if (!File::Exists(filename))
+    ImportSerializedGXPipelineUIDs(path + ".uidcache");
+
+  // Any pipelines that were used before the log was opened, e.g. when reloading after changing
+  // the host config, are added to it.
+  m_gx_pipeline_uid_log.Open(filename, GX_PIPELINE_UID_VERSION);
+  for (const PipelineUIDLog::Pipeline& pipeline : m_gx_pipeline_uid_log.GetPipelines())
   {
-    // If an existing case exists, validate the version before reading entries.
-    u32 existing_magic;
-    u32 existing_version;
-    bool uid_file_valid = false;
-    if (m_gx_pipeline_uid_cache_file.ReadBytes(&existing_magic, sizeof(existing_magic)) &&
-        m_gx_pipeline_uid_cache_file.ReadBytes(&existing_version, sizeof(existing_version)) &&
-        existing_magic == CACHE_FILE_MAGIC && existing_version == GX_PIPELINE_UID_VERSION)
-    {
-      // Ensure the expected size matches the actual size of the file. If it doesn't, it means
-      // the cache file may be corrupted, and we should not proceed with loading potentially
-      // garbage or invalid UIDs.
-      const u64 file_size = m_gx_pipeline_uid_cache_file.GetSize();
-      const size_t uid_count =
-          static_cast<size_t>(file_size - CACHE_HEADER_SIZE) / sizeof(SerializedGXPipelineUid);
-      const size_t expected_size = uid_count * sizeof(SerializedGXPipelineUid) + CACHE_HEADER_SIZE;
-      uid_file_valid = file_size == expected_size;
-      if (uid_file_valid)
-      {
-        for (size_t i = 0; i < uid_count; i++)
-        {
-          SerializedGXPipelineUid serialized_uid;
-          if (m_gx_pipeline_uid_cache_file.ReadBytes(&serialized_uid, sizeof(serialized_uid)))
-          {
-            // This just adds the pipeline to the map, it is compiled later.
-            AddSerializedGXPipelineUID(serialized_uid);
-          }
-          else
-          {
-            uid_file_valid = false;
-            break;
-          }
-        }
-      }
+    // This just adds the pipeline to the map, it is compiled later.
+    AddLoggedGXPipelineUID(m_gx_pipeline_uid_log, pipeline);
+  }
+  for (const auto& it : m_gx_pipeline_cache)
+    AppendGXPipelineUID(it.first);
 
-      // We open the file for reading and writing, so we must seek to the end before writing.
-      if (uid_file_valid)
-        uid_file_valid = m_gx_pipeline_uid_cache_file.Seek(expected_size, SEEK_SET);
-    }
+  INFO_LOG(VIDEO, "Read %zu pipeline UIDs from %s", m_gx_pipeline_uid_log.GetPipelines().size(),
+           filename.c_str());
+}
+
+void ShaderCache::ClosePipelineUIDCache()
+{
+  // This is left as a method in case we need to append extra data to the file in the future.
+  m_gx_pipeline_uid_log.Close();
+}
 
-    // If the file is invalid, close it. We re-open and truncate it below.
-    if (!uid_file_valid)
-      m_gx_pipeline_uid_cache_file.Close();
+void ShaderCache::ImportSerializedGXPipelineUIDs(const std::string& filename)
+{
+  constexpr u32 CACHE_FILE_MAGIC = 0x44495550;  // PUID
+  File::IOFile file(filename, "rb");
+  u32 magic;
+  u32 version;
+  if (!file.ReadBytes(&magic, sizeof(magic)) || !file.ReadBytes(&version, sizeof(version)) ||
+      magic != CACHE_FILE_MAGIC || version != GX_PIPELINE_UID_VERSION)
+  {
+    return;
   }
 
-  // If the file is not open, it means it was either corrupted or didn't exist.
-  if (!m_gx_pipeline_uid_cache_file.IsOpen())
+  // A partially written UID at the end of the file is ignored.
+  size_t count = 0;
+  SerializedGXPipelineUid uid;
+  while (file.ReadBytes(&uid, sizeof(uid)))
   {
-    if (m_gx_pipeline_uid_cache_file.Open(filename, "wb"))
-    {
-      // Write the version identifier.
-      m_gx_pipeline_uid_cache_file.WriteBytes(&CACHE_FILE_MAGIC, sizeof(GX_PIPELINE_UID_VERSION));
-      m_gx_pipeline_uid_cache_file.WriteBytes(&GX_PIPELINE_UID_VERSION,
-                                              sizeof(GX_PIPELINE_UID_VERSION));
-
-      // Write any current UIDs out to the file.
-      // This way, if we load a UID cache where the data was incomplete (e.g. Dolphin crashed),
-      // we don't lose the existing UIDs which were previously at the beginning.
-      for (const auto& it : m_gx_pipeline_cache)
-        AppendGXPipelineUID(it.first);
-    }
+    GXPipelineUid real_uid = {};
+    real_uid.vertex_format = VertexLoaderManager::GetOrCreateMatchingFormat(uid.vertex_decl);
+    real_uid.vs_uid = uid.vs_uid;
+    real_uid.gs_uid = uid.gs_uid;
+    real_uid.ps_uid = uid.ps_uid;
+    real_uid.rasterization_state.hex = uid.rasterization_state_bits;
+    real_uid.depth_state.hex = uid.depth_state_bits;
+    real_uid.blending_state.hex = uid.blending_state_bits;
+    AddGXPipelineUIDForCompile(real_uid);
+    count++;
   }
 
-  INFO_LOG(VIDEO, "Read %u pipeline UIDs from %s",
-           static_cast<unsigned>(m_gx_pipeline_cache.size()), filename.c_str());
+  INFO_LOG(VIDEO, "Imported %zu pipeline UIDs from %s", count, filename.c_str());
 }
 
-void ShaderCache::ClosePipelineUIDCache()
+void ShaderCache::AddLoggedGXPipelineUID(const PipelineUIDLog& log,
+                                         const PipelineUIDLog::Pipeline& pipeline)
 {
-  // This is left as a method in case we need to append extra data to the file in the future.
-  m_gx_pipeline_uid_cache_file.Close();
+  const PipelineUIDLog::PartData& vertex_decl =
+      log.GetPartData(PipelineUIDLog::PART_VERTEX_FORMAT,
+                      pipeline.parts[PipelineUIDLog::PART_VERTEX_FORMAT]);
+  if (vertex_decl.size() != sizeof(PortableVertexDeclaration))
+    return;
+
+  GXPipelineUid real_uid = {};
+  PortableVertexDeclaration decl;
+  std::memcpy(&decl, vertex_decl.data(), sizeof(decl));
+  if (!ReadUIDLogPart(&real_uid.vs_uid,
+                      log.GetPartData(PipelineUIDLog::PART_VERTEX_SHADER,
+                                      pipeline.parts[PipelineUIDLog::PART_VERTEX_SHADER])) ||
+      !ReadUIDLogPart(&real_uid.gs_uid,
+                      log.GetPartData(PipelineUIDLog::PART_GEOMETRY_SHADER,
+                                      pipeline.parts[PipelineUIDLog::PART_GEOMETRY_SHADER])) ||
+      !ReadUIDLogPart(&real_uid.ps_uid,
+                      log.GetPartData(PipelineUIDLog::PART_PIXEL_SHADER,
+                                      pipeline.parts[PipelineUIDLog::PART_PIXEL_SHADER])))
+  {
+    return;
+  }
+  real_uid.vertex_format = VertexLoaderManager::GetOrCreateMatchingFormat(decl);
+  real_uid.rasterization_state.hex = pipeline.rasterization_state_bits;
+  real_uid.depth_state.hex = pipeline.depth_state_bits;
+  real_uid.blending_state.hex = pipeline.blending_state_bits;
+  AddGXPipelineUIDForCompile(real_uid);
 }
 
-void ShaderCache::AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid)
+void ShaderCache::AddGXPipelineUIDForCompile(const GXPipelineUid& uid)
 {
-  GXPipelineUid real_uid = {};
-  real_uid.vertex_format = VertexLoaderManager::GetOrCreateMatchingFormat(uid.vertex_decl);
-  real_uid.vs_uid = uid.vs_uid;
-  real_uid.gs_uid = uid.gs_uid;
-  real_uid.ps_uid = uid.ps_uid;
-  real_uid.rasterization_state.hex = uid.rasterization_state_bits;
-  real_uid.depth_state.hex = uid.depth_state_bits;
-  real_uid.blending_state.hex = uid.blending_state_bits;
-
-  auto iter = m_gx_pipeline_cache.find(real_uid);
+  auto iter = m_gx_pipeline_cache.find(uid);
   if (iter != m_gx_pipeline_cache.end())
     return;
 
   // Flag it as empty with a null pipeline object, for later compilation.
-  auto& entry = m_gx_pipeline_cache[real_uid];
+  auto& entry = m_gx_pipeline_cache[uid];
   entry.second = false;
 }
 
 void ShaderCache::AppendGXPipelineUID(const GXPipelineUid& config)
 {
-  if (!m_gx_pipeline_uid_cache_file.IsOpen())
+  if (!m_gx_pipeline_uid_log.IsOpen())
+    return;
+
+  // Convert to disk format. Vertex declarations are compared with memcmp() when looking up
+  // formats, so their padding bytes are already zero.
+  const u8* vertex_decl_data =
+      reinterpret_cast<const u8*>(&config.vertex_format->GetVertexDeclaration());
+
+  std::array<PipelineUIDLog::PartData, PipelineUIDLog::NUM_PARTS> parts;
+  parts[PipelineUIDLog::PART_VERTEX_FORMAT].assign(
+      vertex_decl_data, vertex_decl_data + sizeof(PortableVertexDeclaration));
+  parts[PipelineUIDLog::PART_VERTEX_SHADER] = GetUIDLogPart(config.vs_uid);
+  parts[PipelineUIDLog::PART_GEOMETRY_SHADER] = GetUIDLogPart(config.gs_uid);
+  parts[PipelineUIDLog::PART_PIXEL_SHADER] = GetUIDLogPart(config.ps_uid);
+  m_gx_pipeline_uid_log.AddPipeline(parts, config.rasterization_state.hex,
+                                    config.depth_state.hex, config.blending_state.hex);
+}
+
+void ShaderCache::UpdatePrecompileProgress()
+{
+  if (m_precompile_total == 0)
     return;
 
-  // Convert to disk format. Ensure all padding bytes are zero.
-  SerializedGXPipelineUid disk_uid;
-  std::memset(&disk_uid, 0, sizeof(disk_uid));
-  disk_uid.vertex_decl = config.vertex_format->GetVertexDeclaration();
-  disk_uid.vs_uid = config.vs_uid;
-  disk_uid.gs_uid = config.gs_uid;
-  disk_uid.ps_uid = config.ps_uid;
-  disk_uid.rasterization_state_bits = config.rasterization_state.hex;
-  disk_uid.depth_state_bits = config.depth_state.hex;
-  disk_uid.blending_state_bits = config.blending_state.hex;
-  if (!m_gx_pipeline_uid_cache_file.WriteBytes(&disk_uid, sizeof(disk_uid)))
+  if (m_precompile_completed < m_precompile_total)
   {
-    WARN_LOG(VIDEO, "Writing pipeline UID to cache failed, closing file.");
-    m_gx_pipeline_uid_cache_file.Close();
+    OSD::AddTypedMessage(OSD::MessageType::ShaderCompilation,
+                         StringFromFormat("Compiling shaders: %zu/%zu", m_precompile_completed,
+                                          m_precompile_total),
+                         OSD::Duration::SHORT, OSD::Color::CYAN);
+    return;
   }
+
+  OSD::AddTypedMessage(OSD::MessageType::ShaderCompilation,
+                       StringFromFormat("Compiled %zu shaders", m_precompile_total),
+                       OSD::Duration::SHORT, OSD::Color::CYAN);
+  m_precompile_total = 0;
+  m_precompile_completed = 0;
 }
 
-void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority)
+AsyncShaderCompiler::WorkItemID
+ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority)
 {
   class VertexShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -684,23 +763,29 @@ void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 prior
     bool Compile() override
     {
       shader = shader_cache->CompileVertexShader(uid);
-      return true;
+      failed = !shader;
+      return !failed;
     }
 
     void Retrieve() override { shader_cache->InsertVertexShader(uid, std::move(shader)); }
+    void Cancel() override { shader_cache->m_vs_cache.CancelPending(uid, failed); }
 
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
+    bool failed = false;
     VertexShaderUid uid;
   };
 
-  m_vs_cache.shader_map[uid].pending = true;
   auto wi = m_async_shader_compiler->CreateWorkItem<VertexShaderWorkItem>(this, uid);
-  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  auto& entry = m_vs_cache.shader_map[uid];
+  entry.pending = true;
+  entry.work_item = m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  return entry.work_item;
 }
 
-void ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid, u32 priority)
+AsyncShaderCompiler::WorkItemID
+ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid, u32 priority)
 {
   class VertexUberShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -713,23 +798,29 @@ void ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid
     bool Compile() override
     {
       shader = shader_cache->CompileVertexUberShader(uid);
-      return true;
+      failed = !shader;
+      return !failed;
     }
 
     void Retrieve() override { shader_cache->InsertVertexUberShader(uid, std::move(shader)); }
+    void Cancel() override { shader_cache->m_uber_vs_cache.CancelPending(uid, failed); }
 
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
+    bool failed = false;
     UberShader::VertexShaderUid uid;
   };
 
-  m_uber_vs_cache.shader_map[uid].pending = true;
   auto wi = m_async_shader_compiler->CreateWorkItem<VertexUberShaderWorkItem>(this, uid);
-  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  auto& entry = m_uber_vs_cache.shader_map[uid];
+  entry.pending = true;
+  entry.work_item = m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  return entry.work_item;
 }
 
-void ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priority)
+AsyncShaderCompiler::WorkItemID
+ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priority)
 {
   class PixelShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -742,23 +833,29 @@ void ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priorit
     bool Compile() override
     {
       shader = shader_cache->CompilePixelShader(uid);
-      return true;
+      failed = !shader;
+      return !failed;
     }
 
     void Retrieve() override { shader_cache->InsertPixelShader(uid, std::move(shader)); }
+    void Cancel() override { shader_cache->m_ps_cache.CancelPending(uid, failed); }
 
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
+    bool failed = false;
     PixelShaderUid uid;
   };
 
-  m_ps_cache.shader_map[uid].pending = true;
   auto wi = m_async_shader_compiler->CreateWorkItem<PixelShaderWorkItem>(this, uid);
-  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  auto& entry = m_ps_cache.shader_map[uid];
+  entry.pending = true;
+  entry.work_item = m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  return entry.work_item;
 }
 
-void ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid, u32 priority)
+AsyncShaderCompiler::WorkItemID
+ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid, u32 priority)
 {
   class PixelUberShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -771,20 +868,25 @@ void ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid&
     bool Compile() override
     {
       shader = shader_cache->CompilePixelUberShader(uid);
-      return true;
+      failed = !shader;
+      return !failed;
     }
 
     void Retrieve() override { shader_cache->InsertPixelUberShader(uid, std::move(shader)); }
+    void Cancel() override { shader_cache->m_uber_ps_cache.CancelPending(uid, failed); }
 
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
+    bool failed = false;
     UberShader::PixelShaderUid uid;
   };
 
-  m_uber_ps_cache.shader_map[uid].pending = true;
   auto wi = m_async_shader_compiler->CreateWorkItem<PixelUberShaderWorkItem>(this, uid);
-  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  auto& entry = m_uber_ps_cache.shader_map[uid];
+  entry.pending = true;
+  entry.work_item = m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  return entry.work_item;
 }
 
 void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
@@ -795,31 +897,10 @@ void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
     PipelineWorkItem(ShaderCache* shader_cache_, const GXPipelineUid& uid_, u32 priority_)
         : shader_cache(shader_cache_), uid(uid_), priority(priority_)
     {
-      // Check if all the stages required for this pipeline have been compiled.
-      // If not, this work item becomes a no-op, and re-queues the pipeline for the next frame.
-      if (SetStagesReady())
-        config = shader_cache->GetGXPipelineConfig(uid);
     }
 
-    bool SetStagesReady()
-    {
-      stages_ready = true;
-
-      auto vs_it = shader_cache->m_vs_cache.shader_map.find(uid.vs_uid);
-      stages_ready &= vs_it != shader_cache->m_vs_cache.shader_map.end() && !vs_it->second.pending;
-      if (vs_it == shader_cache->m_vs_cache.shader_map.end())
-        shader_cache->QueueVertexShaderCompile(uid.vs_uid, priority);
-
-      PixelShaderUid ps_uid = uid.ps_uid;
-      ClearUnusedPixelShaderUidBits(shader_cache->m_api_type, shader_cache->m_host_config, &ps_uid);
-
-      auto ps_it = shader_cache->m_ps_cache.shader_map.find(ps_uid);
-      stages_ready &= ps_it != shader_cache->m_ps_cache.shader_map.end() && !ps_it->second.pending;
-      if (ps_it == shader_cache->m_ps_cache.shader_map.end())
-        shader_cache->QueuePixelShaderCompile(ps_uid, priority);
-
-      return stages_ready;
-    }
+    // The stages are in the cache once the work items they depend on have been retrieved.
+    void Prepare() override { config = shader_cache->GetGXPipelineConfig(uid); }
 
     bool Compile() override
     {
@@ -830,17 +911,19 @@ void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
 
     void Retrieve() override
     {
-      if (stages_ready)
-      {
-        shader_cache->InsertGXPipeline(uid, std::move(pipeline));
-      }
-      else
-      {
-        // Re-queue for next frame.
-        auto wi = shader_cache->m_async_shader_compiler->CreateWorkItem<PipelineWorkItem>(
-            shader_cache, uid, priority);
-        shader_cache->m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
-      }
+      shader_cache->InsertGXPipeline(uid, std::move(pipeline));
+      if (priority == COMPILE_PRIORITY_SHADERCACHE_PIPELINE)
+        shader_cache->m_precompile_completed++;
+    }
+
+    void Cancel() override
+    {
+      // Keep the UID around with a null pipeline, so that it is compiled again when needed.
+      auto iter = shader_cache->m_gx_pipeline_cache.find(uid);
+      if (iter != shader_cache->m_gx_pipeline_cache.end())
+        iter->second.second = false;
+      if (priority == COMPILE_PRIORITY_SHADERCACHE_PIPELINE)
+        shader_cache->m_precompile_completed++;
     }
 
   private:
@@ -849,12 +932,26 @@ void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
     GXPipelineUid uid;
     u32 priority;
     std::optional<AbstractPipelineConfig> config;
-    bool stages_ready;
   };
 
+  std::vector<AsyncShaderCompiler::WorkItemID> dependencies;
+  auto vs_it = m_vs_cache.shader_map.find(uid.vs_uid);
+  if (vs_it == m_vs_cache.shader_map.end())
+    dependencies.push_back(QueueVertexShaderCompile(uid.vs_uid, priority));
+  else if (vs_it->second.pending)
+    dependencies.push_back(vs_it->second.work_item);
+
+  PixelShaderUid ps_uid = uid.ps_uid;
+  ClearUnusedPixelShaderUidBits(m_api_type, m_host_config, &ps_uid);
+  auto ps_it = m_ps_cache.shader_map.find(ps_uid);
+  if (ps_it == m_ps_cache.shader_map.end())
+    dependencies.push_back(QueuePixelShaderCompile(ps_uid, priority));
+  else if (ps_it->second.pending)
+    dependencies.push_back(ps_it->second.work_item);
+
   auto wi = m_async_shader_compiler->CreateWorkItem<PipelineWorkItem>(this, uid, priority);
-  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
   m_gx_pipeline_cache[uid].second = true;
+  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority, dependencies);
 }
 
 void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 priority)
@@ -862,37 +959,13 @@ void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 pri
   class UberPipelineWorkItem final : public AsyncShaderCompiler::WorkItem
   {
   public:
-    UberPipelineWorkItem(ShaderCache* shader_cache_, const GXUberPipelineUid& uid_, u32 priority_)
-        : shader_cache(shader_cache_), uid(uid_), priority(priority_)
+    UberPipelineWorkItem(ShaderCache* shader_cache_, const GXUberPipelineUid& uid_)
+        : shader_cache(shader_cache_), uid(uid_)
     {
-      // Check if all the stages required for this UberPipeline have been compiled.
-      // If not, this work item becomes a no-op, and re-queues the UberPipeline for the next frame.
-      if (SetStagesReady())
-        config = shader_cache->GetGXUberPipelineConfig(uid);
     }
 
-    bool SetStagesReady()
-    {
-      stages_ready = true;
-
-      auto vs_it = shader_cache->m_uber_vs_cache.shader_map.find(uid.vs_uid);
-      stages_ready &=
-          vs_it != shader_cache->m_uber_vs_cache.shader_map.end() && !vs_it->second.pending;
-      if (vs_it == shader_cache->m_uber_vs_cache.shader_map.end())
-        shader_cache->QueueVertexUberShaderCompile(uid.vs_uid, priority);
-
-      UberShader::PixelShaderUid ps_uid = uid.ps_uid;
-      UberShader::ClearUnusedPixelShaderUidBits(shader_cache->m_api_type,
-                                                shader_cache->m_host_config, &ps_uid);
-
-      auto ps_it = shader_cache->m_uber_ps_cache.shader_map.find(ps_uid);
-      stages_ready &=
-          ps_it != shader_cache->m_uber_ps_cache.shader_map.end() && !ps_it->second.pending;
-      if (ps_it == shader_cache->m_uber_ps_cache.shader_map.end())
-        shader_cache->QueuePixelUberShaderCompile(ps_uid, priority);
-
-      return stages_ready;
-    }
+    // The stages are in the cache once the work items they depend on have been retrieved.
+    void Prepare() override { config = shader_cache->GetGXUberPipelineConfig(uid); }
 
     bool Compile() override
     {
@@ -901,33 +974,41 @@ void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 pri
       return true;
     }
 
-    void Retrieve() override
+    void Retrieve() override { shader_cache->InsertGXUberPipeline(uid, std::move(UberPipeline)); }
+
+    void Cancel() override
     {
-      if (stages_ready)
-      {
-        shader_cache->InsertGXUberPipeline(uid, std::move(UberPipeline));
-      }
-      else
-      {
-        // Re-queue for next frame.
-        auto wi = shader_cache->m_async_shader_compiler->CreateWorkItem<UberPipelineWorkItem>(
-            shader_cache, uid, priority);
-        shader_cache->m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
-      }
+      // Keep the UID around with a null pipeline, so that it is compiled again when needed.
+      auto iter = shader_cache->m_gx_uber_pipeline_cache.find(uid);
+      if (iter != shader_cache->m_gx_uber_pipeline_cache.end())
+        iter->second.second = false;
     }
 
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractPipeline> UberPipeline;
     GXUberPipelineUid uid;
-    u32 priority;
     std::optional<AbstractPipelineConfig> config;
-    bool stages_ready;
   };
 
-  auto wi = m_async_shader_compiler->CreateWorkItem<UberPipelineWorkItem>(this, uid, priority);
-  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
+  std::vector<AsyncShaderCompiler::WorkItemID> dependencies;
+  auto vs_it = m_uber_vs_cache.shader_map.find(uid.vs_uid);
+  if (vs_it == m_uber_vs_cache.shader_map.end())
+    dependencies.push_back(QueueVertexUberShaderCompile(uid.vs_uid, priority));
+  else if (vs_it->second.pending)
+    dependencies.push_back(vs_it->second.work_item);
+
+  UberShader::PixelShaderUid ps_uid = uid.ps_uid;
+  UberShader::ClearUnusedPixelShaderUidBits(m_api_type, m_host_config, &ps_uid);
+  auto ps_it = m_uber_ps_cache.shader_map.find(ps_uid);
+  if (ps_it == m_uber_ps_cache.shader_map.end())
+    dependencies.push_back(QueuePixelUberShaderCompile(ps_uid, priority));
+  else if (ps_it->second.pending)
+    dependencies.push_back(ps_it->second.work_item);
+
+  auto wi = m_async_shader_compiler->CreateWorkItem<UberPipelineWorkItem>(this, uid);
   m_gx_uber_pipeline_cache[uid].second = true;
+  m_async_shader_compiler->QueueWorkItem(std::move(wi), priority, dependencies);
 }
 
 void ShaderCache::QueueUberShaderPipelines()
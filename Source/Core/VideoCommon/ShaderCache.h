@@ -15,7 +15,6 @@
 #include <utility>
 
 #include "Common/CommonTypes.h"
-#include "Common/File.h"
 #include "Common/LinearDiskCache.h"
 
 #include "VideoCommon/AbstractPipeline.h"
@@ -23,6 +22,7 @@
 #include "VideoCommon/AsyncShaderCompiler.h"
 #include "VideoCommon/GXPipelineTypes.h"
 #include "VideoCommon/GeometryShaderGen.h"
+#include "VideoCommon/PipelineUIDLog.h"
 #include "VideoCommon/PixelShaderGen.h"
 #include "VideoCommon/RenderState.h"
 #include "VideoCommon/UberShaderPixel.h"
@@ -105,14 +105,21 @@ private:
                                            std::unique_ptr<AbstractPipeline> pipeline);
   const AbstractPipeline* InsertGXUberPipeline(const GXUberPipelineUid& config,
                                                std::unique_ptr<AbstractPipeline> pipeline);
-  void AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid);
+  void ImportSerializedGXPipelineUIDs(const std::string& filename);
+  void AddLoggedGXPipelineUID(const PipelineUIDLog& log, const PipelineUIDLog::Pipeline& pipeline);
+  void AddGXPipelineUIDForCompile(const GXPipelineUid& uid);
   void AppendGXPipelineUID(const GXPipelineUid& config);
+  void UpdatePrecompileProgress();
 
   // ASync Compiler Methods
-  void QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority);
-  void QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid, u32 priority);
-  void QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priority);
-  void QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid, u32 priority);
+  AsyncShaderCompiler::WorkItemID QueueVertexShaderCompile(const VertexShaderUid& uid,
+                                                           u32 priority);
+  AsyncShaderCompiler::WorkItemID
+  QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid, u32 priority);
+  AsyncShaderCompiler::WorkItemID QueuePixelShaderCompile(const PixelShaderUid& uid,
+                                                          u32 priority);
+  AsyncShaderCompiler::WorkItemID
+  QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid, u32 priority);
   void QueuePipelineCompile(const GXPipelineUid& uid, u32 priority);
   void QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 priority);
 
@@ -142,9 +149,24 @@ private:
     {
       std::unique_ptr<AbstractShader> shader;
       bool pending;
+      AsyncShaderCompiler::WorkItemID work_item;  // Only valid while pending.
     };
     std::map<Uid, Shader> shader_map;
     LinearDiskCache<Uid, u8> disk_cache;
+
+    // Forgets a shader whose compile was cancelled, so that it is queued again when needed. A
+    // shader that failed to compile is kept as null instead, so that it isn't compiled again.
+    void CancelPending(const Uid& uid, bool failed)
+    {
+      auto iter = shader_map.find(uid);
+      if (iter == shader_map.end() || !iter->second.pending)
+        return;
+
+      if (failed)
+        iter->second.pending = false;
+      else
+        shader_map.erase(iter);
+    }
   };
   ShaderModuleCache<VertexShaderUid> m_vs_cache;
   ShaderModuleCache<GeometryShaderUid> m_gs_cache;
@@ -156,7 +178,11 @@ private:
   std::map<GXPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>> m_gx_pipeline_cache;
   std::map<GXUberPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>>
       m_gx_uber_pipeline_cache;
-  File::IOFile m_gx_pipeline_uid_cache_file;
+  PipelineUIDLog m_gx_pipeline_uid_log;
+
+  // Progress of compiling the pipelines from the UID log after the game has started.
+  size_t m_precompile_total = 0;
+  size_t m_precompile_completed = 0;
 };
 
 }  // namespace VideoCommon
@@ -0,0 +1,99 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/StageTimings.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "Common/CommonTypes.h"
+#include "Common/StringUtil.h"
+
+namespace StageTimings
+{
+static constexpr size_t NUM_STAGES = static_cast<size_t>(Stage::Count);
+
+static std::atomic<bool> s_enabled{false};
+static std::array<std::atomic<u64>, NUM_STAGES> s_total_ns;
+static std::array<std::atomic<u64>, NUM_STAGES> s_calls;
+
+// The innermost running timer of the current thread.
+static thread_local ScopedTimer* s_current_timer = nullptr;
+
+void SetEnabled(bool enabled)
+{
+  s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool IsEnabled()
+{
+  return s_enabled.load(std::memory_order_relaxed);
+}
+
+void Reset()
+{
+  for (size_t i = 0; i < NUM_STAGES; ++i)
+  {
+    s_total_ns[i] = 0;
+    s_calls[i] = 0;
+  }
+}
+
+u64 GetTotalUs(Stage stage)
+{
+  return s_total_ns[static_cast<size_t>(stage)] / 1000;
+}
+
+const char* GetName(Stage stage)
+{
+  static constexpr std::array<const char*, NUM_STAGES> names = {
+      {"Opcode decode", "Opcode preprocess", "Vertex load", "Flush", "Transform", "Rasterize",
+       "EFB copy", "Submit", "Decode stall", "Submit stall"}};
+  return names[static_cast<size_t>(stage)];
+}
+
+std::string ToString()
+{
+  std::string result = StringFromFormat("%-16s %12s %12s\n", "Stage", "Calls", "Time (ms)");
+  for (size_t i = 0; i < NUM_STAGES; ++i)
+  {
+    const u64 calls = s_calls[i];
+    if (calls == 0)
+      continue;
+
+    const Stage stage = static_cast<Stage>(i);
+    result += StringFromFormat("%-16s %12llu %12.1f\n", GetName(stage),
+                               static_cast<unsigned long long>(calls), GetTotalUs(stage) / 1000.0);
+  }
+  return result;
+}
+
+ScopedTimer::ScopedTimer(Stage stage) : m_stage(stage), m_active(IsEnabled())
+{
+  if (!m_active)
+    return;
+
+  m_parent = s_current_timer;
+  s_current_timer = this;
+  m_start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer()
+{
+  if (!m_active)
+    return;
+
+  const auto elapsed = std::chrono::steady_clock::now() - m_start;
+  s_current_timer = m_parent;
+  if (m_parent)
+    m_parent->m_nested += elapsed;
+
+  const size_t index = static_cast<size_t>(m_stage);
+  const auto exclusive = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - m_nested);
+  s_total_ns[index].fetch_add(exclusive.count(), std::memory_order_relaxed);
+  s_calls[index].fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace StageTimings
@@ -0,0 +1,65 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+// Accumulates the time the GPU thread (and CommandPipeline's decoding thread, or the CPU thread's
+// preprocessing, if used) spends in each stage of processing the FIFO, for benchmarking FIFO log
+// playback. Timing is disabled by
+// default, in which case a ScopedTimer costs a single branch.
+//
+// Stages may nest (e.g. a vertex load flushing the vertex manager). The time of a nested stage is
+// only attributed to that stage, not to the stage it was started from.
+namespace StageTimings
+{
+enum class Stage
+{
+  OpcodeDecode,
+  // The CPU thread's pass over the FIFO when the GPU thread is deterministic.
+  OpcodePreprocess,
+  VertexLoad,
+  Flush,
+  Transform,
+  Rasterize,
+  EFBCopy,
+  // CommandPipeline: executing decoded commands on the GPU thread, the decoding thread waiting
+  // for the GPU thread to free a batch, and the GPU thread waiting for decoded commands.
+  Submit,
+  DecodeStall,
+  SubmitStall,
+  Count
+};
+
+void SetEnabled(bool enabled);
+bool IsEnabled();
+
+void Reset();
+// Returns the total time spent in the stage, in microseconds.
+u64 GetTotalUs(Stage stage);
+const char* GetName(Stage stage);
+// Formats the totals of all stages that were entered at least once as a table.
+std::string ToString();
+
+class ScopedTimer
+{
+public:
+  explicit ScopedTimer(Stage stage);
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  Stage m_stage;
+  bool m_active;
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::steady_clock::duration m_nested{};
+  ScopedTimer* m_parent = nullptr;
+};
+}  // namespace StageTimings
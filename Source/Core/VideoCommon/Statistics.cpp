@@ -47,12 +47,27 @@ std::string Statistics::ToString()
   str += StringFromFormat("Textures created: %i\n", stats.numTexturesCreated);
   str += StringFromFormat("Textures uploaded: %i\n", stats.numTexturesUploaded);
   str += StringFromFormat("Textures alive: %i\n", stats.numTexturesAlive);
+  str += StringFromFormat("Texture lookups: %i\n", stats.thisFrame.numTextureLookups);
+  str += StringFromFormat("Texture overlap checks: %i\n", stats.thisFrame.numTextureOverlapChecks);
   str += StringFromFormat("pshaders created: %i\n", stats.numPixelShadersCreated);
   str += StringFromFormat("pshaders alive: %i\n", stats.numPixelShadersAlive);
   str += StringFromFormat("vshaders created: %i\n", stats.numVertexShadersCreated);
   str += StringFromFormat("vshaders alive: %i\n", stats.numVertexShadersAlive);
   str += StringFromFormat("shaders changes: %i\n", stats.thisFrame.numShaderChanges);
+  str += StringFromFormat("shader compiles queued: %i (%i blocked)\n",
+                          stats.numShaderCompilesQueued, stats.numShaderCompilesBlocked);
+  str += StringFromFormat("shader compiles done: %i (%i stolen, %i cancelled)\n",
+                          stats.numShaderCompilesDone, stats.numShaderCompilesStolen,
+                          stats.numShaderCompilesCancelled);
+  str += StringFromFormat("shader compile wait: %.2f ms avg\n", stats.shaderCompileWaitMs);
+  str += StringFromFormat("shader compile time: %.2f ms avg, %.2f ms max\n",
+                          stats.shaderCompileTimeMs, stats.shaderCompileMaxTimeMs);
   str += StringFromFormat("dlists called: %i\n", stats.thisFrame.numDListsCalled);
+  if (g_ActiveConfig.bCacheDisplayLists)
+  {
+    str += StringFromFormat("dlist cache hits: %i\n", stats.thisFrame.numDListCacheHits);
+    str += StringFromFormat("dlist cache misses: %i\n", stats.thisFrame.numDListCacheMisses);
+  }
   str += StringFromFormat("Primitive joins: %i\n", stats.thisFrame.numPrimitiveJoins);
   str += StringFromFormat("Draw calls: %i\n", stats.thisFrame.numDrawCalls);
   str += StringFromFormat("Primitives: %i\n", stats.thisFrame.numPrims);
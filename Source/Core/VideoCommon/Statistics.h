@@ -19,6 +19,15 @@ struct Statistics
 
   int numVertexLoaders;
 
+  int numShaderCompilesQueued;
+  int numShaderCompilesBlocked;
+  int numShaderCompilesDone;
+  int numShaderCompilesStolen;
+  int numShaderCompilesCancelled;
+  float shaderCompileWaitMs;
+  float shaderCompileTimeMs;
+  float shaderCompileMaxTimeMs;
+
   float proj_0, proj_1, proj_2, proj_3, proj_4, proj_5;
   float gproj_0, gproj_1, gproj_2, gproj_3, gproj_4, gproj_5;
   float gproj_6, gproj_7, gproj_8, gproj_9, gproj_10, gproj_11, gproj_12, gproj_13, gproj_14,
@@ -46,6 +55,8 @@ struct Statistics
     int numDrawCalls;
 
     int numDListsCalled;
+    int numDListCacheHits;
+    int numDListCacheMisses;
 
     int bytesVertexStreamed;
     int bytesIndexStreamed;
@@ -61,6 +72,9 @@ struct Statistics
     int numVerticesLoaded;
     int tevPixelsIn;
     int tevPixelsOut;
+
+    int numTextureLookups;
+    int numTextureOverlapChecks;
   };
   ThisFrame thisFrame;
   void ResetFrame();
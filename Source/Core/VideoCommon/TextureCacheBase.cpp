@@ -100,6 +100,7 @@ void TextureCacheBase::Invalidate()
   }
   textures_by_address.clear();
   textures_by_hash.clear();
+  largest_entry_size = 0;
 
   texture_pool.clear();
 }
@@ -148,10 +149,17 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
 
 void TextureCacheBase::Cleanup(int _frameCount)
 {
+  // Recalculate the size of the largest entry, so that FindOverlappingTextures can narrow its
+  // search again once large textures are gone. Entries removed below may still be counted, which
+  // is harmless since it only has to be an upper bound.
+  largest_entry_size = 0;
+
   TexAddrCache::iterator iter = textures_by_address.begin();
   TexAddrCache::iterator tcend = textures_by_address.end();
   while (iter != tcend)
   {
+    largest_entry_size = std::max(largest_entry_size, iter->second->size_in_bytes);
+
     if (iter->second->tmem_only)
     {
       iter = InvalidateTexture(iter);
@@ -256,6 +264,7 @@ TextureCacheBase::ApplyPaletteToEntry(TCacheEntry* entry, u8* palette, TLUTForma
 
   ConvertTexture(decoded_entry, entry, palette, tlutfmt);
   textures_by_address.emplace(entry->addr, decoded_entry);
+  largest_entry_size = std::max(largest_entry_size, decoded_entry->size_in_bytes);
 
   return decoded_entry;
 }
@@ -328,6 +337,7 @@ TextureCacheBase::DoPartialTextureUpdates(TCacheEntry* entry_to_update, u8* pale
   auto iter = FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes);
   while (iter.first != iter.second)
   {
+    INCSTAT(stats.thisFrame.numTextureOverlapChecks);
     TCacheEntry* entry = iter.first->second;
     if (entry != entry_to_update && entry->IsCopy() && !entry->tmem_only &&
         entry->references.count(entry_to_update) == 0 &&
@@ -794,6 +804,7 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   // For efb copies, the entry created in CopyRenderTargetToTexture always has to be used, or else
   // it was
   // done in vain.
+  INCSTAT(stats.thisFrame.numTextureLookups);
   auto iter_range = textures_by_address.equal_range(address);
   TexAddrCache::iterator iter = iter_range.first;
   TexAddrCache::iterator oldest_entry = iter;
@@ -1032,6 +1043,7 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
   }
 
   entry->SetGeneralParameters(address, texture_size, full_format, false);
+  largest_entry_size = std::max(largest_entry_size, entry->size_in_bytes);
   entry->SetDimensions(nativeW, nativeH, tex_levels);
   entry->SetHashes(base_hash, full_hash);
   entry->is_custom_tex = hires_tex != nullptr;
@@ -1257,6 +1269,7 @@ std::optional<TextureLookupInformation> TextureCacheBase::ComputeTextureInformat
 TextureCacheBase::TCacheEntry*
 TextureCacheBase::GetXFBFromCache(const TextureLookupInformation& tex_info)
 {
+  INCSTAT(stats.thisFrame.numTextureLookups);
   auto iter_range = textures_by_address.equal_range(tex_info.address);
   TexAddrCache::iterator iter = iter_range.first;
 
@@ -1299,6 +1312,7 @@ bool TextureCacheBase::LoadTextureFromOverlappingTextures(TCacheEntry* entry_to_
   auto iter = FindOverlappingTextures(entry_to_update->addr, entry_to_update->size_in_bytes);
   while (iter.first != iter.second)
   {
+    INCSTAT(stats.thisFrame.numTextureOverlapChecks);
     TCacheEntry* entry = iter.first->second;
     if (entry != entry_to_update && entry->IsCopy() && !entry->tmem_only &&
         entry->references.count(entry_to_update) == 0 &&
@@ -1447,6 +1461,7 @@ TextureCacheBase::CreateNormalTexture(const TextureLookupInformation& tex_info)
   }
 
   entry->SetGeneralParameters(tex_info.address, tex_info.total_bytes, tex_info.full_format, false);
+  largest_entry_size = std::max(largest_entry_size, entry->size_in_bytes);
   entry->SetDimensions(tex_info.native_width, tex_info.native_height, tex_info.computed_levels);
   entry->SetHashes(tex_info.base_hash, tex_info.full_hash);
   entry->is_custom_tex = false;
@@ -1734,6 +1749,7 @@ void TextureCacheBase::CopyRenderTargetToTexture(
   auto iter = FindOverlappingTextures(dstAddr, covered_range);
   while (iter.first != iter.second)
   {
+    INCSTAT(stats.thisFrame.numTextureOverlapChecks);
     TCacheEntry* entry = iter.first->second;
 
     if (entry->addr == dstAddr && entry->is_xfb_copy)
@@ -1835,6 +1851,7 @@ void TextureCacheBase::CopyRenderTargetToTexture(
       }
 
       textures_by_address.emplace(dstAddr, entry);
+      largest_entry_size = std::max(largest_entry_size, entry->size_in_bytes);
     }
   }
 }
@@ -1955,10 +1972,13 @@ TextureCacheBase::FindOverlappingTextures(u32 addr, u32 size_in_bytes)
   // which end after the given addr. But the GC textures have a limited size, so we
   // look for all textures which have a start address bigger than addr minus the maximal
   // texture size. But this yields false-positives which must be checked later on.
+  // Usually no texture in the cache is anywhere near the maximal size, so the size of the
+  // largest entry is used instead, which skips most of those false-positives.
 
   // 1024 x 1024 texel times 8 nibbles per texel
   constexpr u32 max_texture_size = 1024 * 1024 * 4;
-  u32 lower_addr = addr > max_texture_size ? addr - max_texture_size : 0;
+  const u32 search_size = std::min(largest_entry_size, max_texture_size);
+  u32 lower_addr = addr > search_size ? addr - search_size : 0;
   auto begin = textures_by_address.lower_bound(lower_addr);
   auto end = textures_by_address.upper_bound(addr + size_in_bytes);
 
@@ -343,6 +343,8 @@ private:
   TexHashCache textures_by_hash;
   TexPool texture_pool;
   u64 last_entry_id = 0;
+  // An upper bound for the size_in_bytes of the entries in textures_by_address.
+  u32 largest_entry_size = 0;
 
   // Backup configuration values
   struct BackupConfig
@@ -16,7 +16,12 @@ class DataReader;
 
 class VertexLoaderUID
 {
-  std::array<u32, 5> vid;
+public:
+  // The raw words, as stored in the per-game vertex loader cache.
+  using Data = std::array<u32, 5>;
+
+private:
+  Data vid;
   size_t hash;
 
 public:
@@ -30,9 +35,26 @@ public:
     vid[4] = vat.g2.Hex;
     hash = CalculateHash();
   }
+  explicit VertexLoaderUID(const Data& data) : vid(data) { hash = CalculateHash(); }
 
   bool operator==(const VertexLoaderUID& rh) const { return vid == rh.vid; }
   size_t GetHash() const { return hash; }
+  const Data& GetData() const { return vid; }
+
+  TVtxDesc GetVtxDesc() const
+  {
+    TVtxDesc vtx_desc;
+    vtx_desc.Hex = vid[0] | static_cast<u64>(vid[1]) << 32;
+    return vtx_desc;
+  }
+  VAT GetVAT() const
+  {
+    VAT vat;
+    vat.g0.Hex = vid[2];
+    vat.g1.Hex = vid[3];
+    vat.g2.Hex = vid[4];
+    return vat;
+  }
 
 private:
   size_t CalculateHash() const
@@ -3,6 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -13,17 +16,22 @@
 #include "Common/Assert.h"
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
+#include "Common/LinearDiskCache.h"
+#include "Common/Logging/Log.h"
 #include "Core/HW/Memmap.h"
 
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/IndexGenerator.h"
 #include "VideoCommon/NativeVertexFormat.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/Statistics.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/VertexLoaderBase.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
+#include "VideoCommon/VideoConfig.h"
 
 namespace VertexLoaderManager
 {
@@ -40,7 +48,18 @@ u32 g_current_components;
 typedef std::unordered_map<VertexLoaderUID, std::unique_ptr<VertexLoaderBase>> VertexLoaderMap;
 static std::mutex s_vertex_loader_map_lock;
 static VertexLoaderMap s_vertex_loader_map;
-// TODO - change into array of pointers. Keep a map of all seen so far.
+
+// Loaders are looked up without the lock through this open addressing table of pointers to
+// s_vertex_loader_map entries, which don't move once inserted. Entries are only added while
+// holding the lock, and the table is kept at most half full so that lookups always end at an empty
+// slot. Loaders that don't fit anymore are still found in the map, with the lock.
+constexpr size_t LOOKUP_TABLE_SIZE = 1024;
+static std::array<std::atomic<const VertexLoaderMap::value_type*>, LOOKUP_TABLE_SIZE>
+    s_lookup_table;
+static size_t s_lookup_table_entries;
+
+// The UIDs of the loaders each game used, so that they can be compiled at boot.
+static LinearDiskCache<VertexLoaderUID::Data, u8> s_uid_cache;
 
 u8* cached_arraybases[12];
 
@@ -57,10 +76,87 @@ void Init()
 void Clear()
 {
   std::lock_guard<std::mutex> lk(s_vertex_loader_map_lock);
+  s_uid_cache.Sync();
+  s_uid_cache.Close();
+  for (auto& entry : s_lookup_table)
+    entry.store(nullptr, std::memory_order_relaxed);
+  s_lookup_table_entries = 0;
   s_vertex_loader_map.clear();
   s_native_vertex_map.clear();
 }
 
+static VertexLoaderBase* FindLoader(const VertexLoaderUID& uid)
+{
+  for (size_t i = uid.GetHash();; i++)
+  {
+    const VertexLoaderMap::value_type* entry =
+        s_lookup_table[i % LOOKUP_TABLE_SIZE].load(std::memory_order_acquire);
+    if (!entry)
+      return nullptr;
+    if (entry->first == uid)
+      return entry->second.get();
+  }
+}
+
+// Must be called with s_vertex_loader_map_lock held.
+static VertexLoaderBase* CreateLoader(const VertexLoaderUID& uid, const TVtxDesc& vtx_desc,
+                                      const VAT& vtx_attr)
+{
+  auto iter =
+      s_vertex_loader_map.emplace(uid, VertexLoaderBase::CreateVertexLoader(vtx_desc, vtx_attr))
+          .first;
+  INCSTAT(stats.numVertexLoaders);
+
+  if (s_lookup_table_entries < LOOKUP_TABLE_SIZE / 2)
+  {
+    size_t i = uid.GetHash();
+    while (s_lookup_table[i % LOOKUP_TABLE_SIZE].load(std::memory_order_relaxed))
+      i++;
+    s_lookup_table[i % LOOKUP_TABLE_SIZE].store(&*iter, std::memory_order_release);
+    s_lookup_table_entries++;
+  }
+
+  return iter->second.get();
+}
+
+static VertexLoaderBase* GetOrCreateLoader(const TVtxDesc& vtx_desc, const VAT& vtx_attr)
+{
+  VertexLoaderUID uid(vtx_desc, vtx_attr);
+  VertexLoaderBase* loader = FindLoader(uid);
+  if (loader)
+    return loader;
+
+  std::lock_guard<std::mutex> lk(s_vertex_loader_map_lock);
+  VertexLoaderMap::iterator iter = s_vertex_loader_map.find(uid);
+  if (iter != s_vertex_loader_map.end())
+    return iter->second.get();
+
+  if (g_ActiveConfig.bShaderCache)
+    s_uid_cache.Append(uid.GetData(), nullptr, 0);
+  return CreateLoader(uid, vtx_desc, vtx_attr);
+}
+
+void LoadVertexLoaderCache()
+{
+  class CacheReader : public LinearDiskCacheReader<VertexLoaderUID::Data, u8>
+  {
+  public:
+    void Read(const VertexLoaderUID::Data& key, const u8* value, u32 value_size) override
+    {
+      VertexLoaderUID uid(key);
+      if (s_vertex_loader_map.find(uid) == s_vertex_loader_map.end())
+        CreateLoader(uid, uid.GetVtxDesc(), uid.GetVAT());
+    }
+  };
+
+  std::lock_guard<std::mutex> lk(s_vertex_loader_map_lock);
+  std::string filename =
+      GetDiskShaderCacheFileName(APIType::Nothing, "vertex-loaders", true, false, false);
+  CacheReader reader;
+  u32 count = s_uid_cache.OpenAndRead(filename, reader);
+  INFO_LOG(VIDEO, "Compiled %u cached vertex loaders from %s", count, filename.c_str());
+}
+
 void UpdateVertexArrayPointers()
 {
   // Anything to update?
@@ -195,7 +291,20 @@ NativeVertexFormat* GetUberVertexFormat(const PortableVertexDeclaration& decl)
   return GetOrCreateMatchingFormat(new_decl);
 }
 
-static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = false)
+static void CreateNativeVertexFormat(VertexLoaderBase* loader)
+{
+  // search for a cached native vertex format
+  const PortableVertexDeclaration& format = loader->m_native_vtx_decl;
+  std::unique_ptr<NativeVertexFormat>& native = s_native_vertex_map[format];
+  if (!native)
+  {
+    native = g_vertex_manager->CreateNativeVertexFormat(format);
+  }
+  loader->m_native_vertex_format = native.get();
+}
+
+static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = false,
+                                       bool create_native_format = true)
 {
   CPState* state = preprocess ? &g_preprocess_cp_state : &g_main_cp_state;
   state->last_id = vtx_attr_group;
@@ -203,36 +312,7 @@ static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = fal
   VertexLoaderBase* loader;
   if (state->attr_dirty[vtx_attr_group])
   {
-    // We are not allowed to create a native vertex format on preprocessing as this is on the wrong
-    // thread
-    bool check_for_native_format = !preprocess;
-
-    VertexLoaderUID uid(state->vtx_desc, state->vtx_attr[vtx_attr_group]);
-    std::lock_guard<std::mutex> lk(s_vertex_loader_map_lock);
-    VertexLoaderMap::iterator iter = s_vertex_loader_map.find(uid);
-    if (iter != s_vertex_loader_map.end())
-    {
-      loader = iter->second.get();
-      check_for_native_format &= !loader->m_native_vertex_format;
-    }
-    else
-    {
-      s_vertex_loader_map[uid] =
-          VertexLoaderBase::CreateVertexLoader(state->vtx_desc, state->vtx_attr[vtx_attr_group]);
-      loader = s_vertex_loader_map[uid].get();
-      INCSTAT(stats.numVertexLoaders);
-    }
-    if (check_for_native_format)
-    {
-      // search for a cached native vertex format
-      const PortableVertexDeclaration& format = loader->m_native_vtx_decl;
-      std::unique_ptr<NativeVertexFormat>& native = s_native_vertex_map[format];
-      if (!native)
-      {
-        native = g_vertex_manager->CreateNativeVertexFormat(format);
-      }
-      loader->m_native_vertex_format = native.get();
-    }
+    loader = GetOrCreateLoader(state->vtx_desc, state->vtx_attr[vtx_attr_group]);
     state->vertex_loaders[vtx_attr_group] = loader;
     state->attr_dirty[vtx_attr_group] = false;
   }
@@ -241,6 +321,13 @@ static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = fal
     loader = state->vertex_loaders[vtx_attr_group];
   }
 
+  // We are not allowed to create a native vertex format on preprocessing as this is on the wrong
+  // thread. When decoding for CommandPipeline, the submitting thread creates it instead. As the
+  // loader may already have been looked up by one of those, this is not only done when the
+  // attributes are dirty.
+  if (!preprocess && create_native_format && !loader->m_native_vertex_format)
+    CreateNativeVertexFormat(loader);
+
   // Lookup pointers for any vertex arrays.
   if (!preprocess)
     UpdateVertexArrayPointers();
@@ -248,20 +335,10 @@ static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = fal
   return loader;
 }
 
-int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool is_preprocess)
+// Prepares the vertex manager for count vertices of the loader's native format and returns where
+// they have to be written to.
+static DataReader PrepareForVertices(const VertexLoaderBase* loader, int primitive, int count)
 {
-  if (!count)
-    return 0;
-
-  VertexLoaderBase* loader = RefreshLoader(vtx_attr_group, is_preprocess);
-
-  int size = count * loader->m_VertexSize;
-  if ((int)src.size() < size)
-    return -1;
-
-  if (is_preprocess)
-    return size;
-
   // If the native vertex format changed, force a flush.
   if (loader->m_native_vertex_format != s_current_vtx_fmt ||
       loader->m_native_components != g_current_components)
@@ -277,20 +354,63 @@ int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bo
   // slope.
   bool cullall = (bpmem.genMode.cullmode == GenMode::CULL_ALL && primitive < 5);
 
-  DataReader dst = g_vertex_manager->PrepareForAdditionalData(
-      primitive, count, loader->m_native_vtx_decl.stride, cullall);
-
-  count = loader->RunVertices(src, dst, count);
+  return g_vertex_manager->PrepareForAdditionalData(primitive, count,
+                                                    loader->m_native_vtx_decl.stride, cullall);
+}
 
+static void FinishVertices(const VertexLoaderBase* loader, int primitive, int count,
+                           const float positions[3][4], const u32 matrix_indices[4])
+{
   IndexGenerator::AddIndices(primitive, count);
 
   g_vertex_manager->FlushData(count, loader->m_native_vtx_decl.stride);
+  g_vertex_manager->SetZSlopeVertices(positions, matrix_indices);
 
   ADDSTAT(stats.thisFrame.numPrims, count);
   INCSTAT(stats.thisFrame.numPrimitiveJoins);
+}
+
+int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool is_preprocess)
+{
+  if (!count)
+    return 0;
+
+  StageTimings::ScopedTimer timer(StageTimings::Stage::VertexLoad);
+
+  VertexLoaderBase* loader = RefreshLoader(vtx_attr_group, is_preprocess);
+
+  int size = count * loader->m_VertexSize;
+  if ((int)src.size() < size)
+    return -1;
+
+  if (is_preprocess)
+    return size;
+
+  DataReader dst = PrepareForVertices(loader, primitive, count);
+
+  count = loader->RunVertices(src, dst, count);
+
+  FinishVertices(loader, primitive, count, position_cache, position_matrix_index);
   return size;
 }
 
+VertexLoaderBase* GetLoaderForDecoding(int vtx_attr_group)
+{
+  return RefreshLoader(vtx_attr_group, false, false);
+}
+
+void SubmitConvertedVertices(VertexLoaderBase* loader, int primitive, int count,
+                             const u8* vertices, const float positions[3][4],
+                             const u32 matrix_indices[4])
+{
+  if (!loader->m_native_vertex_format)
+    CreateNativeVertexFormat(loader);
+
+  DataReader dst = PrepareForVertices(loader, primitive, count);
+  std::memcpy(dst.GetPointer(), vertices, count * loader->m_native_vtx_decl.stride);
+  FinishVertices(loader, primitive, count, positions, matrix_indices);
+}
+
 NativeVertexFormat* GetCurrentVertexFormat()
 {
   return s_current_vtx_fmt;
@@ -12,6 +12,7 @@
 
 class DataReader;
 class NativeVertexFormat;
+class VertexLoaderBase;
 struct PortableVertexDeclaration;
 
 namespace VertexLoaderManager
@@ -22,6 +23,9 @@ using NativeVertexFormatMap =
 void Init();
 void Clear();
 
+// Compiles the vertex loaders the current game used before, and records any new ones from now on.
+void LoadVertexLoaderCache();
+
 void MarkAllDirty();
 
 // Creates or obtains a pointer to a VertexFormat representing decl.
@@ -37,6 +41,16 @@ NativeVertexFormat* GetUberVertexFormat(const PortableVertexDeclaration& decl);
 // Returns -1 if buf_size is insufficient, else the amount of bytes consumed
 int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool is_preprocess);
 
+// Used by CommandPipeline, which splits RunVertices between two threads. The decoding thread
+// looks up the loader and converts the vertices, which only involves the main CP state, and the
+// submitting thread adds the converted vertices, along with the position_cache and
+// position_matrix_index contents after the conversion, to the vertex manager.
+// DisplayListCache also uses this to add the same converted vertices multiple times.
+VertexLoaderBase* GetLoaderForDecoding(int vtx_attr_group);
+void SubmitConvertedVertices(VertexLoaderBase* loader, int primitive, int count,
+                             const u8* vertices, const float positions[3][4],
+                             const u32 matrix_indices[4]);
+
 // For debugging
 std::string VertexLoadersToString();
 
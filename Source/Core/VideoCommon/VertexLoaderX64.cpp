@@ -27,6 +27,9 @@ static const X64Reg scratch3 = ABI_PARAM4;
 static const X64Reg count_reg = R10;
 static const X64Reg skipped_reg = R11;
 static const X64Reg base_reg = RBX;
+// The array index and base of the second vertex, when converting two at once.
+static const X64Reg pair_scratch1 = R12;
+static const X64Reg pair_scratch2 = R13;
 
 static const u8* memory_base_ptr = (u8*)&g_main_cp_state.array_strides;
 
@@ -55,31 +58,55 @@ VertexLoaderX64::VertexLoaderX64(const TVtxDesc& vtx_desc, const VAT& vtx_att)
   JitRegister::Register(region, GetCodePtr(), name.c_str());
 }
 
-OpArg VertexLoaderX64::GetVertexAddr(int array, u64 attribute)
+OpArg VertexLoaderX64::GetSrc(int vertex, u32 offset) const
 {
-  OpArg data = MDisp(src_reg, m_src_ofs);
-  if (attribute & MASK_INDEXED)
+  return MDisp(src_reg, offset + vertex * m_VertexSize);
+}
+
+OpArg VertexLoaderX64::GetDst(int vertex, u32 offset) const
+{
+  return MDisp(dst_reg, offset + vertex * m_native_vtx_decl.stride);
+}
+
+void VertexLoaderX64::GetVertexAddr(int array, u64 attribute, OpArg* data)
+{
+  static const X64Reg index_regs[2] = {scratch1, pair_scratch1};
+  static const X64Reg base_regs[2] = {scratch2, pair_scratch2};
+  const int num_vertices = m_pair ? 2 : 1;
+
+  if (!(attribute & MASK_INDEXED))
+  {
+    for (int i = 0; i < num_vertices; i++)
+      data[i] = GetSrc(i, m_src_ofs);
+    return;
+  }
+
+  int bits = attribute == INDEX8 ? 8 : 16;
+  for (int i = 0; i < num_vertices; i++)
   {
-    int bits = attribute == INDEX8 ? 8 : 16;
-    LoadAndSwap(bits, scratch1, data);
-    m_src_ofs += bits / 8;
+    LoadAndSwap(bits, index_regs[i], GetSrc(i, m_src_ofs));
     if (array == ARRAY_POSITION)
     {
-      CMP(bits, R(scratch1), Imm8(-1));
-      m_skip_vertex = J_CC(CC_E, true);
+      CMP(bits, R(index_regs[i]), Imm8(-1));
+      // A skipped vertex in a pair is left to the single vertex loop.
+      if (m_pair)
+        J_CC(CC_E, m_single_vertex_loop);
+      else
+        m_skip_vertex = J_CC(CC_E, true);
     }
-    IMUL(32, scratch1, MPIC(&g_main_cp_state.array_strides[array]));
-    MOV(64, R(scratch2), MPIC(&VertexLoaderManager::cached_arraybases[array]));
-    return MRegSum(scratch1, scratch2);
   }
-  else
+  m_src_ofs += bits / 8;
+
+  for (int i = 0; i < num_vertices; i++)
   {
-    return data;
+    IMUL(32, index_regs[i], MPIC(&g_main_cp_state.array_strides[array]));
+    MOV(64, R(base_regs[i]), MPIC(&VertexLoaderManager::cached_arraybases[array]));
+    data[i] = MRegSum(index_regs[i], base_regs[i]);
   }
 }
 
-int VertexLoaderX64::ReadVertex(OpArg data, u64 attribute, int format, int count_in, int count_out,
-                                bool dequantize, u8 scaling_exponent,
+int VertexLoaderX64::ReadVertex(const OpArg* vertex_data, u64 attribute, int format, int count_in,
+                                int count_out, bool dequantize, u8 scaling_exponent,
                                 AttributeFormat* native_format)
 {
   static const __m128i shuffle_lut[5][3] = {
@@ -117,7 +144,8 @@ int VertexLoaderX64::ReadVertex(OpArg data, u64 attribute, int format, int count
 
   int elem_size = 1 << (format / 2);
   int load_bytes = elem_size * count_in;
-  OpArg dest = MDisp(dst_reg, m_dst_ofs);
+  OpArg data = vertex_data[0];
+  OpArg dest = GetDst(0, m_dst_ofs);
 
   native_format->components = count_out;
   native_format->enable = true;
@@ -130,7 +158,52 @@ int VertexLoaderX64::ReadVertex(OpArg data, u64 attribute, int format, int count
   if (attribute == DIRECT)
     m_src_ofs += load_bytes;
 
-  if (cpu_info.bSSSE3)
+  if (m_pair)
+  {
+    // Convert both vertices at once, with the first one in the low lane of YMM0 and the second
+    // one in the high lane. The stores below then only need the XMM halves.
+    if (load_bytes > 8)
+    {
+      MOVDQU(coords, data);
+      VINSERTI128(coords, coords, vertex_data[1], 1);
+    }
+    else
+    {
+      for (int i = 0; i < 2; i++)
+      {
+        X64Reg reg = i ? XMM1 : coords;
+        if (load_bytes > 4)
+          MOVQ_xmm(reg, vertex_data[i]);
+        else
+          MOVD_xmm(reg, vertex_data[i]);
+      }
+      VINSERTI128(coords, coords, R(XMM1), 1);
+    }
+
+    VBROADCASTI128(XMM1, MPIC(&shuffle_lut[format][count_in - 1]));
+    VPSHUFB_256(coords, coords, R(XMM1));
+
+    if (format == FORMAT_BYTE)
+      VPSRAD_256(coords, coords, 24);
+    if (format == FORMAT_SHORT)
+      VPSRAD_256(coords, coords, 16);
+
+    if (format != FORMAT_FLOAT)
+    {
+      VCVTDQ2PS_256(coords, R(coords));
+
+      if (dequantize && scaling_exponent)
+      {
+        VBROADCASTI128(XMM1, MPIC(&scale_factors[scaling_exponent]));
+        VMULPS_256(coords, coords, R(XMM1));
+      }
+    }
+
+    VEXTRACTI128(R(XMM1), coords, 1);
+    // Avoid the penalty for mixing legacy SSE and 256-bit AVX code.
+    VZEROUPPER();
+  }
+  else if (cpu_info.bSSSE3)
   {
     if (load_bytes > 8)
       MOVDQU(coords, data);
@@ -231,7 +304,7 @@ int VertexLoaderX64::ReadVertex(OpArg data, u64 attribute, int format, int count
     }
   }
 
-  if (format != FORMAT_FLOAT)
+  if (format != FORMAT_FLOAT && !m_pair)
   {
     CVTDQ2PS(coords, R(coords));
 
@@ -239,21 +312,11 @@ int VertexLoaderX64::ReadVertex(OpArg data, u64 attribute, int format, int count
       MULPS(coords, MPIC(&scale_factors[scaling_exponent]));
   }
 
-  switch (count_out)
-  {
-  case 1:
-    MOVSS(dest, coords);
-    break;
-  case 2:
-    MOVLPS(dest, coords);
-    break;
-  case 3:
-    MOVUPS(dest, coords);
-    break;
-  }
+  for (int i = 0; i < (m_pair ? 2 : 1); i++)
+    StoreFloats(i, native_format->offset, i ? XMM1 : coords, count_out);
 
-  // zfreeze
-  if (native_format == &m_native_vtx_decl.position)
+  // zfreeze, which is never needed for a pair as the last vertices are converted one at a time
+  if (native_format == &m_native_vtx_decl.position && !m_pair)
   {
     CMP(32, R(count_reg), Imm8(3));
     FixupBranch dont_store = J_CC(CC_A);
@@ -265,158 +328,181 @@ int VertexLoaderX64::ReadVertex(OpArg data, u64 attribute, int format, int count
   return load_bytes;
 }
 
-void VertexLoaderX64::ReadColor(OpArg data, u64 attribute, int format)
+void VertexLoaderX64::StoreFloats(int vertex, u32 offset, X64Reg reg, int count)
 {
-  int load_bytes = 0;
-  switch (format)
+  OpArg dest = GetDst(vertex, offset);
+  switch (count)
   {
-  case FORMAT_24B_888:
-  case FORMAT_32B_888x:
-  case FORMAT_32B_8888:
-    MOV(32, R(scratch1), data);
-    if (format != FORMAT_32B_8888)
-      OR(32, R(scratch1), Imm32(0xFF000000));
-    MOV(32, MDisp(dst_reg, m_dst_ofs), R(scratch1));
-    load_bytes = 3 + (format != FORMAT_24B_888);
+  case 1:
+    MOVSS(dest, reg);
     break;
-
-  case FORMAT_16B_565:
-    //                   RRRRRGGG GGGBBBBB
-    // AAAAAAAA BBBBBBBB GGGGGGGG RRRRRRRR
-    LoadAndSwap(16, scratch1, data);
-    if (cpu_info.bBMI1 && cpu_info.bBMI2)
+  case 2:
+    MOVLPS(dest, reg);
+    break;
+  case 3:
+    // Storing all four floats is fine as long as the next attribute overwrites the fourth one,
+    // but the first vertex of a pair must not clobber the start of the second.
+    if (m_pair && vertex == 0 && offset + 16 > static_cast<u32>(m_native_vtx_decl.stride))
     {
-      MOV(32, R(scratch2), Imm32(0x07C3F7C0));
-      PDEP(32, scratch3, scratch1, R(scratch2));
-
-      MOV(32, R(scratch2), Imm32(0xF8FCF800));
-      PDEP(32, scratch1, scratch1, R(scratch2));
-      ANDN(32, scratch2, scratch2, R(scratch3));
-
-      OR(32, R(scratch1), R(scratch2));
+      MOVLPS(dest, reg);
+      MOVHLPS(XMM2, reg);
+      dest.AddMemOffset(2 * sizeof(float));
+      MOVSS(dest, XMM2);
     }
     else
     {
-      SHL(32, R(scratch1), Imm8(11));
-      LEA(32, scratch2, MScaled(scratch1, SCALE_4, 0));
-      LEA(32, scratch3, MScaled(scratch2, SCALE_8, 0));
-      AND(32, R(scratch1), Imm32(0x0000F800));
-      AND(32, R(scratch2), Imm32(0x00FC0000));
-      AND(32, R(scratch3), Imm32(0xF8000000));
-      OR(32, R(scratch1), R(scratch2));
-      OR(32, R(scratch1), R(scratch3));
-
-      MOV(32, R(scratch2), R(scratch1));
-      SHR(32, R(scratch1), Imm8(5));
-      AND(32, R(scratch1), Imm32(0x07000700));
-      OR(32, R(scratch1), R(scratch2));
-
-      SHR(32, R(scratch2), Imm8(6));
-      AND(32, R(scratch2), Imm32(0x00030000));
-      OR(32, R(scratch1), R(scratch2));
+      MOVUPS(dest, reg);
     }
-    OR(32, R(scratch1), Imm32(0x000000FF));
-    SwapAndStore(32, MDisp(dst_reg, m_dst_ofs), scratch1);
-    load_bytes = 2;
     break;
+  }
+}
 
-  case FORMAT_16B_4444:
-    //                   RRRRGGGG BBBBAAAA
-    // AAAAAAAA BBBBBBBB GGGGGGGG RRRRRRRR
-    LoadAndSwap(16, scratch1, data);
-    if (cpu_info.bBMI2)
-    {
-      MOV(32, R(scratch2), Imm32(0x0F0F0F0F));
-      PDEP(32, scratch1, scratch1, R(scratch2));
-    }
-    else
+void VertexLoaderX64::ReadColor(const OpArg* vertex_data, u64 attribute, int format)
+{
+  int load_bytes = 0;
+  for (int i = 0; i < (m_pair ? 2 : 1); i++)
+  {
+    OpArg data = vertex_data[i];
+    OpArg dest = GetDst(i, m_dst_ofs);
+    switch (format)
     {
-      MOV(32, R(scratch2), R(scratch1));
-      SHL(32, R(scratch1), Imm8(8));
-      OR(32, R(scratch1), R(scratch2));
-      AND(32, R(scratch1), Imm32(0x00FF00FF));
+    case FORMAT_24B_888:
+    case FORMAT_32B_888x:
+    case FORMAT_32B_8888:
+      MOV(32, R(scratch1), data);
+      if (format != FORMAT_32B_8888)
+        OR(32, R(scratch1), Imm32(0xFF000000));
+      MOV(32, dest, R(scratch1));
+      load_bytes = 3 + (format != FORMAT_24B_888);
+      break;
+
+    case FORMAT_16B_565:
+      //                   RRRRRGGG GGGBBBBB
+      // AAAAAAAA BBBBBBBB GGGGGGGG RRRRRRRR
+      LoadAndSwap(16, scratch1, data);
+      if (cpu_info.bBMI1 && cpu_info.bBMI2)
+      {
+        MOV(32, R(scratch2), Imm32(0x07C3F7C0));
+        PDEP(32, scratch3, scratch1, R(scratch2));
 
+        MOV(32, R(scratch2), Imm32(0xF8FCF800));
+        PDEP(32, scratch1, scratch1, R(scratch2));
+        ANDN(32, scratch2, scratch2, R(scratch3));
+
+        OR(32, R(scratch1), R(scratch2));
+      }
+      else
+      {
+        SHL(32, R(scratch1), Imm8(11));
+        LEA(32, scratch2, MScaled(scratch1, SCALE_4, 0));
+        LEA(32, scratch3, MScaled(scratch2, SCALE_8, 0));
+        AND(32, R(scratch1), Imm32(0x0000F800));
+        AND(32, R(scratch2), Imm32(0x00FC0000));
+        AND(32, R(scratch3), Imm32(0xF8000000));
+        OR(32, R(scratch1), R(scratch2));
+        OR(32, R(scratch1), R(scratch3));
+
+        MOV(32, R(scratch2), R(scratch1));
+        SHR(32, R(scratch1), Imm8(5));
+        AND(32, R(scratch1), Imm32(0x07000700));
+        OR(32, R(scratch1), R(scratch2));
+
+        SHR(32, R(scratch2), Imm8(6));
+        AND(32, R(scratch2), Imm32(0x00030000));
+        OR(32, R(scratch1), R(scratch2));
+      }
+      OR(32, R(scratch1), Imm32(0x000000FF));
+      SwapAndStore(32, dest, scratch1);
+      load_bytes = 2;
+      break;
+
+    case FORMAT_16B_4444:
+      //                   RRRRGGGG BBBBAAAA
+      // AAAAAAAA BBBBBBBB GGGGGGGG RRRRRRRR
+      LoadAndSwap(16, scratch1, data);
+      if (cpu_info.bBMI2)
+      {
+        MOV(32, R(scratch2), Imm32(0x0F0F0F0F));
+        PDEP(32, scratch1, scratch1, R(scratch2));
+      }
+      else
+      {
+        MOV(32, R(scratch2), R(scratch1));
+        SHL(32, R(scratch1), Imm8(8));
+        OR(32, R(scratch1), R(scratch2));
+        AND(32, R(scratch1), Imm32(0x00FF00FF));
+
+        MOV(32, R(scratch2), R(scratch1));
+        SHL(32, R(scratch1), Imm8(4));
+        OR(32, R(scratch1), R(scratch2));
+        AND(32, R(scratch1), Imm32(0x0F0F0F0F));
+      }
       MOV(32, R(scratch2), R(scratch1));
       SHL(32, R(scratch1), Imm8(4));
       OR(32, R(scratch1), R(scratch2));
-      AND(32, R(scratch1), Imm32(0x0F0F0F0F));
-    }
-    MOV(32, R(scratch2), R(scratch1));
-    SHL(32, R(scratch1), Imm8(4));
-    OR(32, R(scratch1), R(scratch2));
-    SwapAndStore(32, MDisp(dst_reg, m_dst_ofs), scratch1);
-    load_bytes = 2;
-    break;
+      SwapAndStore(32, dest, scratch1);
+      load_bytes = 2;
+      break;
 
-  case FORMAT_24B_6666:
-    //          RRRRRRGG GGGGBBBB BBAAAAAA
-    // AAAAAAAA BBBBBBBB GGGGGGGG RRRRRRRR
-    data.AddMemOffset(-1);  // subtract one from address so we can use a 32bit load and bswap
-    LoadAndSwap(32, scratch1, data);
-    if (cpu_info.bBMI2)
-    {
-      MOV(32, R(scratch2), Imm32(0xFCFCFCFC));
-      PDEP(32, scratch1, scratch1, R(scratch2));
-      MOV(32, R(scratch2), R(scratch1));
-    }
-    else
-    {
-      LEA(32, scratch2, MScaled(scratch1, SCALE_4, 0));  // ______RR RRRRGGGG GGBBBBBB AAAAAA__
-      AND(32, R(scratch2), Imm32(0x00003FFC));           // ________ ________ __BBBBBB AAAAAA__
-      SHL(32, R(scratch1), Imm8(6));                     // __RRRRRR GGGGGGBB BBBBAAAA AA______
-      AND(32, R(scratch1), Imm32(0x3FFC0000));           // __RRRRRR GGGGGG__ ________ ________
-      OR(32, R(scratch1), R(scratch2));                  // __RRRRRR GGGGGG__ __BBBBBB AAAAAA__
-
-      LEA(32, scratch2, MScaled(scratch1, SCALE_4, 0));  // RRRRRRGG GGGG____ BBBBBBAA AAAA____
-      AND(32, R(scratch2), Imm32(0xFC00FC00));           // RRRRRR__ ________ BBBBBB__ ________
-      AND(32, R(scratch1), Imm32(0x00FC00FC));           // ________ GGGGGG__ ________ AAAAAA__
-      OR(32, R(scratch1), R(scratch2));                  // RRRRRR__ GGGGGG__ BBBBBB__ AAAAAA__
-      MOV(32, R(scratch2), R(scratch1));
+    case FORMAT_24B_6666:
+      //          RRRRRRGG GGGGBBBB BBAAAAAA
+      // AAAAAAAA BBBBBBBB GGGGGGGG RRRRRRRR
+      data.AddMemOffset(-1);  // subtract one from address so we can use a 32bit load and bswap
+      LoadAndSwap(32, scratch1, data);
+      if (cpu_info.bBMI2)
+      {
+        MOV(32, R(scratch2), Imm32(0xFCFCFCFC));
+        PDEP(32, scratch1, scratch1, R(scratch2));
+        MOV(32, R(scratch2), R(scratch1));
+      }
+      else
+      {
+        LEA(32, scratch2, MScaled(scratch1, SCALE_4, 0));  // ______RR RRRRGGGG GGBBBBBB AAAAAA__
+        AND(32, R(scratch2), Imm32(0x00003FFC));           // ________ ________ __BBBBBB AAAAAA__
+        SHL(32, R(scratch1), Imm8(6));                     // __RRRRRR GGGGGGBB BBBBAAAA AA______
+        AND(32, R(scratch1), Imm32(0x3FFC0000));           // __RRRRRR GGGGGG__ ________ ________
+        OR(32, R(scratch1), R(scratch2));                  // __RRRRRR GGGGGG__ __BBBBBB AAAAAA__
+
+        LEA(32, scratch2, MScaled(scratch1, SCALE_4, 0));  // RRRRRRGG GGGG____ BBBBBBAA AAAA____
+        AND(32, R(scratch2), Imm32(0xFC00FC00));           // RRRRRR__ ________ BBBBBB__ ________
+        AND(32, R(scratch1), Imm32(0x00FC00FC));           // ________ GGGGGG__ ________ AAAAAA__
+        OR(32, R(scratch1), R(scratch2));                  // RRRRRR__ GGGGGG__ BBBBBB__ AAAAAA__
+        MOV(32, R(scratch2), R(scratch1));
+      }
+      SHR(32, R(scratch1), Imm8(6));
+      AND(32, R(scratch1), Imm32(0x03030303));
+      OR(32, R(scratch1), R(scratch2));
+      SwapAndStore(32, dest, scratch1);
+      load_bytes = 3;
+      break;
     }
-    SHR(32, R(scratch1), Imm8(6));
-    AND(32, R(scratch1), Imm32(0x03030303));
-    OR(32, R(scratch1), R(scratch2));
-    SwapAndStore(32, MDisp(dst_reg, m_dst_ofs), scratch1);
-    load_bytes = 3;
-    break;
   }
   if (attribute == DIRECT)
     m_src_ofs += load_bytes;
 }
 
-void VertexLoaderX64::GenerateVertexLoader()
+void VertexLoaderX64::GenerateVertex()
 {
-  BitSet32 regs = {src_reg,  dst_reg,   scratch1,    scratch2,
-                   scratch3, count_reg, skipped_reg, base_reg};
-  regs &= ABI_ALL_CALLEE_SAVED;
-  ABI_PushRegistersAndAdjustStack(regs, 0);
-
-  // Backup count since we're going to count it down.
-  PUSH(32, R(ABI_PARAM3));
-
-  // ABI_PARAM3 is one of the lower registers, so free it for scratch2.
-  MOV(32, R(count_reg), R(ABI_PARAM3));
-
-  MOV(64, R(base_reg), R(ABI_PARAM4));
-
-  if (m_VtxDesc.Position & MASK_INDEXED)
-    XOR(32, R(skipped_reg), R(skipped_reg));
-
-  // TODO: load constants into registers outside the main loop
-
-  const u8* loop_start = GetCodePtr();
+  const int num_vertices = m_pair ? 2 : 1;
+  OpArg data[2];
 
   if (m_VtxDesc.PosMatIdx)
   {
-    MOVZX(32, 8, scratch1, MDisp(src_reg, m_src_ofs));
-    AND(32, R(scratch1), Imm8(0x3F));
-    MOV(32, MDisp(dst_reg, m_dst_ofs), R(scratch1));
+    for (int i = 0; i < num_vertices; i++)
+    {
+      MOVZX(32, 8, scratch1, GetSrc(i, m_src_ofs));
+      AND(32, R(scratch1), Imm8(0x3F));
+      MOV(32, GetDst(i, m_dst_ofs), R(scratch1));
+    }
 
     // zfreeze
-    CMP(32, R(count_reg), Imm8(3));
-    FixupBranch dont_store = J_CC(CC_A);
-    MOV(32, MPIC(VertexLoaderManager::position_matrix_index, count_reg, SCALE_4), R(scratch1));
-    SetJumpTarget(dont_store);
+    if (!m_pair)
+    {
+      CMP(32, R(count_reg), Imm8(3));
+      FixupBranch dont_store = J_CC(CC_A);
+      MOV(32, MPIC(VertexLoaderManager::position_matrix_index, count_reg, SCALE_4), R(scratch1));
+      SetJumpTarget(dont_store);
+    }
 
     m_native_components |= VB_HAS_POSMTXIDX;
     m_native_vtx_decl.posmtx.components = 4;
@@ -439,7 +525,7 @@ void VertexLoaderX64::GenerateVertexLoader()
       texmatidx_ofs[i] = m_src_ofs++;
   }
 
-  OpArg data = GetVertexAddr(ARRAY_POSITION, m_VtxDesc.Position);
+  GetVertexAddr(ARRAY_POSITION, m_VtxDesc.Position, data);
   int pos_elements = 2 + m_VtxAttr.PosElements;
   ReadVertex(data, m_VtxDesc.Position, m_VtxAttr.PosFormat, pos_elements, pos_elements,
              m_VtxAttr.ByteDequant, m_VtxAttr.PosFrac, &m_native_vtx_decl.position);
@@ -453,12 +539,15 @@ void VertexLoaderX64::GenerateVertexLoader()
     {
       if (!i || m_VtxAttr.NormalIndex3)
       {
-        data = GetVertexAddr(ARRAY_NORMAL, m_VtxDesc.Normal);
+        GetVertexAddr(ARRAY_NORMAL, m_VtxDesc.Normal, data);
         int elem_size = 1 << (m_VtxAttr.NormalFormat / 2);
-        data.AddMemOffset(i * elem_size * 3);
+        for (int j = 0; j < num_vertices; j++)
+          data[j].AddMemOffset(i * elem_size * 3);
       }
-      data.AddMemOffset(ReadVertex(data, m_VtxDesc.Normal, m_VtxAttr.NormalFormat, 3, 3, true,
-                                   scaling_exponent, &m_native_vtx_decl.normals[i]));
+      int load_bytes = ReadVertex(data, m_VtxDesc.Normal, m_VtxAttr.NormalFormat, 3, 3, true,
+                                  scaling_exponent, &m_native_vtx_decl.normals[i]);
+      for (int j = 0; j < num_vertices; j++)
+        data[j].AddMemOffset(load_bytes);
     }
 
     m_native_components |= VB_HAS_NRM0;
@@ -471,7 +560,7 @@ void VertexLoaderX64::GenerateVertexLoader()
   {
     if (col[i])
     {
-      data = GetVertexAddr(ARRAY_COLOR + i, col[i]);
+      GetVertexAddr(ARRAY_COLOR + i, col[i], data);
       ReadColor(data, col[i], m_VtxAttr.color[i].Comp);
       m_native_components |= VB_HAS_COL0 << i;
       m_native_vtx_decl.colors[i].components = 4;
@@ -492,7 +581,7 @@ void VertexLoaderX64::GenerateVertexLoader()
     int elements = m_VtxAttr.texCoord[i].Elements + 1;
     if (tc[i])
     {
-      data = GetVertexAddr(ARRAY_TEXCOORD0 + i, tc[i]);
+      GetVertexAddr(ARRAY_TEXCOORD0 + i, tc[i], data);
       u8 scaling_exponent = m_VtxAttr.texCoord[i].Frac;
       ReadVertex(data, tc[i], m_VtxAttr.texCoord[i].Format, elements, tm[i] ? 2 : elements,
                  m_VtxAttr.ByteDequant, scaling_exponent, &m_native_vtx_decl.texcoords[i]);
@@ -505,24 +594,66 @@ void VertexLoaderX64::GenerateVertexLoader()
       m_native_vtx_decl.texcoords[i].enable = true;
       m_native_vtx_decl.texcoords[i].type = VAR_FLOAT;
       m_native_vtx_decl.texcoords[i].integer = false;
-      MOVZX(64, 8, scratch1, MDisp(src_reg, texmatidx_ofs[i]));
-      if (tc[i])
-      {
-        CVTSI2SS(XMM0, R(scratch1));
-        MOVSS(MDisp(dst_reg, m_dst_ofs), XMM0);
-        m_dst_ofs += sizeof(float);
-      }
-      else
-      {
+      if (!tc[i])
         m_native_vtx_decl.texcoords[i].offset = m_dst_ofs;
-        PXOR(XMM0, R(XMM0));
-        CVTSI2SS(XMM0, R(scratch1));
-        SHUFPS(XMM0, R(XMM0), 0x45);  // 000X -> 0X00
-        MOVUPS(MDisp(dst_reg, m_dst_ofs), XMM0);
-        m_dst_ofs += sizeof(float) * 3;
+      for (int j = 0; j < num_vertices; j++)
+      {
+        MOVZX(64, 8, scratch1, GetSrc(j, texmatidx_ofs[i]));
+        if (tc[i])
+        {
+          CVTSI2SS(XMM0, R(scratch1));
+          StoreFloats(j, m_dst_ofs, XMM0, 1);
+        }
+        else
+        {
+          PXOR(XMM0, R(XMM0));
+          CVTSI2SS(XMM0, R(scratch1));
+          SHUFPS(XMM0, R(XMM0), 0x45);  // 000X -> 0X00
+          StoreFloats(j, m_dst_ofs, XMM0, 3);
+        }
       }
+      m_dst_ofs += sizeof(float) * (tc[i] ? 1 : 3);
     }
   }
+}
+
+void VertexLoaderX64::GenerateVertexLoader()
+{
+  // Long runs of vertices are converted two at a time with 256-bit AVX2 operations. The last few
+  // vertices and any skipped ones always go through the single vertex loop, which handles them.
+  const bool use_pairs = cpu_info.bAVX2;
+
+  BitSet32 regs = {src_reg,  dst_reg,   scratch1,    scratch2,
+                   scratch3, count_reg, skipped_reg, base_reg};
+  if (use_pairs)
+    regs |= BitSet32{pair_scratch1, pair_scratch2};
+  regs &= ABI_ALL_CALLEE_SAVED;
+  ABI_PushRegistersAndAdjustStack(regs, 0);
+
+  // Backup count since we're going to count it down.
+  PUSH(32, R(ABI_PARAM3));
+
+  // ABI_PARAM3 is one of the lower registers, so free it for scratch2.
+  MOV(32, R(count_reg), R(ABI_PARAM3));
+
+  MOV(64, R(base_reg), R(ABI_PARAM4));
+
+  if (m_VtxDesc.Position & MASK_INDEXED)
+    XOR(32, R(skipped_reg), R(skipped_reg));
+
+  // TODO: load constants into registers outside the main loop
+
+  const u8* loop_start = GetCodePtr();
+
+  FixupBranch convert_pair;
+  if (use_pairs)
+  {
+    CMP(32, R(count_reg), Imm8(5));
+    convert_pair = J_CC(CC_AE, true);
+  }
+
+  m_single_vertex_loop = GetCodePtr();
+  GenerateVertex();
 
   // Prepare for the next vertex.
   ADD(64, R(dst_reg), Imm32(m_dst_ofs));
@@ -553,6 +684,22 @@ void VertexLoaderX64::GenerateVertexLoader()
 
   m_VertexSize = m_src_ofs;
   m_native_vtx_decl.stride = m_dst_ofs;
+
+  if (use_pairs)
+  {
+    SetJumpTarget(convert_pair);
+    m_pair = true;
+    m_src_ofs = 0;
+    m_dst_ofs = 0;
+    GenerateVertex();
+    m_pair = false;
+
+    ADD(64, R(dst_reg), Imm32(2 * m_dst_ofs));
+    ADD(64, R(src_reg), Imm32(2 * m_src_ofs));
+    // At least three vertices are left, so the count can't reach zero here.
+    SUB(32, R(count_reg), Imm8(2));
+    JMP(loop_start, true);
+  }
 }
 
 int VertexLoaderX64::RunVertices(DataReader src, DataReader dst, int count)
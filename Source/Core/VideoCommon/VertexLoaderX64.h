@@ -19,10 +19,18 @@ protected:
 private:
   u32 m_src_ofs = 0;
   u32 m_dst_ofs = 0;
+  // Whether the code being generated converts two vertices at once (with AVX2), in which case
+  // the functions below take and return the attribute addresses of both.
+  bool m_pair = false;
   Gen::FixupBranch m_skip_vertex;
-  Gen::OpArg GetVertexAddr(int array, u64 attribute);
-  int ReadVertex(Gen::OpArg data, u64 attribute, int format, int count_in, int count_out,
+  const u8* m_single_vertex_loop = nullptr;
+  Gen::OpArg GetSrc(int vertex, u32 offset) const;
+  Gen::OpArg GetDst(int vertex, u32 offset) const;
+  void GetVertexAddr(int array, u64 attribute, Gen::OpArg* data);
+  int ReadVertex(const Gen::OpArg* data, u64 attribute, int format, int count_in, int count_out,
                  bool dequantize, u8 scaling_exponent, AttributeFormat* native_format);
-  void ReadColor(Gen::OpArg data, u64 attribute, int format);
+  void ReadColor(const Gen::OpArg* data, u64 attribute, int format);
+  void StoreFloats(int vertex, u32 offset, Gen::X64Reg reg, int count);
+  void GenerateVertex();
   void GenerateVertexLoader();
 };
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <memory>
 
 #include "Common/BitSet.h"
@@ -27,6 +28,7 @@
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/SamplerCommon.h"
+#include "VideoCommon/StageTimings.h"
 #include "VideoCommon/TextureCacheBase.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexShaderManager.h"
@@ -143,6 +145,12 @@ void VertexManagerBase::FlushData(u32 count, u32 stride)
   m_cur_buffer_pointer += count * stride;
 }
 
+void VertexManagerBase::SetZSlopeVertices(const float positions[3][4], const u32 matrix_indices[4])
+{
+  std::memcpy(m_zslope_positions, positions, sizeof(m_zslope_positions));
+  std::memcpy(m_zslope_matrix_indices, matrix_indices, sizeof(m_zslope_matrix_indices));
+}
+
 u32 VertexManagerBase::GetRemainingIndices(int primitive)
 {
   u32 index_len = MAXIBUFFERSIZE - IndexGenerator::GetIndexLen();
@@ -274,6 +282,8 @@ void VertexManagerBase::Flush()
   if (m_is_flushed)
     return;
 
+  StageTimings::ScopedTimer timer(StageTimings::Stage::Flush);
+
   // loading a state will invalidate BP, so check for it
   g_video_backend->CheckInvalidState();
 
@@ -443,13 +453,12 @@ void VertexManagerBase::CalculateZSlope(NativeVertexFormat* format)
   {
     // If this vertex format has per-vertex position matrix IDs, look it up.
     if (vert_decl.posmtx.enable)
-      mtxIdx = VertexLoaderManager::position_matrix_index[3 - i];
+      mtxIdx = m_zslope_matrix_indices[3 - i];
 
     if (vert_decl.position.components == 2)
-      VertexLoaderManager::position_cache[2 - i][2] = 0;
+      m_zslope_positions[2 - i][2] = 0;
 
-    VertexShaderManager::TransformToClipSpace(&VertexLoaderManager::position_cache[2 - i][0],
-                                              &out[i * 4], mtxIdx);
+    VertexShaderManager::TransformToClipSpace(&m_zslope_positions[2 - i][0], &out[i * 4], mtxIdx);
 
     // Transform to Screenspace
     float inv_w = 1.0f / out[3 + i * 4];
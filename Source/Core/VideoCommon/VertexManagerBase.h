@@ -50,6 +50,10 @@ public:
   DataReader PrepareForAdditionalData(int primitive, u32 count, u32 stride, bool cullall);
   void FlushData(u32 count, u32 stride);
 
+  // Stores the positions and position matrix indices of the last three vertices that were added,
+  // in the layout of VertexLoaderManager::position_cache, for the z slope calculation of zfreeze.
+  void SetZSlopeVertices(const float positions[3][4], const u32 matrix_indices[4]);
+
   void Flush();
 
   virtual std::unique_ptr<NativeVertexFormat>
@@ -81,6 +85,8 @@ protected:
   static u32 GetRemainingIndices(int primitive);
 
   Slope m_zslope = {};
+  float m_zslope_positions[3][4] = {};
+  u32 m_zslope_matrix_indices[4] = {};
   void CalculateZSlope(NativeVertexFormat* format);
 
   VideoCommon::GXPipelineUid m_current_pipeline_config;
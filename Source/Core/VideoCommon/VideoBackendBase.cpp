@@ -31,6 +31,7 @@
 #include "VideoCommon/BPStructs.h"
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/CommandProcessor.h"
+#include "VideoCommon/DisplayListCache.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/IndexGenerator.h"
@@ -296,6 +297,10 @@ void VideoBackendBase::InitializeShared()
 
   g_Config.Refresh();
   UpdateActiveConfig();
+
+  // Compile the vertex loaders the game used last time up front, rather than mid-frame.
+  if (g_ActiveConfig.bShaderCache)
+    VertexLoaderManager::LoadVertexLoaderCache();
 }
 
 void VideoBackendBase::ShutdownShared()
@@ -305,6 +310,7 @@ void VideoBackendBase::ShutdownShared()
 
   m_initialized = false;
 
+  DisplayListCache::Clear();
   VertexLoaderManager::Clear();
   Fifo::Shutdown();
 }
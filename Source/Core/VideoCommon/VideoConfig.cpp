@@ -106,6 +106,8 @@ void VideoConfig::Refresh()
   iShaderCompilationMode = Config::Get(Config::GFX_SHADER_COMPILATION_MODE);
   iShaderCompilerThreads = Config::Get(Config::GFX_SHADER_COMPILER_THREADS);
   iShaderPrecompilerThreads = Config::Get(Config::GFX_SHADER_PRECOMPILER_THREADS);
+  bPipelinedCommandDecoding = Config::Get(Config::GFX_PIPELINED_COMMAND_DECODING);
+  bCacheDisplayLists = Config::Get(Config::GFX_CACHE_DISPLAY_LISTS);
 
   bZComploc = Config::Get(Config::GFX_SW_ZCOMPLOC);
   bZFreeze = Config::Get(Config::GFX_SW_ZFREEZE);
@@ -171,6 +171,13 @@ struct VideoConfig final
   int iShaderCompilerThreads;
   int iShaderPrecompilerThreads;
 
+  // Decode the FIFO on a separate thread in dual core mode, see CommandPipeline.
+  bool bPipelinedCommandDecoding;
+
+  // Keep the converted vertices of display lists to skip the vertex loader when they are called
+  // again, see DisplayListCache.
+  bool bCacheDisplayLists;
+
   // Static config per API
   // TODO: Move this out of VideoConfig
   struct
@@ -293,4 +293,6 @@ extern XFMemory xfmem;
 
 void LoadXFReg(u32 transferSize, u32 address, DataReader src);
 void LoadIndexedXF(u32 val, int array);
+// Same as LoadIndexedXF, with the (big endian) array data already looked up.
+void LoadIndexedXFData(u32 val, const u32* data);
 void PreprocessIndexedXF(u32 val, int refarray);
@@ -257,11 +257,9 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, DataReader src)
 void LoadIndexedXF(u32 val, int refarray)
 {
   int index = val >> 16;
-  int address = val & 0xFFF;  // check mask
   int size = ((val >> 12) & 0xF) + 1;
   // load stuff from array to address in xf mem
 
-  u32* currData = (u32*)(&xfmem) + address;
   u32* newData;
   if (Fifo::UseDeterministicGPUThread())
   {
@@ -272,6 +270,15 @@ void LoadIndexedXF(u32 val, int refarray)
     newData = (u32*)Memory::GetPointer(g_main_cp_state.array_bases[refarray] +
                                        g_main_cp_state.array_strides[refarray] * index);
   }
+  LoadIndexedXFData(val, newData);
+}
+
+void LoadIndexedXFData(u32 val, const u32* newData)
+{
+  int address = val & 0xFFF;  // check mask
+  int size = ((val >> 12) & 0xF) + 1;
+
+  u32* currData = (u32*)(&xfmem) + address;
   bool changed = false;
   for (int i = 0; i < size; ++i)
   {
@@ -0,0 +1,101 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/PipelineUIDLog.h"
+
+// Merges the pipeline UID logs (User/Cache/<game ID>.uidlog) of several play sessions, so that
+// a single log covering all of them can be distributed or kept.
+
+static bool IsHelpFlag(const std::string& argument)
+{
+  return argument == "--help" || argument == "-?";
+}
+
+int main(int argc, const char* argv[])
+{
+  if (argc == 1 || (argc == 2 && IsHelpFlag(argv[1])))
+  {
+    printf("USAGE: PipelineLogTool [-?] [--help] [-i] -o <OUTPUT FILE> <INPUT FILES>\n");
+    printf("-? / --help: Prints this message\n");
+    printf("-i: Print the contents of the input files (does not require an output file)\n");
+    printf("-o <OUTPUT FILE>: Writes the merged log to a file\n");
+    return 0;
+  }
+
+  std::string output_name;
+  std::vector<std::string> input_names;
+  bool print_info = false;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "-o" && i + 1 < argc)
+      output_name = argv[++i];
+    else if (argument == "-i")
+      print_info = true;
+    else
+      input_names.push_back(argument);
+  }
+
+  if (input_names.empty() || (output_name.empty() && !print_info))
+  {
+    printf("ERROR: Need at least one input file and an output file.\n");
+    return 1;
+  }
+
+  VideoCommon::PipelineUIDLog merged;
+  for (const std::string& input_name : input_names)
+  {
+    VideoCommon::PipelineUIDLog log;
+    if (!log.Load(input_name))
+    {
+      printf("ERROR: %s is not a pipeline UID log.\n", input_name.c_str());
+      return 1;
+    }
+
+    if (print_info)
+    {
+      printf("%s: version %u, %zu pipelines, %zu vertex formats, %zu vertex shaders, "
+             "%zu geometry shaders, %zu pixel shaders\n",
+             input_name.c_str(), log.GetVersion(), log.GetPipelines().size(),
+             log.GetPartCount(VideoCommon::PipelineUIDLog::PART_VERTEX_FORMAT),
+             log.GetPartCount(VideoCommon::PipelineUIDLog::PART_VERTEX_SHADER),
+             log.GetPartCount(VideoCommon::PipelineUIDLog::PART_GEOMETRY_SHADER),
+             log.GetPartCount(VideoCommon::PipelineUIDLog::PART_PIXEL_SHADER));
+    }
+
+    // Logs from different UID versions describe different shaders, so they can't be mixed.
+    if (&input_name == &input_names.front())
+    {
+      merged.Load(input_name);
+    }
+    else if (log.GetVersion() != merged.GetVersion())
+    {
+      printf("ERROR: %s has UID version %u, expected %u.\n", input_name.c_str(), log.GetVersion(),
+             merged.GetVersion());
+      return 1;
+    }
+    else
+    {
+      merged.Merge(log);
+    }
+  }
+
+  if (output_name.empty())
+    return 0;
+
+  if (!merged.Save(output_name))
+  {
+    printf("ERROR: Failed to write %s.\n", output_name.c_str());
+    return 1;
+  }
+
+  printf("Wrote %zu pipelines from %zu logs to %s.\n", merged.GetPipelines().size(),
+         input_names.size(), output_name.c_str());
+  return 0;
+}
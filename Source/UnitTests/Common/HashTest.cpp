@@ -0,0 +1,68 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+
+namespace
+{
+std::vector<u8> MakeData(size_t size)
+{
+  std::vector<u8> data(size);
+  std::mt19937 rng(size);
+  std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+  return data;
+}
+}  // namespace
+
+TEST(Hash, GetHash64IsDeterministic)
+{
+  Common::SetHash64Function();
+  for (u32 size : {8u, 64u, 100u, 1024u, 4096u, 5000u})
+  {
+    const std::vector<u8> data = MakeData(size);
+    const std::vector<u8> copy = data;
+    EXPECT_EQ(Common::GetHash64(data.data(), size, 0), Common::GetHash64(copy.data(), size, 0));
+  }
+}
+
+TEST(Hash, GetHash64DetectsChangedBytes)
+{
+  Common::SetHash64Function();
+  for (u32 size : {64u, 100u, 1024u, 4096u, 5000u})
+  {
+    std::vector<u8> data = MakeData(size);
+    const u64 hash = Common::GetHash64(data.data(), size, 0);
+
+    for (u32 offset : {0u, 1u, 63u, 64u, size / 2, size - 1})
+    {
+      if (offset >= size)
+        continue;
+
+      data[offset] ^= 0x10;
+      EXPECT_NE(hash, Common::GetHash64(data.data(), size, 0)) << size << " " << offset;
+      data[offset] ^= 0x10;
+    }
+  }
+}
+
+TEST(Hash, GetHash64DetectsReorderedData)
+{
+  Common::SetHash64Function();
+
+  // Swap two 64-byte chunks within a 1 KiB block and across blocks.
+  for (u32 second : {64u, 128u, 1024u, 2048u})
+  {
+    std::vector<u8> data = MakeData(4096);
+    const u64 hash = Common::GetHash64(data.data(), 4096, 0);
+    std::swap_ranges(data.begin(), data.begin() + 64, data.begin() + second);
+    EXPECT_NE(hash, Common::GetHash64(data.data(), 4096, 0)) << second;
+  }
+}
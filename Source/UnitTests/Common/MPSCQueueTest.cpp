@@ -0,0 +1,75 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/MPSCQueue.h"
+
+TEST(MPSCQueue, Simple)
+{
+  Common::MPSCQueue<u32> q;
+
+  EXPECT_TRUE(q.Empty());
+  u32 v;
+  EXPECT_FALSE(q.Pop(v));
+
+  q.Push(1);
+  EXPECT_FALSE(q.Empty());
+  EXPECT_TRUE(q.Pop(v));
+  EXPECT_EQ(1u, v);
+  EXPECT_TRUE(q.Empty());
+
+  // Test the FIFO order.
+  for (u32 i = 0; i < 1000; ++i)
+    q.Push(i);
+  for (u32 i = 0; i < 1000; ++i)
+  {
+    EXPECT_TRUE(q.Pop(v));
+    EXPECT_EQ(i, v);
+  }
+  EXPECT_TRUE(q.Empty());
+
+  // Leftover elements are freed with the queue.
+  for (u32 i = 0; i < 1000; ++i)
+    q.Push(i);
+}
+
+TEST(MPSCQueue, MultiThreaded)
+{
+  constexpr u32 NUM_PRODUCERS = 4;
+  constexpr u32 COUNT = 100000;
+  Common::MPSCQueue<u32> q;
+
+  std::vector<std::thread> producers;
+  for (u32 producer = 0; producer < NUM_PRODUCERS; ++producer)
+  {
+    producers.emplace_back([&q, producer] {
+      for (u32 i = 0; i < COUNT; ++i)
+        q.Push(producer * COUNT + i);
+    });
+  }
+
+  // Elements of different producers may interleave, but each producer's stay in order.
+  std::array<u32, NUM_PRODUCERS> next{};
+  for (u32 popped = 0; popped < NUM_PRODUCERS * COUNT;)
+  {
+    u32 v;
+    if (!q.Pop(v))
+      continue;
+
+    const u32 producer = v / COUNT;
+    ASSERT_LT(producer, NUM_PRODUCERS);
+    EXPECT_EQ(next[producer], v % COUNT);
+    next[producer] = v % COUNT + 1;
+    ++popped;
+  }
+
+  for (std::thread& producer : producers)
+    producer.join();
+  EXPECT_TRUE(q.Empty());
+}
@@ -0,0 +1,48 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "Common/ParallelFor.h"
+
+TEST(ParallelFor, VisitsEveryIndexOnce)
+{
+  for (size_t num_threads : {1, 2, 4, 16})
+  {
+    std::vector<std::atomic<int>> visits(1000);
+    Common::ParallelFor(visits.size(), [&](size_t i) { visits[i]++; }, num_threads);
+
+    for (const std::atomic<int>& count : visits)
+      EXPECT_EQ(1, count.load());
+  }
+}
+
+TEST(ParallelFor, EmptyRange)
+{
+  bool called = false;
+  Common::ParallelFor(0, [&](size_t) { called = true; }, 4);
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelFor, NestedAndConcurrentCalls)
+{
+  std::vector<std::atomic<int>> visits(64 * 64);
+  const auto visit_all = [&](size_t offset) {
+    const auto visit_row = [&](size_t i) {
+      Common::ParallelFor(32, [&](size_t j) { visits[offset + i * 64 + j]++; }, 4);
+    };
+    Common::ParallelFor(64, visit_row, 4);
+  };
+
+  // Two callers share the pool, and the inner calls run on its threads.
+  std::thread other_caller(visit_all, 32);
+  visit_all(0);
+  other_caller.join();
+
+  for (const std::atomic<int>& count : visits)
+    EXPECT_EQ(1, count.load());
+}
@@ -1018,6 +1018,81 @@ AVX_RRM_TEST(VPANDN, "dqword")
 AVX_RRM_TEST(VPOR, "dqword")
 AVX_RRM_TEST(VPXOR, "dqword")
 
+// for 256-bit AVX instructions that take the form op reg, reg, r/m
+#define AVX_256_RRM_TEST(Name, mnemonic)                                                           \
+  TEST_F(x64EmitterTest, Name)                                                                     \
+  {                                                                                                \
+    for (const auto& r : ymmnames)                                                                 \
+    {                                                                                              \
+      emitter->Name(r.reg, YMM0, R(YMM0));                                                         \
+      emitter->Name(YMM0, YMM0, R(r.reg));                                                         \
+      emitter->Name(YMM0, r.reg, MatR(R12));                                                       \
+      ExpectDisassembly(mnemonic " " + r.name + ", ymm0, ymm0 " mnemonic " ymm0, ymm0, " +         \
+                        r.name + " " mnemonic " ymm0, " + r.name + ", qqword ptr ds:[r12] ");       \
+    }                                                                                              \
+  }
+
+AVX_256_RRM_TEST(VMULPS_256, "vmulps")
+AVX_256_RRM_TEST(VPSHUFB_256, "vpshufb")
+
+TEST_F(x64EmitterTest, VCVTDQ2PS_256)
+{
+  for (const auto& r : ymmnames)
+  {
+    emitter->VCVTDQ2PS_256(r.reg, R(YMM0));
+    emitter->VCVTDQ2PS_256(YMM0, MatR(R12));
+    ExpectDisassembly("vcvtdq2ps " + r.name + ", ymm0 vcvtdq2ps ymm0, qqword ptr ds:[r12]");
+  }
+}
+
+TEST_F(x64EmitterTest, VPSRAD_256)
+{
+  for (const auto& r : ymmnames)
+  {
+    emitter->VPSRAD_256(r.reg, YMM0, 24);
+    emitter->VPSRAD_256(YMM0, r.reg, 16);
+    ExpectDisassembly("vpsrad " + r.name + ", ymm0, 0x18 vpsrad ymm0, " + r.name + ", 0x10");
+  }
+}
+
+// Bochs prints the 128-bit operands of these with the size of the 256-bit ones.
+TEST_F(x64EmitterTest, VBROADCASTI128)
+{
+  for (const auto& r : ymmnames)
+  {
+    emitter->VBROADCASTI128(r.reg, MatR(R12));
+    ExpectDisassembly("vbroadcasti128 " + r.name + ", qqword ptr ds:[r12]");
+  }
+}
+
+TEST_F(x64EmitterTest, VINSERTI128)
+{
+  for (const auto& r : ymmnames)
+  {
+    emitter->VINSERTI128(r.reg, YMM0, R(XMM0), 1);
+    emitter->VINSERTI128(YMM0, r.reg, MatR(R12), 0);
+    ExpectDisassembly("vinserti128 " + r.name + ", ymm0, ymm0, 0x01 vinserti128 ymm0, " +
+                      r.name + ", qqword ptr ds:[r12], 0x00");
+  }
+}
+
+TEST_F(x64EmitterTest, VEXTRACTI128)
+{
+  for (const auto& r : ymmnames)
+  {
+    emitter->VEXTRACTI128(R(r.reg), YMM0, 1);
+    emitter->VEXTRACTI128(MatR(R12), r.reg, 0);
+    ExpectDisassembly("vextracti128 " + r.name + ", ymm0, 0x01 vextracti128 qqword ptr ds:[r12], " +
+                      r.name + ", 0x00");
+  }
+}
+
+TEST_F(x64EmitterTest, VZEROUPPER)
+{
+  emitter->VZEROUPPER();
+  ExpectDisassembly("vzeroupper");
+}
+
 #define FMA3_TEST(Name, P, packed)                                                                 \
   AVX_RRM_TEST(Name##132##P##S, packed ? "dqword" : "dword")                                       \
   AVX_RRM_TEST(Name##213##P##S, packed ? "dqword" : "dword")                                       \
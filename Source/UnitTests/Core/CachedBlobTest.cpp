@@ -0,0 +1,171 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CachedBlob.h"
+
+namespace
+{
+class MemoryBlobReader final : public DiscIO::BlobReader
+{
+public:
+  // on_read is called with the offset of every read before it is done.
+  MemoryBlobReader(std::vector<u8> data, std::atomic<u32>* read_count,
+                   std::function<void(u64)> on_read = nullptr)
+      : m_data(std::move(data)), m_read_count(read_count), m_on_read(std::move(on_read))
+  {
+  }
+
+  DiscIO::BlobType GetBlobType() const override { return DiscIO::BlobType::PLAIN; }
+  u64 GetRawSize() const override { return m_data.size(); }
+  u64 GetDataSize() const override { return m_data.size(); }
+
+  bool Read(u64 offset, u64 size, u8* out_ptr) override
+  {
+    ++*m_read_count;
+    if (m_on_read)
+      m_on_read(offset);
+    if (offset + size > m_data.size())
+      return false;
+    std::memcpy(out_ptr, m_data.data() + offset, size);
+    return true;
+  }
+
+private:
+  std::vector<u8> m_data;
+  std::atomic<u32>* m_read_count;
+  std::function<void(u64)> m_on_read;
+};
+
+std::vector<u8> MakeData(size_t size)
+{
+  std::vector<u8> data(size);
+  std::iota(data.begin(), data.end(), u8(0));
+  return data;
+}
+}  // namespace
+
+TEST(CachedBlob, ReadsMatchUnderlyingData)
+{
+  const std::vector<u8> data = MakeData(1000);
+  std::atomic<u32> read_count{0};
+  auto reader = DiscIO::CachedBlobReader::Create(
+      std::make_unique<MemoryBlobReader>(data, &read_count), 64, 4, 0);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ(1000u, reader->GetDataSize());
+
+  // Reads spanning several blocks, including the partial last block.
+  for (u64 offset : {0, 10, 63, 100, 500, 900})
+  {
+    std::vector<u8> out(100);
+    ASSERT_TRUE(reader->Read(offset, out.size(), out.data()));
+    EXPECT_EQ(0, std::memcmp(data.data() + offset, out.data(), out.size()));
+  }
+
+  u8 byte;
+  EXPECT_FALSE(reader->Read(999, 2, &byte));
+  EXPECT_TRUE(reader->Read(999, 1, &byte));
+  EXPECT_EQ(data[999], byte);
+}
+
+TEST(CachedBlob, RepeatedReadsAreCached)
+{
+  std::atomic<u32> read_count{0};
+  auto reader = DiscIO::CachedBlobReader::Create(
+      std::make_unique<MemoryBlobReader>(MakeData(1024), &read_count), 256, 3, 0);
+
+  u8 out[16];
+  ASSERT_TRUE(reader->Read(0, sizeof(out), out));
+  ASSERT_TRUE(reader->Read(16, sizeof(out), out));
+  ASSERT_TRUE(reader->Read(0, sizeof(out), out));
+  EXPECT_EQ(1u, read_count);
+
+  // Filling the cache evicts the least recently used block.
+  std::vector<u8> rest(768);
+  ASSERT_TRUE(reader->Read(256, rest.size(), rest.data()));
+  EXPECT_EQ(4u, read_count);
+  ASSERT_TRUE(reader->Read(512, sizeof(out), out));
+  EXPECT_EQ(4u, read_count);
+  ASSERT_TRUE(reader->Read(0, sizeof(out), out));
+  EXPECT_EQ(5u, read_count);
+}
+
+TEST(CachedBlob, SequentialReadsArePrefetched)
+{
+  const std::vector<u8> data = MakeData(64 * 64);
+  std::atomic<u32> read_count{0};
+  auto reader = DiscIO::CachedBlobReader::Create(
+      std::make_unique<MemoryBlobReader>(data, &read_count), 64, 64, 8);
+
+  std::vector<u8> out(data.size());
+  for (u64 offset = 0; offset < data.size(); offset += 32)
+    ASSERT_TRUE(reader->Read(offset, 32, out.data() + offset));
+  EXPECT_EQ(data, out);
+
+  // Every block is read from the underlying reader exactly once, whichever thread loaded it.
+  reader.reset();
+  EXPECT_EQ(64u, read_count);
+}
+
+TEST(CachedBlob, RandomAccessesUseASmallCache)
+{
+  constexpr u64 NUM_BLOCKS = DiscIO::CachedBlobReader::RANDOM_ACCESS_CACHED_BLOCKS + 1;
+  std::atomic<u32> read_count{0};
+  auto reader = DiscIO::CachedBlobReader::Create(
+      std::make_unique<MemoryBlobReader>(MakeData(64 * 64), &read_count), 64, 64, 0);
+
+  // Every other block, so that the accesses are never sequential.
+  u8 byte;
+  for (u64 block = 0; block < NUM_BLOCKS; ++block)
+    ASSERT_TRUE(reader->Read(block * 128, 1, &byte));
+  EXPECT_EQ(NUM_BLOCKS, read_count);
+
+  ASSERT_TRUE(reader->Read(0, 1, &byte));
+  EXPECT_EQ(NUM_BLOCKS + 1, read_count);
+}
+
+TEST(CachedBlob, SeeksDropQueuedPrefetches)
+{
+  const std::vector<u8> data = MakeData(64 * 64);
+  std::atomic<u32> read_count{0};
+  Common::Event prefetch_started;
+  Common::Event seek_done;
+  // Holds up the first prefetched block until the reader has seeked away.
+  auto on_read = [&](u64 offset) {
+    if (offset == 3 * 64)
+    {
+      prefetch_started.Set();
+      seek_done.Wait();
+    }
+  };
+  auto reader = DiscIO::CachedBlobReader::Create(
+      std::make_unique<MemoryBlobReader>(data, &read_count, on_read), 64, 64, 8);
+
+  u8 byte;
+  ASSERT_TRUE(reader->Read(40 * 64, 1, &byte));
+  // Reading blocks 0 to 2 starts prefetching blocks 3 to 10.
+  for (u64 block = 0; block < 3; ++block)
+    ASSERT_TRUE(reader->Read(block * 64, 1, &byte));
+  prefetch_started.Wait();
+
+  // The block is cached, so this doesn't have to wait for the prefetch thread.
+  ASSERT_TRUE(reader->Read(40 * 64, 1, &byte));
+  EXPECT_EQ(data[40 * 64], byte);
+  seek_done.Set();
+
+  // Blocks 4 to 10 were queued before the seek, and are never read.
+  reader.reset();
+  EXPECT_EQ(5u, read_count);
+}
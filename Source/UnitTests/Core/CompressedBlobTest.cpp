@@ -0,0 +1,97 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CompressedBlob.h"
+
+namespace
+{
+bool Callback(const std::string& text, float percent, void* arg)
+{
+  return true;
+}
+
+class CompressedBlobTest : public testing::Test
+{
+protected:
+  CompressedBlobTest() : m_dir{File::CreateTempDir()} {}
+  virtual ~CompressedBlobTest() { File::DeleteDirRecursively(m_dir); }
+
+  std::string GetPath(const std::string& name) const { return m_dir + DIR_SEP + name; }
+
+  std::string m_dir;
+};
+
+// Zeroes, text-like data and incompressible noise, so that both compressed and stored blocks are
+// produced. The size isn't a multiple of the block size to exercise the padded final block.
+std::vector<u8> MakeImage()
+{
+  constexpr size_t BLOCK_SIZE = 0x4000;
+  std::vector<u8> data(BLOCK_SIZE * 77 + 1234);
+  std::mt19937 rng(1234);
+  for (size_t i = 0; i < data.size(); ++i)
+  {
+    switch ((i / BLOCK_SIZE) % 3)
+    {
+    case 0:
+      data[i] = 0;
+      break;
+    case 1:
+      data[i] = static_cast<u8>('a' + i % 7);
+      break;
+    default:
+      data[i] = static_cast<u8>(rng());
+      break;
+    }
+  }
+  return data;
+}
+}  // namespace
+
+TEST_F(CompressedBlobTest, RoundTrip)
+{
+  const std::vector<u8> data = MakeImage();
+  const std::string plain_path = GetPath("plain.iso");
+  const std::string gcz_path = GetPath("compressed.gcz");
+  const std::string decompressed_path = GetPath("decompressed.iso");
+
+  ASSERT_TRUE(File::IOFile(plain_path, "wb").WriteBytes(data.data(), data.size()));
+  ASSERT_TRUE(DiscIO::CompressFileToBlob(plain_path, gcz_path, 0, 0x4000, Callback, nullptr));
+  EXPECT_LT(File::GetSize(gcz_path), data.size());
+
+  std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(gcz_path);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ(DiscIO::BlobType::GCZ, reader->GetBlobType());
+
+  ASSERT_EQ(data.size(), reader->GetDataSize());
+  std::vector<u8> read_data(data.size());
+  ASSERT_TRUE(reader->Read(0, read_data.size(), read_data.data()));
+  EXPECT_EQ(data, read_data);
+
+  // Random access into the middle of a block.
+  ASSERT_TRUE(reader->Read(0x4000 * 40 + 100, 0x5000, read_data.data()));
+  EXPECT_TRUE(std::equal(read_data.begin(), read_data.begin() + 0x5000,
+                         data.begin() + 0x4000 * 40 + 100));
+  reader.reset();
+
+  ASSERT_TRUE(DiscIO::DecompressBlobToFile(gcz_path, decompressed_path, Callback, nullptr));
+  std::string decompressed;
+  ASSERT_TRUE(File::ReadFileToString(decompressed_path, decompressed));
+  // The decompressed file is padded to a whole number of blocks.
+  ASSERT_GE(decompressed.size(), data.size());
+  EXPECT_TRUE(std::equal(data.begin(), data.end(), decompressed.begin(),
+                         [](u8 a, char b) { return a == static_cast<u8>(b); }));
+}
@@ -4,15 +4,24 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "Common/ChunkFile.h"
 #include "Common/Config/Config.h"
 #include "Common/FileUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/CoreTimingWheel.h"
 #include "Core/PowerPC/PowerPC.h"
 #include "UICommon/UICommon.h"
 
@@ -347,3 +356,384 @@ TEST(CoreTiming, Overclocking)
   SConfig::GetInstance().m_OCFactor = 1.0;
   AdvanceAndCheck(4, MAX_SLICE_LENGTH);
 }
+
+TEST(CoreTiming, SaveState)
+{
+  ScopeInit guard;
+
+  CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+  CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", CallbackTemplate<1>);
+  CoreTiming::EventType* cb_c = CoreTiming::RegisterEvent("callbackC", CallbackTemplate<2>);
+
+  // Enter slice 0
+  CoreTiming::Advance();
+
+  CoreTiming::ScheduleEvent(300, cb_c, CB_IDS[2]);
+  CoreTiming::ScheduleEvent(100, cb_a, CB_IDS[0]);
+  CoreTiming::ScheduleEvent(200, cb_b, CB_IDS[1]);
+
+  u8* ptr = nullptr;
+  PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+  CoreTiming::DoState(p);
+  std::vector<u8> state(reinterpret_cast<size_t>(ptr));
+  ptr = state.data();
+  p.SetMode(PointerWrap::MODE_WRITE);
+  CoreTiming::DoState(p);
+
+  // The events only come back from the state.
+  CoreTiming::ClearPendingEvents();
+  ptr = state.data();
+  p.SetMode(PointerWrap::MODE_READ);
+  CoreTiming::DoState(p);
+  EXPECT_EQ(state.data() + state.size(), ptr);
+
+  AdvanceAndCheck(0, 100);
+  AdvanceAndCheck(1, 100);
+  AdvanceAndCheck(2, MAX_SLICE_LENGTH);
+}
+
+namespace TimingWheelTest
+{
+static std::vector<CoreTiming::EventType*> RegisterTypes(u32 count)
+{
+  std::vector<CoreTiming::EventType*> types;
+  for (u32 i = 0; i < count; ++i)
+    types.push_back(CoreTiming::RegisterEvent("type" + std::to_string(i), CallbackTemplate<0>));
+  return types;
+}
+
+static std::vector<u64> PopAll(CoreTiming::TimingWheel* wheel, s64 now)
+{
+  std::vector<u64> popped;
+  CoreTiming::Event ev;
+  while (wheel->PopDue(now, &ev))
+    popped.push_back(ev.userdata);
+  return popped;
+}
+}
+
+TEST(CoreTimingWheel, Order)
+{
+  using namespace TimingWheelTest;
+
+  ScopeInit guard;
+  const std::vector<CoreTiming::EventType*> types = RegisterTypes(2);
+
+  // Events that share a time but are moved down from different levels still keep their order,
+  // and so do events far enough in the future to be on the top level.
+  CoreTiming::TimingWheel wheel;
+  const s64 far = INT64_C(1) << 62;
+  wheel.Insert({far, 0, 0, types[0]});
+  wheel.Insert({5000, 1, 1, types[0]});
+  wheel.Insert({100, 2, 2, types[1]});
+  wheel.Insert({5000, 3, 3, types[1]});
+  wheel.Insert({far, 4, 4, types[1]});
+
+  ASSERT_NE(nullptr, wheel.GetFront(0));
+  EXPECT_EQ(100, wheel.GetFront(0)->time);
+  EXPECT_TRUE(PopAll(&wheel, 99).empty());
+  EXPECT_EQ((std::vector<u64>{2}), PopAll(&wheel, 4000));
+
+  wheel.Insert({5000, 5, 5, types[0]});
+  EXPECT_EQ(5000, wheel.GetFront(4000)->time);
+  EXPECT_EQ((std::vector<u64>{1, 3, 5}), PopAll(&wheel, 5000));
+  EXPECT_EQ((std::vector<u64>{0, 4}), PopAll(&wheel, far));
+  EXPECT_TRUE(wheel.Empty());
+}
+
+TEST(CoreTimingWheel, Past)
+{
+  using namespace TimingWheelTest;
+
+  ScopeInit guard;
+  const std::vector<CoreTiming::EventType*> types = RegisterTypes(1);
+
+  CoreTiming::TimingWheel wheel;
+  wheel.Clear(1000000);
+  wheel.Insert({1000000, 0, 0, types[0]});
+  wheel.Insert({500, 1, 1, types[0]});
+  wheel.Insert({900000, 2, 2, types[0]});
+  wheel.Insert({500, 3, 3, types[0]});
+  EXPECT_EQ(500, wheel.GetFront(1000000)->time);
+  EXPECT_EQ((std::vector<u64>{1, 3, 2, 0}), PopAll(&wheel, 1000000));
+}
+
+TEST(CoreTimingWheel, Remove)
+{
+  using namespace TimingWheelTest;
+
+  ScopeInit guard;
+  const std::vector<CoreTiming::EventType*> types = RegisterTypes(3);
+
+  CoreTiming::TimingWheel wheel;
+  std::vector<CoreTiming::TimingWheel::Handle> handles;
+  for (u64 i = 0; i < 30; ++i)
+    handles.push_back(wheel.Insert({static_cast<s64>(i * 1000), i, i, types[i % 3]}));
+
+  wheel.RemoveAll(types[1]);
+  wheel.Remove(handles[3]);
+  wheel.Remove(handles[29]);
+  wheel.RemoveAll(types[1]);
+  EXPECT_EQ(18u, wheel.Size());
+
+  // Freed nodes are reused.
+  wheel.Insert({2500, 30, 30, types[1]});
+
+  std::vector<u64> expected;
+  for (u64 i = 0; i < 29; ++i)
+  {
+    if (i % 3 != 1 && i != 3)
+      expected.push_back(i);
+    if (i == 2)
+      expected.push_back(30);
+  }
+  EXPECT_EQ(expected, PopAll(&wheel, 100000));
+  EXPECT_TRUE(wheel.Empty());
+}
+
+namespace TraceReplayTest
+{
+// The binary heap CoreTiming used before the timing wheel, to check the wheel against and to
+// compare their speed.
+class HeapQueue
+{
+public:
+  void Insert(const CoreTiming::Event& ev)
+  {
+    m_heap.push_back(ev);
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<CoreTiming::Event>());
+  }
+
+  void RemoveAll(const CoreTiming::EventType* type)
+  {
+    auto itr = std::remove_if(m_heap.begin(), m_heap.end(),
+                              [&](const CoreTiming::Event& e) { return e.type == type; });
+    if (itr != m_heap.end())
+    {
+      m_heap.erase(itr, m_heap.end());
+      std::make_heap(m_heap.begin(), m_heap.end(), std::greater<CoreTiming::Event>());
+    }
+  }
+
+  const CoreTiming::Event* GetFront(s64 now) const
+  {
+    return m_heap.empty() ? nullptr : &m_heap.front();
+  }
+
+  bool PopDue(s64 now, CoreTiming::Event* ev)
+  {
+    if (m_heap.empty() || m_heap.front().time > now)
+      return false;
+
+    *ev = m_heap.front();
+    std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<CoreTiming::Event>());
+    m_heap.pop_back();
+    return true;
+  }
+
+private:
+  std::vector<CoreTiming::Event> m_heap;
+};
+
+struct TraceOp
+{
+  enum class Kind : u8
+  {
+    Schedule,
+    Remove,
+    Advance,
+  };
+
+  Kind kind;
+  u32 type;
+  s64 time;
+};
+
+// Event types of the trace, with roughly the periods of the hardware events at 486 MHz.
+struct TraceSource
+{
+  enum class Kind
+  {
+    // Rescheduled from its callback, like VI, SI polling, audio DMA and the DSP.
+    Periodic,
+    // Removed and rescheduled at arbitrary times, like the decrementer and IOS timers.
+    Reset,
+    // Scheduled in bursts at the same time, like IPC replies.
+    Burst,
+  };
+
+  Kind kind;
+  s64 period;
+  // Reset and burst events happen once in this many slices on average.
+  u32 odds;
+};
+
+// Extra timers are added to check how the queues scale with the number of pending events, as
+// some IOS modules keep many timers around.
+static std::vector<TraceSource> GetTraceSources(u32 extra_timers)
+{
+  std::vector<TraceSource> sources{
+      {TraceSource::Kind::Periodic, 15428, 0},  {TraceSource::Kind::Periodic, 60750, 0},
+      {TraceSource::Kind::Periodic, 4860, 0},   {TraceSource::Kind::Periodic, 6000, 0},
+      {TraceSource::Kind::Periodic, 486000, 0}, {TraceSource::Kind::Reset, 2000000, 8},
+      {TraceSource::Kind::Reset, 500000, 8},    {TraceSource::Kind::Reset, 40000, 8},
+      {TraceSource::Kind::Burst, 2700, 16},     {TraceSource::Kind::Burst, 2700, 16},
+      {TraceSource::Kind::Burst, 2700, 16},
+  };
+  for (u32 i = 0; i < extra_timers; ++i)
+    sources.push_back({TraceSource::Kind::Reset, 10000000 + i * 7919, 256});
+  return sources;
+}
+
+// Records what the sources schedule and remove while the CPU runs slices up to the next event,
+// sometimes ending them early as if an exception check was forced.
+static std::vector<TraceOp> RecordTrace(const std::vector<CoreTiming::EventType*>& types,
+                                        const std::vector<TraceSource>& sources, size_t size)
+{
+  std::vector<TraceOp> trace;
+  std::mt19937 rng(0x1234);
+  HeapQueue queue;
+  s64 now = 0;
+  u64 fifo_order = 0;
+
+  auto schedule = [&](u32 type, s64 time) {
+    trace.push_back({TraceOp::Kind::Schedule, type, time});
+    queue.Insert({time, fifo_order, fifo_order, types[type]});
+    fifo_order++;
+  };
+
+  for (u32 type = 0; type < sources.size(); ++type)
+  {
+    if (sources[type].kind != TraceSource::Kind::Burst)
+      schedule(type, sources[type].period);
+  }
+
+  std::vector<CoreTiming::Event> due;
+  while (trace.size() < size)
+  {
+    const CoreTiming::Event* next = queue.GetFront(now);
+    s64 slice = next ? std::min<s64>(next->time - now, MAX_SLICE_LENGTH) : MAX_SLICE_LENGTH;
+    if (rng() % 4 == 0)
+      slice = rng() % (slice + 1);
+    now += slice;
+
+    trace.push_back({TraceOp::Kind::Advance, 0, now});
+    due.clear();
+    for (CoreTiming::Event ev; queue.PopDue(now, &ev);)
+      due.push_back(ev);
+
+    for (const CoreTiming::Event& ev : due)
+    {
+      const u32 type = static_cast<u32>(
+          std::find(types.begin(), types.end(), ev.type) - types.begin());
+      if (sources[type].kind == TraceSource::Kind::Periodic)
+        schedule(type, ev.time + sources[type].period);
+    }
+
+    for (u32 type = 0; type < sources.size(); ++type)
+    {
+      const TraceSource& source = sources[type];
+      if (source.kind == TraceSource::Kind::Reset && rng() % source.odds == 0)
+      {
+        trace.push_back({TraceOp::Kind::Remove, type, 0});
+        queue.RemoveAll(types[type]);
+        schedule(type, now + 1 + rng() % source.period);
+      }
+    }
+
+    if (rng() % 16 == 0)
+    {
+      const s64 time = now + 1 + rng() % 2700;
+      for (u32 type = 0; type < sources.size(); ++type)
+      {
+        if (sources[type].kind == TraceSource::Kind::Burst)
+          schedule(type, time);
+      }
+    }
+  }
+
+  return trace;
+}
+
+// Returns the order in which the events were popped, along with the slice lengths.
+template <typename Queue>
+std::vector<std::pair<u64, s64>> ReplayTrace(const std::vector<CoreTiming::EventType*>& types,
+                                             const std::vector<TraceOp>& trace)
+{
+  std::vector<std::pair<u64, s64>> result;
+  result.reserve(trace.size());
+  Queue queue;
+  u64 fifo_order = 0;
+  for (const TraceOp& op : trace)
+  {
+    switch (op.kind)
+    {
+    case TraceOp::Kind::Schedule:
+      queue.Insert({op.time, fifo_order, fifo_order, types[op.type]});
+      fifo_order++;
+      break;
+    case TraceOp::Kind::Remove:
+      queue.RemoveAll(types[op.type]);
+      break;
+    case TraceOp::Kind::Advance:
+    {
+      for (CoreTiming::Event ev; queue.PopDue(op.time, &ev);)
+        result.emplace_back(ev.userdata, ev.time);
+      const CoreTiming::Event* next = queue.GetFront(op.time);
+      result.emplace_back(UINT64_MAX, next ? next->time - op.time : 0);
+      break;
+    }
+    }
+  }
+  return result;
+}
+
+static std::vector<CoreTiming::EventType*> RegisterTypes(size_t count)
+{
+  std::vector<CoreTiming::EventType*> types;
+  for (u32 i = 0; i < count; ++i)
+    types.push_back(CoreTiming::RegisterEvent("trace" + std::to_string(i), CallbackTemplate<0>));
+  return types;
+}
+}
+
+TEST(CoreTimingWheel, ReplayTrace)
+{
+  using namespace TraceReplayTest;
+
+  ScopeInit guard;
+  const std::vector<TraceSource> sources = GetTraceSources(64);
+  const std::vector<CoreTiming::EventType*> types = RegisterTypes(sources.size());
+  const std::vector<TraceOp> trace = RecordTrace(types, sources, 200000);
+
+  EXPECT_EQ(ReplayTrace<HeapQueue>(types, trace),
+            ReplayTrace<CoreTiming::TimingWheel>(types, trace));
+}
+
+// Compares the speed of the heap and the timing wheel. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(CoreTimingSpeedTest, DISABLED_ReplayTrace)
+{
+  using namespace TraceReplayTest;
+
+  ScopeInit guard;
+  auto measure = [](auto replay, const std::vector<CoreTiming::EventType*>& types,
+                    const std::vector<TraceOp>& trace) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t popped = replay(types, trace).size();
+    const auto end = std::chrono::steady_clock::now();
+    EXPECT_NE(0u, popped);
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  };
+
+  const std::vector<CoreTiming::EventType*> types = RegisterTypes(GetTraceSources(64).size());
+  for (u32 extra_timers : {0, 16, 64})
+  {
+    const std::vector<TraceOp> trace =
+        RecordTrace(types, GetTraceSources(extra_timers), 1000000);
+    const double heap_ms = measure(ReplayTrace<HeapQueue>, types, trace);
+    const double wheel_ms = measure(ReplayTrace<CoreTiming::TimingWheel>, types, trace);
+    printf("%u extra timers, %zu operations: heap %.1f ms, timing wheel %.1f ms\n", extra_timers,
+           trace.size(), heap_ms, wheel_ms);
+  }
+}
@@ -0,0 +1,228 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/CPU.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/MMU.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "UICommon/UICommon.h"
+
+namespace
+{
+constexpr u32 CODE_ADDRESS = 0x3000;
+constexpr u32 RESULT_ADDRESS = 0x3800;
+constexpr u32 DATA_ADDRESS = 0x10000;
+constexpr u32 OUTPUT_OFFSET = 0x800000;
+
+u32 DForm(u32 opcode, u32 d, u32 a, s32 imm)
+{
+  return (opcode << 26) | (d << 21) | (a << 16) | (imm & 0xFFFF);
+}
+
+u32 XForm(u32 d, u32 a, u32 b, u32 xo)
+{
+  return (31 << 26) | (d << 21) | (a << 16) | (b << 11) | (xo << 1);
+}
+
+u32 addi(u32 d, u32 a, s32 imm)
+{
+  return DForm(14, d, a, imm);
+}
+u32 addis(u32 d, u32 a, s32 imm)
+{
+  return DForm(15, d, a, imm);
+}
+u32 lwz(u32 d, u32 a, s32 imm)
+{
+  return DForm(32, d, a, imm);
+}
+u32 lhz(u32 d, u32 a, s32 imm)
+{
+  return DForm(40, d, a, imm);
+}
+u32 stw(u32 s, u32 a, s32 imm)
+{
+  return DForm(36, s, a, imm);
+}
+u32 cmpwi(u32 crf, u32 a, s32 imm)
+{
+  return DForm(11, crf << 2, a, imm);
+}
+u32 cmplw(u32 crf, u32 a, u32 b)
+{
+  return XForm(crf << 2, a, b, 32);
+}
+u32 add(u32 d, u32 a, u32 b)
+{
+  return XForm(d, a, b, 266);
+}
+u32 subf(u32 d, u32 a, u32 b)
+{
+  return XForm(d, a, b, 40);
+}
+u32 or_(u32 a, u32 s, u32 b)
+{
+  return XForm(s, a, b, 444);
+}
+u32 mtctr(u32 s)
+{
+  return XForm(s, 9, 0, 467);
+}
+u32 rlwinm(u32 a, u32 s, u32 sh, u32 mb, u32 me)
+{
+  return (21 << 26) | (s << 21) | (a << 16) | (sh << 11) | (mb << 6) | (me << 1);
+}
+u32 bc(u32 bo, u32 bi, s32 offset, bool lk = false)
+{
+  return (16 << 26) | (bo << 21) | (bi << 16) | (offset & 0xFFFC) | lk;
+}
+u32 b(s32 offset, bool lk = false)
+{
+  return (18 << 26) | (offset & 0x3FFFFFC) | lk;
+}
+u32 blr()
+{
+  return (19 << 26) | (20 << 21) | (16 << 1);
+}
+
+constexpr u32 BO_TRUE = 12;
+constexpr u32 BO_FALSE = 4;
+constexpr u32 BO_DNZ = 16;
+constexpr u32 CR_LT = 0;
+constexpr u32 CR_GT = 1;
+
+// Walks over an array of words, mixing them into a few registers with the kind of integer code
+// games are full of, and stores a running sum for each of them.
+std::vector<u32> MakeProgram(u32 iterations)
+{
+  return {
+      addi(3, 0, 0),
+      addis(4, 0, iterations >> 16),
+      addi(4, 4, iterations & 0xFFFF),
+      mtctr(4),
+      addis(6, 0, DATA_ADDRESS >> 16),
+      addi(10, 0, 0),
+      addi(11, 0, 0),
+      // loop:
+      lwz(5, 6, 0),
+      rlwinm(7, 5, 8, 24, 31),
+      rlwinm(7, 7, 2, 0, 29),
+      add(3, 3, 7),
+      lhz(8, 6, 2),
+      addi(6, 6, 4),
+      cmpwi(0, 8, 0x4000),
+      bc(BO_TRUE, CR_LT, 4 * 4),
+      subf(3, 8, 3),
+      stw(3, 6, OUTPUT_OFFSET - 4),
+      b(4 * 4, true),
+      // skip:
+      or_(10, 10, 8),
+      bc(BO_DNZ, 0, -12 * 4),
+      b(5 * 4),
+      // function:
+      cmplw(1, 5, 3),
+      bc(BO_FALSE, 4 + CR_GT, 2 * 4),
+      addi(11, 11, 1),
+      blr(),
+      // done:
+      stw(3, 0, RESULT_ADDRESS),
+      stw(10, 0, RESULT_ADDRESS + 4),
+      stw(11, 0, RESULT_ADDRESS + 8),
+      // Idles until the stop event.
+      b(0),
+  };
+}
+
+void Stop(u64 userdata, s64 cycles_late)
+{
+  CPU::Break();
+}
+
+struct Result
+{
+  std::vector<u32> gprs;
+  u32 cr;
+  std::vector<u32> memory;
+  double milliseconds;
+};
+
+Result RunProgram(PowerPC::CPUCore core, u32 iterations)
+{
+  const std::string profile_path = File::CreateTempDir();
+  Core::DeclareAsCPUThread();
+  UICommon::SetUserDirectory(profile_path);
+  Config::Init();
+  SConfig::Init();
+  Memory::Init();
+  CPU::Init(core);
+  CoreTiming::Init();
+
+  const std::vector<u32> program = MakeProgram(iterations);
+  for (size_t i = 0; i < program.size(); i++)
+    PowerPC::HostWrite_U32(program[i], CODE_ADDRESS + static_cast<u32>(i * 4));
+  for (u32 i = 0; i < iterations; i++)
+    PowerPC::HostWrite_U32(i * 0x9E3779B1, DATA_ADDRESS + i * 4);
+  PowerPC::ppcState.pc = CODE_ADDRESS;
+  PowerPC::ppcState.npc = CODE_ADDRESS;
+
+  CoreTiming::ScheduleEvent(iterations * 100, CoreTiming::RegisterEvent("Stop", Stop));
+  CPU::EnableStepping(false);
+  const auto start = std::chrono::steady_clock::now();
+  PowerPC::RunLoop();
+  const auto end = std::chrono::steady_clock::now();
+
+  Result result;
+  result.gprs.assign(std::begin(PowerPC::ppcState.gpr), std::end(PowerPC::ppcState.gpr));
+  result.cr = PowerPC::GetCR();
+  for (u32 i = 0; i < 3; i++)
+    result.memory.push_back(PowerPC::HostRead_U32(RESULT_ADDRESS + i * 4));
+  for (u32 i = 0; i < iterations; i += 61)
+    result.memory.push_back(PowerPC::HostRead_U32(DATA_ADDRESS + OUTPUT_OFFSET + i * 4));
+  result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+  CoreTiming::Shutdown();
+  CPU::Shutdown();
+  Memory::Shutdown();
+  SConfig::Shutdown();
+  Config::Shutdown();
+  Core::UndeclareAsCPUThread();
+  File::DeleteDirRecursively(profile_path);
+  return result;
+}
+}  // Anonymous namespace
+
+TEST(CachedInterpreter, MatchesInterpreter)
+{
+  const Result expected = RunProgram(PowerPC::CPUCore::Interpreter, 0x1000);
+  const Result actual = RunProgram(PowerPC::CPUCore::CachedInterpreter, 0x1000);
+
+  EXPECT_EQ(expected.gprs, actual.gprs);
+  EXPECT_EQ(expected.cr, actual.cr);
+  EXPECT_EQ(expected.memory, actual.memory);
+  EXPECT_NE(0u, actual.memory[2]);
+}
+
+// Compares the speed of the two interpreters. Run it with --gtest_also_run_disabled_tests.
+TEST(CachedInterpreterSpeedTest, DISABLED_IntegerLoop)
+{
+  const Result interpreter = RunProgram(PowerPC::CPUCore::Interpreter, 0x100000);
+  const Result cached_interpreter = RunProgram(PowerPC::CPUCore::CachedInterpreter, 0x100000);
+
+  EXPECT_EQ(interpreter.memory, cached_interpreter.memory);
+  printf("Interpreter: %.1f ms, cached interpreter: %.1f ms\n", interpreter.milliseconds,
+         cached_interpreter.milliseconds);
+}
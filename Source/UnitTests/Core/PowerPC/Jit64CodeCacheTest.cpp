@@ -0,0 +1,174 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// x64Emitter.h declares a TEST instruction, which clashes with gtest's TEST macro.
+#define GTEST_DONT_DEFINE_TEST 1
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/CPU.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/MMU.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "UICommon/UICommon.h"
+
+namespace
+{
+constexpr u32 CODE_ADDRESS = 0x3000;
+constexpr u32 DATA_ADDRESS = 0x100000;
+constexpr u32 OUTPUT_ADDRESS = 0x200000;
+constexpr u32 BODY_INSTRUCTIONS = 3000;
+constexpr u32 ITERATIONS = 700;
+
+u32 DForm(u32 opcode, u32 d, u32 a, s32 imm)
+{
+  return (opcode << 26) | (d << 21) | (a << 16) | (imm & 0xFFFF);
+}
+
+u32 XForm(u32 d, u32 a, u32 b, u32 xo)
+{
+  return (31 << 26) | (d << 21) | (a << 16) | (b << 11) | (xo << 1);
+}
+
+u32 addi(u32 d, u32 a, s32 imm)
+{
+  return DForm(14, d, a, imm);
+}
+u32 addis(u32 d, u32 a, s32 imm)
+{
+  return DForm(15, d, a, imm);
+}
+u32 lwz(u32 d, u32 a, s32 imm)
+{
+  return DForm(32, d, a, imm);
+}
+u32 stw(u32 s, u32 a, s32 imm)
+{
+  return DForm(36, s, a, imm);
+}
+u32 add(u32 d, u32 a, u32 b)
+{
+  return XForm(d, a, b, 266);
+}
+u32 mtctr(u32 s)
+{
+  return XForm(s, 9, 0, 467);
+}
+u32 icbi(u32 a, u32 b)
+{
+  return XForm(0, a, b, 982);
+}
+u32 bc(u32 bo, u32 bi, s32 offset)
+{
+  return (16 << 26) | (bo << 21) | (bi << 16) | (offset & 0xFFFC);
+}
+u32 b(s32 offset)
+{
+  return (18 << 26) | (offset & 0x3FFFFFC);
+}
+
+constexpr u32 BO_DNZ = 16;
+
+// A long block that invalidates itself at the end of every iteration, so that it is compiled
+// again each time and fills the code space without leaving anything to clean up behind it.
+std::vector<u32> MakeProgram()
+{
+  std::vector<u32> program = {
+      addi(3, 0, 0),
+      addi(4, 0, ITERATIONS),
+      mtctr(4),
+      addis(6, 0, DATA_ADDRESS >> 16),
+      addis(7, 0, OUTPUT_ADDRESS >> 16),
+      addi(8, 0, CODE_ADDRESS + 6 * 4),
+  };
+  for (u32 i = 0; i < BODY_INSTRUCTIONS / 3; i++)
+  {
+    const s32 offset = static_cast<s32>(i % 0x1000) * 4;
+    program.push_back(lwz(5, 6, offset));
+    program.push_back(add(3, 3, 5));
+    program.push_back(stw(3, 7, offset));
+  }
+  program.push_back(icbi(0, 8));
+  program.push_back(bc(BO_DNZ, 0, -static_cast<s32>(BODY_INSTRUCTIONS + 1) * 4));
+  // Idles until the stop event.
+  program.push_back(b(0));
+  return program;
+}
+
+void Stop(u64 userdata, s64 cycles_late)
+{
+  CPU::Break();
+}
+
+struct Result
+{
+  u32 sum;
+  std::vector<u32> memory;
+  JitInterface::CodeCacheStats stats;
+};
+
+Result RunProgram(PowerPC::CPUCore core)
+{
+  const std::string profile_path = File::CreateTempDir();
+  Core::DeclareAsCPUThread();
+  UICommon::SetUserDirectory(profile_path);
+  Config::Init();
+  SConfig::Init();
+  Memory::Init();
+  CPU::Init(core);
+  CoreTiming::Init();
+
+  const std::vector<u32> program = MakeProgram();
+  for (size_t i = 0; i < program.size(); i++)
+    PowerPC::HostWrite_U32(program[i], CODE_ADDRESS + static_cast<u32>(i * 4));
+  for (u32 i = 0; i < 0x1000; i++)
+    PowerPC::HostWrite_U32(i * 0x9E3779B1, DATA_ADDRESS + i * 4);
+  PowerPC::ppcState.pc = CODE_ADDRESS;
+  PowerPC::ppcState.npc = CODE_ADDRESS;
+  // icbi only reaches the JIT with the instruction cache enabled.
+  HID0.ICE = 1;
+
+  CoreTiming::ScheduleEvent(ITERATIONS * BODY_INSTRUCTIONS * 10,
+                            CoreTiming::RegisterEvent("Stop", Stop));
+  CPU::EnableStepping(false);
+  PowerPC::RunLoop();
+
+  Result result;
+  result.sum = PowerPC::ppcState.gpr[3];
+  for (u32 i = 0; i < BODY_INSTRUCTIONS / 3; i += 7)
+    result.memory.push_back(PowerPC::HostRead_U32(OUTPUT_ADDRESS + i * 4));
+  result.stats = JitInterface::GetCodeCacheStats();
+
+  CoreTiming::Shutdown();
+  CPU::Shutdown();
+  Memory::Shutdown();
+  SConfig::Shutdown();
+  Config::Shutdown();
+  Core::UndeclareAsCPUThread();
+  File::DeleteDirRecursively(profile_path);
+  return result;
+}
+}  // Anonymous namespace
+
+GTEST_TEST(Jit64CodeCache, EvictsRegionsWhenFull)
+{
+  const Result expected = RunProgram(PowerPC::CPUCore::Interpreter);
+  const Result actual = RunProgram(PowerPC::CPUCore::JIT64);
+
+  EXPECT_EQ(expected.sum, actual.sum);
+  EXPECT_EQ(expected.memory, actual.memory);
+  // The code space filled up, and was reclaimed without clearing everything.
+  EXPECT_NE(0u, actual.stats.evicted_regions);
+  EXPECT_EQ(0u, actual.stats.full_clears);
+  EXPECT_LE(actual.stats.used_bytes, actual.stats.total_bytes);
+}
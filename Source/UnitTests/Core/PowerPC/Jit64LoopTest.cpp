@@ -0,0 +1,227 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// x64Emitter.h declares a TEST instruction, which clashes with gtest's TEST macro.
+#define GTEST_DONT_DEFINE_TEST 1
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/CPU.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/MMU.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "UICommon/UICommon.h"
+
+namespace
+{
+constexpr u32 CODE_ADDRESS = 0x3000;
+constexpr u32 RESULT_ADDRESS = 0x3800;
+constexpr u32 FLOAT_ADDRESS = 0x5000;
+constexpr u32 DATA_ADDRESS = 0x10000;
+constexpr u32 OUTPUT_OFFSET = 0x800000;
+constexpr u32 ITERATIONS = 0x10000;
+
+constexpr u32 COUNTER_LOOP = CODE_ADDRESS + 7 * 4;
+constexpr u32 COMPARE_LOOP = CODE_ADDRESS + 16 * 4;
+
+u32 DForm(u32 opcode, u32 d, u32 a, s32 imm)
+{
+  return (opcode << 26) | (d << 21) | (a << 16) | (imm & 0xFFFF);
+}
+
+u32 XForm(u32 opcode, u32 d, u32 a, u32 b, u32 xo)
+{
+  return (opcode << 26) | (d << 21) | (a << 16) | (b << 11) | (xo << 1);
+}
+
+u32 addi(u32 d, u32 a, s32 imm)
+{
+  return DForm(14, d, a, imm);
+}
+u32 addis(u32 d, u32 a, s32 imm)
+{
+  return DForm(15, d, a, imm);
+}
+u32 lwz(u32 d, u32 a, s32 imm)
+{
+  return DForm(32, d, a, imm);
+}
+u32 stw(u32 s, u32 a, s32 imm)
+{
+  return DForm(36, s, a, imm);
+}
+u32 lfd(u32 d, u32 a, s32 imm)
+{
+  return DForm(50, d, a, imm);
+}
+u32 stfd(u32 s, u32 a, s32 imm)
+{
+  return DForm(54, s, a, imm);
+}
+u32 cmpwi(u32 crf, u32 a, s32 imm)
+{
+  return DForm(11, crf << 2, a, imm);
+}
+u32 add(u32 d, u32 a, u32 b)
+{
+  return XForm(31, d, a, b, 266);
+}
+u32 fadd(u32 d, u32 a, u32 b)
+{
+  return XForm(63, d, a, b, 21);
+}
+u32 mtctr(u32 s)
+{
+  return XForm(31, s, 9, 0, 467);
+}
+u32 bc(u32 bo, u32 bi, s32 offset, bool lk = false)
+{
+  return (16 << 26) | (bo << 21) | (bi << 16) | (offset & 0xFFFC) | lk;
+}
+u32 b(s32 offset, bool lk = false)
+{
+  return (18 << 26) | (offset & 0x3FFFFFC) | lk;
+}
+u32 blr()
+{
+  return (19 << 26) | (20 << 21) | (16 << 1);
+}
+
+constexpr u32 BO_TRUE = 12;
+constexpr u32 BO_DNZ = 16;
+constexpr u32 CR_LT = 0;
+
+// Two loops that the JIT keeps registers bound across. At the head of the first one, r4 and r9
+// are immediates, r3 is dirty and r10-r12 aren't bound yet. The second one is closed by a
+// cmp+bc pair and calls a function that is inlined into it.
+std::vector<u32> MakeProgram()
+{
+  return {
+      addi(3, 0, 0),
+      addis(4, 0, ITERATIONS >> 16),
+      addi(4, 4, ITERATIONS & 0xFFFF),
+      mtctr(4),
+      addis(6, 0, DATA_ADDRESS >> 16),
+      addi(8, 0, FLOAT_ADDRESS),
+      addi(9, 0, 0),
+      // counter_loop:
+      lwz(5, 6, 0),
+      add(3, 3, 5),
+      add(3, 3, 4),
+      addi(6, 6, 4),
+      stw(3, 6, OUTPUT_OFFSET - 4),
+      lfd(1, 8, 0),
+      fadd(2, 2, 1),
+      addi(9, 9, 3),
+      bc(BO_DNZ, 0, -8 * 4),
+      // compare_loop:
+      addi(10, 10, 1),
+      add(11, 11, 10),
+      stfd(2, 8, 8),
+      b(8 * 4, true),
+      cmpwi(0, 10, 5000),
+      bc(BO_TRUE, CR_LT, -5 * 4),
+      stw(3, 0, RESULT_ADDRESS),
+      stw(9, 0, RESULT_ADDRESS + 4),
+      stw(11, 0, RESULT_ADDRESS + 8),
+      stw(12, 0, RESULT_ADDRESS + 12),
+      // Idles until the stop event.
+      b(0),
+      // function:
+      add(12, 12, 10),
+      addi(12, 12, -7),
+      blr(),
+  };
+}
+
+void Stop(u64 userdata, s64 cycles_late)
+{
+  CPU::Break();
+}
+
+struct Result
+{
+  std::vector<u32> gprs;
+  std::vector<u64> fprs;
+  u32 cr;
+  std::vector<u32> memory;
+  bool counter_loop_hot = false;
+  bool compare_loop_hot = false;
+};
+
+Result RunProgram(PowerPC::CPUCore core)
+{
+  const std::string profile_path = File::CreateTempDir();
+  Core::DeclareAsCPUThread();
+  UICommon::SetUserDirectory(profile_path);
+  Config::Init();
+  SConfig::Init();
+  Memory::Init();
+  CPU::Init(core);
+  CoreTiming::Init();
+
+  const std::vector<u32> program = MakeProgram();
+  for (size_t i = 0; i < program.size(); i++)
+    PowerPC::HostWrite_U32(program[i], CODE_ADDRESS + static_cast<u32>(i * 4));
+  for (u32 i = 0; i < ITERATIONS; i++)
+    PowerPC::HostWrite_U32(i * 0x9E3779B1, DATA_ADDRESS + i * 4);
+  PowerPC::HostWrite_U64(0x3FF8000000000000, FLOAT_ADDRESS);
+  PowerPC::ppcState.pc = CODE_ADDRESS;
+  PowerPC::ppcState.npc = CODE_ADDRESS;
+  MSR.FP = 1;
+
+  CoreTiming::ScheduleEvent(ITERATIONS * 100, CoreTiming::RegisterEvent("Stop", Stop));
+  CPU::EnableStepping(false);
+  PowerPC::RunLoop();
+
+  Result result;
+  result.gprs.assign(std::begin(PowerPC::ppcState.gpr), std::end(PowerPC::ppcState.gpr));
+  for (const auto& ps : PowerPC::ppcState.ps)
+    result.fprs.push_back(ps[0]);
+  result.cr = PowerPC::GetCR();
+  for (u32 i = 0; i < 4; i++)
+    result.memory.push_back(PowerPC::HostRead_U32(RESULT_ADDRESS + i * 4));
+  result.memory.push_back(PowerPC::HostRead_U32(FLOAT_ADDRESS + 8));
+  result.memory.push_back(PowerPC::HostRead_U32(FLOAT_ADDRESS + 12));
+  for (u32 i = 0; i < ITERATIONS; i += 61)
+    result.memory.push_back(PowerPC::HostRead_U32(DATA_ADDRESS + OUTPUT_OFFSET + i * 4));
+  if (g_jit)
+  {
+    result.counter_loop_hot = g_jit->js.hotLoopAddresses.count(COUNTER_LOOP) != 0;
+    result.compare_loop_hot = g_jit->js.hotLoopAddresses.count(COMPARE_LOOP) != 0;
+  }
+
+  CoreTiming::Shutdown();
+  CPU::Shutdown();
+  Memory::Shutdown();
+  SConfig::Shutdown();
+  Config::Shutdown();
+  Core::UndeclareAsCPUThread();
+  File::DeleteDirRecursively(profile_path);
+  return result;
+}
+}  // Anonymous namespace
+
+GTEST_TEST(Jit64Loop, MatchesInterpreter)
+{
+  const Result expected = RunProgram(PowerPC::CPUCore::Interpreter);
+  const Result actual = RunProgram(PowerPC::CPUCore::JIT64);
+
+  EXPECT_TRUE(actual.counter_loop_hot);
+  EXPECT_TRUE(actual.compare_loop_hot);
+  EXPECT_EQ(expected.gprs, actual.gprs);
+  EXPECT_EQ(expected.fprs, actual.fprs);
+  EXPECT_EQ(expected.cr, actual.cr);
+  EXPECT_EQ(expected.memory, actual.memory);
+  EXPECT_EQ(5000u, actual.gprs[10]);
+}
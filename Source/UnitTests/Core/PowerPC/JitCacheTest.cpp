@@ -0,0 +1,177 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// x64Emitter.h declares a TEST instruction, which clashes with gtest's TEST macro.
+#define GTEST_DONT_DEFINE_TEST 1
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+namespace
+{
+constexpr u32 CODE_START = 0x3000;
+constexpr u32 CODE_SIZE = 0x400000;
+constexpr u32 MSR_BITS = 0;
+
+class TestBlockCache final : public JitBaseBlockCache
+{
+public:
+  using JitBaseBlockCache::JitBaseBlockCache;
+
+private:
+  void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override {}
+};
+
+// Only provides the JIT state the block cache touches; it never generates code.
+class TestJit final : public JitBase
+{
+public:
+  TestJit() : m_block_cache(*this) { m_block_cache.Clear(); }
+  void Init() override {}
+  void Shutdown() override {}
+  void ClearCache() override { m_block_cache.Clear(); }
+  void Run() override {}
+  void SingleStep() override {}
+  const char* GetName() const override { return "TestJit"; }
+  JitBaseBlockCache* GetBlockCache() override { return &m_block_cache; }
+  void Jit(u32 em_address) override {}
+  const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+  bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+
+private:
+  TestBlockCache m_block_cache;
+};
+
+// Adds a block of num_instructions at address which exits to the given addresses, the way the
+// JITs do after compiling it.
+JitBlock* AddBlock(JitBaseBlockCache& cache, u32 address, u32 num_instructions,
+                   const std::vector<u32>& exits)
+{
+  JitBlock* block = cache.AllocateBlock(address);
+  block->msrBits = MSR_BITS;
+  block->checkedEntry = nullptr;
+  block->normalEntry = nullptr;
+  block->codeSize = 0;
+  block->originalSize = num_instructions;
+  for (u32 exit : exits)
+    block->linkData.push_back({nullptr, exit, false, false});
+
+  std::set<u32> physical_addresses;
+  for (u32 i = 0; i < num_instructions; i++)
+    physical_addresses.insert(address + i * 4);
+  cache.FinalizeBlock(*block, true, physical_addresses);
+  return block;
+}
+}  // Anonymous namespace
+
+GTEST_TEST(JitCache, InvalidationErasesOverlappingBlocks)
+{
+  TestJit jit;
+  JitBaseBlockCache& cache = *jit.GetBlockCache();
+
+  AddBlock(cache, CODE_START, 8, {CODE_START + 0x100});
+  AddBlock(cache, CODE_START + 0x100, 0x80, {CODE_START});
+  AddBlock(cache, CODE_START + 0x400, 4, {});
+
+  // Blocks are found by their start address only.
+  EXPECT_NE(nullptr, cache.GetBlockFromStartAddress(CODE_START, MSR_BITS));
+  EXPECT_EQ(nullptr, cache.GetBlockFromStartAddress(CODE_START + 4, MSR_BITS));
+
+  // A cache line the blocks don't cover leaves them alone.
+  cache.InvalidateICache(CODE_START + 0x380, 32, false);
+  EXPECT_NE(nullptr, cache.GetBlockFromStartAddress(CODE_START + 0x100, MSR_BITS));
+
+  // The second block spans two macro blocks, and is erased through either of them.
+  cache.InvalidateICache(CODE_START + 0x2E0, 32, false);
+  EXPECT_EQ(nullptr, cache.GetBlockFromStartAddress(CODE_START + 0x100, MSR_BITS));
+  EXPECT_NE(nullptr, cache.GetBlockFromStartAddress(CODE_START, MSR_BITS));
+
+  // A block can be recompiled at an address that was invalidated.
+  AddBlock(cache, CODE_START + 0x100, 4, {});
+  EXPECT_NE(nullptr, cache.GetBlockFromStartAddress(CODE_START + 0x100, MSR_BITS));
+
+  // Large ranges erase everything they overlap.
+  cache.InvalidateICache(CODE_START, 0x800, false);
+  EXPECT_EQ(nullptr, cache.GetBlockFromStartAddress(CODE_START, MSR_BITS));
+  EXPECT_EQ(nullptr, cache.GetBlockFromStartAddress(CODE_START + 0x100, MSR_BITS));
+  EXPECT_EQ(nullptr, cache.GetBlockFromStartAddress(CODE_START + 0x400, MSR_BITS));
+}
+
+// Replays a synthetic trace modelled on what games do to the block cache: mostly slow-path block
+// lookups and linking, with icbi invalidations of single cache lines and occasional DMA-sized
+// invalidations of code that gets loaded over. Run it with --gtest_also_run_disabled_tests.
+GTEST_TEST(JitCacheSpeedTest, DISABLED_ReplayTrace)
+{
+  constexpr u32 NUM_BLOCKS = 0x8000;
+  constexpr u32 NUM_OPERATIONS = 500000;
+
+  std::mt19937 rng(0x4A495443);
+  std::uniform_int_distribution<u32> block_dist(0, NUM_BLOCKS - 1);
+  std::uniform_int_distribution<u32> size_dist(2, 24);
+  std::uniform_int_distribution<u32> operation_dist(0, 999);
+  const auto block_address = [](u32 index) {
+    return CODE_START + index * (CODE_SIZE / NUM_BLOCKS);
+  };
+
+  TestJit jit;
+  JitBaseBlockCache& cache = *jit.GetBlockCache();
+  const auto compile = [&](u32 index) {
+    const u32 address = block_address(index);
+    if (cache.GetBlockFromStartAddress(address, MSR_BITS))
+      return;
+    AddBlock(cache, address, size_dist(rng),
+             {block_address(block_dist(rng)), block_address((index + 1) % NUM_BLOCKS)});
+  };
+
+  for (u32 i = 0; i < NUM_BLOCKS; i++)
+    compile(i);
+
+  // Lookups, single cache line invalidations and DMA-sized invalidations, including the
+  // recompilation of the erased blocks.
+  std::array<std::chrono::steady_clock::duration, 3> times{};
+  std::array<size_t, 3> counts{};
+  size_t found = 0;
+  for (u32 i = 0; i < NUM_OPERATIONS; i++)
+  {
+    const u32 operation = operation_dist(rng);
+    const u32 index = block_dist(rng);
+    const size_t type = operation < 800 ? 0 : operation < 990 ? 1 : 2;
+    const auto start = std::chrono::steady_clock::now();
+    if (type == 0)
+    {
+      found += cache.GetBlockFromStartAddress(block_address(index), MSR_BITS) != nullptr;
+    }
+    else if (type == 1)
+    {
+      cache.InvalidateICache(block_address(index) + (operation & 0x60), 32, false);
+      compile(index);
+    }
+    else
+    {
+      const u32 first = index & ~0x3F;
+      cache.InvalidateICache(block_address(first), 0x40 * (CODE_SIZE / NUM_BLOCKS), false);
+      for (u32 j = first; j < first + 0x40; j++)
+        compile(j);
+    }
+    times[type] += std::chrono::steady_clock::now() - start;
+    counts[type]++;
+  }
+
+  EXPECT_NE(0u, found);
+  const char* names[] = {"Lookups", "Cache line invalidations", "DMA invalidations"};
+  for (size_t i = 0; i < times.size(); i++)
+  {
+    printf("%s: %zu in %.1f ms\n", names[i], counts[i],
+           std::chrono::duration<double, std::milli>(times[i]).count());
+  }
+}
@@ -0,0 +1,75 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/RewindBuffer.h"
+
+namespace
+{
+std::vector<u8> MakeState(size_t size, u8 seed)
+{
+  std::vector<u8> state(size);
+  for (size_t i = 0; i < size; ++i)
+    state[i] = static_cast<u8>((i * 7) ^ (i % 1000 == 0 ? seed : 0));
+  return state;
+}
+}  // namespace
+
+TEST(RewindBuffer, PopReturnsStatesInReverseOrder)
+{
+  State::RewindBuffer buffer(64 << 20);
+  std::vector<std::vector<u8>> states;
+  for (u8 i = 0; i < 8; ++i)
+  {
+    // Vary the size too, to cover states growing and shrinking.
+    states.push_back(MakeState(300000 + (i % 3) * 4096 + i, i));
+    buffer.Push(states.back());
+  }
+  EXPECT_EQ(states.size(), buffer.GetNumStates());
+
+  std::vector<u8> state;
+  for (auto it = states.rbegin(); it != states.rend(); ++it)
+  {
+    ASSERT_TRUE(buffer.Pop(&state));
+    EXPECT_EQ(*it, state);
+  }
+  EXPECT_FALSE(buffer.Pop(&state));
+  EXPECT_EQ(0u, buffer.GetNumStates());
+}
+
+TEST(RewindBuffer, DeltasAreSmall)
+{
+  State::RewindBuffer buffer(64 << 20);
+  const std::vector<u8> first = MakeState(1 << 20, 1);
+  buffer.Push(first);
+  buffer.Push(MakeState(1 << 20, 2));
+
+  // A handful of changed bytes must not cost anywhere near a full copy of the state.
+  EXPECT_LT(buffer.GetMemoryUsage(), first.size() + first.size() / 8);
+}
+
+TEST(RewindBuffer, BudgetDropsOldestStates)
+{
+  const size_t state_size = 1 << 20;
+  State::RewindBuffer buffer(state_size + state_size / 4);
+  std::mt19937 rng(1234);
+  std::vector<u8> newest(state_size);
+  for (int i = 0; i < 16; ++i)
+  {
+    // Random data does not compress, so every delta is large.
+    for (u8& byte : newest)
+      byte = static_cast<u8>(rng());
+    buffer.Push(newest);
+    EXPECT_LE(buffer.GetMemoryUsage(), state_size + state_size / 4);
+  }
+
+  EXPECT_LT(buffer.GetNumStates(), 16u);
+  std::vector<u8> state;
+  ASSERT_TRUE(buffer.Pop(&state));
+  EXPECT_EQ(newest, state);
+}
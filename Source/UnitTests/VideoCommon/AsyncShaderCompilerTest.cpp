@@ -0,0 +1,242 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/AsyncShaderCompiler.h"
+
+using VideoCommon::AsyncShaderCompiler;
+
+namespace
+{
+// Records the order in which items are prepared, retrieved and cancelled.
+struct Log
+{
+  std::vector<int> prepared;
+  std::vector<int> retrieved;
+  std::vector<int> cancelled;
+  std::atomic<int> compiled{0};
+};
+
+class TestWorkItem final : public AsyncShaderCompiler::WorkItem
+{
+public:
+  TestWorkItem(Log* log_, int id_, bool succeed_ = true) : log(log_), id(id_), succeed(succeed_) {}
+
+  void Prepare() override { log->prepared.push_back(id); }
+  bool Compile() override
+  {
+    log->compiled++;
+    return succeed;
+  }
+  void Retrieve() override { log->retrieved.push_back(id); }
+  void Cancel() override { log->cancelled.push_back(id); }
+
+private:
+  Log* log;
+  int id;
+  bool succeed;
+};
+
+// Keeps a worker busy until released.
+class BlockingWorkItem final : public AsyncShaderCompiler::WorkItem
+{
+public:
+  BlockingWorkItem(std::atomic<u32>* started_, std::atomic<bool>* release_)
+      : started(started_), release(release_)
+  {
+  }
+
+  bool Compile() override
+  {
+    (*started)++;
+    while (!release->load())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return true;
+  }
+  void Retrieve() override {}
+
+private:
+  std::atomic<u32>* started;
+  std::atomic<bool>* release;
+};
+
+void WaitForCompletion(AsyncShaderCompiler* compiler)
+{
+  while (compiler->HasPendingWork() || compiler->HasCompletedWork())
+  {
+    compiler->WaitUntilCompletion();
+    compiler->RetrieveWorkItems();
+  }
+}
+}  // Anonymous namespace
+
+// The parameter is the number of worker threads, zero compiling synchronously.
+class AsyncShaderCompilerTest : public testing::TestWithParam<u32>
+{
+protected:
+  void SetUp() override { ASSERT_TRUE(m_compiler.StartWorkerThreads(GetParam())); }
+  void TearDown() override { m_compiler.StopWorkerThreads(); }
+
+  AsyncShaderCompiler::WorkItemID
+  Queue(int id, u32 priority = 0,
+        const std::vector<AsyncShaderCompiler::WorkItemID>& dependencies = {}, bool succeed = true)
+  {
+    return m_compiler.QueueWorkItem(
+        AsyncShaderCompiler::CreateWorkItem<TestWorkItem>(&m_log, id, succeed), priority,
+        dependencies);
+  }
+
+  // Occupies all of the workers, so that items queued afterwards can't start until released.
+  void BlockWorkers()
+  {
+    for (u32 i = 0; i < GetParam(); i++)
+    {
+      m_compiler.QueueWorkItem(
+          AsyncShaderCompiler::CreateWorkItem<BlockingWorkItem>(&m_started, &m_release), 0);
+    }
+    while (m_started.load() != GetParam())
+      std::this_thread::yield();
+  }
+
+  void ReleaseWorkers() { m_release.store(true); }
+
+  AsyncShaderCompiler m_compiler;
+  Log m_log;
+  std::atomic<u32> m_started{0};
+  std::atomic<bool> m_release{false};
+};
+INSTANTIATE_TEST_CASE_P(WorkerThreads, AsyncShaderCompilerTest, ::testing::Values(0u, 1u, 4u));
+
+TEST_P(AsyncShaderCompilerTest, CompilesEverything)
+{
+  for (int i = 0; i < 1000; i++)
+    Queue(i, i % 3);
+  WaitForCompletion(&m_compiler);
+
+  EXPECT_EQ(1000, m_log.compiled.load());
+  EXPECT_EQ(1000u, m_log.retrieved.size());
+  EXPECT_TRUE(m_log.cancelled.empty());
+
+  const AsyncShaderCompiler::Statistics stats = m_compiler.GetStatistics();
+  EXPECT_EQ(1000u, stats.compiled_items);
+  EXPECT_EQ(0u, stats.queued_items);
+  EXPECT_EQ(0u, stats.blocked_items);
+  EXPECT_LE(stats.max_compile_time_us, stats.total_compile_time_us);
+}
+
+TEST_P(AsyncShaderCompilerTest, WaitsForDependencies)
+{
+  const auto vs = Queue(1);
+  const auto ps = Queue(2);
+  Queue(3, 0, {vs, ps});
+  WaitForCompletion(&m_compiler);
+
+  ASSERT_EQ(3u, m_log.retrieved.size());
+  EXPECT_EQ(3, m_log.retrieved[2]);
+  ASSERT_EQ(3u, m_log.prepared.size());
+  EXPECT_EQ(3, m_log.prepared[2]);
+
+  // Depending on items that were already retrieved doesn't block.
+  Queue(4, 0, {vs, ps});
+  EXPECT_EQ(4, m_log.prepared.back());
+  WaitForCompletion(&m_compiler);
+  EXPECT_EQ(4, m_log.retrieved.back());
+}
+
+TEST_P(AsyncShaderCompilerTest, CancelsDependentsOfFailedItems)
+{
+  const auto failing = Queue(1, 0, {}, false);
+  const auto dependent = Queue(2, 0, {failing});
+  Queue(3, 0, {dependent});
+  WaitForCompletion(&m_compiler);
+
+  EXPECT_TRUE(m_log.retrieved.empty());
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), m_log.cancelled);
+  EXPECT_EQ(1, m_log.compiled.load());
+}
+
+TEST_P(AsyncShaderCompilerTest, CancelPendingWork)
+{
+  BlockWorkers();
+  const auto first = Queue(1);
+  Queue(2, 0, {first});
+  Queue(3);
+
+  m_compiler.CancelPendingWork();
+  ReleaseWorkers();
+  WaitForCompletion(&m_compiler);
+
+  std::sort(m_log.cancelled.begin(), m_log.cancelled.end());
+  if (GetParam() == 0)
+  {
+    // Without worker threads, items are compiled as soon as they are queued, so only the blocked
+    // one is left to cancel.
+    EXPECT_EQ((std::vector<int>{2}), m_log.cancelled);
+    EXPECT_EQ((std::vector<int>{1, 3}), m_log.retrieved);
+  }
+  else
+  {
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), m_log.cancelled);
+    EXPECT_TRUE(m_log.retrieved.empty());
+    EXPECT_EQ(0, m_log.compiled.load());
+  }
+  EXPECT_EQ(m_log.cancelled.size(), m_compiler.GetStatistics().cancelled_items);
+}
+
+TEST_P(AsyncShaderCompilerTest, KeepsWorkAcrossRestart)
+{
+  BlockWorkers();
+  for (int i = 0; i < 100; i++)
+    Queue(i);
+
+  // Stop the workers while they are busy, which leaves the other items queued.
+  std::thread releaser([this] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ReleaseWorkers();
+  });
+  m_compiler.StopWorkerThreads();
+  releaser.join();
+
+  // With a single worker, this restarts without worker threads, which compiles the leftovers
+  // synchronously.
+  ASSERT_TRUE(m_compiler.StartWorkerThreads(GetParam() > 0 ? GetParam() - 1 : 0));
+  WaitForCompletion(&m_compiler);
+  EXPECT_EQ(100u, m_log.retrieved.size());
+}
+
+// Queues many short items at once, like loading a large pipeline UID log does, to measure the
+// overhead of the queues themselves. Run it with --gtest_also_run_disabled_tests.
+TEST(AsyncShaderCompilerSpeedTest, DISABLED_ManySmallItems)
+{
+  AsyncShaderCompiler compiler;
+  const u32 threads = std::max(2u, std::thread::hardware_concurrency());
+  ASSERT_TRUE(compiler.StartWorkerThreads(threads));
+
+  Log log;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 200000; i++)
+  {
+    compiler.QueueWorkItem(AsyncShaderCompiler::CreateWorkItem<TestWorkItem>(&log, i),
+                           static_cast<u32>(i % 4));
+  }
+  WaitForCompletion(&compiler);
+  const auto end = std::chrono::steady_clock::now();
+  compiler.StopWorkerThreads();
+
+  const AsyncShaderCompiler::Statistics stats = compiler.GetStatistics();
+  EXPECT_EQ(200000u, log.retrieved.size());
+  printf("%u workers: %.1f ms, %llu stolen, %.2f us average wait\n", threads,
+         std::chrono::duration<double, std::milli>(end - start).count(),
+         static_cast<unsigned long long>(stats.stolen_items),
+         static_cast<double>(stats.total_wait_time_us) / stats.compiled_items);
+}
@@ -0,0 +1,122 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DisplayListCache.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/Statistics.h"
+
+namespace
+{
+constexpr u32 ADDRESS = 0x80000;
+
+class DisplayListCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Normally done by the texture cache.
+    Common::SetHash64Function();
+    DisplayListCache::Clear();
+    g_main_cp_state.vtx_desc.Hex = 0;
+  }
+
+  void TearDown() override { DisplayListCache::Clear(); }
+
+  // Calls the display list and returns whether it was replayed from the cache.
+  bool Call(u32 address, std::vector<u8>* display_list)
+  {
+    const int hits = stats.thisFrame.numDListCacheHits;
+    const int misses = stats.thisFrame.numDListCacheMisses;
+    DisplayListCache::Interpret(address, display_list->data(),
+                                static_cast<u32>(display_list->size()));
+    EXPECT_EQ(1, stats.thisFrame.numDListCacheHits - hits + stats.thisFrame.numDListCacheMisses -
+                     misses);
+    return stats.thisFrame.numDListCacheHits != hits;
+  }
+
+  std::vector<u8> m_display_list = std::vector<u8>(32, OpcodeDecoder::GX_NOP);
+};
+}  // Anonymous namespace
+
+TEST_F(DisplayListCacheTest, RecordsOnSecondCall)
+{
+  EXPECT_FALSE(Call(ADDRESS, &m_display_list));
+  EXPECT_FALSE(Call(ADDRESS, &m_display_list));
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+  EXPECT_EQ(1u, DisplayListCache::GetEntryCount());
+
+  // The same contents at another address are a separate display list.
+  EXPECT_FALSE(Call(ADDRESS + 0x20, &m_display_list));
+}
+
+TEST_F(DisplayListCacheTest, ChangedContentsMiss)
+{
+  Call(ADDRESS, &m_display_list);
+  Call(ADDRESS, &m_display_list);
+
+  std::vector<u8> rewritten = m_display_list;
+  rewritten.back() = OpcodeDecoder::GX_UNKNOWN_RESET;
+  EXPECT_FALSE(Call(ADDRESS, &rewritten));
+  EXPECT_FALSE(Call(ADDRESS, &rewritten));
+  EXPECT_TRUE(Call(ADDRESS, &rewritten));
+
+  std::vector<u8> shortened(m_display_list.begin(), m_display_list.end() - 1);
+  EXPECT_FALSE(Call(ADDRESS, &shortened));
+
+  // Both variants stay cached.
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+  EXPECT_TRUE(Call(ADDRESS, &rewritten));
+}
+
+TEST_F(DisplayListCacheTest, ChangedVertexStateMisses)
+{
+  Call(ADDRESS, &m_display_list);
+  Call(ADDRESS, &m_display_list);
+
+  g_main_cp_state.vtx_desc.Position = DIRECT;
+  EXPECT_FALSE(Call(ADDRESS, &m_display_list));
+  EXPECT_FALSE(Call(ADDRESS, &m_display_list));
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+
+  g_main_cp_state.vtx_desc.Position = NOT_PRESENT;
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+}
+
+TEST_F(DisplayListCacheTest, EvictsLeastRecentlyUsed)
+{
+  // Fill the cache to find out how many display lists it keeps.
+  size_t calls = 0;
+  while (DisplayListCache::GetEntryCount() == calls)
+  {
+    ASSERT_LT(calls, 0x100000u);
+    Call(ADDRESS + static_cast<u32>(calls++) * 0x20, &m_display_list);
+  }
+  const size_t capacity = DisplayListCache::GetEntryCount();
+  const u32 address = ADDRESS + static_cast<u32>(capacity) * 0x20;
+  DisplayListCache::Clear();
+
+  Call(ADDRESS, &m_display_list);
+  Call(ADDRESS, &m_display_list);
+  for (size_t i = 1; i < capacity; i++)
+    Call(ADDRESS + static_cast<u32>(i) * 0x20, &m_display_list);
+
+  // Using the entry keeps it while the display lists after it are evicted.
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+  Call(address, &m_display_list);
+  EXPECT_EQ(capacity, DisplayListCache::GetEntryCount());
+  EXPECT_TRUE(Call(ADDRESS, &m_display_list));
+  EXPECT_FALSE(Call(ADDRESS + 0x20, &m_display_list));
+
+  for (size_t i = 0; i < capacity; i++)
+    Call(address + static_cast<u32>(i + 1) * 0x20, &m_display_list);
+  EXPECT_FALSE(Call(ADDRESS, &m_display_list));
+}
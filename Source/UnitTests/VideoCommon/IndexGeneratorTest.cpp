@@ -0,0 +1,252 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/IndexGenerator.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+// Straightforward implementation of the primitive conversions, to check the pattern kernels
+// against.
+std::vector<u32> ReferenceIndices(int primitive, u32 num_verts, u32 index, bool pr, u32 restart)
+{
+  std::vector<u32> out;
+  auto triangle = [&](u32 a, u32 b, u32 c) {
+    out.insert(out.end(), {a, b, c});
+    if (pr)
+      out.push_back(restart);
+  };
+
+  switch (primitive)
+  {
+  case OpcodeDecoder::GX_DRAW_QUADS:
+  case OpcodeDecoder::GX_DRAW_QUADS_2:
+  {
+    u32 i = 3;
+    for (; i < num_verts; i += 4)
+    {
+      if (pr)
+      {
+        out.insert(out.end(), {index + i - 2, index + i - 1, index + i - 3, index + i, restart});
+      }
+      else
+      {
+        triangle(index + i - 3, index + i - 2, index + i - 1);
+        triangle(index + i - 3, index + i - 1, index + i);
+      }
+    }
+    if (i == num_verts)
+      triangle(index + num_verts - 3, index + num_verts - 2, index + num_verts - 1);
+    break;
+  }
+  case OpcodeDecoder::GX_DRAW_TRIANGLES:
+    for (u32 i = 2; i < num_verts; i += 3)
+      triangle(index + i - 2, index + i - 1, index + i);
+    break;
+  case OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP:
+    if (pr)
+    {
+      for (u32 i = 0; i < num_verts; i++)
+        out.push_back(index + i);
+      out.push_back(restart);
+    }
+    else
+    {
+      for (u32 i = 2; i < num_verts; i++)
+      {
+        if (i % 2 == 0)
+          triangle(index + i - 2, index + i - 1, index + i);
+        else
+          triangle(index + i - 2, index + i, index + i - 1);
+      }
+    }
+    break;
+  case OpcodeDecoder::GX_DRAW_TRIANGLE_FAN:
+  {
+    u32 i = 2;
+    if (pr)
+    {
+      for (; i + 3 <= num_verts; i += 3)
+      {
+        out.insert(out.end(),
+                   {index + i - 1, index + i, index, index + i + 1, index + i + 2, restart});
+      }
+      for (; i + 2 <= num_verts; i += 2)
+        out.insert(out.end(), {index + i - 1, index + i, index, index + i + 1, restart});
+    }
+    for (; i < num_verts; i++)
+      triangle(index, index + i - 1, index + i);
+    break;
+  }
+  case OpcodeDecoder::GX_DRAW_LINES:
+    for (u32 i = 1; i < num_verts; i += 2)
+      out.insert(out.end(), {index + i - 1, index + i});
+    break;
+  case OpcodeDecoder::GX_DRAW_LINE_STRIP:
+    for (u32 i = 1; i < num_verts; i++)
+      out.insert(out.end(), {index + i - 1, index + i});
+    break;
+  case OpcodeDecoder::GX_DRAW_POINTS:
+    for (u32 i = 0; i < num_verts; i++)
+      out.push_back(index + i);
+    break;
+  }
+  return out;
+}
+
+const int primitives[] = {
+    OpcodeDecoder::GX_DRAW_QUADS,
+    OpcodeDecoder::GX_DRAW_QUADS_2,
+    OpcodeDecoder::GX_DRAW_TRIANGLES,
+    OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP,
+    OpcodeDecoder::GX_DRAW_TRIANGLE_FAN,
+    OpcodeDecoder::GX_DRAW_LINES,
+    OpcodeDecoder::GX_DRAW_LINE_STRIP,
+    OpcodeDecoder::GX_DRAW_POINTS,
+};
+}  // Anonymous namespace
+
+// The parameter is whether primitive restart is supported.
+class IndexGeneratorTest : public testing::TestWithParam<bool>
+{
+protected:
+  void SetUp() override
+  {
+    m_primitive_restart = GetParam();
+    g_Config.backend_info.bSupportsPrimitiveRestart = m_primitive_restart;
+    IndexGenerator::Init();
+  }
+
+  // Converts two draws of the given primitive, so that the second one has a nonzero base index,
+  // and checks the result against the reference. The buffer is filled with garbage first to
+  // catch writes past the end of the indices.
+  template <typename T>
+  void Check(int primitive, u32 first_count, u32 second_count)
+  {
+    constexpr T restart = std::numeric_limits<T>::max();
+    std::vector<T> buffer(8 * (first_count + second_count) + 64, 0x5A5A);
+    IndexGenerator::Start(buffer.data());
+    IndexGenerator::AddIndices(primitive, first_count);
+    IndexGenerator::AddIndices(primitive, second_count);
+
+    std::vector<u32> expected =
+        ReferenceIndices(primitive, first_count, 0, m_primitive_restart, restart);
+    const std::vector<u32> second =
+        ReferenceIndices(primitive, second_count, first_count, m_primitive_restart, restart);
+    expected.insert(expected.end(), second.begin(), second.end());
+
+    EXPECT_EQ(first_count + second_count, IndexGenerator::GetNumVerts());
+    ASSERT_EQ(expected.size(), IndexGenerator::GetIndexLen())
+        << "primitive " << primitive << ", counts " << first_count << " " << second_count;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+      ASSERT_EQ(expected[i], buffer[i]) << "primitive " << primitive << ", counts " << first_count
+                                        << " " << second_count << ", index " << i;
+    }
+    EXPECT_EQ(static_cast<T>(0x5A5A), buffer[expected.size()]);
+  }
+
+  bool m_primitive_restart = false;
+};
+INSTANTIATE_TEST_CASE_P(PrimitiveRestart, IndexGeneratorTest, ::testing::Values(false, true));
+
+TEST_P(IndexGeneratorTest, MatchesReference16)
+{
+  for (int primitive : primitives)
+  {
+    for (u32 count = 0; count < 300; count++)
+      Check<u16>(primitive, count, count * 7 % 131);
+  }
+}
+
+TEST_P(IndexGeneratorTest, MatchesReference32)
+{
+  for (int primitive : primitives)
+  {
+    for (u32 count = 0; count < 300; count++)
+      Check<u32>(primitive, count, count * 7 % 131);
+  }
+}
+
+#ifdef _M_X86
+// Also checks the SSE2 kernels on machines that would use the AVX2 ones.
+TEST_P(IndexGeneratorTest, MatchesReferenceSSE2)
+{
+  const bool avx2 = cpu_info.bAVX2;
+  cpu_info.bAVX2 = false;
+  IndexGenerator::Init();
+  for (int primitive : primitives)
+  {
+    for (u32 count = 0; count < 100; count++)
+    {
+      Check<u16>(primitive, count, count * 7 % 131);
+      Check<u32>(primitive, count, count * 7 % 131);
+    }
+  }
+  cpu_info.bAVX2 = avx2;
+}
+#endif
+
+TEST_P(IndexGeneratorTest, RemainingIndices)
+{
+  std::vector<u16> buffer16(1024);
+  IndexGenerator::Start(buffer16.data());
+  IndexGenerator::AddIndices(OpcodeDecoder::GX_DRAW_POINTS, 100);
+  EXPECT_EQ(65534u - 100, IndexGenerator::GetRemainingIndices());
+
+  // 32-bit indices don't run out before the buffers do.
+  std::vector<u32> buffer32(1024);
+  IndexGenerator::Start(buffer32.data());
+  IndexGenerator::AddIndices(OpcodeDecoder::GX_DRAW_POINTS, 100);
+  EXPECT_LT(65534u, IndexGenerator::GetRemainingIndices());
+}
+
+// Converts the 32-bit indices past 65535, where the 16-bit kernels would wrap around.
+TEST_P(IndexGeneratorTest, LargeBaseIndex)
+{
+  for (int primitive : primitives)
+    Check<u32>(primitive, 70000, 257);
+}
+
+class IndexGeneratorSpeedTest : public IndexGeneratorTest
+{
+};
+INSTANTIATE_TEST_CASE_P(PrimitiveRestart, IndexGeneratorSpeedTest, ::testing::Values(false, true));
+
+TEST_P(IndexGeneratorSpeedTest, LargeDraws16)
+{
+  std::vector<u16> buffer(65536 * 2);
+  for (int primitive : primitives)
+  {
+    for (int i = 0; i < 100; ++i)
+    {
+      IndexGenerator::Start(buffer.data());
+      for (int j = 0; j < 16; ++j)
+        IndexGenerator::AddIndices(primitive, 1024);
+    }
+  }
+}
+
+TEST_P(IndexGeneratorSpeedTest, LargeDraws32)
+{
+  std::vector<u32> buffer(65536 * 2);
+  for (int primitive : primitives)
+  {
+    for (int i = 0; i < 100; ++i)
+    {
+      IndexGenerator::Start(buffer.data());
+      for (int j = 0; j < 16; ++j)
+        IndexGenerator::AddIndices(primitive, 1024);
+    }
+  }
+}
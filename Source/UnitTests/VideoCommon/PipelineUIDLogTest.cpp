@@ -0,0 +1,150 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "VideoCommon/PipelineUIDLog.h"
+
+using VideoCommon::PipelineUIDLog;
+
+namespace
+{
+using Parts = std::array<PipelineUIDLog::PartData, PipelineUIDLog::NUM_PARTS>;
+
+// Pipelines that share most of their parts, like the ones of a real game.
+Parts MakeParts(u8 vertex_format, u8 pixel_shader)
+{
+  return {{{vertex_format, 1, 2, 3}, {vertex_format, 4}, {}, {pixel_shader, 5, 6}}};
+}
+
+class PipelineUIDLogTest : public testing::Test
+{
+protected:
+  PipelineUIDLogTest() : m_dir{File::CreateTempDir()} {}
+  virtual ~PipelineUIDLogTest() { File::DeleteDirRecursively(m_dir); }
+
+  std::string GetPath(const std::string& name) const { return m_dir + DIR_SEP + name; }
+
+  std::string m_dir;
+};
+}  // Anonymous namespace
+
+TEST_F(PipelineUIDLogTest, DeduplicatesParts)
+{
+  PipelineUIDLog log;
+  EXPECT_TRUE(log.AddPipeline(MakeParts(0, 0), 1, 2, 3));
+  EXPECT_TRUE(log.AddPipeline(MakeParts(0, 1), 1, 2, 3));
+  EXPECT_TRUE(log.AddPipeline(MakeParts(0, 1), 1, 2, 4));
+  EXPECT_FALSE(log.AddPipeline(MakeParts(0, 0), 1, 2, 3));
+
+  EXPECT_EQ(3u, log.GetPipelines().size());
+  EXPECT_EQ(1u, log.GetPartCount(PipelineUIDLog::PART_VERTEX_FORMAT));
+  EXPECT_EQ(1u, log.GetPartCount(PipelineUIDLog::PART_GEOMETRY_SHADER));
+  EXPECT_EQ(2u, log.GetPartCount(PipelineUIDLog::PART_PIXEL_SHADER));
+  EXPECT_EQ(4u, log.GetPipelines()[2].blending_state_bits);
+}
+
+TEST_F(PipelineUIDLogTest, AppendsToFile)
+{
+  const std::string path = GetPath("log");
+  {
+    PipelineUIDLog log;
+    EXPECT_FALSE(log.Open(path, 7));
+    log.AddPipeline(MakeParts(0, 0), 1, 2, 3);
+    log.AddPipeline(MakeParts(1, 0), 1, 2, 3);
+  }
+
+  PipelineUIDLog log;
+  ASSERT_TRUE(log.Load(path, 7));
+  ASSERT_EQ(2u, log.GetPipelines().size());
+  const PipelineUIDLog::Pipeline& pipeline = log.GetPipelines()[1];
+  EXPECT_EQ(MakeParts(1, 0)[PipelineUIDLog::PART_VERTEX_FORMAT],
+            log.GetPartData(PipelineUIDLog::PART_VERTEX_FORMAT,
+                            pipeline.parts[PipelineUIDLog::PART_VERTEX_FORMAT]));
+  EXPECT_EQ(3u, pipeline.blending_state_bits);
+
+  // Pipelines that were added before opening are written to the file too.
+  log.AddPipeline(MakeParts(2, 2), 1, 2, 3);
+  EXPECT_TRUE(log.Open(path, 7));
+  log.Close();
+  ASSERT_TRUE(log.Load(path, 7));
+  EXPECT_EQ(3u, log.GetPipelines().size());
+}
+
+TEST_F(PipelineUIDLogTest, RejectsOtherVersions)
+{
+  const std::string path = GetPath("log");
+  PipelineUIDLog log;
+  log.AddPipeline(MakeParts(0, 0), 1, 2, 3);
+  log.Open(path, 1);
+  log.Close();
+
+  EXPECT_FALSE(log.Load(path, 2));
+  EXPECT_TRUE(log.GetPipelines().empty());
+  EXPECT_TRUE(log.Load(path));
+  EXPECT_EQ(1u, log.GetVersion());
+
+  // Opening with a new version starts over.
+  EXPECT_FALSE(log.Open(path, 2));
+  EXPECT_TRUE(log.GetPipelines().empty());
+}
+
+TEST_F(PipelineUIDLogTest, IgnoresTruncatedRecords)
+{
+  const std::string path = GetPath("log");
+  {
+    PipelineUIDLog log;
+    log.Open(path, 1);
+    log.AddPipeline(MakeParts(0, 0), 1, 2, 3);
+    log.AddPipeline(MakeParts(0, 1), 1, 2, 3);
+  }
+
+  // Cut the last pipeline record in half, as a crash while writing it could.
+  u64 size = File::GetSize(path);
+  {
+    File::IOFile file(path, "r+b");
+    ASSERT_TRUE(file.Resize(size - 10));
+  }
+
+  PipelineUIDLog log;
+  ASSERT_TRUE(log.Open(path, 1));
+  EXPECT_EQ(1u, log.GetPipelines().size());
+
+  // The truncated record is dropped from the file, so that new ones can be read back.
+  log.AddPipeline(MakeParts(0, 2), 1, 2, 3);
+  log.Close();
+  ASSERT_TRUE(log.Load(path, 1));
+  EXPECT_EQ(2u, log.GetPipelines().size());
+}
+
+TEST_F(PipelineUIDLogTest, Merge)
+{
+  PipelineUIDLog a;
+  a.AddPipeline(MakeParts(0, 0), 1, 2, 3);
+  a.AddPipeline(MakeParts(0, 1), 1, 2, 3);
+  PipelineUIDLog b;
+  b.AddPipeline(MakeParts(0, 1), 1, 2, 3);
+  b.AddPipeline(MakeParts(1, 1), 1, 2, 3);
+  b.AddPipeline(MakeParts(1, 2), 1, 2, 3);
+
+  EXPECT_EQ(2u, a.Merge(b));
+  EXPECT_EQ(4u, a.GetPipelines().size());
+  EXPECT_EQ(2u, a.GetPartCount(PipelineUIDLog::PART_VERTEX_FORMAT));
+  EXPECT_EQ(3u, a.GetPartCount(PipelineUIDLog::PART_PIXEL_SHADER));
+  EXPECT_EQ(0u, a.Merge(b));
+
+  const std::string path = GetPath("merged");
+  ASSERT_TRUE(a.Save(path));
+  PipelineUIDLog loaded;
+  ASSERT_TRUE(loaded.Load(path));
+  EXPECT_EQ(0u, loaded.Merge(a));
+  EXPECT_EQ(4u, loaded.GetPipelines().size());
+}
@@ -0,0 +1,99 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/ColorMath.h"
+
+TEST(SoftwareColorMath, CombineColorMatchesReference)
+{
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> d_dist(-1024, 1023);
+
+  for (int iteration = 0; iteration < 20000; ++iteration)
+  {
+    ColorMath::CombinerInputs inputs;
+    for (int i = 0; i < 3; ++i)
+    {
+      inputs.a[i] = static_cast<u8>(rng());
+      inputs.b[i] = static_cast<u8>(rng());
+      inputs.c[i] = static_cast<u8>(rng());
+      inputs.d[i] = static_cast<s16>(d_dist(rng));
+    }
+
+    // The extremes of c are where the rounding differs the most.
+    if (iteration % 4 == 0)
+      inputs.c[iteration / 4 % 3] = (iteration & 8) ? 255 : 0;
+
+    for (u32 bias = 0; bias < 4; ++bias)
+    {
+      for (u32 shift = 0; shift < 4; ++shift)
+      {
+        for (int flags = 0; flags < 4; ++flags)
+        {
+          const bool subtract = flags & 1;
+          const bool clamp = flags & 2;
+
+          std::array<s16, 3> expected;
+          std::array<s16, 3> actual;
+          ColorMath::Reference::CombineColor(inputs, bias, shift, subtract, clamp,
+                                             expected.data());
+          ColorMath::CombineColor(inputs, bias, shift, subtract, clamp, actual.data());
+          ASSERT_EQ(expected, actual) << bias << " " << shift << " " << flags;
+        }
+      }
+    }
+  }
+}
+
+TEST(SoftwareColorMath, CombineColorDoesNotWritePastResult)
+{
+  const ColorMath::CombinerInputs inputs = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12}};
+  std::array<s16, 4> result;
+  result.fill(0x1234);
+  ColorMath::CombineColor(inputs, 0, 0, false, true, result.data());
+  EXPECT_EQ(0x1234, result[3]);
+}
+
+TEST(SoftwareColorMath, BlendColorMatchesReference)
+{
+  std::mt19937 rng(1);
+
+  for (int iteration = 0; iteration < 200000; ++iteration)
+  {
+    const u32 src = rng();
+    const u32 dst = rng();
+    u32 src_factor = rng();
+    u32 dst_factor = rng();
+
+    // Blend factors are usually 0, 255 or a single alpha value repeated in every component.
+    if (iteration % 3 == 0)
+      src_factor = (src_factor & 1) ? 0xffffffff : 0;
+    if (iteration % 5 == 0)
+      dst_factor = (dst_factor & 0xff) * 0x01010101;
+
+    u8 src_color[4];
+    u8 expected[4];
+    u8 actual[4];
+    std::memcpy(src_color, &src, sizeof(src));
+    std::memcpy(expected, &dst, sizeof(dst));
+    std::memcpy(actual, &dst, sizeof(dst));
+
+    ColorMath::Reference::BlendColor(src_color, expected, src_factor, dst_factor);
+    ColorMath::BlendColor(src_color, actual, src_factor, dst_factor);
+    ASSERT_EQ(0, std::memcmp(expected, actual, sizeof(actual)))
+        << std::hex << src << " " << dst << " " << src_factor << " " << dst_factor;
+
+    std::memcpy(expected, &dst, sizeof(dst));
+    std::memcpy(actual, &dst, sizeof(dst));
+    ColorMath::Reference::SubtractBlend(src_color, expected);
+    ColorMath::SubtractBlend(src_color, actual);
+    ASSERT_EQ(0, std::memcmp(expected, actual, sizeof(actual))) << std::hex << src << " " << dst;
+  }
+}
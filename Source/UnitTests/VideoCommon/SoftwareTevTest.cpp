@@ -0,0 +1,149 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/Tev.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+// Sets up a random stage, swap table, konst and indirect configuration. Textures are preloaded
+// into TMEM, and everything after the TEV stages (alpha test, z texture, fog, z test and
+// blending) is disabled so that the EFB color is the output of the last stage.
+void RandomizeTevConfiguration(std::mt19937& rng)
+{
+  std::memset(&bpmem, 0, sizeof(bpmem));
+
+  bpmem.genMode.numtevstages = rng() % 16;
+  bpmem.genMode.numindstages = rng() % 5;
+
+  for (auto& order : bpmem.tevorders)
+  {
+    // Only the color channels the rasterizer can provide.
+    static const u32 color_channels[] = {0, 1, 5, 6, 7};
+    order.hex = rng();
+    order.colorchan0 = color_channels[rng() % 5];
+    order.colorchan1 = color_channels[rng() % 5];
+  }
+  for (auto& ksel : bpmem.tevksel)
+    ksel.hex = rng();
+  for (auto& combiner : bpmem.combiners)
+  {
+    combiner.colorC.hex = rng();
+    combiner.alphaC.hex = rng();
+  }
+  // Half of the indirect stages are disabled, which is the common case.
+  for (auto& indirect : bpmem.tevind)
+    indirect.hex = (rng() & 1) ? rng() : 0;
+  for (auto& indmtx : bpmem.indmtx)
+  {
+    indmtx.col0.hex = rng();
+    indmtx.col1.hex = rng();
+    indmtx.col2.hex = rng();
+  }
+  bpmem.tevindref.hex = rng();
+  for (auto& texscale : bpmem.texscale)
+    texscale.hex = rng();
+
+  for (auto& tex : bpmem.tex)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      tex.texImage0[i].width = 3;
+      tex.texImage0[i].height = 3;
+      tex.texImage0[i].format = static_cast<u32>(TextureFormat::RGB5A3);
+      tex.texImage1[i].image_type = 1;
+      tex.texImage1[i].tmem_even = rng() % 16;
+      tex.texMode0[i].wrap_s = rng() % 3;
+      tex.texMode0[i].wrap_t = rng() % 3;
+    }
+  }
+
+  bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+  bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+  bpmem.alpha_test.logic = AlphaTest::AND;
+  bpmem.blendmode.colorupdate = 1;
+  bpmem.blendmode.alphaupdate = 1;
+}
+
+void RandomizeTevInputs(std::mt19937& rng, Tev& tev)
+{
+  for (auto& color : tev.Color)
+  {
+    for (u8& component : color)
+      component = static_cast<u8>(rng());
+  }
+  for (auto& uv : tev.Uv)
+  {
+    uv.s = static_cast<s32>(rng() % 0x2000) - 0x1000;
+    uv.t = static_cast<s32>(rng() % 0x2000) - 0x1000;
+  }
+  tev.Position[0] = rng() % EFB_WIDTH;
+  tev.Position[1] = rng() % EFB_HEIGHT;
+  tev.Position[2] = rng() & 0xFFFFFF;
+}
+
+u64 HashColor(u64 hash, u32 color)
+{
+  // 64-bit FNV-1a
+  for (int i = 0; i < 4; i++)
+    hash = (hash ^ ((color >> (i * 8)) & 0xFF)) * 0x100000001B3;
+  return hash;
+}
+}  // Anonymous namespace
+
+// The expected hash was recorded with the Tev that decoded the stage configuration from bpmem for
+// every stage of every pixel, before it was decoded once per primitive by Tev::SetupStages.
+TEST(SoftwareTev, DecodedStagesMatchPerPixelDecoding)
+{
+  std::mt19937 rng(0x54455600);
+
+  for (u8& byte : texMem)
+    byte = static_cast<u8>(rng());
+
+  auto tev = std::make_unique<Tev>();
+  tev->Init();
+
+  u64 hash = 0xCBF29CE484222325;
+  for (int configuration = 0; configuration < 2000; configuration++)
+  {
+    RandomizeTevConfiguration(rng);
+    for (int reg = 0; reg < 4; reg++)
+    {
+      for (int comp = 0; comp < 4; comp++)
+      {
+        PixelShaderManager::constants.colors[reg][comp] = static_cast<s32>(rng() % 2048) - 1024;
+        tev->SetRegColor(reg, comp, static_cast<s16>(rng() % 256));
+      }
+    }
+    tev->SetupStages();
+
+    for (int pixel = 0; pixel < 16; pixel++)
+    {
+      RandomizeTevInputs(rng, *tev);
+      const u16 x = static_cast<u16>(tev->Position[0]);
+      const u16 y = static_cast<u16>(tev->Position[1]);
+
+      for (auto format : {PEControl::RGB8_Z24, PEControl::RGBA6_Z24})
+      {
+        bpmem.zcontrol.pixel_format = format;
+        u8 black[4] = {};
+        EfbInterface::SetColor(x, y, black);
+        tev->Draw();
+        hash = HashColor(hash, EfbInterface::GetColor(x, y));
+      }
+    }
+  }
+
+  EXPECT_EQ(0x0DC2784DFF167816u, hash);
+}
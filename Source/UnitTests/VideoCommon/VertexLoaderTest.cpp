@@ -2,11 +2,16 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <random>
 #include <tuple>
 #include <type_traits>
 #include <unordered_set>
+#include <vector>
 
 #include <gtest/gtest.h>  // NOLINT
 
@@ -16,6 +21,7 @@
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/VertexLoaderBase.h"
+#include "VideoCommon/VertexLoader.h"
 #include "VideoCommon/VertexLoaderManager.h"
 
 TEST(VertexLoaderUID, UniqueEnough)
@@ -92,6 +98,17 @@ protected:
     EXPECT_EQ(actual_count, expected_count);
   }
 
+  // Converts the same vertices repeatedly and prints the throughput of the loader.
+  void MeasureThroughput(int iterations, int count)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+      RunVertices(count);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%s: %.1f Mvertices/s\n", m_loader->GetName().c_str(),
+           iterations * static_cast<double>(count) / elapsed.count() / 1e6);
+  }
+
   void ResetPointers()
   {
     m_src = DataReader(input_memory, input_memory + sizeof(input_memory));
@@ -268,8 +285,7 @@ TEST_P(VertexLoaderSpeedTest, PositionDirectAll)
   elements += 2;
   size_t elem_size = static_cast<size_t>(1) << (format / 2);
   CreateAndCheckSizes(elements * elem_size, elements * sizeof(float));
-  for (int i = 0; i < 1000; ++i)
-    RunVertices(100000);
+  MeasureThroughput(1000, 100000);
 }
 
 TEST_P(VertexLoaderSpeedTest, TexCoordSingleElement)
@@ -287,8 +303,7 @@ TEST_P(VertexLoaderSpeedTest, TexCoordSingleElement)
   size_t elem_size = static_cast<size_t>(1) << (format / 2);
   CreateAndCheckSizes(2 * sizeof(s8) + elements * elem_size,
                       2 * sizeof(float) + elements * sizeof(float));
-  for (int i = 0; i < 1000; ++i)
-    RunVertices(100000);
+  MeasureThroughput(1000, 100000);
 }
 
 TEST_F(VertexLoaderTest, LargeFloatVertexSpeed)
@@ -351,6 +366,95 @@ TEST_F(VertexLoaderTest, LargeFloatVertexSpeed)
 
   // This test is only done 100x in a row since it's ~20x slower using the
   // current vertex loader implementation.
-  for (int i = 0; i < 100; ++i)
-    RunVertices(100000);
+  MeasureThroughput(100, 100000);
+}
+
+// Checks the JIT loader against the generic one with a mix of formats, skipped vertices and
+// vertex counts, which covers the x64 loop converting two vertices at once on AVX2 hosts.
+TEST_F(VertexLoaderTest, MatchesGeneric)
+{
+  m_vtx_desc.PosMatIdx = 1;
+  m_vtx_desc.Tex1MatIdx = 1;
+  m_vtx_desc.Tex2MatIdx = 1;
+  m_vtx_desc.Position = INDEX16;
+  m_vtx_desc.Normal = INDEX8;
+  m_vtx_desc.Color0 = DIRECT;
+  m_vtx_desc.Color1 = INDEX8;
+  m_vtx_desc.Tex0Coord = DIRECT;
+  m_vtx_desc.Tex1Coord = INDEX16;
+
+  m_vtx_attr.g0.PosElements = 1;  // XYZ
+  m_vtx_attr.g0.PosFormat = FORMAT_SHORT;
+  m_vtx_attr.g0.PosFrac = 5;
+  m_vtx_attr.g0.NormalElements = 1;  // NBT
+  m_vtx_attr.g0.NormalIndex3 = 1;
+  m_vtx_attr.g0.NormalFormat = FORMAT_BYTE;
+  m_vtx_attr.g0.Color0Comp = FORMAT_16B_565;
+  m_vtx_attr.g0.Color1Comp = FORMAT_24B_6666;
+  m_vtx_attr.g0.Tex0CoordElements = 1;  // ST
+  m_vtx_attr.g0.Tex0CoordFormat = FORMAT_UBYTE;
+  m_vtx_attr.g0.Tex0Frac = 3;
+  m_vtx_attr.g0.ByteDequant = 1;
+  m_vtx_attr.g1.Tex1CoordFormat = FORMAT_FLOAT;
+
+  std::unique_ptr<VertexLoaderBase> generic =
+      std::make_unique<VertexLoader>(m_vtx_desc, m_vtx_attr);
+  CreateAndCheckSizes(15, generic->m_native_vtx_decl.stride);
+  const int stride = m_loader->m_native_vtx_decl.stride;
+
+  // The arrays are random data, after the vertices.
+  std::mt19937 rng(1234);
+  u8* arrays = input_memory + 64 * 1024;
+  for (int i = 0; i < 64 * 1024; i++)
+    arrays[i] = static_cast<u8>(rng());
+  for (int i = 0; i < 12; i++)
+  {
+    VertexLoaderManager::cached_arraybases[i] = arrays + 16 + i * 4096;
+    g_main_cp_state.array_strides[i] = 12;
+  }
+
+  std::vector<u8> expected(64 * 1024);
+  for (int count = 1; count < 64; count++)
+  {
+    ResetPointers();
+    for (int i = 0; i < count; i++)
+    {
+      for (int j = 0; j < 3; j++)
+        Input<u8>(rng() % 64);
+      // Skip every few vertices, sometimes several in a row.
+      Input<u16>(rng() % 5 == 0 ? 0xFFFF : rng() % 256);
+      for (int j = 0; j < 3; j++)
+        Input<u8>(rng() % 256);
+      Input<u16>(static_cast<u16>(rng()));
+      Input<u8>(rng() % 256);
+      Input<u16>(static_cast<u16>(rng()));
+      Input<u16>(rng() % 256);
+    }
+
+    memset(expected.data(), 0xFF, expected.size());
+    const int expected_count = generic->RunVertices(
+        DataReader(input_memory, input_memory + sizeof(input_memory)),
+        DataReader(expected.data(), expected.data() + expected.size()), count);
+    float expected_position_cache[3][4];
+    u32 expected_position_matrix_index[4];
+    memcpy(expected_position_cache, VertexLoaderManager::position_cache,
+           sizeof(expected_position_cache));
+    memcpy(expected_position_matrix_index, VertexLoaderManager::position_matrix_index,
+           sizeof(expected_position_matrix_index));
+
+    ResetPointers();
+    memset(output_memory, 0xFF, expected.size());
+    ASSERT_EQ(expected_count, m_loader->RunVertices(m_src, m_dst, count)) << "count " << count;
+    for (int i = 0; i < expected_count * stride; i++)
+    {
+      ASSERT_EQ(expected[i], output_memory[i]) << "count " << count << ", vertex " << i / stride
+                                               << ", byte " << i % stride;
+    }
+    EXPECT_EQ(0, memcmp(expected_position_cache, VertexLoaderManager::position_cache,
+                        sizeof(expected_position_cache)))
+        << "count " << count;
+    EXPECT_EQ(0, memcmp(expected_position_matrix_index, VertexLoaderManager::position_matrix_index,
+                        sizeof(expected_position_matrix_index)))
+        << "count " << count;
+  }
 }